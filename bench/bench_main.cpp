@@ -0,0 +1,1287 @@
+// Scan and detection benchmarks against the virtual RTU bus.
+//
+//   pio run -e native_bench && .pio/build/native_bench/program [options]
+//
+// Options:
+//   --layout NAME=SPEC   bus layout to run (repeatable, replaces the defaults);
+//                        SPEC uses the virtual_bus.h layout syntax
+//   --only LIST          comma separated subset of scan,baud,config,detect,map,tec,poll,
+//                        warm,bus,latency,crc,parallel,stream,
+//                        led,dump,identify,decode,changes,history,busstats,
+//                        retry,gateway,cache
+//   --timescale N        run the clock N times faster than real time (default 5)
+//   --no-fast            benchmark with fast sweep disabled (2 s probe timeouts)
+//   --polled             poll available() for replies instead of RX event framing
+//   --csv                machine readable output
+//
+// Times are reported in bus time (virtual ms), which is what the firmware
+// would spend on a real line; wall ms is the host time at the chosen scale.
+
+#include <Arduino.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include "scanner.h"
+#include "scan_engine.h"
+#include "modbus_rtu.h"
+#include "register_map.h"
+#include "poll_scheduler.h"
+#include "device_inventory.h"
+#include "bus_task.h"
+#include "stream_output.h"
+#include "led_renderer.h"
+#include "bulk_dump.h"
+#include "fingerprint.h"
+#include "register_profile.h"
+#include "tec_profile.h"
+#include "change_report.h"
+#include "history.h"
+#include "bus_stats.h"
+#include "retry_policy.h"
+#include "tcp_gateway.h"
+#include "read_cache.h"
+#include "virtual_bus.h"
+
+struct BenchLayout {
+  std::string name;
+  std::string spec;
+};
+
+struct BenchResult {
+  unsigned long virtualMs;
+  double wallMs;
+  uint32_t requests;
+  String outcome;
+};
+
+static const BenchLayout defaultLayouts[] = {
+  {"empty", ""},
+  {"single", "1=generic"},
+  {"tec-8e2", "1:8E2=tec"},
+  {"id2-19200", "2@19200=generic"},
+  {"dense-32", "1-32=generic~5"},
+  {"slow-mixed", "1=generic~150,7=sparse~60"},
+  {"sparse-map", "1=sparse"},
+  {"tec-strict", "1:8E2=tecstrict"},
+  {"bms-19200", "m@19200~200,1@19200=generic,2@19200=meter~5"},
+  {"bms-115200", "m@115200~100,3@115200=meter~5"},
+  {"two-segment", "1-8=generic~5|1-8=meter~5"},
+};
+
+static bool csvOutput = false;
+
+// Segment of a layout spec ('|' separated, see virtual_bus.h), "" if absent
+static std::string segmentSpec(const std::string& spec, int segment) {
+  size_t start = 0;
+  for (int i = 0; i < segment; i++) {
+    start = spec.find('|', start);
+    if (start == std::string::npos) return "";
+    start++;
+  }
+  return spec.substr(start, spec.find('|', start) - start);
+}
+
+// Layout spec of one segment without its "m..." entry for another master
+static std::string slaveEntries(const std::string& layout, int segment = 0) {
+  std::string spec = segmentSpec(layout, segment);
+  std::string slaves;
+  size_t start = 0;
+  while (start <= spec.size()) {
+    size_t end = spec.find(',', start);
+    if (end == std::string::npos) end = spec.size();
+    std::string entry = spec.substr(start, end - start);
+    if (!entry.empty() && entry[0] != 'm' && entry[0] != 'M') slaves += (slaves.empty() ? "" : ",") + entry;
+    start = end + 1;
+  }
+  return slaves;
+}
+
+// First slave ID in a layout spec, used as the target for the per-device benchmarks
+static uint8_t firstSlaveId(const std::string& spec) {
+  long id = strtol(slaveEntries(spec).c_str(), nullptr, 10);
+  return id >= 1 && id <= 247 ? id : 1;
+}
+
+// Poll points for every slave in a layout: a slow status block and a fast
+// measurement block per device
+#define BENCH_POLL_MS 10000
+#define BENCH_BUS_READS 200
+#define BENCH_LATENCY_READS 100
+#define BENCH_CHANGES_MS 60000       // One snapshot interval of change reporting
+#define BENCH_HISTORY_MS 600000      // Ten minutes of recorded plant values
+#define BENCH_HISTORY_SCALE 20       // Clock speed-up for them; only the values matter
+#define BENCH_STATS_RECORDS 1000000   // busStatsRecord() calls timed on the host
+#define BENCH_STATS_SAMPLES 20000     // Synthetic latencies for the quantile error
+#define BENCH_STATS_MS 60000          // Polling recorded into the statistics
+#define BENCH_RETRY_ROUNDS 200        // Reads of each slave with and without the retry policy
+#define BENCH_GATEWAY_MS 30000        // Bus time each gateway load runs
+#define BENCH_CACHE_MS 10000          // Bus time of the shared-consumer load
+
+// Counts what a history query would send to the console
+class CountingPrint : public Print {
+ public:
+  size_t bytes = 0;
+  size_t lines = 0;
+  size_t write(uint8_t c) override {
+    bytes++;
+    if (c == '\n') lines++;
+    return 1;
+  }
+};
+
+// Idle hook calls during one ModbusMaster transaction, its count of wake-ups
+static uint32_t modbusMasterWakeups = 0;
+
+static void countModbusMasterWakeup() {
+  modbusMasterWakeups++;
+}
+
+// Points of every segment go to the bus on that segment; returns the
+// number of buses with points
+static uint8_t addPollPoints(const std::string& spec) {
+  pollClear();
+  uint8_t buses = 0;
+  for (uint8_t bus = 0; bus < rtuBusCount(); bus++) {
+    std::string slaves = slaveEntries(spec, bus);
+    if (!slaves.empty()) buses++;
+    const char* p = slaves.c_str();
+    while (*p) {
+      long first = strtol(p, (char**)&p, 10);
+      long last = *p == '-' ? strtol(p + 1, (char**)&p, 10) : first;
+      for (long id = first; id >= 1 && id <= last && id <= 247; id++) {
+        pollAddPoint(id, MAP_HOLDING_REGISTERS, 0, 10, 1000, bus);
+        pollAddPoint(id, MAP_INPUT_REGISTERS, 0, 4, 250, bus);
+      }
+      while (*p && *p != ',') p++;
+      if (*p == ',') p++;
+    }
+  }
+  return buses;
+}
+
+// A Modbus TCP client on its own thread: keeps `depth` reads of `quantity`
+// input registers outstanding and times each reply in bus time
+struct BenchTcpClient {
+  uint8_t depth;
+  uint16_t quantity;
+  std::atomic<bool> stop{false};
+  uint32_t replies = 0;
+  uint32_t busy = 0;
+  uint32_t other = 0;
+  uint64_t latencyUs = 0;       // Sum over the data replies
+  uint32_t maxLatencyUs = 0;
+  std::thread thread;
+};
+
+static void benchTcpClient(BenchTcpClient* client, uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  if (fd < 0 || connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+    if (fd >= 0) close(fd);
+    return;
+  }
+  struct timeval timeout = {0, 100000};   // Wake up now and then to see the stop flag
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  uint32_t sentUs[256];
+  uint8_t buffer[512];
+  size_t length = 0;
+  uint16_t nextId = 0;
+  uint8_t outstanding = 0;
+  while (!client->stop) {
+    for (; outstanding < client->depth; outstanding++, nextId++) {
+      uint8_t frame[12] = {highByte(nextId), lowByte(nextId), 0, 0, 0, 6, 1, MB_FC_READ_INPUT_REGISTERS,
+                           0, 0, highByte(client->quantity), lowByte(client->quantity)};
+      sentUs[nextId & 0xFF] = micros();
+      if (send(fd, frame, sizeof(frame), MSG_NOSIGNAL) != sizeof(frame)) client->stop = true;
+    }
+    ssize_t got = recv(fd, buffer + length, sizeof(buffer) - length, 0);
+    if (got == 0) break;
+    if (got < 0) continue;
+    length += got;
+    while (length >= 7 && length >= 6u + ((buffer[4] << 8) | buffer[5])) {
+      size_t frameLength = 6 + ((buffer[4] << 8) | buffer[5]);
+      uint16_t transactionId = (buffer[0] << 8) | buffer[1];
+      bool busy = buffer[7] != MB_FC_READ_INPUT_REGISTERS && buffer[8] == 0x06;
+      if (buffer[7] == MB_FC_READ_INPUT_REGISTERS) {
+        uint32_t us = micros() - sentUs[transactionId & 0xFF];
+        client->replies++;
+        client->latencyUs += us;
+        client->maxLatencyUs = max(client->maxLatencyUs, us);
+      } else if (busy) {
+        client->busy++;
+      } else {
+        client->other++;
+      }
+      outstanding--;
+      length -= frameLength;
+      memmove(buffer, buffer + frameLength, length);
+      if (busy) delay(50);   // Back off as a SCADA client would before asking again
+    }
+  }
+  close(fd);
+}
+
+// Bulk dump until done, loop() style
+static void runDump() {
+  while (dumpActive()) {
+    dumpTick();
+    busDispatch();
+    delay(1);
+  }
+  while (busPending()) busDispatch();
+}
+
+// Scan until done; bus results come back through busDispatch() as in loop()
+static void runScan() {
+  while (scanActive()) {
+    scanTick();
+    busDispatch();
+    delay(1);
+  }
+  while (busPending()) busDispatch();
+}
+
+// Line settings of the first layout entry ("2@19200:8E1=..."), so the poll
+// benchmark talks to its slaves without running the detection first
+static void firstLineSettings(const std::string& spec, uint32_t* baud, uint32_t* config) {
+  static const uint32_t configs[] = {SERIAL_8N1, SERIAL_8N2, SERIAL_8E1, SERIAL_8E2,
+                                     SERIAL_8O1, SERIAL_7E1, SERIAL_7O1};
+  std::string slaves = slaveEntries(spec);
+  std::string entry = slaves.substr(0, slaves.find(','));
+  size_t at = entry.find('@');
+  size_t colon = entry.find(':');
+  *baud = at != std::string::npos ? strtoul(entry.c_str() + at + 1, nullptr, 10) : MODBUS_BAUD;
+  *config = SERIAL_8N1;
+  if (colon == std::string::npos) return;
+  for (uint32_t candidate : configs) {
+    if (entry.compare(colon + 1, 3, rtuConfigName(candidate)) == 0) *config = candidate;
+  }
+}
+
+static void resetBus() {
+  for (uint8_t i = 0; i < rtuBusCount(); i++) {
+    RtuBus& bus = *rtuBuses[i];
+    rtuBegin(bus, MODBUS_BAUD, SERIAL_8N1);
+    bus.turnaroundUs = 0;
+    while (bus.port->available()) bus.port->read();
+  }
+  virtualBusResetStats();
+  retryReset();     // A circuit left open by one run would refuse the next
+}
+
+template <typename Fn>
+static BenchResult timeRun(Fn run) {
+  resetBus();
+  auto wallStart = std::chrono::steady_clock::now();
+  unsigned long start = millis();
+
+  BenchResult result;
+  result.outcome = run();
+
+  result.virtualMs = millis() - start;
+  result.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+  VirtualBusStats stats;
+  virtualBusStats(&stats);
+  result.requests = stats.requests;
+  return result;
+}
+
+static void report(const BenchLayout& layout, const char* function, const BenchResult& result) {
+  if (csvOutput) {
+    printf("%s,%s,%lu,%.1f,%u,%s\n", layout.name.c_str(), function, result.virtualMs,
+           result.wallMs, result.requests, result.outcome.c_str());
+  } else {
+    printf("%-12s %-24s %10lu %9.1f %9u  %s\n", layout.name.c_str(), function, result.virtualMs,
+           result.wallMs, result.requests, result.outcome.c_str());
+  }
+  fflush(stdout);
+}
+
+// The TEC analysis as it decoded before register profiles: tables built on
+// the stack per call, a float multiply per register and a switch for the
+// unit state. Kept here as the baseline for the "decode" benchmark.
+struct LegacyTecRegister {
+  uint16_t address;
+  const char* name;
+  const char* unit;
+  float scale;
+};
+
+static uint32_t legacyTecDecode(const uint16_t* input, const uint16_t* holding, bool format) {
+  LegacyTecRegister inputRegisters[] = {
+    {1, "B1 - Inlet Temperature", "°C", 0.1}, {2, "B2 - Outlet Temperature", "°C", 0.1},
+    {3, "T2 - Ambient Temperature", "°C", 0.1}, {4, "T4 - Suction", "°C", 0.1}, {5, "T3 - Discharge", "°C", 0.1},
+    {6, "B6 - Low Pressure Side", "bar", 0.1}, {7, "B7 - High Pressure Side", "bar", 0.1},
+    {8, "Flow", "m3/h", 0.1}, {9, "Room Temperature", "°C", 0.1}, {13, "Compressor", "Hz", 1.0},
+    {14, "Y3 - Indoor pump PWM", "%", 0.1}, {17, "B4 - Hot Water", "°C", 0.1},
+    {18, "Operating Hours", "Hours", 1.0}, {20, "Unit State", "", 1.0}
+  };
+  LegacyTecRegister holdingRegisters[] = {
+    {61, "ST01 - Cooling mode temperature", "°C", 0.1}, {62, "ST02 - Heating mode temperature", "°C", 0.1},
+    {79, "ST09 - DHW temperature setup", "°C", 0.1}, {80, "ST10 - DHW temperature difference", "°C", 0.1}
+  };
+  uint32_t sink = 0;
+  char text[REGISTER_TEXT_MAX];
+  for (const LegacyTecRegister& reg : inputRegisters) {
+    uint16_t rawValue = input[reg.address - 1];
+    float scaledValue = rawValue * reg.scale;
+    if (format) sink += snprintf(text, sizeof(text), "%.1f %s", scaledValue, reg.unit);
+    else sink += (uint32_t)scaledValue;
+    if (reg.address == 20) {
+      const char* stateText = "Unknown";
+      switch (rawValue) {
+        case 1: stateText = "Heating"; break;
+        case 2: stateText = "Cooling"; break;
+        case 3: stateText = "Antifreeze"; break;
+        case 4: stateText = "Defrost"; break;
+        case 5: stateText = "Standby"; break;
+        case 6: stateText = "Off"; break;
+        case 7: stateText = "Starting"; break;
+        case 8: stateText = "On"; break;
+        case 9: stateText = "DHW"; break;
+      }
+      if (format) sink += snprintf(text, sizeof(text), "%s (%d)", stateText, rawValue);
+      else sink += stateText[0];
+    }
+  }
+  for (const LegacyTecRegister& reg : holdingRegisters) {
+    float scaledValue = holding[reg.address - 61] * reg.scale;
+    if (format) sink += snprintf(text, sizeof(text), "%.1f %s", scaledValue, reg.unit);
+    else sink += (uint32_t)scaledValue;
+  }
+  return sink;
+}
+
+static uint32_t profileTecDecode(const uint16_t* input, const uint16_t* holding, bool format) {
+  int32_t values[32];
+  bool valid[32] = {};
+  registerDecodeBlock(tecRegisters, tecRegisterCount, MAP_INPUT_REGISTERS, 1, 20, input, values, valid);
+  registerDecodeBlock(tecRegisters, tecRegisterCount, MAP_HOLDING_REGISTERS, 61, 20, holding, values, valid);
+  uint32_t sink = 0;
+  char text[REGISTER_TEXT_MAX];
+  for (uint8_t i = 0; i < tecRegisterCount; i++) {
+    if (!valid[i]) continue;
+    if (format) sink += registerFormat(tecRegisters[i], values[i], text, sizeof(text));
+    else sink += values[i];
+  }
+  return sink;
+}
+
+// Nanoseconds per register for `decode` over `rounds` polls of 18 registers
+template <typename Fn>
+static float decodeNsPerRegister(Fn decode, bool format, uint32_t rounds, uint32_t* sink) {
+  static const uint16_t input[20] = {452, 398, 65486, 30, 612, 84, 215, 12, 205, 0, 0, 0, 48, 650, 0, 0, 480, 12345, 0, 1};
+  static uint16_t holding[20] = {};
+  holding[0] = 120; holding[1] = 450; holding[18] = 500; holding[19] = 50;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t round = 0; round < rounds; round++) *sink += decode(input, holding, format);
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  return ns / ((double)rounds * 18);
+}
+
+static bool wanted(const std::string& only, const char* name) {
+  if (only.empty()) return true;
+  return ("," + only + ",").find(std::string(",") + name + ",") != std::string::npos;
+}
+
+int main(int argc, char** argv) {
+  std::vector<BenchLayout> layouts;
+  std::string only;
+  uint32_t timeScale = 5;
+  bool polledFraming = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--layout" && i + 1 < argc) {
+      std::string value = argv[++i];
+      size_t eq = value.find('=');
+      if (eq == std::string::npos) {
+        layouts.push_back({value, value});
+      } else {
+        layouts.push_back({value.substr(0, eq), value.substr(eq + 1)});
+      }
+    } else if (arg == "--only" && i + 1 < argc) {
+      only = argv[++i];
+    } else if (arg == "--timescale" && i + 1 < argc) {
+      timeScale = strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--no-fast") {
+      sweepSettings.fastSweep = false;
+    } else if (arg == "--polled") {
+      polledFraming = true;
+    } else if (arg == "--csv") {
+      csvOutput = true;
+    } else {
+      fprintf(stderr, "usage: %s [--layout NAME=SPEC]... [--only scan,baud,config,detect,map,tec,poll,warm,bus,latency,crc,parallel,stream,led,dump,identify,decode,changes,history,busstats,retry,gateway,cache] "
+                      "[--timescale N] [--no-fast] [--polled] [--csv]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (layouts.empty()) {
+    layouts.assign(std::begin(defaultLayouts), std::end(defaultLayouts));
+  }
+
+  nativeSetTimeScale(timeScale);
+  Serial.setMuted(true);
+  if (!virtualBusStart(layouts[0].spec.c_str())) return 1;
+  setup();
+  if (polledFraming) rtuSetEventFraming(modbusBus, false);
+
+  if (csvOutput) {
+    printf("layout,function,virtual_ms,wall_ms,requests,outcome\n");
+  } else {
+    printf("Fast sweep: %s, time scale %ux\n\n", sweepSettings.fastSweep ? "on" : "off", timeScale);
+    printf("%-12s %-24s %10s %9s %9s  %s\n", "layout", "function", "bus ms", "wall ms", "requests", "outcome");
+  }
+
+  if (wanted(only, "crc")) {
+    // CPU only, so measured in real time; best of five runs
+    static const BenchLayout host = {"host", ""};
+    nativeSetTimeScale(1);
+    report(host, "rtuCrc16", timeRun([] {
+      RtuCrcBenchmark best = {};
+      for (int run = 0; run < 5; run++) {
+        RtuCrcBenchmark crc;
+        rtuCrcBenchmark(&crc);
+        if (run == 0 || crc.tableUs < best.tableUs) best.tableUs = crc.tableUs;
+        if (run == 0 || crc.bitwiseUs < best.bitwiseUs) best.bitwiseUs = crc.bitwiseUs;
+        best.bytes = crc.bytes;
+        best.mismatches += crc.mismatches;
+      }
+      char line[160];
+      snprintf(line, sizeof(line), "table %.1f bytes/us, bitwise %.1f bytes/us, %.1fx, %s",
+               (float)best.bytes / max(best.tableUs, (uint32_t)1), (float)best.bytes / max(best.bitwiseUs, (uint32_t)1),
+               (float)best.bitwiseUs / max(best.tableUs, (uint32_t)1), best.mismatches ? "MISMATCH" : "bit-exact");
+      return String(line);
+    }));
+    nativeSetTimeScale(timeScale);
+  }
+
+  if (wanted(only, "decode")) {
+    // CPU only like crc: decoding the TEC registers of one poll (IR 1-20,
+    // HR 61-80), the pre-profile path against the descriptor table. The host
+    // has an FPU; on the ESP32-C3 every float operation of the old path is a
+    // library call, so the gap there is wider than shown.
+    static const BenchLayout host = {"host", ""};
+    nativeSetTimeScale(1);
+    for (bool format : {false, true}) {
+      report(host, format ? "decode/format" : "decode/values", timeRun([format] {
+        const uint32_t rounds = format ? 20000 : 200000;
+        volatile uint32_t result = 0;
+        uint32_t sink = 0;
+        float legacy = 1e9f, profile = 1e9f;
+        for (int run = 0; run < 5; run++) {
+          legacy = min(legacy, decodeNsPerRegister(legacyTecDecode, format, rounds, &sink));
+          profile = min(profile, decodeNsPerRegister(profileTecDecode, format, rounds, &sink));
+        }
+        result = sink;
+        (void)result;
+        char line[160];
+        snprintf(line, sizeof(line), "stack tables + float %.1f ns/reg, profile %.1f ns/reg, %.1fx", legacy, profile,
+                 legacy / max(profile, 0.001f));
+        return String(line);
+      }));
+    }
+    nativeSetTimeScale(timeScale);
+  }
+
+  if (wanted(only, "changes")) {
+    // A plant in steady state polled for a minute with binary output, every
+    // read sent against change reporting: temperatures with a 0.5 degree
+    // deadband, flows with 1%, setpoints and coils on any change
+    static const BenchLayout plant = {"plant", "1=plant~5"};
+    if (!virtualBusStart(plant.spec.c_str())) return 1;
+    rtuBegin(modbusBus, 9600, SERIAL_8N1);
+    pollClear();
+    pollAddPoint(1, MAP_INPUT_REGISTERS, 0, 16, 250);
+    pollAddPoint(1, MAP_INPUT_REGISTERS, 16, 16, 250);
+    pollAddPoint(1, MAP_HOLDING_REGISTERS, 0, 20, 1000);
+    pollAddPoint(1, MAP_COILS, 0, 16, 1000);
+    pollSetDeadband(0, 5, false);
+    pollSetDeadband(1, 1, true);
+
+    uint32_t allBytes = 0;
+    for (bool changes : {false, true}) {
+      report(plant, changes ? "changes/deadband" : "changes/every-read", timeRun([&] {
+        streamSetMode(STREAM_BINARY);
+        streamResetStats();
+        changeSetEnabled(changes);
+        pollStart();
+        unsigned long start = millis();
+        while (millis() - start < BENCH_CHANGES_MS) {
+          pollTick();
+          busDispatch();
+          delay(1);
+        }
+        while (busPending()) busDispatch();
+        PollWindow totals = pollTotals();
+        pollStop();
+        StreamStats sent = streamStats();
+        streamSetMode(STREAM_TEXT);
+        changeSetEnabled(false);
+        if (!changes) allBytes = sent.bytes;
+
+        char line[160];
+        int length = snprintf(line, sizeof(line), "%lu reads, %lu records, %lu values, %lu bytes",
+                              (unsigned long)totals.reads, (unsigned long)sent.records,
+                              (unsigned long)sent.values, (unsigned long)sent.bytes);
+        if (changes) {
+          snprintf(line + length, sizeof(line) - length, ", %.1fx less, %lu full reports",
+                   (float)allBytes / max(sent.bytes, (uint32_t)1), (unsigned long)changeStats().snapshots);
+        }
+        return String(line);
+      }));
+    }
+    pollClear();
+  }
+
+  if (wanted(only, "history")) {
+    // Ten minutes of the plant recorded (1 s and 250 ms points, 16 series),
+    // then every raw sample and minute bucket queried out
+    static const BenchLayout plant = {"plant", "1=plant~5"};
+    if (!virtualBusStart(plant.spec.c_str())) return 1;
+    rtuBegin(modbusBus, 9600, SERIAL_8N1);
+    pollClear();
+    pollAddPoint(1, MAP_INPUT_REGISTERS, 0, 8, 1000);
+    pollAddPoint(1, MAP_INPUT_REGISTERS, 16, 8, 250);
+    historyClear();
+    nativeSetTimeScale(BENCH_HISTORY_SCALE);
+
+    report(plant, "history/record", timeRun([&] {
+      pollStart();
+      unsigned long start = millis();
+      while (millis() - start < BENCH_HISTORY_MS) {
+        pollTick();
+        busDispatch();
+        delay(1);
+      }
+      while (busPending()) busDispatch();
+      PollWindow totals = pollTotals();
+      pollStop();
+      uint32_t samples = 0, buckets = 0;
+      for (uint8_t i = 0; i < historySeriesCount(); i++) {
+        samples += historySeries(i).samples;
+        buckets += historySeries(i).bucketCount;
+      }
+      char line[160];
+      snprintf(line, sizeof(line), "%u series, %lu reads (%lu failed), %lu samples, %lu closed buckets",
+               historySeriesCount(), (unsigned long)totals.reads, (unsigned long)totals.failures,
+               (unsigned long)samples, (unsigned long)buckets);
+      return String(line);
+    }));
+    nativeSetTimeScale(1);
+
+    report(plant, "history/query", timeRun([] {
+      CountingPrint out;
+      uint32_t values = 0;
+      auto wallStart = std::chrono::steady_clock::now();
+      for (uint8_t i = 0; i < historySeriesCount(); i++) {
+        values += historyStreamRaw(out, "> data - hist 0 raw", i, 0);
+        values += historyStreamRollup(out, "> data - hist 0 rollup", i, 0);
+      }
+      double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - wallStart).count();
+      char line[160];
+      snprintf(line, sizeof(line), "%lu samples+buckets in %lu lines, %lu bytes, %.0f us on the host, %.1f s at 115200",
+               (unsigned long)values, (unsigned long)out.lines, (unsigned long)out.bytes, us, out.bytes * 10 / 115200.0f);
+      return String(line);
+    }));
+
+    report(plant, "history/memory", timeRun([] {
+      // Per series and hour of retention, raw at each point's period
+      const HistorySeries& fast = historySeries(historySeriesCount() - 1);
+      const HistorySeries& slow = historySeries(0);
+      char line[200];
+      snprintf(line, sizeof(line), "%u B RAM for %d series; raw %lu B/h at %lu ms (%.0f min kept), %lu B/h at %lu ms; "
+               "rollup %lu B/h (%d h kept)",
+               (unsigned)(sizeof(HistorySeries) * HISTORY_MAX_SERIES + HISTORY_MAX_SERIES *
+                          (HISTORY_RAW_SAMPLES * 6 + HISTORY_BUCKETS * sizeof(HistoryBucket))),
+               HISTORY_MAX_SERIES, 3600000UL / slow.periodMs * 6, (unsigned long)slow.periodMs,
+               HISTORY_RAW_SAMPLES * slow.periodMs / 60000.0f, 3600000UL / fast.periodMs * 6,
+               (unsigned long)fast.periodMs, 3600000UL / HISTORY_BUCKET_MS * sizeof(HistoryBucket),
+               (int)(HISTORY_BUCKETS * HISTORY_BUCKET_MS / 3600000UL));
+      return String(line);
+    }));
+    nativeSetTimeScale(timeScale);
+    pollClear();
+  }
+
+  if (wanted(only, "busstats")) {
+    // CPU only like crc: what recording costs a transaction, spread over
+    // eight slaves; then known latencies (10-14 ms, 3% at 40-120 ms) through
+    // the histogram against their exact quantiles
+    static const BenchLayout host = {"host", ""};
+    nativeSetTimeScale(1);
+    report(host, "busstats/record", timeRun([] {
+      busStatsReset();
+      auto wallStart = std::chrono::steady_clock::now();
+      for (uint32_t i = 0; i < BENCH_STATS_RECORDS; i++) {
+        busStatsRecord(modbusBus, 1 + (i & 7), MB_FC_READ_HOLDING_REGISTERS, ModbusMaster::ku8MBSuccess,
+                       8000 + (i & 1023) * 16, 8, 25, 1500);
+      }
+      double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - wallStart).count();
+      char line[160];
+      double readNs = (8 + 25) * 10 * 1e9 / 115200;   // Request and 10 register reply on the wire
+      snprintf(line, sizeof(line), "%.1f ns per transaction, %.4f%% of a 10 register read at 115200",
+               ns / BENCH_STATS_RECORDS, ns / BENCH_STATS_RECORDS / readNs * 100);
+      return String(line);
+    }));
+
+    report(host, "busstats/quantiles", timeRun([] {
+      busStatsReset();
+      std::vector<uint32_t> exact;
+      uint32_t state = 12345;
+      for (uint32_t i = 0; i < BENCH_STATS_SAMPLES; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        uint32_t us = state % 100 < 3 ? 40000 + state % 80000 : 10000 + state % 4000;
+        exact.push_back(us);
+        busStatsRecord(modbusBus, 1, MB_FC_READ_HOLDING_REGISTERS, ModbusMaster::ku8MBSuccess, us, 8, 25, 0);
+      }
+      std::sort(exact.begin(), exact.end());
+      const BusStatsEntry& entry = *busStatsEntry(0, 0);
+      char line[200];
+      int length = 0;
+      for (float fraction : {0.50f, 0.95f, 0.99f}) {
+        uint32_t want = exact[(size_t)(fraction * (exact.size() - 1))];
+        uint32_t got = busStatsQuantileUs(entry, fraction);
+        length += snprintf(line + length, sizeof(line) - length, "p%.0f %.2f/%.2f ms (%+.1f%%)  ", fraction * 100,
+                           got / 1000.0f, want / 1000.0f, ((float)got - want) * 100 / want);
+      }
+      snprintf(line + length, sizeof(line) - length, "%u B per slave/function", (unsigned)sizeof(BusStatsEntry));
+      return String(line);
+    }));
+    nativeSetTimeScale(timeScale);
+
+    // The same on the virtual bus: a minute of polling two slaves with
+    // different turnarounds, as the menu would show it
+    static const BenchLayout plant = {"plant", "1=plant~5,2=plant~20"};
+    if (!virtualBusStart(plant.spec.c_str())) return 1;
+    rtuBegin(modbusBus, 9600, SERIAL_8N1);
+    pollClear();
+    pollAddPoint(1, MAP_INPUT_REGISTERS, 0, 16, 250);
+    pollAddPoint(2, MAP_INPUT_REGISTERS, 0, 16, 250);
+    report(plant, "busstats/poll", timeRun([] {
+      busStatsReset();
+      pollStart();
+      unsigned long start = millis();
+      while (millis() - start < BENCH_STATS_MS) {
+        pollTick();
+        busDispatch();
+        delay(1);
+      }
+      while (busPending()) busDispatch();
+      pollStop();
+      char line[200];
+      int length = 0;
+      for (uint8_t i = 0; busStatsEntry(0, i); i++) {
+        const BusStatsEntry& entry = *busStatsEntry(0, i);
+        length += snprintf(line + length, sizeof(line) - length, "slave %d: %lu reads p50 %.1f p95 %.1f p99 %.1f ms  ",
+                           entry.slaveId, (unsigned long)entry.ok.load(), busStatsQuantileUs(entry, 0.50f) / 1000.0f,
+                           busStatsQuantileUs(entry, 0.95f) / 1000.0f, busStatsQuantileUs(entry, 0.99f) / 1000.0f);
+      }
+      return String(line);
+    }));
+    pollClear();
+  }
+
+  if (wanted(only, "retry")) {
+    // HR 0-9 of a slave on a noisy line (10% garbled, 3% lost), a clean one
+    // and one that has gone (ID 9), in turn: one try per read as before the
+    // retry policy, against the default policy with its circuit breaker
+    static const BenchLayout noisy = {"noisy", "1=generic%10?3,2=generic"};
+    if (!virtualBusStart(noisy.spec.c_str())) return 1;
+    rtuBegin(modbusBus, 9600, SERIAL_8N1);
+    RetryPolicy defaults = retryPolicy;
+    for (bool policy : {false, true}) {
+      report(noisy, policy ? "retry/policy" : "retry/single-try", timeRun([&] {
+        retryPolicy = defaults;
+        if (!policy) {
+          retryPolicy.maxAttempts = 1;
+          retryPolicy.breakerFailures = 0;
+        }
+        retryReset();
+        static const uint8_t ids[] = {1, 2, 9};
+        uint32_t ok[3] = {0, 0, 0}, transactions[3] = {0, 0, 0}, busMs[3] = {0, 0, 0};
+        uint16_t values[RTU_MAX_READ_WORDS];
+        uint16_t timeoutMs = rtuReadTimeoutMs(modbusBus, MB_FC_READ_HOLDING_REGISTERS, 10);
+        for (uint32_t round = 0; round < BENCH_RETRY_ROUNDS; round++) {
+          for (uint8_t i = 0; i < 3; i++) {
+            RetryOutcome outcome;
+            unsigned long startMs = millis();
+            uint8_t status = retryRead(modbusBus, ids[i], MB_FC_READ_HOLDING_REGISTERS, 0, 10, values, timeoutMs,
+                                       &outcome);
+            if (status == ModbusMaster::ku8MBSuccess) ok[i]++;
+            transactions[i] += outcome.attempts;
+            busMs[i] += millis() - startMs;
+          }
+        }
+        retryPolicy = defaults;
+        char line[200];
+        snprintf(line, sizeof(line), "noisy %lu/%d ok in %lu ms, clean %lu/%d, gone: %lu tries %lu ms; %lu retries, %lu trip(s)",
+                 (unsigned long)ok[0], BENCH_RETRY_ROUNDS, (unsigned long)busMs[0], (unsigned long)ok[1],
+                 BENCH_RETRY_ROUNDS, (unsigned long)transactions[2], (unsigned long)busMs[2],
+                 (unsigned long)retryStats(modbusBus).retries, (unsigned long)retryStats(modbusBus).trips);
+        return String(line);
+      }));
+    }
+  }
+
+  if (wanted(only, "gateway")) {
+    // Modbus TCP clients on loopback sharing one slave through the gateway,
+    // as many real sockets as SCADA clients: one client asking for 2
+    // registers and waiting for each reply, four of them, and three of them
+    // next to a greedy one that pipelines 8 reads of 100 registers. The
+    // clients all read the same registers, so the read cache is off except
+    // in the last load, which shows what it saves them.
+    static const BenchLayout gateway = {"gateway", "1=generic~5"};
+    if (!virtualBusStart(gateway.spec.c_str())) return 1;
+    rtuBegin(modbusBus, 9600, SERIAL_8N1);
+    static const struct {
+      const char* name;
+      uint8_t polite;
+      bool greedy;
+      bool cached;
+    } loads[] = {{"gateway/1 client", 1, false, false}, {"gateway/4 clients", 4, false, false},
+                 {"gateway/3 + greedy", 3, true, false}, {"gateway/4 clients cached", 4, false, true}};
+    bool enabled = cacheSettings.enabled;
+    for (const auto& load : loads) {
+      report(gateway, load.name, timeRun([&] {
+        cacheSettings.enabled = load.cached;
+        cacheClear();
+        gatewayStart(0);
+        std::vector<BenchTcpClient*> clients;
+        for (uint8_t i = 0; i < load.polite + load.greedy; i++) {
+          BenchTcpClient* client = new BenchTcpClient();
+          bool greedy = i == load.polite;
+          client->depth = greedy ? 8 : 1;
+          client->quantity = greedy ? 100 : 2;
+          client->thread = std::thread(benchTcpClient, client, gatewayPort());
+          clients.push_back(client);
+        }
+        unsigned long start = millis();
+        while (millis() - start < BENCH_GATEWAY_MS) {
+          gatewayTick();
+          busDispatch();
+          delay(1);
+        }
+        float seconds = (millis() - start) / 1000.0f;
+        for (BenchTcpClient* client : clients) client->stop = true;
+        for (BenchTcpClient* client : clients) client->thread.join();
+        while (busPending()) busDispatch();
+        const GatewayStats& stats = gatewayStats();
+        gatewayStop();
+
+        // Polite clients together, then the greedy one
+        uint32_t politeReplies = 0, politeMaxUs = 0;
+        uint64_t politeUs = 0;
+        for (uint8_t i = 0; i < load.polite; i++) {
+          politeReplies += clients[i]->replies;
+          politeUs += clients[i]->latencyUs;
+          politeMaxUs = max(politeMaxUs, clients[i]->maxLatencyUs);
+        }
+        char line[240];
+        int length = snprintf(line, sizeof(line),
+                              "%.1f req/s, %lu busy; wait avg %.1f max %.1f ms; 2-reg clients %.1f replies/s, "
+                              "reply avg %.1f max %.1f ms",
+                              stats.requests / seconds, (unsigned long)stats.busy,
+                              stats.forwarded ? stats.waitUs / 1000.0f / stats.forwarded : 0.0f,
+                              stats.maxWaitUs / 1000.0f, politeReplies / seconds,
+                              politeReplies ? politeUs / 1000.0f / politeReplies : 0.0f, politeMaxUs / 1000.0f);
+        if (load.greedy) {
+          const BenchTcpClient& greedy = *clients[load.polite];
+          snprintf(line + length, sizeof(line) - length, "; greedy %lu replies, %lu busy",
+                   (unsigned long)greedy.replies, (unsigned long)greedy.busy);
+        }
+        for (BenchTcpClient* client : clients) delete client;
+        return String(line);
+      }));
+    }
+    cacheSettings.enabled = enabled;
+  }
+
+  if (wanted(only, "cache")) {
+    // One slave read by several consumers: poll points on IR 0-9 every
+    // 250 ms, IR 2-5 every 500 ms and HR 0-9 every second, next to a
+    // dashboard script reading IR 0-9 through the console every 100 ms;
+    // without the read cache and with it. Then the TEC profile analysed
+    // twice in a row, as after detection.
+    static const BenchLayout consumers = {"consumers", "1=generic~5"};
+    if (!virtualBusStart(consumers.spec.c_str())) return 1;
+    rtuBegin(modbusBus, 9600, SERIAL_8N1);
+    auto wireTransactions = [] { return busStatsTotal(0).transactions.load(); };
+    bool enabled = cacheSettings.enabled;
+    for (bool cache : {false, true}) {
+      report(consumers, cache ? "cache/consumers" : "cache/consumers-uncached", timeRun([&] {
+        cacheSettings.enabled = cache;
+        cacheClear();
+        cacheResetStats();
+        busStatsReset();
+        pollClear();
+        pollAddPoint(1, MAP_INPUT_REGISTERS, 0, 10, 250);
+        pollAddPoint(1, MAP_INPUT_REGISTERS, 2, 4, 500);
+        pollAddPoint(1, MAP_HOLDING_REGISTERS, 0, 10, 1000);
+
+        static uint32_t consoleReads;
+        consoleReads = 0;
+        BusRequest request = {};
+        request.slaveId = 1;
+        request.function = MB_FC_READ_INPUT_REGISTERS;
+        request.quantity = 10;
+        request.retry = true;
+        request.maxAgeMs = CACHE_ANY_AGE;
+        request.callback = [](const BusResult& result) {
+          if (result.status == ModbusMaster::ku8MBSuccess) consoleReads++;
+        };
+        uint32_t busyUs = busTaskStats().busyUs;
+        pollStart();
+        unsigned long start = millis(), nextRead = start;
+        while (millis() - start < BENCH_CACHE_MS) {
+          if ((long)(millis() - nextRead) >= 0 && busSubmit(request)) nextRead += 100;
+          pollTick();
+          busDispatch();
+          delay(1);
+        }
+        while (busPending()) busDispatch();
+        PollWindow totals = pollTotals();
+        pollStop();
+        pollClear();
+        busyUs = busTaskStats().busyUs - busyUs;
+
+        char line[200];
+        snprintf(line, sizeof(line), "%lu poll + %lu console reads in %lu transactions, bus %.0f%% busy, "
+                 "%.1f%% without a transaction", (unsigned long)totals.reads, (unsigned long)consoleReads,
+                 (unsigned long)wireTransactions(), busyUs / (BENCH_CACHE_MS * 10.0f), cacheHitRate(modbusBus));
+        return String(line);
+      }));
+    }
+
+    static const BenchLayout tec = {"tec-8e2", "1:8E2=tec"};
+    if (!virtualBusStart(tec.spec.c_str())) return 1;
+    cacheSettings.enabled = true;
+    cacheClear();
+    report(tec, "cache/tec twice", timeRun([&] {
+      rtuBegin(modbusBus, 9600, SERIAL_8E2);
+      uint32_t transactions[2];
+      unsigned long elapsedMs[2];
+      for (uint8_t i = 0; i < 2; i++) {
+        uint32_t before = wireTransactions();
+        unsigned long start = millis();
+        analyzeTECHeatPump(1);
+        elapsedMs[i] = millis() - start;
+        transactions[i] = wireTransactions() - before;
+      }
+      char line[128];
+      snprintf(line, sizeof(line), "first %lu transactions %lu ms, again %lu transactions %lu ms",
+               (unsigned long)transactions[0], elapsedMs[0], (unsigned long)transactions[1], elapsedMs[1]);
+      return String(line);
+    }));
+    cacheSettings.enabled = enabled;
+  }
+
+  if (wanted(only, "identify")) {
+    // Every database device plus three it does not know, one slave each;
+    // expected = profile name, or nullptr for "not identified"
+    static const struct {
+      const char* sim;
+      const char* expected;
+    } devices[] = {
+      {"tec", "TEC QRS11 heat pump"}, {"tecstrict", "TEC QRS11 heat pump"},
+      {"sdm120", "Eastron SDM120 energy meter"}, {"sdm630", "Eastron SDM630 energy meter"},
+      {"ddsu666", "Chint DDSU666 energy meter"}, {"pzem016", "Peacefair PZEM-016 AC meter"},
+      {"pzem017", "Peacefair PZEM-017 DC meter"}, {"xymd02", "XY-MD02 temperature/humidity sensor"},
+      {"r4dcb08", "R4DCB08 temperature module"}, {"relay8", "Waveshare 8-channel relay"},
+      {"ain8", "Waveshare 8-channel analog input"}, {"epever", "Epever Tracer charge controller"},
+      {"growatt", "Growatt inverter"}, {"generic", nullptr}, {"meter", nullptr}, {"sparse", nullptr},
+    };
+    const uint8_t deviceCount = sizeof(devices) / sizeof(devices[0]);
+    std::string spec;
+    for (uint8_t i = 0; i < deviceCount; i++) {
+      spec += (i ? "," : "") + std::to_string(i + 1) + "=" + devices[i].sim + "~5";
+    }
+    static BenchLayout fingerprints = {"fingerprints", ""};
+    fingerprints.spec = spec;
+    if (!virtualBusStart(spec.c_str())) return 1;
+    rtuBegin(modbusBus, 9600, SERIAL_8N1);
+
+    uint32_t totalProbes = 0, maxProbes = 0, wrong = 0;
+    for (uint8_t i = 0; i < deviceCount; i++) {
+      report(fingerprints, (std::string("identify/") + devices[i].sim).c_str(), timeRun([&] {
+        FingerprintResult result;
+        fingerprintIdentify(modbusBus, i + 1, &result);
+        const char* name = result.profile >= 0 ? fingerprintProfile(result.profile).name : nullptr;
+        bool correct = name && devices[i].expected ? strcmp(name, devices[i].expected) == 0 : !name && !devices[i].expected;
+        if (!correct) wrong++;
+        if (devices[i].expected) {
+          totalProbes += result.probes;
+          maxProbes = max(maxProbes, (uint32_t)result.probes);
+        }
+        return String(name ? name : result.noReply ? "no reply" : "unknown") + ", " + String(result.probes) +
+               " reads" + (correct ? "" : ", WRONG");
+      }));
+    }
+    report(fingerprints, "identify/summary", timeRun([&] {
+      char line[160];
+      snprintf(line, sizeof(line), "%u profiles, tree depth %u; known devices %.1f reads avg, %lu max; %lu wrong",
+               fingerprintProfileCount(), fingerprintTreeDepth(), (float)totalProbes / (deviceCount - 3),
+               (unsigned long)maxProbes, (unsigned long)wrong);
+      return String(line);
+    }));
+  }
+
+  for (const BenchLayout& layout : layouts) {
+    if (!virtualBusStart(layout.spec.c_str())) return 1;
+    retryReset();   // Another set of slaves: open circuits belong to the last one
+    cacheClear();
+    uint8_t slaveId = firstSlaveId(layout.spec);
+    uint32_t detectedBaud = MODBUS_BAUD;
+
+    if (wanted(only, "scan")) {
+      report(layout, "scanModbusDevices", timeRun([] {
+        scanModbusDevices();
+        runScan();
+        return String(scanStats().devicesFound) + " device(s)";
+      }));
+    }
+
+    if (wanted(only, "parallel") && rtuBusCount() > 1 && !slaveEntries(layout.spec, 1).empty()) {
+      // Both segments one after the other on their own bus, then together
+      report(layout, "scan/bus 1 then bus 2", timeRun([] {
+        uint16_t found = 0;
+        for (uint8_t bus = 0; bus < 2; bus++) {
+          scanStart(1, 247, 1 << bus);
+          runScan();
+          found += scanStats().devicesFound;
+        }
+        return String(found) + " device(s)";
+      }));
+      report(layout, "scan/both in parallel", timeRun([] {
+        scanStart(1, 247, 0x03);
+        runScan();
+        return String(scanStats().devicesFound) + " device(s) on " + String(scanStats().buses) + " buses";
+      }));
+    }
+
+    if (wanted(only, "baud")) {
+      // Probe sweep alone first, then with listening for traffic (the default)
+      uint16_t listenMs = sweepSettings.listenMs;
+      for (uint16_t listen : {(uint16_t)0, listenMs}) {
+        sweepSettings.listenMs = listen;
+        report(layout, listen ? "autoDetectBaudRate" : "autoDetectBaudRate/sweep", timeRun([&] {
+          uint32_t lineBaud;
+          if (!autoDetectBaudRate(slaveId, &detectedBaud, &lineBaud)) {
+            detectedBaud = lineBaud ? lineBaud : MODBUS_BAUD;
+            return lineBaud ? String("line at ") + String(lineBaud) + " baud, slave silent" : String("not found");
+          }
+          return String(detectedBaud) + " baud";
+        }));
+      }
+      sweepSettings.listenMs = listenMs;
+    }
+
+    if (wanted(only, "config")) {
+      report(layout, "autoDetectSerialConfig", timeRun([&] {
+        bool found = autoDetectSerialConfig(slaveId, detectedBaud);
+        return String(found ? rtuConfigName(modbusBus.config) : "not found");
+      }));
+    }
+
+    if (wanted(only, "detect")) {
+      report(layout, "detectModbusDevice", timeRun([] {
+        detectModbusDevice();
+        return String("done");
+      }));
+    }
+
+    if (wanted(only, "map")) {
+      // The seed grid alone everywhere; the gap sweep down to 16 addresses
+      // costs minutes of bus time per table, so it runs on the sparse map
+      // only, whose HR 4321-4340 lies off the grid
+      for (bool sweep : {false, true}) {
+        if (sweep && layout.name != "sparse-map") continue;
+        report(layout, sweep ? "discoverRegisterMap" : "discoverRegisterMap/grid", timeRun([&] {
+          MapDiscoveryOptions options;
+          MapDiscoveryResult result;
+          mapDefaultOptions(&options);
+          if (!sweep) options.minBlock = 0;
+          rtuBegin(modbusBus, detectedBaud, SERIAL_8N1);
+          discoverRegisterMap(modbusBus, slaveId, options, &result);
+          String ranges;
+          for (uint8_t i = 0; i < result.rangeCount; i++) {
+            ranges += String(i ? " " : "") + mapTableName(result.ranges[i].table) + ":" +
+                      String(result.ranges[i].first) + "-" + String(result.ranges[i].last);
+          }
+          String stop = result.deviceLost ? " (device lost)" : result.cancelled ? " (cancelled)" : "";
+          return String(result.rangeCount) + " range(s) in " + String(result.transactions) + " reads" + stop + ": " +
+                 ranges;
+        }));
+      }
+    }
+
+    if (wanted(only, "tec")) {
+      report(layout, "analyzeTECHeatPump", timeRun([&] {
+        rtuBegin(modbusBus, 9600, SERIAL_8E2);
+        analyzeTECHeatPump(slaveId);
+        return String("TEC profile poll");
+      }));
+    }
+
+    if (wanted(only, "warm")) {
+      // Restart with an empty inventory and run detection, then restart again
+      // with what it stored: boot to first successful read both ways
+      inventoryClear();
+      report(layout, "boot cold + detect", timeRun([] {
+        setup();
+        detectModbusDevice();
+        return String("first read ") + String(inventoryFirstReadMs()) + " ms, " +
+               String(inventoryCount()) + " device(s) stored";
+      }));
+      report(layout, "boot warm", timeRun([] {
+        setup();
+        return String("first read ") + String(inventoryFirstReadMs()) + " ms, " +
+               String(inventoryCount()) + " device(s) verified";
+      }));
+    }
+
+    if (wanted(only, "poll")) {
+      report(layout, "pollScheduler", timeRun([&] {
+        uint32_t baud, config;
+        firstLineSettings(layout.spec, &baud, &config);
+        rtuBegin(modbusBus, baud, config);
+        uint8_t buses = addPollPoints(layout.spec);
+        if (pollPointCount() == 0) return String("no points");
+
+        // One patient read per point first, as a scan would have done, so the
+        // poll timeouts start from the slaves' measured turnaround
+        uint16_t scratch[RTU_MAX_READ_WORDS];
+        for (uint8_t i = 0; i < pollPointCount(); i++) {
+          const PollPoint& point = pollPoints()[i];
+          rtuReadRequest(*rtuBuses[point.bus], point.slaveId, point.table + 1, point.address, point.count,
+                         scratch, sweepSettings.slowTimeoutMs);
+        }
+        float predicted = 0;
+        for (uint8_t bus = 0; bus < rtuBusCount(); bus++) {
+          predicted = max(predicted, pollPredictedUtilisation(*rtuBuses[bus]));
+        }
+        pollStart();
+        unsigned long start = millis();
+        while (millis() - start < BENCH_POLL_MS) {
+          pollTick();
+          busDispatch();
+          delay(1);
+        }
+        while (busPending()) busDispatch();
+        PollWindow totals = pollTotals();
+        pollStop();
+        char line[128];
+        snprintf(line, sizeof(line), "%d points, %lu reads, bus %.0f%% busy (predicted %.0f%%), %lu misses, %lu failures",
+                 pollPointCount(), (unsigned long)totals.reads, totals.busyUs / (BENCH_POLL_MS * 10.0f * buses),
+                 predicted * 100, (unsigned long)totals.misses, (unsigned long)totals.failures);
+        return String(line);
+      }));
+    }
+
+    if (wanted(only, "bus")) {
+      // Back-to-back reads of the first slave: called from loop() one at a
+      // time, then through the bus task with the queue kept full
+      uint32_t baud, config;
+      firstLineSettings(layout.spec, &baud, &config);
+      static uint32_t completed, failures;
+      auto throughput = [](uint32_t reads, uint32_t failed, uint32_t busyUs, unsigned long elapsedMs,
+                           uint32_t longestPassUs) {
+        char line[160];
+        snprintf(line, sizeof(line), "%lu reads, %.0f/s, bus %.0f%% busy, %lu failures, longest loop pass %.1f ms",
+                 (unsigned long)reads, elapsedMs ? reads * 1000.0f / elapsedMs : 0,
+                 elapsedMs ? busyUs / (elapsedMs * 10.0f) : 0, (unsigned long)failed, longestPassUs / 1000.0f);
+        return String(line);
+      };
+
+      report(layout, "rtuReadRequest/direct", timeRun([&] {
+        rtuBegin(modbusBus, baud, config);
+        uint16_t values[RTU_MAX_READ_WORDS];
+        rtuReadRequest(modbusBus, slaveId, MB_FC_READ_INPUT_REGISTERS, 0, 4, values, sweepSettings.slowTimeoutMs);
+        uint32_t busyUs = 0, longestPassUs = 0;
+        failures = 0;
+        unsigned long start = millis();
+        for (uint32_t i = 0; i < BENCH_BUS_READS; i++) {
+          uint32_t startUs = micros();
+          uint8_t status = rtuReadRequest(modbusBus, slaveId, MB_FC_READ_INPUT_REGISTERS, 0, 4, values,
+                                          rtuReadTimeoutMs(modbusBus, MB_FC_READ_INPUT_REGISTERS, 4));
+          busyUs += micros() - startUs;
+          if (status != ModbusMaster::ku8MBSuccess) failures++;
+          delay(1); // The rest of the loop() pass
+          longestPassUs = max(longestPassUs, (uint32_t)(micros() - startUs));
+        }
+        return throughput(BENCH_BUS_READS, failures, busyUs, millis() - start, longestPassUs);
+      }));
+
+      report(layout, "busSubmit/queued", timeRun([&] {
+        rtuBegin(modbusBus, baud, config);
+        uint16_t values[RTU_MAX_READ_WORDS];
+        rtuReadRequest(modbusBus, slaveId, MB_FC_READ_INPUT_REGISTERS, 0, 4, values, sweepSettings.slowTimeoutMs);
+        uint32_t busyStartUs = busTaskStats().busyUs;
+        completed = failures = 0;
+
+        BusRequest request = {};
+        request.slaveId = slaveId;
+        request.function = MB_FC_READ_INPUT_REGISTERS;
+        request.quantity = 4;
+        request.callback = [](const BusResult& result) {
+          completed++;
+          if (result.status != ModbusMaster::ku8MBSuccess) failures++;
+        };
+        uint32_t submitted = 0, longestPassUs = 0;
+        unsigned long start = millis();
+        while (completed < BENCH_BUS_READS) {
+          uint32_t startUs = micros();
+          while (submitted < BENCH_BUS_READS && busSubmit(request)) submitted++;
+          busDispatch();
+          delay(1);
+          longestPassUs = max(longestPassUs, (uint32_t)(micros() - startUs));
+        }
+        return throughput(completed, failures, busTaskStats().busyUs - busyStartUs, millis() - start,
+                          longestPassUs);
+      }));
+    }
+
+    if (wanted(only, "stream")) {
+      // Console bytes for one 100 register read (menu option 5) as text and
+      // as a binary record; the rest of the output is the same in both
+      uint32_t baud, config;
+      firstLineSettings(layout.spec, &baud, &config);
+      report(layout, "readHoldingRegisters/out", timeRun([&] {
+        rtuBegin(modbusBus, baud, config);
+        modbus.begin(slaveId, Serial1);
+        uint32_t bytes[2];
+        for (StreamMode mode : {STREAM_TEXT, STREAM_BINARY}) {
+          streamSetMode(mode);
+          streamResetStats();
+          uint32_t before = Serial.bytesWritten();
+          readHoldingRegisters(slaveId, 0, 100);
+          bytes[mode] = Serial.bytesWritten() - before;
+        }
+        streamSetMode(STREAM_TEXT);
+        if (streamStats().records == 0) return String("read failed");
+        char line[160];
+        snprintf(line, sizeof(line), "text %lu bytes, binary %lu bytes (record %lu), %.1fx less; %.1f vs %.1f ms at 115200",
+                 (unsigned long)bytes[0], (unsigned long)bytes[1], (unsigned long)streamStats().bytes,
+                 (float)bytes[0] / bytes[1], bytes[0] * 10 / 115.2f, bytes[1] * 10 / 115.2f);
+        return String(line);
+      }));
+    }
+
+    if (wanted(only, "dump") && !slaveEntries(layout.spec).empty()) {
+      // HR 0-99 of the first slave in protocol-size chunks, then one
+      // register per read for comparison
+      uint32_t baud, config;
+      firstLineSettings(layout.spec, &baud, &config);
+      float rates[2];
+      for (uint16_t maxChunk : {(uint16_t)0, (uint16_t)1}) {
+        report(layout, maxChunk ? "dump/one per read" : "dump/chunked", timeRun([&] {
+          rtuBegin(modbusBus, baud, config);
+          dumpStart(slaveId, MAP_HOLDING_REGISTERS, 0, 99, 0, maxChunk);
+          runDump();
+          const DumpStats& dump = dumpStats();
+          rates[maxChunk] = dumpValuesPerSecond(dump);
+          char line[160];
+          int length = snprintf(line, sizeof(line), "%lu registers, %lu reads, %lu missing, %.1f registers/s%s",
+                                (unsigned long)dump.values, (unsigned long)dump.transactions,
+                                (unsigned long)dump.missing, rates[maxChunk], dump.deviceLost ? ", device lost" : "");
+          if (maxChunk && rates[1] > 0) snprintf(line + length, sizeof(line) - length, ", chunked %.1fx", rates[0] / rates[1]);
+          return String(line);
+        }));
+      }
+    }
+
+    if (wanted(only, "led")) {
+      // LED work during a full scan: status posts from the scan path, renderer
+      // wake-ups and the show() calls that reached the strip; then the cost
+      // of one post on the host
+      report(layout, "scan/led", timeRun([] {
+        ledResetStats();
+        scanModbusDevices();
+        runScan();
+        LedStats led = ledStats();
+        auto wallStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < 10000; i++) ledFlash(LED_SUCCESS, 100);
+        double postNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - wallStart).count() / 10000;
+        char line[160];
+        snprintf(line, sizeof(line), "%lu posts, %lu frames, %lu shows, %.0f ns/post",
+                 (unsigned long)led.posts, (unsigned long)led.frames, (unsigned long)led.shows, postNs);
+        return String(line);
+      }));
+    }
+
+    if (wanted(only, "latency")) {
+      // HR 0-9 of the first slave through ModbusMaster, the polled RTU path
+      // and RX event framing. Frame-end latency is the transaction time less
+      // request and reply on the wire and the slave's turnaround, i.e. how
+      // long after its last byte the reply was taken as complete.
+      uint32_t baud, config;
+      firstLineSettings(layout.spec, &baud, &config);
+      bool eventFraming = modbusBus.eventFraming;
+      enum { PATH_MODBUSMASTER, PATH_POLLED, PATH_EVENTS };
+      static const char* names[] = {"ModbusMaster/polled", "rtuReadRequest/polled", "rtuReadRequest/events"};
+
+      for (int path : {PATH_MODBUSMASTER, PATH_POLLED, PATH_EVENTS}) {
+        report(layout, names[path], timeRun([&] {
+          // The polled path sees each byte as it lands, so its warm-up read
+          // measures the turnaround exactly
+          rtuSetEventFraming(modbusBus, false);
+          rtuBegin(modbusBus, baud, config);
+          uint16_t values[RTU_MAX_READ_WORDS];
+          rtuReadRequest(modbusBus, slaveId, MB_FC_READ_HOLDING_REGISTERS, 0, 10, values, sweepSettings.slowTimeoutMs);
+          rtuSetEventFraming(modbusBus, path == PATH_EVENTS);
+          uint32_t wireUs = (8 + 5 + 20) * rtuCharTimeUs(modbusBus) + modbusBus.turnaroundUs;
+          modbus.begin(slaveId, Serial1);
+          modbus.idle(countModbusMasterWakeup);
+
+          uint32_t totalUs = 0, latencyTotalUs = 0, latencyMaxUs = 0, wakeups = 0, failures = 0;
+          for (uint32_t i = 0; i < BENCH_LATENCY_READS; i++) {
+            modbusMasterWakeups = 0;
+            uint32_t startUs = micros();
+            uint8_t status = path == PATH_MODBUSMASTER
+                ? modbus.readHoldingRegisters(0, 10)
+                : rtuReadRequest(modbusBus, slaveId, MB_FC_READ_HOLDING_REGISTERS, 0, 10, values,
+                                 rtuReadTimeoutMs(modbusBus, MB_FC_READ_HOLDING_REGISTERS, 10));
+            uint32_t durationUs = micros() - startUs;
+            wakeups += path == PATH_MODBUSMASTER ? modbusMasterWakeups : modbusBus.lastWakeups;
+            if (status != ModbusMaster::ku8MBSuccess) {
+              failures++;
+              rtuDrain(modbusBus, sweepSettings.slowTimeoutMs);
+              continue;
+            }
+            uint32_t latencyUs = durationUs > wireUs ? durationUs - wireUs : 0;
+            totalUs += durationUs;
+            latencyTotalUs += latencyUs;
+            latencyMaxUs = max(latencyMaxUs, latencyUs);
+          }
+          modbus.idle(yield);
+          rtuSetEventFraming(modbusBus, eventFraming);
+
+          uint32_t ok = BENCH_LATENCY_READS - failures;
+          char line[160];
+          snprintf(line, sizeof(line), "%.2f ms/read, frame end +%.2f ms avg (max %.2f), %.0f wake-ups/read, %lu failures",
+                   ok ? totalUs / 1000.0f / ok : 0, ok ? latencyTotalUs / 1000.0f / ok : 0,
+                   latencyMaxUs / 1000.0f, (float)wakeups / BENCH_LATENCY_READS, (unsigned long)failures);
+          return String(line);
+        }));
+      }
+    }
+  }
+
+  virtualBusStop();
+  return 0;
+}
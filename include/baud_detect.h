@@ -0,0 +1,29 @@
+#ifndef BAUD_DETECT_H
+#define BAUD_DETECT_H
+
+#include <Arduino.h>
+
+// Baud rate detection from traffic already on the bus (another master and
+// its slaves). The RX pin's edges are timestamped in hardware while the
+// UART keeps receiving; the shortest low and high levels are one bit time.
+// Nothing is transmitted, and no baud rate has to be tried.
+
+#define BAUD_MIN_EDGES 40            // About one short frame before a result counts
+#define BAUD_ENOUGH_EDGES 120        // Stop listening early: about one request and reply
+#define BAUD_TOLERANCE_PCT 5         // Distance to a standard rate that still snaps to it
+
+struct BaudMeasurement {
+  uint32_t edges;             // Edges seen on RX
+  uint32_t lowPulseNs;        // Shortest low level (0 = none)
+  uint32_t highPulseNs;       // Shortest high level between two low ones (0 = none)
+  uint32_t bitTimeNs;         // Estimated bit time
+  uint32_t measuredBaud;      // 1 / bit time, 0 while the line stayed silent
+  uint32_t baud;              // Nearest standard rate, 0 if none is close enough
+  unsigned long elapsedMs;    // Time spent listening
+};
+
+// Listen for up to listenMs; returns true when the traffic gave a standard baud rate
+bool baudMeasureFromTraffic(uint16_t listenMs, BaudMeasurement* measurement);
+uint32_t baudNearestStandard(uint32_t measuredBaud);
+
+#endif // BAUD_DETECT_H
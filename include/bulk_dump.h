@@ -0,0 +1,62 @@
+#ifndef BULK_DUMP_H
+#define BULK_DUMP_H
+
+#include <Arduino.h>
+#include "modbus_rtu.h"
+#include "register_map.h"
+
+// Bulk dump of an address range, up to the whole 0-65535 space of one
+// table. Reads go through the bus task in chunks of up to the protocol
+// maximum (125 registers, 2000 bits), past ModbusMaster's 64-word buffer,
+// and every chunk is printed (or streamed as a binary record) as soon as it
+// arrives. dumpTick() keeps one read in flight from loop().
+//
+// Chunks adapt to the device: an exception halves the chunk and retries
+// the same start, down to a single address that is then reported missing;
+// every successful read doubles the chunk again. A run of timeouts halves
+// it too, and a single address that keeps timing out (or a device that
+// never answered) ends the dump. Illegal Function means the device has no
+// such table. Every missing address costs one short exception round trip,
+// so a sparse table is best dumped over the ranges map discovery found.
+
+#define DUMP_MAX_RETRIES 2            // Timeouts per chunk before it is halved
+#define DUMP_VALUES_PER_LINE 10       // Registers per text line (bits: 4x as many)
+#define DUMP_MODBUSMASTER_WORDS 64    // ModbusMaster's response buffer; larger reads go to a dump
+
+struct DumpStats {
+  uint8_t bus;                // Index into rtuBuses
+  uint8_t slaveId;
+  uint8_t table;              // MapTable
+  uint16_t first;
+  uint16_t last;
+  uint32_t next;              // Next address to read (last + 1 when done)
+  uint16_t chunk;             // Current chunk size
+  uint16_t maxChunk;
+  uint32_t values;            // Registers or bits read
+  uint32_t transactions;
+  uint32_t exceptions;        // Chunks halved after an exception
+  uint32_t missing;           // Addresses the device does not have
+  uint32_t timeouts;
+  uint32_t busyUs;            // Bus time of all transactions
+  unsigned long startMs;
+  unsigned long elapsedMs;
+  bool cancelled;
+  bool deviceLost;            // A single address kept timing out
+  bool unsupported;           // Illegal Function: the device has no such table
+};
+
+typedef void (*DumpFinishHandler)(const DumpStats& stats);
+
+// maxChunk 0 = protocol maximum for the table; 1 reads one address per transaction
+bool dumpStart(uint8_t slaveId, uint8_t table, uint16_t first, uint16_t last, uint8_t bus = 0,
+               uint16_t maxChunk = 0);
+void dumpTick();
+void dumpCancel();
+bool dumpActive();
+const DumpStats& dumpStats();
+float dumpValuesPerSecond(const DumpStats& stats);
+float dumpSingleReadEstimate(const RtuBus& bus);   // Values/s reading one address per transaction
+void dumpSetFinishHandler(DumpFinishHandler handler);
+bool dumpHandleCommand(const String& input);
+
+#endif // BULK_DUMP_H
@@ -0,0 +1,61 @@
+#ifndef BUS_SNIFFER_H
+#define BUS_SNIFFER_H
+
+#include <Arduino.h>
+
+// Listen-only discovery: reads the bus raw, splits RTU frames on the t3.5
+// silent interval, validates CRC and pairs requests from another master
+// with the slave replies. Nothing is ever transmitted.
+
+#define SNIFFER_MAX_SLAVES 32        // Distinct slave IDs tracked
+#define SNIFFER_MAX_RANGES 8         // Address ranges kept per table per slave
+#define SNIFFER_BUFFER_SIZE 512      // Raw bytes buffered until the line goes idle
+
+// Tables addressed by the standard read/write function codes
+enum SnifferTable {
+  SNIFF_COILS,
+  SNIFF_DISCRETE_INPUTS,
+  SNIFF_HOLDING_REGISTERS,
+  SNIFF_INPUT_REGISTERS,
+  SNIFF_TABLE_COUNT
+};
+
+struct SnifferRange {
+  uint16_t first;
+  uint16_t last;
+};
+
+struct SnifferSlave {
+  uint8_t slaveId;
+  uint16_t requests;          // Requests addressed to this slave
+  uint16_t responses;         // Normal replies
+  uint16_t exceptions;        // Exception replies
+  uint16_t unanswered;        // Requests that got no reply
+  uint32_t functionMask;      // Bit n set when FC n was seen (FC < 32)
+  uint8_t rangeCount[SNIFF_TABLE_COUNT];
+  SnifferRange ranges[SNIFF_TABLE_COUNT][SNIFFER_MAX_RANGES];
+};
+
+struct SnifferStats {
+  uint32_t frames;            // Frames with a valid CRC
+  uint32_t crcErrors;         // Bytes dropped while resynchronising
+  uint32_t broadcasts;        // Requests to slave ID 0
+  uint32_t unmatched;         // Replies without a matching request
+  uint32_t bytes;             // Raw bytes received
+  unsigned long startMs;
+  unsigned long cycleMs;      // Master poll cycle, 0 until it repeats
+};
+
+void snifferStart();
+void snifferStop();
+void snifferTick();
+bool snifferActive();
+void snifferPrintMap();
+const SnifferStats& snifferStats();
+const SnifferSlave* snifferSlaves(uint8_t* count);
+
+// Console controls while sniffing: t = table, r = reset, q = stop.
+// Returns true if the line was consumed by the sniffer.
+bool snifferHandleCommand(const String& input);
+
+#endif // BUS_SNIFFER_H
@@ -0,0 +1,72 @@
+#ifndef BUS_STATS_H
+#define BUS_STATS_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "modbus_rtu.h"
+
+// Transaction statistics per bus and per slave/function code, recorded by
+// rtuReadRequest() around every transaction it makes. The scan, polling,
+// dump and gateway paths all go through it; the menu's ModbusMaster reads
+// are timed the same way in main.cpp.
+//
+// Recording happens with the bus lock held, so each bus has exactly one
+// writer at a time. The counters are atomics that are only ever loaded and
+// stored (the ESP32-C3 has no atomic read-modify-write instructions), so
+// the recorder never waits and a reader on another task sees whole values.
+// A reader may see one transaction's fields half updated; the printout is
+// a snapshot, not a transaction.
+//
+// Latency is the whole transaction, request out to reply checked. Replies
+// (data or exception) go into a log-linear histogram with four buckets per
+// doubling from 256 us on, which gives p50/p95/p99 within about 10%.
+// Timeouts and broken replies only say how long we waited, they are counted
+// but stay out of the histogram.
+//
+// A slave gets its own entries once it has replied, so sweeping 247 silent
+// IDs does not fill the table; their timeouts show in the bus totals only.
+
+#define BUS_STATS_MAX_ENTRIES 16      // Slave/function pairs per bus
+#define BUS_STATS_MIN_SHIFT 8         // First bucket holds everything below 256 us
+#define BUS_STATS_SUB_SHIFT 2         // 4 buckets per doubling of the latency
+#define BUS_STATS_OCTAVES 13          // 256 us .. 2 s, above that the last bucket
+#define BUS_STATS_BUCKETS (1 + (BUS_STATS_OCTAVES << BUS_STATS_SUB_SHIFT))
+
+typedef std::atomic<uint32_t> BusStatsCounter;
+
+struct BusStatsEntry {
+  std::atomic<bool> used;     // Published after slaveId and function are set
+  uint8_t slaveId;            // 0 for the bus totals
+  uint8_t function;
+  BusStatsCounter transactions;
+  BusStatsCounter ok;
+  BusStatsCounter timeouts;
+  BusStatsCounter crcErrors;  // CRC, framing and late replies
+  BusStatsCounter exceptions; // Modbus exception replies
+  BusStatsCounter other;      // Wrong slave or function in the reply
+  BusStatsCounter txBytes;
+  BusStatsCounter rxBytes;
+  BusStatsCounter maxLatencyUs;
+  BusStatsCounter turnaroundUs;     // Running average of the slave's turnaround
+  BusStatsCounter buckets[BUS_STATS_BUCKETS];
+};
+
+// Call with the bus lock held; turnaroundUs 0 = not measured
+void busStatsRecord(const RtuBus& bus, uint8_t slaveId, uint8_t function, uint8_t result,
+                    uint32_t latencyUs, uint16_t txBytes, uint16_t rxBytes, uint32_t turnaroundUs);
+
+// Slave/function entries of a bus in the order they first replied,
+// nullptr past the last one; the totals have slaveId 0
+const BusStatsEntry* busStatsEntry(uint8_t bus, uint8_t index);
+const BusStatsEntry& busStatsTotal(uint8_t bus);
+
+// Latency below which `fraction` of the replies fell, 0 without replies
+uint32_t busStatsQuantileUs(const BusStatsEntry& entry, float fraction);
+uint32_t busStatsReplies(const BusStatsEntry& entry);
+
+// Takes each bus lock in turn, so it waits for a running transaction
+void busStatsReset();
+
+void busStatsPrint();
+
+#endif // BUS_STATS_H
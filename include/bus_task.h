@@ -0,0 +1,73 @@
+#ifndef BUS_TASK_H
+#define BUS_TASK_H
+
+#include <Arduino.h>
+#include "modbus_rtu.h"
+
+// Bus I/O in its own FreeRTOS task. Requests go in through a queue and the
+// task runs them back to back at line rate, blocking only on the UART;
+// completed results come back through a second queue and busDispatch()
+// hands them to their callbacks in the loop() task. The console, LED and
+// any uplink never wait on the wire.
+//
+// Code that still calls the rtu* functions directly (menu options)
+// shares the bus safely: every transaction holds the bus lock.
+//
+// Each bus gets its own task and request queue, so two segments run their
+// transactions at the same time; results of all buses share one queue.
+//
+// A request with maxAgeMs set may be answered by the read cache or merged
+// with a queued read that covers it; its result then comes back the same
+// way, with cached set and no time on the wire.
+
+#define BUS_QUEUE_LENGTH 8
+#define BUS_TASK_PRIORITY 2          // Above loop() (1), so queued work goes out first
+#define BUS_TASK_STACK 4096
+
+struct BusResult;
+typedef void (*BusCallback)(const BusResult& result);
+
+struct BusRequest {
+  RtuBus* bus;                // nullptr = modbusBus
+  uint8_t slaveId;
+  uint8_t function;           // MB_FC_READ_xxx
+  uint16_t address;
+  uint16_t quantity;
+  uint16_t timeoutMs;         // 0 = rtuReadTimeoutMs() for this read
+  bool keepLate;              // No drain after a timeout; a late reply shows up as straySlave of the next
+  bool retry;                 // Under the retry policy and circuit breaker (retry_policy.h)
+  uint32_t maxAgeMs;          // Cached values this young will do (read_cache.h), 0 = always the bus
+  uint32_t tag;               // Caller's reference, returned unchanged
+  BusCallback callback;       // Runs in the loop() task from busDispatch()
+};
+
+struct BusResult {
+  BusRequest request;
+  uint8_t status;             // ku8MB* result code
+  uint32_t durationUs;        // Request sent to reply complete (or timeout)
+  unsigned long completedMs;
+  uint16_t rxBytes;           // Bytes received, also on a timeout
+  uint8_t straySlave;         // Slave ID of a valid frame that was not ours (0 = none)
+  bool cached;                // From the read cache or another request's reply, no transaction
+  uint16_t values[RTU_MAX_READ_WORDS];  // Bits packed 16 per word
+};
+
+struct BusTaskStats {
+  uint32_t submitted;
+  uint32_t completed;
+  uint32_t rejected;          // Queue full
+  uint32_t busyUs;            // Time spent in transactions
+  uint8_t maxQueued;          // Deepest the request queue has been
+};
+
+bool busTaskStart(RtuBus& bus);              // Once per bus
+bool busTaskRunning();
+bool busTaskRunning(const RtuBus& bus);
+bool busSubmit(const BusRequest& request);   // Never blocks; false when the queue is full
+uint8_t busPending();                        // Submitted and not dispatched yet, all buses
+uint8_t busPending(const RtuBus& bus);
+uint8_t busDispatch();                       // Run callbacks of completed requests; returns how many
+const BusTaskStats& busTaskStats(const RtuBus& bus = modbusBus);
+void busTaskPrintStats();
+
+#endif // BUS_TASK_H
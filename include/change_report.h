@@ -0,0 +1,56 @@
+#ifndef CHANGE_REPORT_H
+#define CHANGE_REPORT_H
+
+#include <Arduino.h>
+#include "poll_scheduler.h"
+#include "stream_output.h"
+
+// Change-only reporting for polled values. The stage keeps the last
+// reported value of every register and bit of the poll points. A read
+// then only reports the values that moved further than the point's
+// deadband from that value. Bits report any change. Measuring from the
+// last *reported* value means a slow drift is still reported once it
+// adds up to the deadband.
+//
+// A point's deadband is absolute (raw register counts) or a percentage
+// of the last reported value, taken as unsigned; use an absolute deadband
+// for signed registers. Deadband 0 reports every change.
+//
+// The first read after polling starts (or change reporting is switched
+// on) and the first read after each snapshot interval report the whole
+// point, so a host that joins late, or has lost a record, catches up.
+//
+// Text output prints one line per read with changes. Binary output sends a
+// record per run of changed registers; runs are merged when the gap costs
+// less than another record header. A bit point is sent whole.
+
+#define CHANGE_MAX_VALUES 1024        // Last reported registers, plus bits packed 16 per word, over all points
+#define CHANGE_SNAPSHOT_MS 60000      // Default interval of the full report per point, 0 = none
+#define CHANGE_MERGE_GAP ((STREAM_HEADER_BYTES + 2) / 2)   // Unchanged registers sent rather than a new record
+
+struct ChangeStats {
+  uint32_t reads;
+  uint32_t valuesRead;        // Registers or bits that came in
+  uint32_t valuesReported;    // ... and that went out
+  uint32_t snapshots;         // Reads reported whole
+  uint32_t untracked;         // Reads of points that did not fit CHANGE_MAX_VALUES, reported whole
+};
+
+void changeSetEnabled(bool enabled);
+bool changeEnabled();
+void changeSetSnapshotMs(uint32_t snapshotMs);
+uint32_t changeSnapshotMs();
+
+// "5" = absolute, "2%" = percent; false for anything else
+bool changeParseDeadband(const char* text, uint16_t* deadband, bool* percent);
+
+// Lays out the value store for the points; pollStart() calls it
+void changeBegin(const PollPoint* points, uint8_t count);
+
+// Reports what changed in a successful read of point `index`
+void changeReport(uint8_t index, const PollPoint& point, const uint16_t* values);
+
+const ChangeStats& changeStats();
+void changePrintStats();
+
+#endif // CHANGE_REPORT_H
@@ -0,0 +1,62 @@
+#ifndef COMMAND_LINE_H
+#define COMMAND_LINE_H
+
+#include <Arduino.h>
+
+// Scriptable one-line commands next to the interactive menu. Console input
+// is collected without blocking; a complete line that starts with a
+// command word runs at once, anything else goes to the menu as before.
+// A host can send commands back to back: reads go to the bus task, and
+// when its queue is full the line waits (and input stops being read) until
+// there is room again.
+//
+// Grammar (an optional "#<id>" first token is echoed in every reply):
+//   read <co|di|hr|ir> <slave> <address> <count> [bus]
+//   scan [<first>-<last>] [fast|slow] [retry|noretry]
+//   dump <co|di|hr|ir> <slave> [<first>-<last>] [bus]     (whole table without a range)
+//   poll add <slave> <co|di|hr|ir> <address> <count> <period ms> [bus]
+//   poll clear | poll start | poll stop | poll stats
+//   poll deadband <point> <value>[%]                       (change_report.h)
+//   poll changes on|off [snapshot s]
+//   history [list] | history raw|rollup <series> [seconds]     (history.h)
+//   history flash <block> | history spill on|off | history clear
+//   stats [reset]                                          (bus_stats.h)
+//   retry [attempts <n>] [timeouts <n>] [backoff <ms>] [breaker <failures>|off]
+//   retry reset                                            (retry_policy.h)
+//   gateway [start [port] [bus]] | gateway stop | gateway reset     (tcp_gateway.h)
+//   gateway wifi <ssid> [password]
+//   cache [on|off|clear|reset] | cache default <ms>        (read_cache.h)
+//   cache ttl <co|di|hr|ir> <slave> <first>[-<last>] <ms> [bus] | cache ttl clear
+//   baud <rate> [8N1|8E1|...]
+//   output text|binary
+//   status
+//   help
+//
+// Replies are single lines starting with "> ", so a script can pick them
+// out of the menu text:
+//   > ok <id> <command> [details]
+//   > data <id> <table> <slave> <address>: <values>
+//   > data <id> hist <series> raw|rollup: <samples>          (history.h line format)
+//   > data <id> stats <bus> <slave> <fc>|all: <count> <ok> <timeouts> <crc> <exceptions> <other>
+//                     <p50 us> <p95 us> <p99 us> <max us>
+//   > data <id> retry <bus>: <calls> <retries> <recovered> <failed> <no budget> <refused> <trips>
+//   > data <id> gateway: <clients> <requests> <replies> <exceptions> <busy> <no reply> <rejected>
+//                        <requests/s> <avg wait us> <max wait us>
+//   > data <id> cache <bus>: <hits> <larger block> <merged> <misses> <stored> <evicted> <hit %>
+//   > err <id> <message>
+//   > done <id> scan <found> <probes> <ms>     (when a scan started by a command ends)
+//   > done <id> dump <values> <reads> <ms> <values/s> [cancelled|lost|unsupported]
+// <id> is "-" for a command without one. In binary output mode read data
+// goes out as a record (stream_output.h) before the "ok" line. A read
+// answered by the read cache ends its "ok" line with "cached".
+
+#define COMMAND_MAX_LINE 128
+#define COMMAND_MAX_ID 15
+
+// Next complete console line, or false if none is complete yet; never blocks
+bool commandReadLine(String& line);
+
+// Run the line if it is a command; false leaves it to the menu
+bool commandHandle(const String& line);
+
+#endif // COMMAND_LINE_H
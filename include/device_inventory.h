@@ -0,0 +1,37 @@
+#ifndef DEVICE_INVENTORY_H
+#define DEVICE_INVENTORY_H
+
+#include <Arduino.h>
+#include "modbus_rtu.h"
+
+// Devices found by detection and scans, kept in NVS so a restart can skip
+// the rediscovery: at boot every known device gets one probe at its own
+// line settings, and only a device that no longer answers sends us back
+// to full detection.
+
+#define INVENTORY_MAX_DEVICES 32
+#define INVENTORY_VERSION 1
+
+#define INVENTORY_FLAG_TEC 0x01      // Answered the TEC QRS11 heat pump checks
+
+// One device in 6 bytes
+struct __attribute__((packed)) InventoryRecord {
+  uint8_t slaveId;
+  uint8_t format;             // SERIAL_xxx data/parity/stop bits (low byte)
+  uint16_t baud100;           // Baud rate / 100
+  uint8_t turnaroundMs;       // Measured turnaround, rounded up (255 = 255 ms or more)
+  uint8_t flags;              // INVENTORY_FLAG_xxx
+};
+
+void inventoryBegin();              // Call first thing in setup(): starts the boot clock and loads NVS
+bool inventoryWarmStart(RtuBus& bus);
+void inventoryRemember(uint8_t slaveId, const RtuBus& bus, uint8_t flags = 0);
+void inventoryClear();
+uint8_t inventoryCount();
+const InventoryRecord* inventoryRecords();
+uint32_t inventoryBaud(const InventoryRecord& record);
+uint32_t inventoryConfig(const InventoryRecord& record);
+unsigned long inventoryFirstReadMs(); // Boot to the first device that answered, 0 until then
+void inventoryPrint();
+
+#endif // DEVICE_INVENTORY_H
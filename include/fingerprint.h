@@ -0,0 +1,62 @@
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <Arduino.h>
+#include "modbus_rtu.h"
+#include "register_map.h"
+
+// Device identification from a table of fingerprints. Every profile lists
+// what a few single-address reads return on that device: a value range,
+// or an exception for an address it does not have, and the tables it has
+// none of. An address a profile does not list may answer either way.
+//
+// fingerprintBegin() compiles the table into a decision tree. Each node
+// reads the address that leaves the fewest candidates in its worst branch
+// (ties: the fewest over all branches), and the answer picks the branch.
+// A device is only named after FINGERPRINT_MIN_PROBES reads agreed with
+// it; an answer no remaining profile expects means an unknown device.
+//
+// Register expectations follow the vendors' published maps as far as the
+// identification needs them. Add a device by adding a profile.
+
+#define FINGERPRINT_MIN_PROBES 3
+#define FINGERPRINT_MAX_PROFILES 16     // Candidates are a bit mask; also sizes the compile scratch
+#define FINGERPRINT_MAX_PROBES 64       // Distinct addresses over all profiles
+#define FINGERPRINT_MAX_NODES 96
+#define FINGERPRINT_MAX_EDGES 192
+#define FINGERPRINT_MAX_DEPTH 8
+
+// Expectation min > max: the address answers with an exception
+#define FINGERPRINT_ABSENT 1, 0
+
+struct FingerprintCheck {
+  uint8_t table;              // MapTable
+  uint16_t address;
+  uint16_t min;               // Register value, or 0/1 for a bit
+  uint16_t max;
+};
+
+struct FingerprintProfile {
+  const char* name;
+  uint8_t inventoryFlags;     // INVENTORY_FLAG_xxx to remember with the device
+  uint8_t absentTables;       // Bit per MapTable the device does not implement
+  const FingerprintCheck* checks;
+  uint8_t checkCount;
+};
+
+struct FingerprintResult {
+  int8_t profile;             // Index of the identified profile, -1 = none
+  uint32_t candidates;        // Profiles still possible at the end (0 = unknown device)
+  uint8_t probes;             // Transactions used
+  bool noReply;               // A probe got no valid reply, identification abandoned
+  unsigned long elapsedMs;
+};
+
+void fingerprintBegin();      // Compiles the tree; fingerprintIdentify() calls it when needed
+bool fingerprintIdentify(RtuBus& bus, uint8_t slaveId, FingerprintResult* result);
+uint8_t fingerprintProfileCount();
+const FingerprintProfile& fingerprintProfile(uint8_t index);
+uint8_t fingerprintTreeDepth();     // Most reads any known device takes
+void fingerprintPrintResult(const FingerprintResult& result);
+
+#endif // FINGERPRINT_H
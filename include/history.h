@@ -0,0 +1,93 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <Arduino.h>
+#include "poll_scheduler.h"
+
+// Recent history of polled values in RAM, for commissioning and fault
+// hunting without a PC attached. Every polled register or bit gets a
+// series when polling starts, in point order, until HISTORY_MAX_SERIES run
+// out. Restarting the same points keeps what was recorded.
+//
+// Each series has two fixed rings, all static, nothing allocated:
+//   raw     the last HISTORY_RAW_SAMPLES reads with their time, 6 bytes
+//           each (4 minutes at 1 s polling)
+//   rollup  min/max/avg of every HISTORY_BUCKET_MS, 8 bytes a bucket
+//           (HISTORY_BUCKETS = 4 hours of minutes)
+// Values are taken as unsigned; a minute without reads is an empty bucket.
+//
+// With flash spill on, a full rollup ring writes its oldest
+// HISTORY_SPILL_BUCKETS to NVS as one block instead of dropping them. The
+// blocks form a ring of HISTORY_SPILL_BLOCKS shared by all series, tagged
+// with the boot they were recorded in, so they can be read after a restart.
+
+#ifndef HISTORY_MAX_SERIES
+#define HISTORY_MAX_SERIES 16
+#endif
+#define HISTORY_RAW_SAMPLES 240
+#define HISTORY_BUCKET_MS 60000UL
+#define HISTORY_BUCKETS 240
+#define HISTORY_SPILL_BUCKETS 60      // One hour per flash block
+#define HISTORY_SPILL_BLOCKS 8        // About 4 KB of NVS
+#define HISTORY_LINE_VALUES 10        // Samples per output line
+
+struct HistoryBucket {
+  uint16_t min;
+  uint16_t max;
+  uint16_t avg;
+  uint16_t count;             // Reads in the bucket, 0 = none
+};
+
+struct HistorySeries {
+  uint8_t point;              // Poll point and value within it
+  uint16_t offset;
+  uint8_t bus;
+  uint8_t slaveId;
+  uint8_t table;              // MapTable
+  uint16_t address;
+  uint32_t periodMs;
+  uint32_t samples;           // Reads recorded since the series started
+
+  uint16_t rawNext;           // Raw ring: next slot to write, samples held
+  uint16_t rawCount;
+  uint16_t bucketNext;        // Rollup ring
+  uint16_t bucketCount;
+  bool bucketOpen;
+  unsigned long bucketStartMs;      // The bucket being filled
+  HistoryBucket open;               // Its min/max and read count so far
+  uint32_t openSum;
+};
+
+// One NVS block, as listed by historyFlashBlock()
+struct HistoryFlashInfo {
+  uint8_t slaveId;
+  uint8_t table;
+  uint16_t address;
+  uint16_t boot;              // Boot counter when it was written
+  uint32_t firstStartMs;      // Start of its first bucket, millis() of that boot
+  uint8_t count;
+};
+
+void historyBegin(const PollPoint* points, uint8_t count);  // pollStart() calls it
+void historySample(const PollPoint& point, const uint16_t* values);   // Every successful poll read
+
+uint8_t historySeriesCount();
+const HistorySeries& historySeries(uint8_t index);
+void historyClear();
+
+void historySetSpill(bool enabled);
+bool historySpill();
+bool historyFlashBlock(uint8_t block, HistoryFlashInfo* info);
+
+// Stream a window to `out` in lines of HISTORY_LINE_VALUES, each starting
+// with `prefix`. Raw: "<age s>=<value>", rollup: "<age s>=<min>/<avg>/<max>"
+// with the age of the bucket start, oldest first; windowS = 0 is all.
+// Returns the samples or buckets written.
+uint16_t historyStreamRaw(Print& out, const char* prefix, uint8_t series, uint32_t windowS);
+uint16_t historyStreamRollup(Print& out, const char* prefix, uint8_t series, uint32_t windowS);
+uint16_t historyStreamFlash(Print& out, const char* prefix, uint8_t block);
+
+// Series with retention and memory per hour, and the flash blocks
+void historyPrint();
+
+#endif // HISTORY_H
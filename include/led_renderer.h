@@ -0,0 +1,39 @@
+#ifndef LED_RENDERER_H
+#define LED_RENDERER_H
+
+#include <Arduino.h>
+#include "scanner.h"
+
+// The status LED is drawn by its own FreeRTOS task. setLEDStatus() and
+// ledFlash() only record the wanted state and post a copy to a one-slot
+// mailbox (xQueueOverwrite, never blocks), so the scan and poll paths pay
+// a few hundred nanoseconds per change instead of a show() on the wire.
+//
+// The task wakes on a post, or every LED_FRAME_MS while an animation is
+// running, and sleeps indefinitely on a static colour. Breathing curves
+// come from a 256-entry sine table indexed by animation phase, and
+// FastLED.show() is only called when the colour actually changed.
+//
+// Post from the loop() task; the state is not guarded against two posters.
+
+#define LED_FRAME_MS 20              // 50 frames/s while animating
+#define LED_TASK_PRIORITY 1          // Same as loop(), below the bus tasks
+#define LED_TASK_STACK 2048
+
+#define LED_SCANNING_PERIOD_MS 1257  // Breathing periods (2 pi x 200/300/150 ms)
+#define LED_CONNECTING_PERIOD_MS 1885
+#define LED_WRITING_PERIOD_MS 942
+
+struct LedStats {
+  uint32_t posts;     // setLEDStatus() and ledFlash() calls
+  uint32_t frames;    // Renderer wake-ups
+  uint32_t shows;     // FastLED.show() calls (colour changes)
+};
+
+void initializeLED();                                 // Sets up FastLED and starts the task
+void ledFlash(LEDStatus flash, uint16_t durationMs);  // Show a colour briefly, then the status again
+bool ledRendererRunning();
+const LedStats& ledStats();
+void ledResetStats();
+
+#endif // LED_RENDERER_H
@@ -0,0 +1,105 @@
+#ifndef MODBUS_RTU_H
+#define MODBUS_RTU_H
+
+#include <Arduino.h>
+#include <ModbusMaster.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// Lightweight RTU read transactions with a caller-chosen response timeout.
+// ModbusMaster hardcodes a 2 s timeout, which makes sweeping empty slave IDs
+// painfully slow; this layer returns the same ku8MB* result codes so callers
+// can keep using printModbusError().
+
+#define RTU_DEFAULT_TIMEOUT_MS 2000   // Same as ModbusMaster's fixed timeout
+#define RTU_MAX_READ_WORDS 125        // Protocol maximum for register reads
+#define RTU_MAX_READ_BITS 2000        // Protocol maximum for coil/input reads
+#define RTU_EVENT_FIFO_MAX 120        // RX FIFO threshold cap (the hardware FIFO holds 128)
+
+// Modbus function codes used by the read paths
+#define MB_FC_READ_COILS 0x01
+#define MB_FC_READ_DISCRETE_INPUTS 0x02
+#define MB_FC_READ_HOLDING_REGISTERS 0x03
+#define MB_FC_READ_INPUT_REGISTERS 0x04
+
+struct RtuBus {
+  HardwareSerial* port;
+  int8_t rxPin;
+  int8_t txPin;
+  int8_t dePin;               // DE/RE pin, -1 if not used
+  uint32_t baud;              // Active baud rate (0 = not started)
+  uint32_t config;            // Active SERIAL_xxx frame format
+  uint32_t turnaroundUs;      // Slowest device turnaround measured so far
+  uint16_t lastRxBytes;       // Bytes received by the last transaction
+  uint32_t lastTurnaroundUs;  // Turnaround of the last transaction, 0 = no reply
+  uint8_t strayResponseSlave; // Slave ID of a valid frame that was not ours (0 = none)
+  void (*idle)();             // Called while waiting for a response
+  SemaphoreHandle_t lock;     // Recursive mutex held per transaction (nullptr = single task)
+  SemaphoreHandle_t rxEvent;  // Given by the UART RX event callback
+  bool eventFraming;          // Wait on RX events instead of polling available()
+  uint16_t lastWakeups;       // Times the last transaction woke up before its reply was complete
+};
+
+// Fast-sweep settings shared by the scan and auto-detect probe paths
+struct SweepSettings {
+  bool fastSweep;             // Derive probe timeouts from baud rate and turnaround
+  bool retryPass;             // Re-probe every silent ID with the slow timeout
+  uint16_t minTurnaroundMs;   // Turnaround budget until a device has been measured
+  uint16_t slowTimeoutMs;     // Timeout used by the retry pass
+  uint16_t listenMs;          // Baud detection listens this long for traffic first (0 = probe only)
+};
+
+extern RtuBus modbusBus;
+extern RtuBus modbusBus2;           // Second segment, only with MODBUS_BUS_COUNT 2
+extern RtuBus* const rtuBuses[];    // Every configured bus, modbusBus first
+extern SweepSettings sweepSettings;
+
+uint8_t rtuBusCount();
+uint8_t rtuBusNumber(const RtuBus& bus);   // 1-based, for messages
+
+void rtuBegin(RtuBus& bus, uint32_t baud, uint32_t config);
+uint8_t rtuCharBits(uint32_t config);
+uint32_t rtuCharTimeUs(const RtuBus& bus);
+uint32_t rtuFrameGapUs(const RtuBus& bus);
+uint16_t rtuResponseTimeoutMs(const RtuBus& bus, uint16_t responseBytes);
+uint16_t rtuProbeTimeoutMs(const RtuBus& bus);
+uint16_t rtuReadTimeoutMs(const RtuBus& bus, uint8_t function, uint16_t quantity);
+const char* rtuConfigName(uint32_t config);
+
+uint8_t rtuReadRequest(RtuBus& bus, uint8_t slaveId, uint8_t function,
+                       uint16_t address, uint16_t quantity, uint16_t* dst,
+                       uint16_t timeoutMs);
+
+// Single holding register 0 read used to detect a slave
+uint8_t rtuProbe(RtuBus& bus, uint8_t slaveId, uint16_t timeoutMs);
+
+// Discard input until the line has been quiet for quietMs, so a late reply
+// to a timed-out request cannot be taken for the answer to the next one
+void rtuDrain(RtuBus& bus, uint16_t quietMs);
+
+uint16_t rtuCrc16(const uint8_t* data, uint16_t length);
+uint16_t rtuCrc16Bitwise(const uint8_t* data, uint16_t length);
+
+#define RTU_CRC_BENCH_FRAMES 200
+
+struct RtuCrcBenchmark {
+  uint32_t mismatches;        // Lengths 0-256 where table and bitwise CRC differ
+  uint32_t bytes;             // Bytes run through each implementation
+  uint32_t bitwiseUs;
+  uint32_t tableUs;
+};
+
+void rtuCrcBenchmark(RtuCrcBenchmark* result);
+
+// Event-driven framing: the UART's RX timeout is set to t3.5 and its FIFO
+// threshold to the expected reply length, and the waiting task sleeps until
+// one of them fires instead of polling available() byte by byte
+bool rtuSetEventFraming(RtuBus& bus, bool enabled);
+uint8_t rtuRxTimeoutSymbols(const RtuBus& bus);
+
+// Exclusive use of the bus across tasks; every rtu* call on the bus takes
+// it, hold it explicitly to keep several calls together
+void rtuLock(RtuBus& bus);
+void rtuUnlock(RtuBus& bus);
+
+#endif // MODBUS_RTU_H
@@ -0,0 +1,75 @@
+#ifndef POLL_SCHEDULER_H
+#define POLL_SCHEDULER_H
+
+#include <Arduino.h>
+#include "modbus_rtu.h"
+#include "register_map.h"
+
+// Continuous multi-rate polling. Every point (slave, table, address,
+// count) is released once per period and must be read before the next
+// release; pollTick() hands each bus task one read at a time, always the
+// released point on that bus with the earliest deadline (non-preemptive
+// EDF per bus, the buses running in parallel).
+// Bus time spent, utilisation and deadline misses are reported per window.
+
+#define POLL_MAX_POINTS 64
+#define POLL_REPORT_MS 10000         // Length of a reporting window
+
+struct PollPoint {
+  uint8_t bus;                // Index into rtuBuses
+  uint8_t slaveId;
+  uint8_t table;              // MapTable
+  uint16_t address;
+  uint16_t count;
+  uint32_t periodMs;
+  uint16_t deadband;          // Change reporting, see change_report.h
+  bool deadbandPercent;
+
+  // Scheduler state
+  bool pending;               // Released and not read yet
+  unsigned long releaseMs;    // Current release; its deadline is releaseMs + periodMs
+  unsigned long nextReleaseMs;
+  uint8_t lastStatus;
+  uint32_t lastDurationUs;
+
+  uint32_t reads;
+  uint32_t failures;          // Reads without a valid reply
+  uint32_t misses;            // Finished late, or a whole period skipped
+  uint32_t maxLatenessMs;     // Worst completion past the deadline
+};
+
+struct PollWindow {
+  unsigned long startMs;
+  uint32_t busyUs;            // Bus time of all reads in the window, summed over the buses
+  uint32_t reads;
+  uint32_t failures;
+  uint32_t misses;
+};
+
+// Called after every successful read with the values (bits packed 16 per word)
+typedef void (*PollSampleHandler)(const PollPoint& point, const uint16_t* values);
+
+void pollClear();
+int pollAddPoint(uint8_t slaveId, uint8_t table, uint16_t address, uint16_t count, uint32_t periodMs,
+                 uint8_t bus = 0);
+bool pollSetDeadband(uint8_t index, uint16_t deadband, bool percent);
+uint8_t pollPointCount();
+const PollPoint* pollPoints();
+void pollSetSampleHandler(PollSampleHandler handler);
+
+void pollStart();
+void pollStop();
+void pollTick();
+bool pollActive();
+
+uint32_t pollEstimateUs(const RtuBus& bus, const PollPoint& point);
+float pollPredictedUtilisation(const RtuBus& bus);   // Points on that bus only
+void pollPrintStats();
+PollWindow pollTotals();        // Counters since pollStart()
+
+// Console controls while polling: s = statistics, v = show values,
+// c = changes only (change_report.h), h = history (history.h), q = stop.
+// Returns true if the line was consumed by the scheduler.
+bool pollHandleCommand(const String& input);
+
+#endif // POLL_SCHEDULER_H
@@ -0,0 +1,103 @@
+#ifndef READ_CACHE_H
+#define READ_CACHE_H
+
+#include <Arduino.h>
+#include "modbus_rtu.h"
+#include "retry_policy.h"
+#include "bus_task.h"
+
+// Short-lived copies of recent read replies, so consumers that want the
+// same registers within a moment of each other (the console, polling, the
+// gateway's clients, a repeated profile analysis) share one transaction.
+//
+// A block is kept per reply: slave, table and address range on one bus.
+// A read inside a fresh block is answered from it, also when the block is
+// larger than the read. How long a block stays fresh is set per point:
+// TTL rules cover an address range of a table, and a block lives as long
+// as the shortest TTL of the points in it (cacheSettings.defaultTtlMs where
+// no rule applies, 0 = never cached). A caller can ask for younger values
+// still with maxAgeMs; polling asks for half its period.
+//
+// Reads that opt in through BusRequest.maxAgeMs are merged in flight as
+// well: a request inside an identical or larger one that is queued and not
+// dispatched yet does not go to the bus, it gets a copy of that reply
+// (failures included) when it is dispatched. Synchronous reads through
+// cacheRead() wait for the bus lock and look again, so they take the
+// reply of a bus task read of the same registers that was on the wire.
+//
+// Only value reads go through here. Scans, probes, fingerprinting, map
+// discovery and the dump ask the device itself and always use the bus;
+// the menu's ModbusMaster reads do too. The firmware does not write, so
+// nothing else makes a block stale before its TTL.
+//
+// The blocks of a bus are only touched with its bus lock held; the
+// in-flight merging runs in the loop() task.
+
+#define CACHE_BLOCKS_PER_BUS 12
+#define CACHE_MAX_RULES 16
+#define CACHE_MAX_LEADERS 16          // Opted-in requests tracked while queued
+#define CACHE_MAX_FOLLOWERS 16        // Requests waiting for another's reply
+#define CACHE_ANY_AGE 0xFFFFFFFF      // maxAgeMs: whatever the TTL allows
+
+struct CacheSettings {
+  bool enabled;
+  uint32_t defaultTtlMs;      // For points without a rule
+};
+
+struct CacheTtlRule {
+  uint8_t bus;                // 1-based, 0 = free slot
+  uint8_t slaveId;            // 0 = every slave
+  uint8_t table;              // MapTable
+  uint16_t first;
+  uint16_t last;
+  uint32_t ttlMs;             // 0 = never cached
+};
+
+// Every read that asked the cache is one of hits, coveredHits, joined, misses
+struct CacheStats {
+  uint32_t hits;              // Answered from a block of the same range
+  uint32_t coveredHits;       // Answered from a larger block
+  uint32_t joined;            // Merged into a read already queued
+  uint32_t misses;            // Went to the bus
+  uint32_t stores;            // Replies kept
+  uint32_t evictions;         // Fresh blocks pushed out to make room
+};
+
+extern CacheSettings cacheSettings;
+
+// TTL of the points slaveId (0 = all) table first..last on bus; replaces a
+// rule for the same range, false when all rules are taken. Clears the cache.
+bool cacheSetTtl(uint8_t slaveId, uint8_t table, uint16_t first, uint16_t last, uint32_t ttlMs,
+                 RtuBus& bus = modbusBus);
+void cacheClearRules();
+const CacheTtlRule* cacheRule(uint8_t index);   // nullptr past the last one
+
+// Call with the bus lock held. A lookup copies the values (bits packed 16
+// per word, as read) into dst; a store keeps a successful reply.
+bool cacheLookup(RtuBus& bus, uint8_t slaveId, uint8_t function, uint16_t address, uint16_t quantity,
+                 uint16_t* dst, uint32_t maxAgeMs = CACHE_ANY_AGE);
+void cacheStore(RtuBus& bus, uint8_t slaveId, uint8_t function, uint16_t address, uint16_t quantity,
+                const uint16_t* values);
+
+// retryRead() behind the cache; outcome->attempts is 0 for a cached answer
+uint8_t cacheRead(RtuBus& bus, uint8_t slaveId, uint8_t function, uint16_t address, uint16_t quantity,
+                  uint16_t* dst, uint16_t timeoutMs, uint32_t maxAgeMs = CACHE_ANY_AGE,
+                  RetryOutcome* outcome = nullptr);
+
+// In-flight merging for the bus task, loop() task only. cacheJoin() takes
+// the request as a follower if a queued one covers it; otherwise busSubmit()
+// queues it and registers it with cacheLead(). cacheRelease() runs the
+// followers of a dispatched reply and returns how many there were.
+bool cacheJoin(const BusRequest& request);
+void cacheLead(const BusRequest& request);
+uint8_t cacheRelease(const BusResult& result);
+
+const CacheStats& cacheStats(const RtuBus& bus);
+float cacheHitRate(const RtuBus& bus);        // Percent of the requests, merged ones included
+
+// Drop every block; the rules stay
+void cacheClear();
+void cacheResetStats();
+void cachePrintStats();
+
+#endif // READ_CACHE_H
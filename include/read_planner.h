@@ -0,0 +1,52 @@
+#ifndef READ_PLANNER_H
+#define READ_PLANNER_H
+
+#include <Arduino.h>
+#include "modbus_rtu.h"
+#include "register_map.h"
+
+// Read coalescing for profile polls. The wanted registers are merged into
+// the cheapest set of block reads: reading across a gap costs its bytes on
+// the wire, a separate transaction costs the request frame, the reply
+// header, two frame gaps and the slave's turnaround at the current baud.
+// A block the device rejects with an address exception is split and the
+// split is kept for later polls.
+
+#define PLAN_MAX_POINTS 64
+
+struct PlanPoint {
+  uint8_t table;              // MapTable
+  uint16_t address;
+  uint16_t value;             // Register value, or 0/1 for coils and inputs
+  bool valid;                 // Value came from the last poll
+};
+
+struct PlanBlock {
+  uint8_t table;
+  uint16_t first;
+  uint16_t count;
+  uint8_t firstPoint;         // Points covered: points[firstPoint .. firstPoint + pointCount)
+  uint8_t pointCount;
+  bool dead;                  // Single address the device does not have; skipped
+};
+
+struct ReadPlan {
+  PlanPoint points[PLAN_MAX_POINTS];
+  uint8_t pointCount;
+  PlanBlock blocks[PLAN_MAX_POINTS];  // Every block covers at least one point
+  uint8_t blockCount;
+  uint16_t splits;            // Blocks split after an address exception
+  uint16_t transactions;      // Reads issued by the last planExecute
+  uint16_t failures;          // Blocks without a reply in the last planExecute
+  unsigned long elapsedMs;    // Duration of the last planExecute
+};
+
+void planInit(ReadPlan* plan);
+bool planAdd(ReadPlan* plan, uint8_t table, uint16_t address);
+void planBuild(ReadPlan* plan, const RtuBus& bus);
+uint16_t planExecute(ReadPlan* plan, RtuBus& bus, uint8_t slaveId);
+bool planValue(const ReadPlan* plan, uint8_t table, uint16_t address, uint16_t* value);
+uint32_t planTransactionOverheadUs(const RtuBus& bus);
+void planPrint(const ReadPlan* plan);
+
+#endif // READ_PLANNER_H
@@ -0,0 +1,69 @@
+#ifndef REGISTER_MAP_H
+#define REGISTER_MAP_H
+
+#include <Arduino.h>
+#include "modbus_rtu.h"
+
+// Register-map discovery. Single-register seed probes find a valid
+// address; multi-register reads then gallop outwards from it and bisect on
+// Illegal Data Address (0x02) to pin down the exact first and last address
+// of the block. A read succeeds only if every address in it exists, so one
+// successful read clears up to 125 registers or 2000 bits at once.
+//
+// Seeds come from a grid where vendors tend to start their blocks (every
+// seedStride addresses in the dense span, then multiples of 100 and 1000).
+// A sweep of the gaps between the blocks follows, coarse to fine: every
+// 4096th address not covered yet, then every 2048th, down to minBlock, so
+// any block of minBlock addresses or more is found wherever it is. A 0x02
+// for a read across a gap cannot tell whether some address in it exists,
+// so the gaps have to be probed address by address at that spacing;
+// shorter blocks off the seed grid can be missed.
+
+#define MAP_MAX_RANGES 48           // Ranges kept over all four tables
+
+enum MapTable {
+  MAP_COILS,
+  MAP_DISCRETE_INPUTS,
+  MAP_HOLDING_REGISTERS,
+  MAP_INPUT_REGISTERS,
+  MAP_TABLE_COUNT
+};
+
+struct MapRange {
+  uint8_t table;
+  uint16_t first;
+  uint16_t last;
+};
+
+struct MapDiscoveryOptions {
+  uint16_t firstAddress;
+  uint16_t lastAddress;
+  uint16_t denseSpan;         // Fine seed grid covers [firstAddress, firstAddress + denseSpan)
+  uint8_t seedStride;         // Seed spacing inside the dense span
+  uint8_t gapProbe;           // Addresses probed past each range end to catch short gaps
+  uint16_t minBlock;          // Power of two: shortest block found anywhere, 0 = seed grid only
+  uint16_t maxRangeLength;    // Stop growing here; the device probably does not check addresses
+  uint8_t tableMask;          // Bit n set to search MapTable n
+};
+
+struct MapDiscoveryResult {
+  MapRange ranges[MAP_MAX_RANGES];
+  uint8_t rangeCount;
+  bool truncated;             // More ranges found than MAP_MAX_RANGES
+  bool cancelled;
+  bool deviceLost;            // Repeated timeouts ended the search
+  bool supported[MAP_TABLE_COUNT];    // False after Illegal Function
+  bool unbounded[MAP_TABLE_COUNT];    // A range reached maxRangeLength
+  uint16_t maxBlock[MAP_TABLE_COUNT]; // Largest read quantity the device accepted
+  uint32_t transactions;
+  uint32_t timeouts;
+  unsigned long elapsedMs;
+};
+
+void mapDefaultOptions(MapDiscoveryOptions* options);
+bool discoverRegisterMap(RtuBus& bus, uint8_t slaveId, const MapDiscoveryOptions& options,
+                         MapDiscoveryResult* result);
+void printRegisterMap(const MapDiscoveryResult& result);
+const char* mapTableName(uint8_t table);
+
+#endif // REGISTER_MAP_H
@@ -0,0 +1,120 @@
+#ifndef REGISTER_PROFILE_H
+#define REGISTER_PROFILE_H
+
+#include <Arduino.h>
+#include "register_map.h"
+#include "read_planner.h"
+
+// Register profiles as compile-time descriptor tables. A profile is a
+// constexpr array of RegisterDescriptor built with the reg*() helpers
+// below, so it lives in flash and nothing is constructed when a device is
+// polled. Each helper picks the decoder (a template instance for the
+// signedness and word order) when the table is compiled; decoding a value
+// is one indirect call, with no switch on the register type.
+//
+// Values stay fixed point: a number is an int32_t plus the decimals its
+// descriptor gives (452 with 1 decimal is 45.2), so decoding and
+// formatting need no float. That matters on the ESP32-C3, which has no
+// FPU. Enums and bitfields are label tables indexed by value or bit.
+//
+//   static constexpr const char* modes[] = {"Off", "Heat", "Cool"};
+//   static constexpr RegisterDescriptor profile[] = {
+//     regNumber(MAP_INPUT_REGISTERS, 1, "Inlet", "°C", 1, true),
+//     regNumber32(MAP_INPUT_REGISTERS, 30, "Energy", "kWh", 2),
+//     regEnum(MAP_HOLDING_REGISTERS, 5, "Mode", modes),
+//   };
+//   static_assert(registerProfileValid(profile), "bad register profile");
+
+#define REGISTER_MAX_DECIMALS 6
+#define REGISTER_TEXT_MAX 48          // Longest registerFormat() result kept by callers
+
+enum RegisterKind : uint8_t {
+  REG_NUMBER,                 // Fixed point: value / 10^decimals
+  REG_ENUM,                   // labels[value - labelBase]
+  REG_BITS                    // labels[bit] for every bit set
+};
+
+// Turns the register's words (one, or two for a pair) into its raw value
+typedef int32_t (*RegisterDecoder)(const uint16_t* words);
+
+struct RegisterDescriptor {
+  uint8_t table;              // MapTable
+  uint16_t address;
+  uint8_t words;              // 1, or 2 for a 32-bit value in two registers
+  uint8_t kind;               // RegisterKind
+  uint8_t decimals;
+  RegisterDecoder decode;
+  const char* name;
+  const char* unit;
+  const char* const* labels;
+  uint8_t labelCount;
+  int16_t labelBase;          // Value of labels[0] for an enum
+};
+
+template <bool Signed>
+int32_t registerDecodeWord(const uint16_t* words) {
+  return Signed ? (int32_t)(int16_t)words[0] : (int32_t)words[0];
+}
+
+// 32-bit pairs; most devices send the high word first
+template <bool Signed, bool LowWordFirst>
+int32_t registerDecodePair(const uint16_t* words) {
+  return (int32_t)(LowWordFirst ? ((uint32_t)words[1] << 16 | words[0]) : ((uint32_t)words[0] << 16 | words[1]));
+}
+
+constexpr RegisterDescriptor regNumber(uint8_t table, uint16_t address, const char* name, const char* unit,
+                                       uint8_t decimals = 0, bool isSigned = false) {
+  return {table, address, 1, REG_NUMBER, decimals,
+          isSigned ? &registerDecodeWord<true> : &registerDecodeWord<false>, name, unit, nullptr, 0, 0};
+}
+
+// Unsigned pairs above 2^31 wrap; none of the supported devices count that far
+constexpr RegisterDescriptor regNumber32(uint8_t table, uint16_t address, const char* name, const char* unit,
+                                         uint8_t decimals = 0, bool isSigned = false, bool lowWordFirst = false) {
+  return {table, address, 2, REG_NUMBER, decimals,
+          lowWordFirst ? (isSigned ? &registerDecodePair<true, true> : &registerDecodePair<false, true>)
+                       : (isSigned ? &registerDecodePair<true, false> : &registerDecodePair<false, false>),
+          name, unit, nullptr, 0, 0};
+}
+
+template <size_t N>
+constexpr RegisterDescriptor regEnum(uint8_t table, uint16_t address, const char* name,
+                                     const char* const (&labels)[N], int16_t labelBase = 0) {
+  return {table, address, 1, REG_ENUM, 0, &registerDecodeWord<false>, name, "", labels, (uint8_t)N, labelBase};
+}
+
+template <size_t N>
+constexpr RegisterDescriptor regBits(uint8_t table, uint16_t address, const char* name,
+                                     const char* const (&labels)[N]) {
+  return {table, address, 1, REG_BITS, 0, &registerDecodeWord<false>, name, "", labels, (uint8_t)N, 0};
+}
+
+constexpr bool registerDescriptorValid(const RegisterDescriptor& reg) {
+  return reg.table < MAP_TABLE_COUNT && reg.decimals <= REGISTER_MAX_DECIMALS && reg.decode != nullptr &&
+         (reg.kind == REG_NUMBER || reg.labelCount > 0) && (reg.kind != REG_BITS || reg.labelCount <= 16) &&
+         (reg.words == 1 || (reg.table >= MAP_HOLDING_REGISTERS && reg.address < 0xFFFF));
+}
+
+// For static_assert on a profile table
+template <size_t N>
+constexpr bool registerProfileValid(const RegisterDescriptor (&profile)[N], size_t i = 0) {
+  return i == N || (registerDescriptorValid(profile[i]) && registerProfileValid(profile, i + 1));
+}
+
+// Formats a decoded value ("45.2 °C", "Heating (1)", "AL01, AL03" or
+// "none"); returns the length written
+size_t registerFormat(const RegisterDescriptor& reg, int32_t value, char* out, size_t size);
+
+// Adds every address of the profile to the plan
+void registerProfilePlan(ReadPlan* plan, const RegisterDescriptor* profile, uint8_t count);
+
+// Decodes one register from the plan's last poll; false if a word is missing
+bool registerPlanValue(const ReadPlan* plan, const RegisterDescriptor& reg, int32_t* value);
+
+// Decodes the profile registers inside one polled block (`quantity`
+// registers or bits from `first`, bits packed 16 per word as read).
+// values[i] and valid[i] belong to profile[i]; returns the number decoded.
+uint8_t registerDecodeBlock(const RegisterDescriptor* profile, uint8_t count, uint8_t table, uint16_t first,
+                            uint16_t quantity, const uint16_t* words, int32_t* values, bool* valid);
+
+#endif // REGISTER_PROFILE_H
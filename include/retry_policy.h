@@ -0,0 +1,83 @@
+#ifndef RETRY_POLICY_H
+#define RETRY_POLICY_H
+
+#include <Arduino.h>
+#include "modbus_rtu.h"
+
+// Retries that know what a result means. A timeout, a CRC error, a reply
+// from the wrong slave or a "busy" exception (0x05, 0x06, 0x0B) may go away
+// when asked again; any other exception is the device's answer and is
+// returned at once.
+//
+// A transient failure is retried up to retryPolicy.maxAttempts, with an
+// exponential backoff of which a random half is jitter, so two masters or
+// a slave that is catching up do not collide again on the next attempt.
+// Timeouts get fewer retries than CRC errors: each one already cost a full
+// timeout. Each bus also has a retry budget: a retry spends a token, a
+// reply at the first attempt (an exception too) earns a tenth of one, so a
+// sick bus cannot double its own load.
+//
+// A slave whose calls keep failing after their retries gets its circuit
+// opened: calls return RETRY_CIRCUIT_OPEN without touching the bus until
+// the open period is over. Then a single attempt is let through; success
+// closes the circuit, failure opens it again for twice as long. Any reply,
+// exceptions included, proves the slave is there and closes it too, and
+// all circuits close when the bus changes baud rate or frame format.
+//
+// Everything runs with the bus lock held, the state is per bus.
+
+#define RETRY_CIRCUIT_OPEN 0xE8       // Result code of a call the breaker refused
+#define RETRY_BREAKER_SLOTS 8         // Failing slaves tracked per bus
+#define RETRY_BUDGET_TOKENS 10        // Retries a bus can spend in a row
+
+struct RetryPolicy {
+  uint8_t maxAttempts;        // Per call, the first included (1 = no retries)
+  uint8_t maxTimeoutRetries;  // Of those retries, how many may follow a timeout
+  uint16_t backoffMs;         // Before the first retry; doubles for each next one
+  uint16_t maxBackoffMs;
+  uint8_t breakerFailures;    // Failed calls in a row that open a slave's circuit, 0 = off
+  uint32_t breakerOpenMs;     // First open period
+  uint32_t breakerMaxOpenMs;  // Doubling stops here
+};
+
+struct RetryOutcome {
+  uint8_t attempts;           // Transactions made, 0 when the circuit was open
+  uint8_t timeouts;
+};
+
+struct RetryStats {
+  uint32_t calls;
+  uint32_t retries;
+  uint32_t recovered;         // Calls that succeeded on a retry
+  uint32_t exhausted;         // Calls still failing after the last retry
+  uint32_t budgetDenied;      // Retries skipped because the bus budget was spent
+  uint32_t shortCircuited;    // Calls refused by an open circuit
+  uint32_t trips;             // Circuits opened
+};
+
+extern RetryPolicy retryPolicy;
+
+// True for results that may succeed when asked again
+bool retryTransient(uint8_t result);
+
+// Runs attempt(context) under the policy for slaveId on bus; the attempt
+// is one transaction and returns its ku8MB* result. After a timeout the
+// line must be quiet for quietMs before the retry, so a late reply cannot
+// answer it. Holds the bus lock.
+typedef uint8_t (*RetryAttempt)(void* context);
+uint8_t retryRun(RtuBus& bus, uint8_t slaveId, RetryAttempt attempt, void* context, uint16_t quietMs,
+                 RetryOutcome* outcome = nullptr);
+
+// rtuReadRequest() with retries and the circuit breaker
+uint8_t retryRead(RtuBus& bus, uint8_t slaveId, uint8_t function, uint16_t address, uint16_t quantity,
+                  uint16_t* dst, uint16_t timeoutMs, RetryOutcome* outcome = nullptr);
+
+bool retryCircuitOpen(const RtuBus& bus, uint8_t slaveId);
+const RetryStats& retryStats(const RtuBus& bus);
+
+// Close every circuit and clear the statistics
+void retryReset();
+
+void retryPrintStats();
+
+#endif // RETRY_POLICY_H
@@ -0,0 +1,56 @@
+#ifndef SCAN_ENGINE_H
+#define SCAN_ENGINE_H
+
+#include <Arduino.h>
+
+// Incremental slave ID scan. Probes go through the bus task, a couple
+// queued ahead per bus, so the LED animation and console stay responsive
+// while a scan is running. With two buses each segment is swept on its own
+// at the same time, so both take as long as one.
+// In fast-sweep mode silent IDs can be re-probed with a slow timeout in a
+// second pass; IDs that showed signs of life are always retried.
+enum ScanState {
+  SCAN_IDLE,            // No scan in progress
+  SCAN_RUNNING,         // Keeping probes queued on every bus
+  SCAN_PAUSED           // Scan suspended from the console
+};
+
+struct ScanStats {
+  uint8_t firstId;
+  uint8_t lastId;
+  uint8_t nextId;             // Lowest slave ID still to probe on any bus
+  uint8_t buses;              // Buses being swept
+  uint16_t probes;            // Probes issued so far
+  uint16_t devicesFound;      // Slaves that answered with data
+  uint16_t devicesWithErrors; // Slaves that answered with an exception
+  uint8_t pass;               // 1 = sweep, 2 = retry pass for slow/suspect IDs (furthest bus)
+  uint16_t retryIds;          // IDs queued for the retry pass
+  uint16_t foundOnRetry;      // Devices that only answered in the retry pass
+  uint16_t timeoutMs;         // Probe timeout of the first pass on the first bus
+  unsigned long startMs;      // millis() when the scan started
+  unsigned long pausedMs;     // Total time spent paused
+  unsigned long pauseStartMs; // millis() when the current pause began
+};
+
+#define SCAN_ALL_BUSES 0xFF
+#define SCAN_PIPELINE_DEPTH 2       // Probes queued per bus, so its task never waits for loop()
+
+// busMask: bit n selects rtuBuses[n]; buses that are not started are skipped
+void scanStart(uint8_t firstId, uint8_t lastId, uint8_t busMask = SCAN_ALL_BUSES);
+void scanTick();
+void scanPause();
+void scanResume();
+void scanCancel();
+bool scanActive();
+ScanState scanState();
+const ScanStats& scanStats();
+
+// Called once when a scan completes or is cancelled
+typedef void (*ScanFinishHandler)(const ScanStats& stats, bool cancelled);
+void scanSetFinishHandler(ScanFinishHandler handler);
+
+// Console controls while a scan is active: p = pause/resume, c = cancel,
+// s = status. Returns true if the line was consumed by the scan engine.
+bool scanHandleCommand(const String& input);
+
+#endif // SCAN_ENGINE_H
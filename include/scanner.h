@@ -0,0 +1,79 @@
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include <Arduino.h>
+#include <ModbusMaster.h>
+
+// WS2812 LED configuration
+#define LED_PIN 10        // GPIO 10 for WS2812
+#define NUM_LEDS 1        // Single LED
+#define LED_TYPE WS2812B
+#define COLOR_ORDER GRB
+
+// Modbus RTU configuration
+#define MODBUS_RX_PIN 20  // GPIO 20 for RX (adjust for your wiring)
+#define MODBUS_TX_PIN 21  // GPIO 21 for TX (adjust for your wiring)
+#define MODBUS_DE_PIN -1   // GPIO 2 for DE/RE (Direction Enable - optional, set to -1 if not used)
+#define MODBUS_BAUD 9600  // Common Modbus RTU baud rate
+
+// Second RS485 segment on UART0, which is free while the console runs over
+// USB CDC. With two buses, scans and polling drive both at the same time.
+#ifndef MODBUS_BUS_COUNT
+#define MODBUS_BUS_COUNT 1        // 1 or 2
+#endif
+#define MODBUS2_PORT Serial0
+#define MODBUS2_RX_PIN 5          // GPIO 5 for RX of the second bus
+#define MODBUS2_TX_PIN 6          // GPIO 6 for TX of the second bus
+#define MODBUS2_DE_PIN -1         // DE/RE of the second bus, -1 if not used
+#define MODBUS2_BAUD 9600
+#define MODBUS2_CONFIG SERIAL_8N1
+
+// Modbus slave configuration
+#define SLAVE_ID 1        // Default slave ID, change as needed
+
+// LED Status Colors and Functions
+enum LEDStatus {
+  LED_OFF,              // LED off
+  LED_READY,            // System ready (blue)
+  LED_SCANNING,         // Scanning for devices (purple pulse)
+  LED_SUCCESS,          // Communication success (green)
+  LED_ERROR,            // Communication error (red)
+  LED_WARNING,          // Warning/timeout (orange)
+  LED_WRITING,          // Writing data (yellow)
+  LED_CONNECTING        // Trying to connect (cyan)
+};
+
+// Shared state defined in main.cpp
+extern ModbusMaster modbus;
+
+// Forward declarations
+void printModbusError(uint8_t result);
+void changeModbusSettings(uint32_t newBaud, uint8_t newSlaveId);
+void readHoldingRegisters(uint8_t slaveId, uint16_t startAddress, uint16_t quantity);
+void readInputRegisters(uint8_t slaveId, uint16_t startAddress, uint16_t quantity);
+void readCoils(uint8_t slaveId, uint16_t startAddress, uint16_t quantity);
+void readDiscreteInputs(uint8_t slaveId, uint16_t startAddress, uint16_t quantity);
+void writeSingleRegister(uint8_t slaveId, uint16_t address, uint16_t value);
+void writeSingleCoil(uint8_t slaveId, uint16_t address, bool value);
+void scanModbusDevices();
+// True when slaveId answered at *detectedBaud. *lineBaud gets the rate measured
+// from another master's traffic, also when slaveId stayed silent (0 = none).
+bool autoDetectBaudRate(uint8_t slaveId, uint32_t* detectedBaud, uint32_t* lineBaud = nullptr);
+bool autoDetectSerialConfig(uint8_t slaveId, uint32_t baudRate);
+void detectModbusDevice();
+void testSpecificSlaveId();
+void testDifferentBaudRates();
+void readSpecificRegisters();
+void configurePolling();
+void configureDump();
+void showHistory();
+void writeToRegister();
+void showCurrentConfiguration();
+void changeSettingsInteractive();
+void showHelp();
+void showMainMenu();
+void setLEDStatus(LEDStatus status, bool animate = true);
+void ledStatusMessage(LEDStatus status, const char* message);
+void analyzeTECHeatPump(uint8_t slaveId);
+
+#endif // SCANNER_H
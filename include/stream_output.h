@@ -0,0 +1,61 @@
+#ifndef STREAM_OUTPUT_H
+#define STREAM_OUTPUT_H
+
+#include <Arduino.h>
+
+// Machine-oriented output for register data. In binary mode every read
+// that would print one text line per value ("Register 12: 0x01C4 (452)",
+// about 30 bytes per 2-byte value) sends one length-prefixed record
+// instead, built in a preallocated buffer and written with a single call.
+// Menu text keeps going to the console around the records; the sync bytes
+// and CRC let a host decoder (tools/decode_stream.py) find the records in
+// between. Text stays the default.
+//
+// Record layout, little-endian:
+//   0   2  sync 0xA5 0x5A
+//   2   2  body length (bytes from version up to the CRC)
+//   4   1  version (STREAM_RECORD_VERSION)
+//   5   4  timestamp, millis()
+//   9   1  bus (1-based)
+//   10  1  slave ID
+//   11  1  table (MapTable: 0 coils, 1 discrete inputs, 2 holding, 3 input)
+//   12  2  start address
+//   14  2  count (registers or bits)
+//   16  2n values: count words, or bits packed 16 per word (bit 0 first)
+//   ..  2  Modbus CRC16 over the body
+
+#define STREAM_SYNC_0 0xA5
+#define STREAM_SYNC_1 0x5A
+#define STREAM_RECORD_VERSION 1
+#define STREAM_HEADER_BYTES 16
+#define STREAM_MAX_WORDS 125          // Largest single read; bits fit in 2000 / 16
+#define STREAM_MAX_RECORD (STREAM_HEADER_BYTES + STREAM_MAX_WORDS * 2 + 2)
+
+enum StreamMode {
+  STREAM_TEXT,          // Human-readable lines (default)
+  STREAM_BINARY         // Length-prefixed records
+};
+
+struct StreamStats {
+  uint32_t records;
+  uint32_t bytes;
+  uint32_t values;      // Registers or bits sent
+};
+
+void streamSetMode(StreamMode mode);
+StreamMode streamMode();
+bool streamBinary();
+const StreamStats& streamStats();
+void streamResetStats();
+
+// Build a record value by value, e.g. straight from ModbusMaster's
+// response buffer; streamEnd() adds the CRC and writes it out
+void streamBegin(uint8_t bus, uint8_t slaveId, uint8_t table, uint16_t address, uint16_t count);
+void streamWord(uint16_t value);
+void streamEnd();
+
+// Whole record from a word array (bits packed 16 per word)
+void streamRecord(uint8_t bus, uint8_t slaveId, uint8_t table, uint16_t address, uint16_t count,
+                  const uint16_t* values);
+
+#endif // STREAM_OUTPUT_H
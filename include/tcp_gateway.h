@@ -0,0 +1,74 @@
+#ifndef TCP_GATEWAY_H
+#define TCP_GATEWAY_H
+
+#include <Arduino.h>
+#include "modbus_rtu.h"
+
+// Modbus TCP server on the WiFi side that forwards to one RTU bus, so
+// several SCADA clients can share the line without a separate gateway box.
+// The MBAP unit ID is the RTU slave ID; the transaction ID goes back with
+// the reply. Only the read function codes (0x01-0x04) are forwarded, the
+// rest gets exception 0x01 like writes everywhere else in this firmware.
+//
+// gatewayTick() runs from loop() on non-blocking BSD sockets (lwIP on the
+// C3, the host stack in the native build): it accepts clients, cuts MBAP
+// frames out of their byte streams and queues the requests per client.
+// The bus task gets at most GATEWAY_IN_FLIGHT of them at a time, so the
+// order on the wire is still decided here: deficit round robin over the
+// clients on estimated bus time, so a client asking for 125 registers gets
+// no more of the line than one asking for a single register, and a client
+// that pipelines cannot starve one that waits for each reply. Reads go
+// through the read cache (read_cache.h): clients polling the same registers
+// share the transactions.
+//
+// Load is shed instead of queued without limit: a request that finds its
+// client's queue full, or that waited GATEWAY_MAX_WAIT_MS without reaching
+// the bus, is answered with exception 0x06 (Slave Device Busy). A slave
+// that does not reply gets the client exception 0x0B.
+//
+// Menu options that wait for console input stop loop(), and the gateway
+// with it; clients see their replies late or get 0x06 afterwards.
+
+#define GATEWAY_PORT 502
+#define GATEWAY_MAX_CLIENTS 4
+#define GATEWAY_CLIENT_QUEUE 4        // Requests queued per client before 0x06
+#define GATEWAY_IN_FLIGHT 2           // Requests handed to the bus task at a time
+#define GATEWAY_MAX_WAIT_MS 1000      // Longer in the queue is answered with 0x06
+#define GATEWAY_IDLE_MS 60000         // Clients silent this long are disconnected
+
+struct GatewayStats {
+  unsigned long startMs;
+  uint32_t connections;       // Clients accepted
+  uint32_t refused;           // Connections closed because all slots were taken
+  uint32_t requests;          // Complete MBAP frames received
+  uint32_t replies;           // Data replies passed back
+  uint32_t exceptions;        // Exception replies from the slaves, passed back
+  uint32_t failed;            // Answered with 0x0B: no valid reply on the bus
+  uint32_t busy;              // Answered with 0x06 by the gateway
+  uint32_t rejected;          // Answered with 0x01, 0x03 or 0x0A without using the bus
+  uint32_t forwarded;         // Handed to the bus task
+  uint64_t waitUs;            // Sum of queue waits of the forwarded requests
+  uint32_t maxWaitUs;
+  uint64_t responseUs;        // Sum of request-in to reply-out times of the answered ones
+  uint32_t maxResponseUs;
+  uint8_t maxQueued;          // Most requests waiting in the gateway at once
+};
+
+// Listen on port (0 = any free port, see gatewayPort()) for bus; on the C3
+// WiFi is joined first with the stored credentials
+bool gatewayStart(uint16_t port = GATEWAY_PORT, RtuBus& bus = modbusBus);
+void gatewayStop();
+void gatewayTick();
+bool gatewayActive();
+uint16_t gatewayPort();
+uint8_t gatewayClientCount();
+
+// Stored in NVS; used by the next gatewayStart()
+void gatewaySetWifi(const char* ssid, const char* password);
+
+const GatewayStats& gatewayStats();
+float gatewayRequestsPerSecond();
+void gatewayResetStats();
+void gatewayPrintStats();
+
+#endif // TCP_GATEWAY_H
@@ -0,0 +1,13 @@
+#ifndef TEC_PROFILE_H
+#define TEC_PROFILE_H
+
+#include "register_profile.h"
+
+// TEC QRS11 heat pump registers read by menu option 6: sensors in input
+// registers, setpoints in holding registers (never written), alarms in
+// discrete inputs.
+
+extern const RegisterDescriptor tecRegisters[];
+extern const uint8_t tecRegisterCount;
+
+#endif // TEC_PROFILE_H
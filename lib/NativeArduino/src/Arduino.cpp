@@ -0,0 +1,88 @@
+#include "Arduino.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using SteadyClock = std::chrono::steady_clock;
+
+// Virtual time = anchor + (wall clock - wall anchor) * scale
+static SteadyClock::time_point wallAnchor = SteadyClock::now();
+static std::atomic<uint64_t> virtualAnchorUs{0};
+static std::atomic<uint32_t> timeScale{1};
+
+static uint8_t pinLevels[64];
+
+static uint64_t wallMicrosSinceAnchor() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - wallAnchor).count();
+}
+
+uint64_t nativeMicros64() {
+  return virtualAnchorUs.load() + wallMicrosSinceAnchor() * timeScale.load();
+}
+
+void nativeSetTimeScale(uint32_t scale) {
+  if (scale == 0) scale = 1;
+  // Re-anchor so virtual time stays continuous across the change
+  uint64_t now = nativeMicros64();
+  wallAnchor = SteadyClock::now();
+  virtualAnchorUs = now;
+  timeScale = scale;
+}
+
+uint32_t nativeTimeScale() {
+  return timeScale.load();
+}
+
+void nativeSleepUntilUs(uint64_t deadlineUs) {
+  uint64_t now = nativeMicros64();
+  if (deadlineUs <= now) return;
+  std::this_thread::sleep_for(std::chrono::microseconds((deadlineUs - now) / timeScale.load()));
+}
+
+unsigned long millis() {
+  return (unsigned long)(nativeMicros64() / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long)nativeMicros64();
+}
+
+void delay(unsigned long ms) {
+  nativeSleepUntilUs(nativeMicros64() + ms * 1000ULL);
+}
+
+void delayMicroseconds(unsigned int us) {
+  nativeSleepUntilUs(nativeMicros64() + us);
+}
+
+void yield() {
+  std::this_thread::yield();
+}
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin < sizeof(pinLevels)) pinLevels[pin] = value;
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < sizeof(pinLevels) ? pinLevels[pin] : LOW;
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  if (inMax == inMin) return outMin;
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+long random(long howBig) {
+  return howBig > 0 ? rand() % howBig : 0;
+}
+
+long random(long howSmall, long howBig) {
+  return howBig > howSmall ? howSmall + random(howBig - howSmall) : howSmall;
+}
+
+void randomSeed(unsigned long seed) {
+  srand(seed);
+}
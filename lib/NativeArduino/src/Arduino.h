@@ -0,0 +1,110 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// Just enough of the Arduino API to build the scanner on Linux. Time comes
+// from a scalable clock (see nativeSetTimeScale) so long bus timeouts can be
+// simulated quickly, and Serial1 talks to the virtual RTU bus over a pty.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define CHANGE 0x03
+#define FALLING 0x02
+#define RISING 0x01
+
+#define PI 3.1415926535897932384626433832795
+
+// Section attributes have no meaning on the host
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+// Frame formats use the ESP32 core encoding so rtuCharBits() works unchanged
+#define SERIAL_5N1 0x8000010
+#define SERIAL_6N1 0x8000014
+#define SERIAL_7N1 0x8000018
+#define SERIAL_8N1 0x800001c
+#define SERIAL_5N2 0x8000030
+#define SERIAL_6N2 0x8000034
+#define SERIAL_7N2 0x8000038
+#define SERIAL_8N2 0x800003c
+#define SERIAL_5E1 0x8000012
+#define SERIAL_6E1 0x8000016
+#define SERIAL_7E1 0x800001a
+#define SERIAL_8E1 0x800001e
+#define SERIAL_5E2 0x8000032
+#define SERIAL_6E2 0x8000036
+#define SERIAL_7E2 0x800003a
+#define SERIAL_8E2 0x800003e
+#define SERIAL_5O1 0x8000013
+#define SERIAL_6O1 0x8000017
+#define SERIAL_7O1 0x800001b
+#define SERIAL_8O1 0x800001f
+#define SERIAL_5O2 0x8000033
+#define SERIAL_6O2 0x8000037
+#define SERIAL_7O2 0x800003b
+#define SERIAL_8O2 0x800003f
+
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+#define bit(b) (1UL << (b))
+
+using std::min;
+using std::max;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline uint16_t word(uint8_t high, uint8_t low) { return (uint16_t)((high << 8) | low); }
+inline uint16_t word(uint16_t w) { return w; }
+
+inline bool isDigit(int c) { return c >= '0' && c <= '9'; }
+inline bool isSpace(int c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+inline bool isAlpha(int c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+
+// Clock control for the native build: with a time scale of N, millis()
+// advances N times faster than the wall clock and delay() sleeps 1/N as long.
+void nativeSetTimeScale(uint32_t scale);
+uint32_t nativeTimeScale();
+void nativeSleepUntilUs(uint64_t deadlineUs);
+uint64_t nativeMicros64();
+
+void setup();
+void loop();
+
+#include "WString.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+
+#endif // NATIVE_ARDUINO_H
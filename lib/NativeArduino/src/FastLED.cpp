@@ -0,0 +1,21 @@
+#include "FastLED.h"
+
+CFastLED FastLED;
+
+// Plain HSV to RGB conversion; close enough for a simulated LED
+CRGB::CRGB(const CHSV& hsv) {
+  uint8_t region = hsv.h / 43;
+  uint8_t remainder = (hsv.h - region * 43) * 6;
+  uint8_t p = (hsv.v * (255 - hsv.s)) >> 8;
+  uint8_t q = (hsv.v * (255 - ((hsv.s * remainder) >> 8))) >> 8;
+  uint8_t t = (hsv.v * (255 - ((hsv.s * (255 - remainder)) >> 8))) >> 8;
+
+  switch (region) {
+    case 0: r = hsv.v; g = t; b = p; break;
+    case 1: r = q; g = hsv.v; b = p; break;
+    case 2: r = p; g = hsv.v; b = t; break;
+    case 3: r = p; g = q; b = hsv.v; break;
+    case 4: r = t; g = p; b = hsv.v; break;
+    default: r = hsv.v; g = p; b = q; break;
+  }
+}
@@ -0,0 +1,59 @@
+#ifndef NATIVE_FASTLED_H
+#define NATIVE_FASTLED_H
+
+#include <stdint.h>
+
+// LED stand-in for the native build: keeps the colour so code paths run,
+// counts show() calls, drives no hardware.
+
+#define WS2812B 0
+#define GRB 0
+
+struct CHSV {
+  uint8_t h, s, v;
+  CHSV(uint8_t hue, uint8_t sat, uint8_t val) : h(hue), s(sat), v(val) {}
+};
+
+struct CRGB {
+  uint8_t r, g, b;
+
+  enum HTMLColorCode : uint32_t {
+    Black = 0x000000,
+    Blue = 0x0000FF,
+    Cyan = 0x00FFFF,
+    Green = 0x008000,
+    Orange = 0xFFA500,
+    Purple = 0x800080,
+    Red = 0xFF0000,
+    White = 0xFFFFFF,
+    Yellow = 0xFFFF00,
+  };
+
+  CRGB() : r(0), g(0), b(0) {}
+  CRGB(uint8_t red, uint8_t green, uint8_t blue) : r(red), g(green), b(blue) {}
+  CRGB(HTMLColorCode code) : r(code >> 16), g(code >> 8), b(code) {}
+  CRGB(uint32_t code) : r(code >> 16), g(code >> 8), b(code) {}
+  CRGB(const CHSV& hsv);
+
+  bool operator==(const CRGB& rhs) const { return r == rhs.r && g == rhs.g && b == rhs.b; }
+  bool operator!=(const CRGB& rhs) const { return !(*this == rhs); }
+};
+
+class CFastLED {
+ public:
+  template <int CHIPSET, int DATA_PIN, int RGB_ORDER>
+  void addLeds(CRGB* leds, int count) { _leds = leds; _count = count; }
+  void setBrightness(uint8_t brightness) { _brightness = brightness; }
+  void show() { _shows++; }
+  uint32_t showCount() const { return _shows; }
+
+ private:
+  CRGB* _leds = nullptr;
+  int _count = 0;
+  uint8_t _brightness = 255;
+  uint32_t _shows = 0;
+};
+
+extern CFastLED FastLED;
+
+#endif // NATIVE_FASTLED_H
@@ -0,0 +1,177 @@
+#include "Arduino.h"
+#include "virtual_bus.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <thread>
+#include <unistd.h>
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+HardwareSerial Serial0(2);
+
+static uint32_t charTimeUs(unsigned long baud, uint32_t config) {
+  if (baud == 0) return 0;
+  uint32_t bits = 1 + (((config >> 2) & 0x03) + 5) + ((config & 0x03) ? 1 : 0) +
+                  (((config >> 4) & 0x03) == 0x03 ? 2 : 1);
+  return (bits * 1000000UL + baud - 1) / baud;
+}
+
+bool HardwareSerial::openPort() {
+  if (_fd >= 0) return true;
+
+  if (_uartNr == 0) {
+    _fd = STDIN_FILENO;
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+  } else {
+    _fd = virtualBusOpenPort(segment());
+  }
+  return _fd >= 0;
+}
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t, int8_t, bool,
+                           unsigned long, uint8_t) {
+  _baud = baud;
+  _config = config;
+  openPort();
+  if (_uartNr != 0) {
+    virtualBusSetLine(segment(), _fd, baud, config);
+  }
+}
+
+void HardwareSerial::end(bool) {
+  // The pty stays open so the simulator keeps its peer; only settings reset
+  _peeked = -1;
+}
+
+void HardwareSerial::updateBaudRate(unsigned long baud) {
+  begin(baud, _config);
+}
+
+int HardwareSerial::available() {
+  if (!openPort()) return 0;
+  int count = 0;
+  if (ioctl(_fd, FIONREAD, &count) < 0) count = 0;
+  if (count == 0 && _peeked < 0 && _uartNr != 0) {
+    // Wait loops spin on available(); give the simulator thread the CPU
+    // so a single-core host does not stretch its reply timing
+    usleep(20);
+  }
+  return count + (_peeked >= 0 ? 1 : 0);
+}
+
+int HardwareSerial::peek() {
+  if (_peeked < 0) _peeked = read();
+  return _peeked;
+}
+
+int HardwareSerial::read() {
+  if (_peeked >= 0) {
+    int c = _peeked;
+    _peeked = -1;
+    return c;
+  }
+  if (!openPort()) return -1;
+  uint8_t c;
+  if (::read(_fd, &c, 1) != 1) return -1;
+  _rxConsumed++;
+  return c;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  if (_uartNr == 0) {
+    _bytesWritten += size;
+    if (_muted) return size;
+    ssize_t written = ::write(STDOUT_FILENO, buffer, size);
+    return written < 0 ? 0 : written;
+  }
+
+  if (!openPort() || _baud == 0) return 0;
+  uint64_t now = nativeMicros64();
+  if (_txIdleAtUs < now) _txIdleAtUs = now;
+  _txIdleAtUs += size * charTimeUs(_baud, _config);
+
+  ssize_t written = ::write(_fd, buffer, size);
+  return written < 0 ? 0 : written;
+}
+
+void HardwareSerial::flush() {
+  if (_uartNr == 0) return;
+  nativeSleepUntilUs(_txIdleAtUs);
+}
+
+void HardwareSerial::onReceive(OnReceiveCb function, bool onlyOnTimeout) {
+  std::lock_guard<std::mutex> lock(_rxMutex);
+  _onReceive = function;
+  _onlyOnTimeout = onlyOnTimeout;
+  if (_onReceive && !_watching && _uartNr != 0) {
+    _watching = true;
+    std::thread([this] { watchReceive(); }).detach();
+  }
+}
+
+bool HardwareSerial::setRxTimeout(uint8_t symbols) {
+  _rxTimeout = symbols;
+  return true;
+}
+
+bool HardwareSerial::setRxFIFOFull(uint8_t fifoBytes) {
+  _rxFifoFull = fifoBytes > 0 ? fifoBytes : 1;
+  return true;
+}
+
+// Stands in for the UART's RX interrupts: polls the port a few times per
+// character and raises a FIFO-full event when more than rxfifoFull bytes have
+// come in since the last event, and a timeout event once the line has been quiet for
+// the RX timeout after the last byte. Bytes reach the pty in bursts at the
+// mercy of the host scheduler, so the line only counts as quiet once the
+// simulator's reply has ended on its own clock as well.
+
+void HardwareSerial::watchReceive() {
+  uint32_t lastReceived = _rxConsumed;
+  uint32_t sinceEvent = 0;
+  uint64_t lastByteUs = 0;
+  bool timeoutArmed = false;
+
+  for (;;) {
+    uint32_t charUs = charTimeUs(_baud ? _baud : 9600, _config);
+    nativeSleepUntilUs(nativeMicros64() + (charUs / 4 > 0 ? charUs / 4 : 1));
+
+    // Consumed first: a read() between the two samples then hides a byte
+    // for one round instead of counting it twice
+    uint32_t consumed = _rxConsumed;   // A peeked byte already counts as consumed
+    int queued = 0;
+    if (_fd < 0 || ioctl(_fd, FIONREAD, &queued) < 0) queued = 0;
+    uint32_t received = consumed + queued;
+    if ((int32_t)(received - lastReceived) < 0) continue;
+    uint64_t now = nativeMicros64();
+
+    uint64_t quietFromUs = max(lastByteUs, virtualBusReplyEndUs(segment()));
+    bool fire = false;
+    bool timeout = false;
+    if (received != lastReceived) {
+      sinceEvent += received - lastReceived;
+      lastReceived = received;
+      lastByteUs = now;
+      timeoutArmed = true;
+      if (sinceEvent > _rxFifoFull) fire = true;   // Like the hardware: more than the threshold
+    } else if (timeoutArmed && quietFromUs != UINT64_MAX && now >= quietFromUs + _rxTimeout * charUs) {
+      fire = timeout = true;
+      timeoutArmed = false;
+    }
+    if (!fire) continue;
+    sinceEvent = 0;
+
+    OnReceiveCb callback;
+    {
+      std::lock_guard<std::mutex> lock(_rxMutex);
+      if (!_onlyOnTimeout || timeout) callback = _onReceive;
+    }
+    if (callback) callback();
+  }
+}
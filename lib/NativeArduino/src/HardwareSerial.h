@@ -0,0 +1,79 @@
+#ifndef NATIVE_HARDWARESERIAL_H
+#define NATIVE_HARDWARESERIAL_H
+
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include "Stream.h"
+
+typedef std::function<void(void)> OnReceiveCb;
+
+// UART 0 is the console (stdin/stdout); UART 1 is the RS485 bus, backed by
+// the virtual bus pty (or a real serial device, see virtual_bus.h). Serial0
+// stands in for the second bus port (the target's UART0 while the console
+// runs over USB CDC) and uses the virtual bus's second segment.
+class HardwareSerial : public Stream {
+ public:
+  explicit HardwareSerial(int uartNr) : _uartNr(uartNr) {}
+
+  void begin(unsigned long baud, uint32_t config = 0x800001c, int8_t rxPin = -1, int8_t txPin = -1,
+             bool invert = false, unsigned long timeoutMs = 20000UL, uint8_t rxfifoFullThrhd = 112);
+  void end(bool fullyTerminate = true);
+  void updateBaudRate(unsigned long baud);
+  unsigned long baudRate() const { return _baud; }
+  uint32_t getConfig() const { return _config; }
+
+  int available() override;
+  int peek() override;
+  int read() override;
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+
+  // Bus port: blocks until the bytes written so far have left the "wire"
+  // at the configured baud rate, like the ESP32 core's flush()
+  void flush() override;
+
+  // RX events as in the ESP32 core: the callback runs when more than
+  // rxfifoFull bytes have arrived or the line has been idle for the RX
+  // timeout (in character times); with onlyOnTimeout only the latter
+  void onReceive(OnReceiveCb function, bool onlyOnTimeout = false);
+  bool setRxTimeout(uint8_t symbols);
+  bool setRxFIFOFull(uint8_t fifoBytes);
+
+  operator bool() const { return true; }
+
+  // Native only: silence console output and count what would have been
+  // written (used by the benchmarks)
+  void setMuted(bool muted) { _muted = muted; }
+  uint32_t bytesWritten() const { return _bytesWritten; }
+
+ private:
+  bool openPort();
+  void watchReceive();
+  int segment() const { return _uartNr - 1; }
+
+  int _uartNr;
+  int _fd = -1;
+  int _peeked = -1;
+  bool _muted = false;
+  uint32_t _bytesWritten = 0;
+  unsigned long _baud = 0;
+  uint32_t _config = 0x800001c;
+  uint64_t _txIdleAtUs = 0;   // Virtual time at which the last written byte is on the wire
+
+  std::mutex _rxMutex;
+  OnReceiveCb _onReceive;
+  bool _onlyOnTimeout = false;
+  bool _watching = false;
+  std::atomic<uint8_t> _rxTimeout{2};
+  std::atomic<uint8_t> _rxFifoFull{112};
+  std::atomic<uint32_t> _rxConsumed{0};   // Bytes taken by read(), so the watcher can count arrivals
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial0;
+
+#endif // NATIVE_HARDWARESERIAL_H
@@ -0,0 +1,127 @@
+#include "Preferences.h"
+
+#include <map>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+typedef std::map<std::string, std::vector<uint8_t>> Entries;
+
+static std::map<std::string, Entries> store;
+static std::mutex storeMutex;
+static bool loaded = false;
+
+static const char* storePath() {
+  const char* path = getenv("MODBUS_NATIVE_NVS");
+  return path && *path ? path : nullptr;
+}
+
+// File format: repeated <namespace>\0<key>\0<uint32 length><bytes>
+static void loadStore() {
+  loaded = true;
+  const char* path = storePath();
+  FILE* file = path ? fopen(path, "rb") : nullptr;
+  if (!file) return;
+
+  std::vector<char> data;
+  char chunk[4096];
+  size_t count;
+  while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0) data.insert(data.end(), chunk, chunk + count);
+  fclose(file);
+
+  size_t pos = 0;
+  while (pos < data.size()) {
+    std::string ns(&data[pos]);
+    pos += ns.size() + 1;
+    if (pos >= data.size()) break;
+    std::string key(&data[pos]);
+    pos += key.size() + 1;
+    uint32_t length;
+    if (pos + sizeof(length) > data.size()) break;
+    memcpy(&length, &data[pos], sizeof(length));
+    pos += sizeof(length);
+    if (pos + length > data.size()) break;
+    store[ns][key].assign(data.begin() + pos, data.begin() + pos + length);
+    pos += length;
+  }
+}
+
+static void saveStore() {
+  const char* path = storePath();
+  FILE* file = path ? fopen(path, "wb") : nullptr;
+  if (!file) return;
+  for (const auto& ns : store) {
+    for (const auto& entry : ns.second) {
+      uint32_t length = entry.second.size();
+      fwrite(ns.first.c_str(), 1, ns.first.size() + 1, file);
+      fwrite(entry.first.c_str(), 1, entry.first.size() + 1, file);
+      fwrite(&length, sizeof(length), 1, file);
+      fwrite(entry.second.data(), 1, length, file);
+    }
+  }
+  fclose(file);
+}
+
+bool Preferences::begin(const char* name, bool readOnly, const char*) {
+  std::lock_guard<std::mutex> lock(storeMutex);
+  if (!loaded) loadStore();
+  _namespace = name;
+  _readOnly = readOnly;
+  _open = true;
+  return true;
+}
+
+void Preferences::end() {
+  _open = false;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+  if (!_open || _readOnly) return 0;
+  std::lock_guard<std::mutex> lock(storeMutex);
+  const uint8_t* bytes = (const uint8_t*)value;
+  store[_namespace][key].assign(bytes, bytes + length);
+  saveStore();
+  return length;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t maxLength) {
+  if (!_open) return 0;
+  std::lock_guard<std::mutex> lock(storeMutex);
+  auto ns = store.find(_namespace);
+  if (ns == store.end()) return 0;
+  auto entry = ns->second.find(key);
+  if (entry == ns->second.end() || entry->second.size() > maxLength) return 0;
+  memcpy(buffer, entry->second.data(), entry->second.size());
+  return entry->second.size();
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  if (!_open) return 0;
+  std::lock_guard<std::mutex> lock(storeMutex);
+  auto ns = store.find(_namespace);
+  if (ns == store.end()) return 0;
+  auto entry = ns->second.find(key);
+  return entry == ns->second.end() ? 0 : entry->second.size();
+}
+
+bool Preferences::isKey(const char* key) {
+  return getBytesLength(key) > 0;
+}
+
+bool Preferences::remove(const char* key) {
+  if (!_open || _readOnly) return false;
+  std::lock_guard<std::mutex> lock(storeMutex);
+  bool removed = store[_namespace].erase(key) > 0;
+  saveStore();
+  return removed;
+}
+
+bool Preferences::clear() {
+  if (!_open || _readOnly) return false;
+  std::lock_guard<std::mutex> lock(storeMutex);
+  store.erase(_namespace);
+  saveStore();
+  return true;
+}
@@ -0,0 +1,29 @@
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// NVS stand-in for the native build: byte values per namespace and key,
+// kept in memory and, when MODBUS_NATIVE_NVS names a file, saved there on
+// every change so they survive a restart like flash does.
+class Preferences {
+ public:
+  bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+  void end();
+
+  size_t putBytes(const char* key, const void* value, size_t length);
+  size_t getBytes(const char* key, void* buffer, size_t maxLength);
+  size_t getBytesLength(const char* key);
+  bool isKey(const char* key);
+  bool remove(const char* key);
+  bool clear();
+
+ private:
+  std::string _namespace;
+  bool _open = false;
+  bool _readOnly = false;
+};
+
+#endif // NATIVE_PREFERENCES_H
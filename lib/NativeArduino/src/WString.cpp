@@ -0,0 +1,98 @@
+#include "Arduino.h"
+
+#include <ctype.h>
+
+static std::string toBase(unsigned long value, unsigned char base) {
+  if (base < 2 || base > 36) base = 10;
+  if (value == 0) return "0";
+  std::string digits;
+  while (value > 0) {
+    unsigned long digit = value % base;
+    digits.insert(digits.begin(), (char)(digit < 10 ? '0' + digit : 'a' + digit - 10));
+    value /= base;
+  }
+  return digits;
+}
+
+static std::string toBaseSigned(long value, unsigned char base) {
+  if (value < 0 && base == 10) return "-" + toBase((unsigned long)(-value), base);
+  return toBase((unsigned long)value, base);
+}
+
+static std::string toDecimal(double value, unsigned char decimalPlaces) {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, value);
+  return buffer;
+}
+
+String::String(unsigned char value, unsigned char base) : _buffer(toBase(value, base)) {}
+String::String(int value, unsigned char base) : _buffer(toBaseSigned(value, base)) {}
+String::String(unsigned int value, unsigned char base) : _buffer(toBase(value, base)) {}
+String::String(long value, unsigned char base) : _buffer(toBaseSigned(value, base)) {}
+String::String(unsigned long value, unsigned char base) : _buffer(toBase(value, base)) {}
+String::String(float value, unsigned char decimalPlaces) : _buffer(toDecimal(value, decimalPlaces)) {}
+String::String(double value, unsigned char decimalPlaces) : _buffer(toDecimal(value, decimalPlaces)) {}
+
+bool String::equalsIgnoreCase(const String& other) const {
+  if (_buffer.size() != other._buffer.size()) return false;
+  for (size_t i = 0; i < _buffer.size(); i++) {
+    if (tolower((unsigned char)_buffer[i]) != tolower((unsigned char)other._buffer[i])) return false;
+  }
+  return true;
+}
+
+bool String::endsWith(const String& suffix) const {
+  if (suffix._buffer.size() > _buffer.size()) return false;
+  return _buffer.compare(_buffer.size() - suffix._buffer.size(), suffix._buffer.size(), suffix._buffer) == 0;
+}
+
+int String::indexOf(char c, unsigned int fromIndex) const {
+  size_t pos = _buffer.find(c, fromIndex);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String& str, unsigned int fromIndex) const {
+  size_t pos = _buffer.find(str._buffer, fromIndex);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char c) const {
+  size_t pos = _buffer.rfind(c);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int beginIndex) const {
+  if (beginIndex >= _buffer.size()) return String();
+  return String(_buffer.substr(beginIndex));
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+  if (beginIndex > endIndex) std::swap(beginIndex, endIndex);
+  if (beginIndex >= _buffer.size()) return String();
+  return String(_buffer.substr(beginIndex, endIndex - beginIndex));
+}
+
+void String::trim() {
+  size_t first = 0;
+  while (first < _buffer.size() && isspace((unsigned char)_buffer[first])) first++;
+  size_t last = _buffer.size();
+  while (last > first && isspace((unsigned char)_buffer[last - 1])) last--;
+  _buffer = _buffer.substr(first, last - first);
+}
+
+void String::toLowerCase() {
+  for (char& c : _buffer) c = tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+  for (char& c : _buffer) c = toupper((unsigned char)c);
+}
+
+void String::replace(const String& find, const String& replacement) {
+  if (find._buffer.empty()) return;
+  size_t pos = 0;
+  while ((pos = _buffer.find(find._buffer, pos)) != std::string::npos) {
+    _buffer.replace(pos, find._buffer.size(), replacement._buffer);
+    pos += replacement._buffer.size();
+  }
+}
@@ -0,0 +1,71 @@
+#ifndef NATIVE_WSTRING_H
+#define NATIVE_WSTRING_H
+
+#include <string>
+
+// Arduino String on top of std::string, covering what the scanner uses
+class String {
+ public:
+  String(const char* cstr = "") : _buffer(cstr ? cstr : "") {}
+  String(const std::string& str) : _buffer(str) {}
+  explicit String(char c) : _buffer(1, c) {}
+  explicit String(unsigned char value, unsigned char base = 10);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(float value, unsigned char decimalPlaces = 2);
+  explicit String(double value, unsigned char decimalPlaces = 2);
+
+  const char* c_str() const { return _buffer.c_str(); }
+  unsigned int length() const { return _buffer.size(); }
+  bool isEmpty() const { return _buffer.empty(); }
+  void reserve(unsigned int size) { _buffer.reserve(size); }
+
+  char charAt(unsigned int index) const { return index < _buffer.size() ? _buffer[index] : 0; }
+  char operator[](unsigned int index) const { return charAt(index); }
+  void setCharAt(unsigned int index, char c) { if (index < _buffer.size()) _buffer[index] = c; }
+
+  bool equals(const String& other) const { return _buffer == other._buffer; }
+  bool equalsIgnoreCase(const String& other) const;
+  bool startsWith(const String& prefix) const { return _buffer.compare(0, prefix._buffer.size(), prefix._buffer) == 0; }
+  bool endsWith(const String& suffix) const;
+  int indexOf(char c, unsigned int fromIndex = 0) const;
+  int indexOf(const String& str, unsigned int fromIndex = 0) const;
+  int lastIndexOf(char c) const;
+  String substring(unsigned int beginIndex) const;
+  String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+  void trim();
+  void toLowerCase();
+  void toUpperCase();
+  void remove(unsigned int index) { if (index < _buffer.size()) _buffer.erase(index); }
+  void remove(unsigned int index, unsigned int count) { if (index < _buffer.size()) _buffer.erase(index, count); }
+  void replace(const String& find, const String& replacement);
+
+  long toInt() const { return strtol(_buffer.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(_buffer.c_str(), nullptr); }
+  double toDouble() const { return strtod(_buffer.c_str(), nullptr); }
+
+  String& operator+=(const String& rhs) { _buffer += rhs._buffer; return *this; }
+  String& operator+=(const char* rhs) { _buffer += rhs; return *this; }
+  String& operator+=(char rhs) { _buffer += rhs; return *this; }
+  bool concat(const String& rhs) { _buffer += rhs._buffer; return true; }
+  bool concat(char rhs) { _buffer += rhs; return true; }
+
+  bool operator==(const String& rhs) const { return _buffer == rhs._buffer; }
+  bool operator==(const char* rhs) const { return _buffer == rhs; }
+  bool operator!=(const String& rhs) const { return _buffer != rhs._buffer; }
+  bool operator!=(const char* rhs) const { return _buffer != rhs; }
+  bool operator<(const String& rhs) const { return _buffer < rhs._buffer; }
+
+  friend String operator+(const String& lhs, const String& rhs) { return String(lhs._buffer + rhs._buffer); }
+  friend String operator+(const String& lhs, const char* rhs) { return String(lhs._buffer + rhs); }
+  friend String operator+(const char* lhs, const String& rhs) { return String(lhs + rhs._buffer); }
+  friend String operator+(const String& lhs, char rhs) { return String(lhs._buffer + rhs); }
+
+ private:
+  std::string _buffer;
+};
+
+#endif // NATIVE_WSTRING_H
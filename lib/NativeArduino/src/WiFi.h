@@ -0,0 +1,32 @@
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+#include "Arduino.h"
+
+// WiFi stand-in for the native build: the host network is always up, so
+// the gateway's sockets go straight to the host stack on every interface.
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_CONNECTED = 3,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+#define WIFI_STA 1
+
+class NativeIpAddress {
+ public:
+  String toString() const { return "0.0.0.0"; }
+};
+
+class WiFiClass {
+ public:
+  bool mode(int) { return true; }
+  wl_status_t begin(const char*, const char* = nullptr) { return WL_CONNECTED; }
+  wl_status_t status() { return WL_CONNECTED; }
+  NativeIpAddress localIP() { return NativeIpAddress(); }
+};
+
+inline WiFiClass WiFi;
+
+#endif // NATIVE_WIFI_H
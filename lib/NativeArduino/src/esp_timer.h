@@ -0,0 +1,12 @@
+#ifndef NATIVE_ESP_TIMER_H
+#define NATIVE_ESP_TIMER_H
+
+#include <stdint.h>
+#include "Arduino.h"
+
+// esp_timer stand-in for the native build: the same 64-bit microsecond
+// clock as micros(), time scale included.
+
+inline int64_t esp_timer_get_time() { return (int64_t)nativeMicros64(); }
+
+#endif // NATIVE_ESP_TIMER_H
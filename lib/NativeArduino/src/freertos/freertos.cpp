@@ -0,0 +1,193 @@
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "task.h"
+
+#include <Arduino.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+struct NativeTask {
+  TaskFunction_t function;
+  void* parameter;
+};
+
+struct NativeQueue {
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::deque<std::vector<uint8_t>> items;
+  UBaseType_t length;
+  UBaseType_t itemSize;
+};
+
+struct NativeSemaphore {
+  std::mutex mutex;
+  std::condition_variable changed;
+  int count;
+  bool isMutex;
+  std::thread::id owner;
+  int depth;
+};
+
+static thread_local NativeTask* currentTask = nullptr;
+
+// Wait on `changed` until ready() holds or the ticks (virtual ms) run out
+template <typename Ready>
+static bool waitFor(std::condition_variable& changed, std::unique_lock<std::mutex>& lock, TickType_t ticks,
+                    Ready ready) {
+  if (ticks == portMAX_DELAY) {
+    changed.wait(lock, ready);
+    return true;
+  }
+  auto wall = std::chrono::microseconds(ticks * 1000ULL / nativeTimeScale());
+  return changed.wait_for(lock, wall, ready);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char*, uint32_t, void* parameter, UBaseType_t,
+                       TaskHandle_t* handle) {
+  NativeTask* task = new NativeTask{function, parameter};
+  if (handle) *handle = task;
+  std::thread([task] {
+    currentTask = task;
+    task->function(task->parameter);
+  }).detach();
+  return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth,
+                                   void* parameter, UBaseType_t priority, TaskHandle_t* handle, BaseType_t) {
+  return xTaskCreate(function, name, stackDepth, parameter, priority, handle);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  return currentTask;
+}
+
+TickType_t xTaskGetTickCount() {
+  return (TickType_t)millis();
+}
+
+void vTaskDelay(TickType_t ticks) {
+  if (ticks == 0) {
+    std::this_thread::yield();
+  } else {
+    delay(ticks);
+  }
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  NativeQueue* queue = new NativeQueue;
+  queue->length = length;
+  queue->itemSize = itemSize;
+  return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticksToWait) {
+  std::unique_lock<std::mutex> lock(queue->mutex);
+  if (!waitFor(queue->changed, lock, ticksToWait, [&] { return queue->items.size() < queue->length; })) {
+    return errQUEUE_FULL;
+  }
+  const uint8_t* bytes = (const uint8_t*)item;
+  queue->items.emplace_back(bytes, bytes + queue->itemSize);
+  queue->changed.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void* item) {
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  if (queue->items.size() >= queue->length) queue->items.pop_back();
+  const uint8_t* bytes = (const uint8_t*)item;
+  queue->items.emplace_back(bytes, bytes + queue->itemSize);
+  queue->changed.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* buffer, TickType_t ticksToWait) {
+  std::unique_lock<std::mutex> lock(queue->mutex);
+  if (!waitFor(queue->changed, lock, ticksToWait, [&] { return !queue->items.empty(); })) {
+    return pdFALSE;
+  }
+  memcpy(buffer, queue->items.front().data(), queue->itemSize);
+  queue->items.pop_front();
+  queue->changed.notify_all();
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  return queue->items.size();
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  return queue->length - queue->items.size();
+}
+
+static SemaphoreHandle_t createSemaphore(int count, bool isMutex) {
+  NativeSemaphore* semaphore = new NativeSemaphore;
+  semaphore->count = count;
+  semaphore->isMutex = isMutex;
+  semaphore->depth = 0;
+  return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return createSemaphore(1, true);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+  return createSemaphore(1, true);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+  return createSemaphore(0, false);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait) {
+  std::unique_lock<std::mutex> lock(semaphore->mutex);
+  if (!waitFor(semaphore->changed, lock, ticksToWait, [&] { return semaphore->count > 0; })) {
+    return pdFALSE;
+  }
+  semaphore->count--;
+  semaphore->owner = std::this_thread::get_id();
+  semaphore->depth = 1;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  std::lock_guard<std::mutex> lock(semaphore->mutex);
+  if (semaphore->isMutex) {
+    if (semaphore->owner != std::this_thread::get_id() || semaphore->count > 0) return pdFALSE;
+    semaphore->owner = std::thread::id();
+  } else if (semaphore->count > 0) {
+    return pdFALSE; // Binary: already given
+  }
+  semaphore->count++;
+  semaphore->changed.notify_all();
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t ticksToWait) {
+  {
+    std::lock_guard<std::mutex> lock(semaphore->mutex);
+    if (semaphore->count == 0 && semaphore->owner == std::this_thread::get_id()) {
+      semaphore->depth++;
+      return pdTRUE;
+    }
+  }
+  return xSemaphoreTake(semaphore, ticksToWait);
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore) {
+  {
+    std::lock_guard<std::mutex> lock(semaphore->mutex);
+    if (semaphore->owner != std::this_thread::get_id()) return pdFALSE;
+    if (--semaphore->depth > 0) return pdTRUE;
+  }
+  return xSemaphoreGive(semaphore);
+}
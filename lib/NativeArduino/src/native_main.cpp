@@ -0,0 +1,24 @@
+#include "Arduino.h"
+#include "virtual_bus.h"
+
+// Entry point for the interactive native build: same setup()/loop() as the
+// firmware, console on stdin/stdout, Serial1 on the virtual bus. The
+// benchmark build provides its own main().
+#ifndef NATIVE_BENCH
+
+int main() {
+  const char* scale = getenv("MODBUS_SIM_TIMESCALE");
+  if (scale) nativeSetTimeScale(strtoul(scale, nullptr, 10));
+
+  setup();
+  if (!getenv("MODBUS_NATIVE_PORT")) {
+    printf("🧪 Virtual RTU bus on %s:\n", virtualBusPortName());
+    virtualBusPrintLayout();
+  }
+
+  for (;;) {
+    loop();
+  }
+}
+
+#endif // NATIVE_BENCH
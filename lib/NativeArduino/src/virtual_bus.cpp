@@ -0,0 +1,869 @@
+#include "Arduino.h"
+#include "virtual_bus.h"
+
+#include <atomic>
+#include <errno.h>
+#include <fcntl.h>
+#include <mutex>
+#include <poll.h>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+
+// Register tables, numbered like the read function codes minus one
+enum SimTable { SIM_COILS, SIM_DISCRETE_INPUTS, SIM_HOLDING_REGISTERS, SIM_INPUT_REGISTERS };
+
+// A block of valid addresses. Registers read base + (address - first), plus
+// up to +/- noise that changes on every read; bits read bit
+// (address - first) % 16 of base.
+struct SimRange {
+  uint8_t table;
+  uint16_t first;
+  uint16_t last;
+  uint16_t base;
+  uint16_t noise;
+};
+
+struct SimProfile {
+  const char* name;
+  const SimRange* ranges;
+  uint8_t rangeCount;
+};
+
+struct SimSlave {
+  uint8_t id;
+  unsigned long baud;
+  uint32_t config;
+  uint16_t turnaroundMs;
+  const SimProfile* profile;
+  uint8_t garblePercent;      // Replies with a flipped bit, like line noise
+  uint8_t lossPercent;        // Requests left unanswered
+};
+
+static const SimRange genericRanges[] = {
+  {SIM_HOLDING_REGISTERS, 0, 99, 1000},
+  {SIM_INPUT_REGISTERS, 0, 99, 2000},
+  {SIM_COILS, 0, 63, 0x5555},
+  {SIM_DISCRETE_INPUTS, 0, 63, 0x3333},
+};
+
+// TEC QRS11 heat pump, values as documented for menu option 6
+static const SimRange tecRanges[] = {
+  {SIM_INPUT_REGISTERS, 1, 1, 452},      // B1 inlet 45.2 C
+  {SIM_INPUT_REGISTERS, 2, 2, 487},      // B2 outlet 48.7 C
+  {SIM_INPUT_REGISTERS, 3, 3, 124},      // T2 ambient 12.4 C
+  {SIM_INPUT_REGISTERS, 4, 4, 85},       // T4 suction
+  {SIM_INPUT_REGISTERS, 5, 5, 652},      // T3 discharge
+  {SIM_INPUT_REGISTERS, 6, 6, 23},       // B6 low pressure 2.3 bar
+  {SIM_INPUT_REGISTERS, 7, 7, 185},      // B7 high pressure 18.5 bar
+  {SIM_INPUT_REGISTERS, 8, 8, 12},       // Flow
+  {SIM_INPUT_REGISTERS, 9, 9, 210},      // Room temperature
+  {SIM_INPUT_REGISTERS, 10, 12, 0},
+  {SIM_INPUT_REGISTERS, 13, 13, 45},     // Compressor 45 Hz
+  {SIM_INPUT_REGISTERS, 14, 14, 875},    // Y3 pump PWM 87.5 %
+  {SIM_INPUT_REGISTERS, 15, 16, 0},
+  {SIM_INPUT_REGISTERS, 17, 17, 505},    // B4 hot water
+  {SIM_INPUT_REGISTERS, 18, 18, 12345},  // Operating hours
+  {SIM_INPUT_REGISTERS, 19, 19, 0},
+  {SIM_INPUT_REGISTERS, 20, 20, 1},      // Unit state: heating
+  {SIM_HOLDING_REGISTERS, 61, 61, 120},  // ST01 cooling 12.0 C
+  {SIM_HOLDING_REGISTERS, 62, 62, 450},  // ST02 heating 45.0 C
+  {SIM_HOLDING_REGISTERS, 63, 78, 0},
+  {SIM_HOLDING_REGISTERS, 79, 79, 500},  // ST09 DHW 50.0 C
+  {SIM_HOLDING_REGISTERS, 80, 80, 50},   // ST10 DHW difference 5.0 C
+  {SIM_DISCRETE_INPUTS, 1, 8, 0},        // AL01-AL19, no alarms
+};
+
+// Same unit with firmware that only maps the documented registers: reads
+// that span an undocumented address fail with Illegal Data Address
+static const SimRange tecStrictRanges[] = {
+  {SIM_INPUT_REGISTERS, 1, 1, 452},
+  {SIM_INPUT_REGISTERS, 2, 2, 487},
+  {SIM_INPUT_REGISTERS, 3, 3, 124},
+  {SIM_INPUT_REGISTERS, 4, 4, 85},
+  {SIM_INPUT_REGISTERS, 5, 5, 652},
+  {SIM_INPUT_REGISTERS, 6, 6, 23},
+  {SIM_INPUT_REGISTERS, 7, 7, 185},
+  {SIM_INPUT_REGISTERS, 8, 8, 12},
+  {SIM_INPUT_REGISTERS, 9, 9, 210},
+  {SIM_INPUT_REGISTERS, 13, 13, 45},
+  {SIM_INPUT_REGISTERS, 14, 14, 875},
+  {SIM_INPUT_REGISTERS, 17, 17, 505},
+  {SIM_INPUT_REGISTERS, 18, 18, 12345},
+  {SIM_INPUT_REGISTERS, 20, 20, 1},
+  {SIM_HOLDING_REGISTERS, 61, 61, 120},
+  {SIM_HOLDING_REGISTERS, 62, 62, 450},
+  {SIM_HOLDING_REGISTERS, 79, 79, 500},
+  {SIM_HOLDING_REGISTERS, 80, 80, 50},
+  {SIM_DISCRETE_INPUTS, 1, 8, 0},
+};
+
+// Scattered blocks with gaps that answer with Illegal Data Address
+static const SimRange sparseRanges[] = {
+  {SIM_HOLDING_REGISTERS, 0, 9, 0},
+  {SIM_HOLDING_REGISTERS, 100, 119, 100},
+  {SIM_HOLDING_REGISTERS, 1000, 1049, 1000},
+  {SIM_HOLDING_REGISTERS, 4321, 4340, 4321},     // Off the seed grid: only the gap sweep finds it
+  {SIM_HOLDING_REGISTERS, 40000, 40009, 40000},
+  {SIM_INPUT_REGISTERS, 0, 4, 7},
+  {SIM_INPUT_REGISTERS, 30000, 30019, 3000},
+  {SIM_COILS, 0, 15, 0x00FF},
+};
+
+// Energy meter style map: measurements in input registers, setup in holding
+static const SimRange meterRanges[] = {
+  {SIM_INPUT_REGISTERS, 0, 79, 0x4300},
+  {SIM_HOLDING_REGISTERS, 0, 19, 0},
+};
+
+// Devices from the fingerprint database, as far as identification reads them.
+// Float measurements only need their high word in range.
+static const SimRange sdm120Ranges[] = {
+  {SIM_INPUT_REGISTERS, 0, 11, 0x4366},      // Voltage 230 V, current, power
+  {SIM_INPUT_REGISTERS, 70, 71, 0x4248},     // Frequency 50 Hz
+  {SIM_HOLDING_REGISTERS, 2, 3, 0},
+};
+
+static const SimRange sdm630Ranges[] = {
+  {SIM_INPUT_REGISTERS, 0, 11, 0x4366},      // Phase voltages and currents
+  {SIM_INPUT_REGISTERS, 70, 71, 0x4248},
+  {SIM_INPUT_REGISTERS, 200, 205, 0x43C7},   // Line-to-line voltages 398 V
+  {SIM_HOLDING_REGISTERS, 2, 3, 0},
+};
+
+static const SimRange ddsu666Ranges[] = {
+  {SIM_HOLDING_REGISTERS, 0, 0, 0x0100},     // Firmware revision
+  {SIM_HOLDING_REGISTERS, 0x2000, 0x2003, 0x4366},
+  {SIM_HOLDING_REGISTERS, 0x2044, 0x2045, 0x4248},
+};
+
+static const SimRange pzem016Ranges[] = {
+  {SIM_INPUT_REGISTERS, 0, 0, 2301},         // 230.1 V
+  {SIM_INPUT_REGISTERS, 1, 6, 0},
+  {SIM_INPUT_REGISTERS, 7, 7, 500},          // 50.0 Hz
+  {SIM_INPUT_REGISTERS, 8, 8, 95},           // PF 0.95
+  {SIM_INPUT_REGISTERS, 9, 9, 0},
+  {SIM_HOLDING_REGISTERS, 1, 1, 2300},       // Power alarm threshold
+  {SIM_HOLDING_REGISTERS, 2, 2, 1},          // Slave address
+};
+
+static const SimRange pzem017Ranges[] = {
+  {SIM_INPUT_REGISTERS, 0, 0, 1250},         // 12.50 V
+  {SIM_INPUT_REGISTERS, 1, 7, 0},
+  {SIM_HOLDING_REGISTERS, 0, 1, 3000},       // Voltage alarm thresholds
+  {SIM_HOLDING_REGISTERS, 2, 2, 1},          // Slave address
+  {SIM_HOLDING_REGISTERS, 3, 3, 0},          // 100 A shunt
+};
+
+static const SimRange xymd02Ranges[] = {
+  {SIM_INPUT_REGISTERS, 1, 1, 215},          // 21.5 C
+  {SIM_INPUT_REGISTERS, 2, 2, 456},          // 45.6 %
+  {SIM_HOLDING_REGISTERS, 0x0101, 0x0101, 1},
+  {SIM_HOLDING_REGISTERS, 0x0102, 0x0102, 0},
+};
+
+static const SimRange r4dcb08Ranges[] = {
+  {SIM_HOLDING_REGISTERS, 0, 7, 215},        // Eight temperatures
+  {SIM_HOLDING_REGISTERS, 0x00FD, 0x00FD, 1},
+  {SIM_HOLDING_REGISTERS, 0x00FE, 0x00FE, 2},
+};
+
+static const SimRange relay8Ranges[] = {
+  {SIM_COILS, 0, 7, 0x00A5},
+  {SIM_HOLDING_REGISTERS, 0x4000, 0x4000, 1},
+  {SIM_HOLDING_REGISTERS, 0x8000, 0x8000, 0x0100},  // Firmware version
+};
+
+static const SimRange ain8Ranges[] = {
+  {SIM_INPUT_REGISTERS, 0, 7, 4000},         // Channels in mV
+  {SIM_HOLDING_REGISTERS, 0x1000, 0x1007, 0},
+  {SIM_HOLDING_REGISTERS, 0x4000, 0x4000, 1},
+};
+
+static const SimRange epeverRanges[] = {
+  {SIM_INPUT_REGISTERS, 0x3100, 0x3103, 1850},   // PV 18.50 V, ...
+  {SIM_INPUT_REGISTERS, 0x3104, 0x3104, 1320},   // Battery 13.20 V
+  {SIM_HOLDING_REGISTERS, 0x9000, 0x9000, 1},    // Sealed
+  {SIM_HOLDING_REGISTERS, 0x9001, 0x9001, 200},  // 200 Ah
+  {SIM_COILS, 2, 3, 0},
+  {SIM_DISCRETE_INPUTS, 0x2000, 0x2000, 0},
+};
+
+static const SimRange growattRanges[] = {
+  {SIM_INPUT_REGISTERS, 0, 0, 1},            // Normal
+  {SIM_INPUT_REGISTERS, 1, 99, 0},
+  {SIM_HOLDING_REGISTERS, 0, 0, 1},
+  {SIM_HOLDING_REGISTERS, 1, 8, 0},
+  {SIM_HOLDING_REGISTERS, 9, 11, 0x4748},    // "GH", ...
+};
+
+// A plant in steady state: measurements that flicker around their value,
+// setpoints and states that do not move
+static const SimRange plantRanges[] = {
+  {SIM_INPUT_REGISTERS, 0, 15, 2000, 3},     // Temperatures, a few tenths of noise
+  {SIM_INPUT_REGISTERS, 16, 23, 5000, 40},   // Flows and power, noisier
+  {SIM_INPUT_REGISTERS, 24, 31, 100, 0},     // States and counters
+  {SIM_HOLDING_REGISTERS, 0, 19, 200, 0},    // Setpoints
+  {SIM_COILS, 0, 15, 0x00F0, 0},
+  {SIM_DISCRETE_INPUTS, 0, 15, 0, 0},
+};
+
+#define PROFILE(name, ranges) {name, ranges, sizeof(ranges) / sizeof(ranges[0])}
+
+static const SimProfile profiles[] = {
+  PROFILE("generic", genericRanges),
+  PROFILE("tec", tecRanges),
+  PROFILE("tecstrict", tecStrictRanges),
+  PROFILE("sparse", sparseRanges),
+  PROFILE("meter", meterRanges),
+  PROFILE("sdm120", sdm120Ranges),
+  PROFILE("sdm630", sdm630Ranges),
+  PROFILE("ddsu666", ddsu666Ranges),
+  PROFILE("pzem016", pzem016Ranges),
+  PROFILE("pzem017", pzem017Ranges),
+  PROFILE("xymd02", xymd02Ranges),
+  PROFILE("r4dcb08", r4dcb08Ranges),
+  PROFILE("relay8", relay8Ranges),
+  PROFILE("ain8", ain8Ranges),
+  PROFILE("epever", epeverRanges),
+  PROFILE("growatt", growattRanges),
+  PROFILE("plant", plantRanges),
+};
+
+// Another master on the bus
+struct SimMaster {
+  bool enabled;
+  unsigned long baud;
+  uint32_t config;
+  uint16_t periodMs;
+};
+
+// One RS485 segment: its own slaves, pty, simulator thread and line
+// settings. Segment 0 backs Serial1, segment 1 the second bus port.
+struct SimSegment {
+  SimSlave slaves[VIRTUAL_BUS_MAX_SLAVES];
+  int slaveCount = 0;
+  SimMaster foreignMaster;
+
+  int ptyMaster = -1;
+  char ptyName[128];
+  bool externalPort = false;
+
+  std::thread thread;
+  std::atomic<unsigned long> lineBaud{0};
+  std::atomic<uint32_t> lineConfig{SERIAL_8N1};
+  std::atomic<uint64_t> replyEndUs{0};
+};
+
+static SimSegment segments[VIRTUAL_BUS_MAX_SEGMENTS];
+static std::atomic<bool> running{false};
+
+static std::atomic<uint32_t> statRequests{0};
+static std::atomic<uint32_t> statResponses{0};
+static std::atomic<uint32_t> statExceptions{0};
+static std::atomic<uint32_t> statMismatched{0};
+static std::atomic<uint32_t> statRxBytes{0};
+static std::atomic<uint32_t> statTxBytes{0};
+
+static std::mutex pulseMutex;
+static VirtualBusPulses pulses;
+
+static uint16_t crc16(const uint8_t* data, size_t length) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+  }
+  return crc;
+}
+
+static uint32_t charTimeUs(unsigned long baud, uint32_t config) {
+  uint32_t bits = 1 + (((config >> 2) & 0x03) + 5) + ((config & 0x03) ? 1 : 0) +
+                  (((config >> 4) & 0x03) == 0x03 ? 2 : 1);
+  return (bits * 1000000UL + baud - 1) / baud;
+}
+
+static bool parseFormat(const char* text, uint32_t* config) {
+  static const struct { const char* name; uint32_t config; } formats[] = {
+    {"8N1", SERIAL_8N1}, {"8N2", SERIAL_8N2}, {"8E1", SERIAL_8E1}, {"8E2", SERIAL_8E2},
+    {"8O1", SERIAL_8O1}, {"8O2", SERIAL_8O2}, {"7E1", SERIAL_7E1}, {"7O1", SERIAL_7O1},
+    {"7N1", SERIAL_7N1}, {"7E2", SERIAL_7E2}, {"7O2", SERIAL_7O2}, {"7N2", SERIAL_7N2},
+  };
+  for (const auto& format : formats) {
+    if (strncasecmp(text, format.name, 3) == 0) {
+      *config = format.config;
+      return true;
+    }
+  }
+  return false;
+}
+
+static const SimProfile* findProfile(const char* name, size_t length) {
+  for (const auto& profile : profiles) {
+    if (strlen(profile.name) == length && strncmp(profile.name, name, length) == 0) return &profile;
+  }
+  return nullptr;
+}
+
+static bool parseSegment(SimSegment& segment, const char* layout) {
+  SimSlave* slaves = segment.slaves;
+  int& slaveCount = segment.slaveCount;
+  SimMaster& foreignMaster = segment.foreignMaster;
+  slaveCount = 0;
+  foreignMaster.enabled = false;
+  const char* p = layout;
+
+  while (*p) {
+    while (*p == ',' || *p == ' ') p++;
+    if (!*p) break;
+
+    char* end;
+    if (*p == 'm' || *p == 'M') {
+      foreignMaster = {true, 9600, SERIAL_8N1, 200};
+      p++;
+      while (*p && *p != ',' && *p != ' ') {
+        char key = *p++;
+        if (key == '@') {
+          foreignMaster.baud = strtoul(p, &end, 10);
+          p = end;
+        } else if (key == ':' && parseFormat(p, &foreignMaster.config)) {
+          p += 3;
+        } else if (key == '~') {
+          foreignMaster.periodMs = strtoul(p, &end, 10);
+          p = end;
+        } else {
+          fprintf(stderr, "virtual bus: bad master entry in layout\n");
+          return false;
+        }
+      }
+      continue;
+    }
+
+    long firstId = strtol(p, &end, 10);
+    if (end == p || firstId < 1 || firstId > 247) {
+      fprintf(stderr, "virtual bus: bad slave ID in layout at '%s'\n", p);
+      return false;
+    }
+    p = end;
+    long lastId = firstId;
+    if (*p == '-') {
+      lastId = strtol(p + 1, &end, 10);
+      if (end == p + 1 || lastId < firstId || lastId > 247) {
+        fprintf(stderr, "virtual bus: bad slave ID range in layout at '%s'\n", p);
+        return false;
+      }
+      p = end;
+    }
+
+    SimSlave slave = {0, 9600, SERIAL_8N1, 10, &profiles[0], 0, 0};
+    while (*p && *p != ',' && *p != ' ') {
+      char key = *p++;
+      if (key == '@') {
+        slave.baud = strtoul(p, &end, 10);
+        p = end;
+      } else if (key == ':') {
+        if (!parseFormat(p, &slave.config)) {
+          fprintf(stderr, "virtual bus: unknown frame format '%.3s'\n", p);
+          return false;
+        }
+        p += 3;
+      } else if (key == '=') {
+        size_t length = strcspn(p, ",@:~%? ");
+        slave.profile = findProfile(p, length);
+        if (!slave.profile) {
+          fprintf(stderr, "virtual bus: unknown profile '%.*s'\n", (int)length, p);
+          return false;
+        }
+        p += length;
+      } else if (key == '~') {
+        slave.turnaroundMs = strtoul(p, &end, 10);
+        p = end;
+      } else if (key == '%' || key == '?') {
+        unsigned long percent = strtoul(p, &end, 10);
+        if (end == p || percent > 100) {
+          fprintf(stderr, "virtual bus: bad percentage after '%c'\n", key);
+          return false;
+        }
+        (key == '%' ? slave.garblePercent : slave.lossPercent) = percent;
+        p = end;
+      } else {
+        fprintf(stderr, "virtual bus: unexpected '%c' in layout\n", key);
+        return false;
+      }
+    }
+
+    for (long id = firstId; id <= lastId && slaveCount < VIRTUAL_BUS_MAX_SLAVES; id++) {
+      slave.id = id;
+      slaves[slaveCount++] = slave;
+    }
+  }
+  return true;
+}
+
+// Segments are separated by '|'; segments left out have no slaves
+static bool parseLayout(const char* layout) {
+  for (int i = 0; i < VIRTUAL_BUS_MAX_SEGMENTS; i++) {
+    const char* end = strchr(layout, '|');
+    size_t length = end ? (size_t)(end - layout) : strlen(layout);
+    char text[512];
+    if (length >= sizeof(text)) length = sizeof(text) - 1;
+    memcpy(text, layout, length);
+    text[length] = '\0';
+    if (!parseSegment(segments[i], text)) return false;
+    layout = end ? end + 1 : layout + length;
+  }
+  if (*layout) {
+    fprintf(stderr, "virtual bus: more than %d segments in layout\n", VIRTUAL_BUS_MAX_SEGMENTS);
+    return false;
+  }
+  return true;
+}
+
+static bool lineMatches(const SimSegment& segment, const SimSlave& slave) {
+  // Data bits and parity must agree; a stop bit mismatch still decodes
+  uint32_t config = segment.lineConfig.load();
+  return slave.baud == segment.lineBaud.load() && (slave.config & 0x0F) == (config & 0x0F);
+}
+
+// Per simulator thread, so the segments need no lock
+static uint32_t nextRandom() {
+  static thread_local uint32_t state = 2463534242u;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+static uint16_t noiseValue(uint16_t noise) {
+  return nextRandom() % (2 * noise + 1);
+}
+
+// True for `percent` out of every 100 calls
+static bool chance(uint8_t percent) {
+  return percent > 0 && nextRandom() % 100 < percent;
+}
+
+static bool rangeValue(const SimProfile* profile, uint8_t table, uint16_t address, uint16_t* value) {
+  for (uint8_t i = 0; i < profile->rangeCount; i++) {
+    const SimRange& range = profile->ranges[i];
+    if (range.table == table && address >= range.first && address <= range.last) {
+      uint16_t offset = address - range.first;
+      if (table == SIM_COILS || table == SIM_DISCRETE_INPUTS) {
+        *value = (range.base >> (offset % 16)) & 1;
+      } else {
+        *value = range.base + offset;
+        if (range.noise) *value += noiseValue(range.noise) - range.noise;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+// Build the reply PDU for a read request; returns the reply length (with CRC)
+static size_t buildReply(const SimSlave& slave, const uint8_t* request, uint8_t* reply) {
+  uint8_t function = request[1];
+  uint16_t address = (request[2] << 8) | request[3];
+  uint16_t quantity = (request[4] << 8) | request[5];
+  uint8_t exception = 0;
+
+  reply[0] = slave.id;
+  reply[1] = function;
+  size_t length = 0;
+
+  if (function < 0x01 || function > 0x04) {
+    exception = 0x01;
+  } else {
+    bool bits = function <= 0x02;
+    uint8_t table = function - 1;
+    if (quantity == 0 || quantity > (bits ? 2000 : 125)) {
+      exception = 0x03;
+    } else {
+      uint8_t byteCount = bits ? (quantity + 7) / 8 : quantity * 2;
+      reply[2] = byteCount;
+      memset(reply + 3, 0, byteCount);
+      for (uint16_t i = 0; i < quantity && !exception; i++) {
+        uint16_t value;
+        if (!rangeValue(slave.profile, table, address + i, &value)) {
+          exception = 0x02;
+        } else if (bits) {
+          if (value) reply[3 + i / 8] |= 1 << (i % 8);
+        } else {
+          reply[3 + i * 2] = value >> 8;
+          reply[4 + i * 2] = value & 0xFF;
+        }
+      }
+      length = 3 + byteCount;
+    }
+  }
+
+  if (exception) {
+    reply[1] = function | 0x80;
+    reply[2] = exception;
+    length = 3;
+    statExceptions++;
+  }
+
+  uint16_t crc = crc16(reply, length);
+  reply[length++] = crc & 0xFF;
+  reply[length++] = crc >> 8;
+  return length;
+}
+
+static size_t requestLength(const uint8_t* frame, size_t available) {
+  if (available < 2) return 0;
+  switch (frame[1]) {
+    case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06:
+      return 8;
+    case 0x0F: case 0x10:
+      return available >= 7 ? 9 + frame[6] : 0;
+    default:
+      return 0;
+  }
+}
+
+// Feed one frame's bit stream into the pulse counters: start bit, data
+// bits LSB first, parity, stop bits; the idle level after the last stop bit
+// is not a bounded pulse and is left out. The edge capture sits on the
+// first segment only, like the RMT input on Serial1's RX pin.
+static void countPulses(const SimSegment& segment, const uint8_t* frame, size_t length,
+                        unsigned long baud, uint32_t config) {
+  if (&segment != &segments[0]) return;
+  uint8_t dataBits = ((config >> 2) & 0x03) + 5;
+  uint8_t parity = config & 0x03;   // 0 none, 2 even, 3 odd
+  uint8_t stopBits = ((config >> 4) & 0x03) == 0x03 ? 2 : 1;
+  uint32_t bitNs = 1000000000UL / baud;
+
+  std::lock_guard<std::mutex> lock(pulseMutex);
+  int level = 1;
+  uint32_t run = 0;     // Bits at the current level; 0 while idle
+  auto emit = [&](int value) {
+    if (value == level) {
+      if (run) run++;
+      return;
+    }
+    if (run) {
+      uint32_t& shortest = level ? pulses.highMinNs : pulses.lowMinNs;
+      if (!shortest || run * bitNs < shortest) shortest = run * bitNs;
+    }
+    pulses.edges++;
+    level = value;
+    run = 1;
+  };
+
+  for (size_t i = 0; i < length; i++) {
+    uint8_t ones = 0;
+    emit(0);
+    for (uint8_t b = 0; b < dataBits; b++) {
+      int value = (frame[i] >> b) & 1;
+      ones += value;
+      emit(value);
+    }
+    if (parity) emit(parity == 0x02 ? ones & 1 : !(ones & 1));
+    for (uint8_t b = 0; b < stopBits; b++) emit(1);
+  }
+}
+
+static void handleRequest(SimSegment& segment, const uint8_t* frame, size_t length, uint64_t frameStartUs) {
+  statRequests++;
+  uint8_t id = frame[0];
+  if (id == 0) return; // Broadcast: no reply
+
+  for (int i = 0; i < segment.slaveCount; i++) {
+    const SimSlave& slave = segment.slaves[i];
+    if (slave.id != id) continue;
+    if (!lineMatches(segment, slave)) {
+      statMismatched++;
+      return;
+    }
+
+    if (chance(slave.lossPercent)) return;
+    uint8_t reply[256 + 5];
+    size_t replyLength = buildReply(slave, frame, reply);
+    if (chance(slave.garblePercent)) reply[replyLength / 2] ^= 0x10;
+
+    // The first character lands after the request, the turnaround and its
+    // own frame time; the rest follows two characters at a time, so the line
+    // never looks idle inside a frame (RX timeout framing) without a sleep
+    // per byte.
+    uint32_t charUs = charTimeUs(segment.lineBaud.load(), segment.lineConfig.load());
+    uint64_t firstUs = frameStartUs + length * charUs + slave.turnaroundMs * 1000ULL + charUs;
+    nativeSleepUntilUs(firstUs);
+    // Counted before the write so the master never sees a reply the
+    // statistics do not include yet
+    statResponses++;
+    statTxBytes += replyLength;
+    segment.replyEndUs = UINT64_MAX; // Until the last chunk is written
+    countPulses(segment, reply, replyLength, segment.lineBaud.load(), segment.lineConfig.load());
+    write(segment.ptyMaster, reply, 1);
+    for (size_t sent = 1; sent < replyLength; ) {
+      size_t chunk = replyLength - sent < 2 ? replyLength - sent : 2;
+      nativeSleepUntilUs(firstUs + (sent + chunk - 1) * charUs);
+      write(segment.ptyMaster, reply + sent, chunk);
+      sent += chunk;
+    }
+    segment.replyEndUs = firstUs + (replyLength - 1) * charUs;
+    return;
+  }
+}
+
+// One request/reply exchange of the other master. Serial1 only decodes it
+// when its line settings match; the pulse counters see it regardless.
+static void foreignMasterPoll(SimSegment& segment, uint8_t* nextSlave) {
+  const SimMaster& master = segment.foreignMaster;
+  const SimSlave* slaves = segment.slaves;
+  int slaveCount = segment.slaveCount;
+  const SimSlave* target = nullptr;
+  for (int i = 0; i < slaveCount && !target; i++) {
+    const SimSlave& slave = slaves[(*nextSlave + i) % slaveCount];
+    if (slave.baud == master.baud && (slave.config & 0x0F) == (master.config & 0x0F)) target = &slave;
+  }
+  uint8_t request[8] = {target ? target->id : (uint8_t)1, 0x03, 0x00, 0x00, 0x00, 0x02};
+  uint16_t crc = crc16(request, 6);
+  request[6] = crc & 0xFF;
+  request[7] = crc >> 8;
+  *nextSlave = target ? (target - slaves + 1) % slaveCount : 0;
+
+  uint32_t charUs = charTimeUs(master.baud, master.config);
+  bool decoded = master.baud == segment.lineBaud.load() &&
+                 (master.config & 0x0F) == (segment.lineConfig.load() & 0x0F);
+  uint64_t startUs = nativeMicros64();
+  nativeSleepUntilUs(startUs + sizeof(request) * charUs);
+  countPulses(segment, request, sizeof(request), master.baud, master.config);
+  if (decoded) write(segment.ptyMaster, request, sizeof(request));
+  if (!target) return;
+
+  uint8_t reply[256 + 5];
+  size_t replyLength = buildReply(*target, request, reply);
+  nativeSleepUntilUs(startUs + (sizeof(request) + replyLength) * charUs + target->turnaroundMs * 1000ULL);
+  countPulses(segment, reply, replyLength, master.baud, master.config);
+  if (decoded) write(segment.ptyMaster, reply, replyLength);
+}
+
+static void simulatorLoop(SimSegment& segment) {
+  uint8_t buffer[512];
+  size_t length = 0;
+  uint64_t frameStartUs = 0;
+  uint64_t lastByteUs = 0;
+  uint64_t masterDueUs = nativeMicros64();
+  uint8_t masterNextSlave = 0;
+
+  while (running) {
+    // The other master waits for a quiet line, as on a real bus
+    if (segment.foreignMaster.enabled && length == 0 && nativeMicros64() >= masterDueUs) {
+      foreignMasterPoll(segment, &masterNextSlave);
+      masterDueUs = nativeMicros64() + segment.foreignMaster.periodMs * 1000ULL;
+    }
+
+    pollfd pfd = {segment.ptyMaster, POLLIN, 0};
+    int ready = poll(&pfd, 1, 2);
+
+    if (ready > 0 && (pfd.revents & POLLIN)) {
+      ssize_t count = read(segment.ptyMaster, buffer + length, sizeof(buffer) - length);
+      if (count > 0) {
+        if (length == 0) frameStartUs = nativeMicros64();
+        length += count;
+        lastByteUs = nativeMicros64();
+        statRxBytes += count;
+      }
+    } else if (ready > 0 && (pfd.revents & (POLLHUP | POLLERR))) {
+      // No process has the pty open (yet)
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      continue;
+    }
+
+    // Take complete frames off the front of the buffer
+    while (length >= 4) {
+      size_t frameLength = requestLength(buffer, length);
+      unsigned long baud = segment.lineBaud.load();
+      bool idle = nativeMicros64() - lastByteUs > 4ULL * charTimeUs(baud ? baud : 9600, segment.lineConfig.load());
+
+      if (frameLength == 0) {
+        // Unknown function: treat everything up to the idle gap as one frame
+        if (!idle) break;
+        frameLength = length;
+      }
+      if (frameLength > length) {
+        if (!idle) break;
+        length = 0; // Truncated frame
+        break;
+      }
+
+      uint16_t crc = buffer[frameLength - 2] | (buffer[frameLength - 1] << 8);
+      if (crc16(buffer, frameLength - 2) == crc) {
+        handleRequest(segment, buffer, frameLength, frameStartUs);
+        memmove(buffer, buffer + frameLength, length - frameLength);
+        length -= frameLength;
+        frameStartUs = nativeMicros64();
+      } else {
+        memmove(buffer, buffer + 1, length - 1); // Resynchronise
+        length--;
+      }
+    }
+    if (length > 0 && length < 4 && nativeMicros64() - lastByteUs > 100000) {
+      length = 0; // Stray bytes
+    }
+  }
+}
+
+static bool createPty(SimSegment& segment) {
+  if (segment.ptyMaster >= 0) return true;
+
+  segment.ptyMaster = posix_openpt(O_RDWR | O_NOCTTY);
+  if (segment.ptyMaster < 0 || grantpt(segment.ptyMaster) != 0 || unlockpt(segment.ptyMaster) != 0 ||
+      ptsname_r(segment.ptyMaster, segment.ptyName, sizeof(segment.ptyName)) != 0) {
+    perror("virtual bus: cannot create pty");
+    segment.ptyMaster = -1;
+    return false;
+  }
+  return true;
+}
+
+bool virtualBusStart(const char* layout) {
+  virtualBusStop();
+  if (!parseLayout(layout ? layout : "")) return false;
+  for (SimSegment& segment : segments) {
+    if (!createPty(segment)) return false;
+  }
+
+  running = true;
+  for (SimSegment& segment : segments) {
+    segment.thread = std::thread(simulatorLoop, std::ref(segment));
+  }
+  return true;
+}
+
+void virtualBusStop() {
+  if (!running) return;
+  running = false;
+  for (SimSegment& segment : segments) {
+    if (segment.thread.joinable()) segment.thread.join();
+  }
+}
+
+bool virtualBusRunning() {
+  return running;
+}
+
+const char* virtualBusPortName(int segment) {
+  return segments[segment].ptyName;
+}
+
+void virtualBusStats(VirtualBusStats* stats) {
+  stats->requests = statRequests;
+  stats->responses = statResponses;
+  stats->exceptions = statExceptions;
+  stats->mismatched = statMismatched;
+  stats->rxBytes = statRxBytes;
+  stats->txBytes = statTxBytes;
+}
+
+void virtualBusResetStats() {
+  statRequests = 0;
+  statResponses = 0;
+  statExceptions = 0;
+  statMismatched = 0;
+  statRxBytes = 0;
+  statTxBytes = 0;
+}
+
+void virtualBusPulseReset() {
+  std::lock_guard<std::mutex> lock(pulseMutex);
+  pulses = {0, 0, 0};
+}
+
+void virtualBusPulses(VirtualBusPulses* result) {
+  std::lock_guard<std::mutex> lock(pulseMutex);
+  *result = pulses;
+}
+
+uint64_t virtualBusReplyEndUs(int segment) {
+  return segments[segment].replyEndUs;
+}
+
+static void printSegment(const SimSegment& segment) {
+  const SimMaster& foreignMaster = segment.foreignMaster;
+  if (foreignMaster.enabled) {
+    printf("  master   : %lu baud, format 0x%07x, one request every %d ms\n", foreignMaster.baud,
+           (unsigned)foreignMaster.config, foreignMaster.periodMs);
+  }
+  for (int i = 0; i < segment.slaveCount; i++) {
+    const SimSlave& slave = segment.slaves[i];
+    printf("  slave %3d: %lu baud, format 0x%07x, profile %s, turnaround %d ms", slave.id,
+           slave.baud, (unsigned)slave.config, slave.profile->name, slave.turnaroundMs);
+    if (slave.garblePercent || slave.lossPercent) {
+      printf(", %d%% garbled, %d%% lost", slave.garblePercent, slave.lossPercent);
+    }
+    printf("\n");
+  }
+}
+
+static speed_t toSpeed(unsigned long baud) {
+  switch (baud) {
+    case 1200: return B1200;
+    case 2400: return B2400;
+    case 4800: return B4800;
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    default: return B9600;
+  }
+}
+
+void virtualBusPrintLayout() {
+  for (int i = 0; i < VIRTUAL_BUS_MAX_SEGMENTS; i++) {
+    if (i > 0 && segments[i].slaveCount == 0 && !segments[i].foreignMaster.enabled) continue;
+    if (i > 0) printf("  -- segment %d (%s)\n", i, segments[i].ptyName);
+    printSegment(segments[i]);
+  }
+}
+
+int virtualBusOpenPort(int segment) {
+  const char* device = getenv(segment == 0 ? "MODBUS_NATIVE_PORT" : "MODBUS_NATIVE_PORT2");
+  SimSegment& sim = segments[segment];
+  sim.externalPort = device && *device;
+
+  if (!sim.externalPort) {
+    if (!running) {
+      const char* layout = getenv("MODBUS_SIM_LAYOUT");
+      if (!virtualBusStart(layout ? layout : "1=generic")) return -1;
+    }
+    device = sim.ptyName;
+  }
+
+  int fd = open(device, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (fd < 0) {
+    fprintf(stderr, "virtual bus: cannot open %s: %s\n", device, strerror(errno));
+    return -1;
+  }
+
+  // Raw bytes in both directions: no echo, no CR/LF translation
+  termios tio;
+  if (tcgetattr(fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+  return fd;
+}
+
+void virtualBusSetLine(int segment, int fd, unsigned long baud, uint32_t config) {
+  SimSegment& sim = segments[segment];
+  sim.lineBaud = baud;
+  sim.lineConfig = config;
+  if (!sim.externalPort || fd < 0) return;
+
+  // Real adapter: apply the settings to the tty
+  termios tio;
+  if (tcgetattr(fd, &tio) != 0) return;
+  cfsetspeed(&tio, toSpeed(baud));
+  tio.c_cflag &= ~(CSIZE | PARENB | PARODD | CSTOPB);
+  tio.c_cflag |= ((config >> 2) & 0x03) == 0x02 ? CS7 : CS8;
+  if (config & 0x02) tio.c_cflag |= PARENB;
+  if ((config & 0x03) == 0x03) tio.c_cflag |= PARODD;
+  if (((config >> 4) & 0x03) == 0x03) tio.c_cflag |= CSTOPB;
+  tcsetattr(fd, TCSANOW, &tio);
+}
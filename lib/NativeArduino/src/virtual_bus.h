@@ -0,0 +1,76 @@
+#ifndef NATIVE_VIRTUAL_BUS_H
+#define NATIVE_VIRTUAL_BUS_H
+
+#include <stdint.h>
+
+// Simulated RTU slave population behind a pseudo-terminal. Serial1 opens the
+// pty's slave side like any tty; a simulator thread on the master side
+// answers read requests with the timing of a real line (request and reply
+// time at the configured baud plus each slave's turnaround).
+//
+// Layout: entries separated by ',' or spaces, each
+//   <id>[-<lastId>][@<baud>][:<format>][=<profile>][~<turnaroundMs>][%<garbled>][?<lost>]
+// e.g. "1=generic,2@19200:8E1=meter~5,10:8E2=tec,20-29=sparse~40,3%5?2".
+// Defaults: 9600 baud, 8N1, generic profile, 10 ms turnaround, a clean line.
+// %<garbled> is the percentage of replies with a bit flipped (a CRC error
+// at the master), ?<lost> the percentage of requests left unanswered.
+// Profiles: generic, tec, tecstrict, sparse, meter, and the fingerprint
+// database devices sdm120, sdm630, ddsu666, pzem016, pzem017, xymd02,
+// r4dcb08, relay8, ain8, epever, growatt; plant has measurements with noise
+// on every read (IR 0-31), for change reporting.
+//
+// An entry "m[@<baud>][:<format>][~<periodMs>]" adds another master that
+// reads HR 0-1 from the slaves with its line settings in turn, one request
+// every period (default 200 ms), like a BMS already polling the bus.
+// Its traffic reaches Serial1 only when the port's line settings match.
+//
+// A slave answers when the master's baud, data bits and parity match its
+// own; stop bits are not checked, as on real UARTs.
+//
+// '|' starts the next segment: a second RS485 line with its own pty and
+// simulator thread behind Serial0, e.g. "1-16=generic|17-32=meter".
+// Segment 0 is Serial1; a segment left out has no slaves.
+//
+// Environment:
+//   MODBUS_SIM_LAYOUT   layout used when a bus port is first opened
+//   MODBUS_NATIVE_PORT  use this serial device for Serial1 instead of the simulator
+//   MODBUS_NATIVE_PORT2 the same for Serial0
+
+#define VIRTUAL_BUS_MAX_SLAVES 64
+#define VIRTUAL_BUS_MAX_SEGMENTS 2
+
+// Summed over all segments
+struct VirtualBusStats {
+  uint32_t requests;      // Valid request frames seen
+  uint32_t responses;     // Replies sent
+  uint32_t exceptions;    // Exception replies sent
+  uint32_t mismatched;    // Requests ignored because of line settings
+  uint32_t rxBytes;
+  uint32_t txBytes;
+};
+
+// Emulated RX edge capture (the RMT receiver on the ESP32): shortest low
+// and high level in ns and the number of edges, counted from all traffic on
+// the first segment's wire whatever Serial1's baud rate
+struct VirtualBusPulses {
+  uint32_t lowMinNs;
+  uint32_t highMinNs;
+  uint32_t edges;
+};
+
+bool virtualBusStart(const char* layout);
+void virtualBusStop();
+bool virtualBusRunning();
+const char* virtualBusPortName(int segment = 0);
+void virtualBusStats(VirtualBusStats* stats);
+void virtualBusResetStats();
+void virtualBusPrintLayout();
+void virtualBusPulseReset();
+void virtualBusPulses(VirtualBusPulses* pulses);
+
+// Used by HardwareSerial
+int virtualBusOpenPort(int segment);
+void virtualBusSetLine(int segment, int fd, unsigned long baud, uint32_t config);
+uint64_t virtualBusReplyEndUs(int segment);   // Virtual time the last reply ends (UINT64_MAX while still sending it)
+
+#endif // NATIVE_VIRTUAL_BUS_H
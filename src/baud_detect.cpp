@@ -0,0 +1,128 @@
+#include "baud_detect.h"
+#include "scanner.h"
+
+static const uint32_t standardRates[] = {1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200};
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <driver/rmt.h>
+
+// An RMT receive channel on the RX pin records every level and its duration.
+// The GPIO matrix feeds the pin to the UART and the RMT at the same time, so
+// Serial1 keeps working while we listen. The UART's own autobaud counters are
+// 12 bits wide on the C3 and overflow below about 20000 baud.
+#define BAUD_RMT_CHANNEL RMT_CHANNEL_2   // First receive channel on the C3
+#define BAUD_RMT_TICK_NS 100             // 80 MHz APB / 8
+#define BAUD_RMT_IDLE_TICKS 30000        // 3 ms without an edge ends a capture
+
+static RingbufHandle_t captureBuffer = nullptr;
+
+static bool captureStart() {
+  rmt_config_t config = RMT_DEFAULT_CONFIG_RX((gpio_num_t)MODBUS_RX_PIN, BAUD_RMT_CHANNEL);
+  config.clk_div = 8;
+  config.mem_block_num = 2;
+  config.rx_config.filter_en = true;
+  config.rx_config.filter_ticks_thresh = 40;   // APB cycles: ignore glitches under 0.5 us
+  config.rx_config.idle_threshold = BAUD_RMT_IDLE_TICKS;
+  if (rmt_config(&config) != ESP_OK || rmt_driver_install(BAUD_RMT_CHANNEL, 4096, 0) != ESP_OK) {
+    return false;
+  }
+  rmt_get_ringbuf_handle(BAUD_RMT_CHANNEL, &captureBuffer);
+  rmt_rx_start(BAUD_RMT_CHANNEL, true);
+  return true;
+}
+
+static void addPulse(BaudMeasurement* measurement, uint32_t level, uint32_t ticks) {
+  // A zero duration marks the end of a capture; the level running into the
+  // idle threshold is the line going quiet, not a pulse
+  if (ticks == 0 || ticks >= BAUD_RMT_IDLE_TICKS) return;
+  uint32_t ns = ticks * BAUD_RMT_TICK_NS;
+  uint32_t& shortest = level ? measurement->highPulseNs : measurement->lowPulseNs;
+  if (shortest == 0 || ns < shortest) shortest = ns;
+  measurement->edges++;
+}
+
+static void captureCollect(BaudMeasurement* measurement, uint16_t waitMs) {
+  size_t size = 0;
+  rmt_item32_t* items = (rmt_item32_t*)xRingbufferReceive(captureBuffer, &size, pdMS_TO_TICKS(waitMs));
+  if (!items) return;
+  for (size_t i = 0; i < size / sizeof(rmt_item32_t); i++) {
+    addPulse(measurement, items[i].level0, items[i].duration0);
+    addPulse(measurement, items[i].level1, items[i].duration1);
+  }
+  vRingbufferReturnItem(captureBuffer, items);
+}
+
+static void captureStop() {
+  rmt_rx_stop(BAUD_RMT_CHANNEL);
+  rmt_driver_uninstall(BAUD_RMT_CHANNEL);
+  captureBuffer = nullptr;
+}
+
+#else
+#include "virtual_bus.h"
+
+// Native build: the virtual bus reports the pulses of everything on its wire
+static bool captureStart() {
+  virtualBusPulseReset();
+  return true;
+}
+
+static void captureCollect(BaudMeasurement* measurement, uint16_t waitMs) {
+  delay(waitMs);
+  VirtualBusPulses pulses;
+  virtualBusPulses(&pulses);
+  measurement->edges = pulses.edges;
+  measurement->lowPulseNs = pulses.lowMinNs;
+  measurement->highPulseNs = pulses.highMinNs;
+}
+
+static void captureStop() {
+}
+#endif
+
+uint32_t baudNearestStandard(uint32_t measuredBaud) {
+  for (uint32_t rate : standardRates) {
+    uint32_t tolerance = rate * BAUD_TOLERANCE_PCT / 100;
+    if (measuredBaud + tolerance >= rate && measuredBaud <= rate + tolerance) return rate;
+  }
+  return 0;
+}
+
+// Both shortest levels are one bit when the traffic holds an isolated 0 and
+// an isolated 1, which practically every frame does; averaging them cancels
+// the transceiver's rise/fall skew. If they disagree by more than a quarter
+// one of them spans several bits and the shorter one is used.
+static void estimateBaud(BaudMeasurement* measurement) {
+  uint32_t low = measurement->lowPulseNs;
+  uint32_t high = measurement->highPulseNs;
+  if (measurement->edges < BAUD_MIN_EDGES || (low == 0 && high == 0)) return;
+
+  if (low == 0 || high == 0) {
+    measurement->bitTimeNs = max(low, high);
+  } else if (max(low, high) * 4 <= min(low, high) * 5) {
+    measurement->bitTimeNs = (low + high) / 2;
+  } else {
+    measurement->bitTimeNs = min(low, high);
+  }
+  measurement->measuredBaud = (1000000000UL + measurement->bitTimeNs / 2) / measurement->bitTimeNs;
+  measurement->baud = baudNearestStandard(measurement->measuredBaud);
+}
+
+bool baudMeasureFromTraffic(uint16_t listenMs, BaudMeasurement* measurement) {
+  memset(measurement, 0, sizeof(*measurement));
+  unsigned long startMs = millis();
+  if (!captureStart()) {
+    Serial.println("⚠️  Edge capture unavailable");
+    return false;
+  }
+
+  // Check every 20 ms; a busy bus answers well before listenMs runs out
+  while (millis() - startMs < listenMs && measurement->edges < BAUD_ENOUGH_EDGES) {
+    captureCollect(measurement, 20);
+  }
+  captureStop();
+
+  measurement->elapsedMs = millis() - startMs;
+  estimateBaud(measurement);
+  return measurement->baud != 0;
+}
@@ -0,0 +1,262 @@
+#include "bulk_dump.h"
+#include "scanner.h"
+#include "bus_task.h"
+#include "bus_sniffer.h"
+#include "stream_output.h"
+#include "read_planner.h"
+
+static bool active = false;
+static bool inFlight = false;
+static uint8_t generation = 0;       // Tags reads so results of a cancelled dump are ignored
+static uint8_t retries = 0;          // Timeouts of the current chunk
+static int32_t missingFrom = -1;     // Start of the run of missing addresses being collected
+static DumpStats stats;
+static DumpFinishHandler finishHandler = nullptr;
+
+static bool tableIsBits(uint8_t table) {
+  return table == MAP_COILS || table == MAP_DISCRETE_INPUTS;
+}
+
+static const char* unitName() {
+  return tableIsBits(stats.table) ? "bits" : "registers";
+}
+
+static void printDumpControls() {
+  Serial.println("⌨️  Dump controls: c = cancel, s = status");
+}
+
+static void printProgress() {
+  unsigned long elapsed = millis() - stats.startMs;
+  Serial.printf("📦 At %s %lu of %u-%u: %lu %s in %lu reads, chunk %u, %.0f %s/s\n", mapTableName(stats.table),
+                (unsigned long)stats.next, stats.first, stats.last, (unsigned long)stats.values, unitName(),
+                (unsigned long)stats.transactions, stats.chunk,
+                elapsed > 0 ? stats.values * 1000.0f / elapsed : 0.0f, unitName());
+}
+
+// Addresses are reported in runs: "HR 100-119: not present"
+static void flushMissing(uint32_t end) {
+  if (missingFrom < 0) return;
+  if (end - 1 > (uint32_t)missingFrom) {
+    Serial.printf("   %s %ld-%lu: not present\n", mapTableName(stats.table), (long)missingFrom, (unsigned long)end - 1);
+  } else {
+    Serial.printf("   %s %ld: not present\n", mapTableName(stats.table), (long)missingFrom);
+  }
+  missingFrom = -1;
+}
+
+// One console line per DUMP_VALUES_PER_LINE registers (or 4x as many
+// bits, in groups of 8), each built in a buffer and written at once
+static void printChunk(uint16_t address, uint16_t count, const uint16_t* values) {
+  bool bits = tableIsBits(stats.table);
+  uint16_t perLine = bits ? DUMP_VALUES_PER_LINE * 4 : DUMP_VALUES_PER_LINE;
+  char line[16 + DUMP_VALUES_PER_LINE * 6 + 8];
+
+  for (uint16_t i = 0; i < count; i += perLine) {
+    int length = snprintf(line, sizeof(line), "   %s %5u:", mapTableName(stats.table), address + i);
+    for (uint16_t j = i; j < count && j < i + perLine; j++) {
+      if (bits) {
+        if ((j - i) % 8 == 0) line[length++] = ' ';
+        line[length++] = (values[j / 16] >> (j % 16)) & 1 ? '1' : '0';
+      } else {
+        length += snprintf(line + length, sizeof(line) - length, " %5u", values[j]);
+      }
+    }
+    line[length] = '\0';
+    Serial.println(line);
+  }
+}
+
+static void finishDump() {
+  active = false;
+  stats.elapsedMs = millis() - stats.startMs;
+  flushMissing(stats.next);
+
+  const char* title = stats.cancelled ? "Dump cancelled" : stats.deviceLost ? "Dump stopped, device not responding"
+                      : stats.unsupported ? "Dump stopped, table not supported" : "Dump complete";
+  if (stats.cancelled || stats.deviceLost || stats.unsupported) {
+    ledStatusMessage(LED_WARNING, title);
+  } else {
+    ledStatusMessage(LED_SUCCESS, title);
+  }
+
+  Serial.printf("\n📦 %s %u-%u of slave %d on bus %d\n", mapTableName(stats.table), stats.first, stats.last,
+                stats.slaveId, stats.bus + 1);
+  Serial.printf("   %lu %s in %lu reads, %lu ms: %.0f %s/s (one per read: ~%.0f/s)\n", (unsigned long)stats.values,
+                unitName(), (unsigned long)stats.transactions, stats.elapsedMs, dumpValuesPerSecond(stats), unitName(),
+                dumpSingleReadEstimate(*rtuBuses[stats.bus]));
+  if (stats.exceptions > 0 || stats.missing > 0) {
+    Serial.printf("   %lu chunk(s) halved after an exception, %lu address(es) not present\n",
+                  (unsigned long)stats.exceptions, (unsigned long)stats.missing);
+  }
+  if (stats.timeouts > 0) {
+    Serial.printf("   %lu timeout(s) or garbled replies\n", (unsigned long)stats.timeouts);
+  }
+  if (finishHandler) finishHandler(stats);
+
+  Serial.println("\n" + String('-', 40));
+  showMainMenu();
+}
+
+static void onChunkDone(const BusResult& result) {
+  const BusRequest& request = result.request;
+  if (!active || request.tag != generation) return;
+  inFlight = false;
+  stats.transactions++;
+  stats.busyUs += result.durationUs;
+
+  switch (result.status) {
+    case ModbusMaster::ku8MBSuccess:
+      flushMissing(request.address);
+      if (streamBinary()) {
+        streamRecord(stats.bus + 1, stats.slaveId, stats.table, request.address, request.quantity, result.values);
+      } else {
+        printChunk(request.address, request.quantity, result.values);
+      }
+      stats.values += request.quantity;
+      stats.next += request.quantity;
+      stats.chunk = min((uint16_t)(request.quantity * 2), stats.maxChunk);
+      retries = 0;
+      break;
+
+    case ModbusMaster::ku8MBIllegalFunction:
+      stats.unsupported = true;
+      break;
+
+    case ModbusMaster::ku8MBIllegalDataAddress:
+    case ModbusMaster::ku8MBIllegalDataValue:
+    case ModbusMaster::ku8MBSlaveDeviceFailure:
+      retries = 0;
+      if (request.quantity > 1) {
+        stats.exceptions++;
+        stats.chunk = request.quantity / 2;
+      } else {
+        if (missingFrom < 0) missingFrom = request.address;
+        stats.missing++;
+        stats.next++;
+        stats.chunk = 1;
+      }
+      break;
+
+    default:
+      // Timeout, CRC error or a reply from another slave: try again, then
+      // smaller if the device has answered at all
+      stats.timeouts++;
+      if (++retries > DUMP_MAX_RETRIES) {
+        retries = 0;
+        bool answered = stats.values > 0 || stats.exceptions > 0 || stats.missing > 0;
+        if (request.quantity > 1 && answered) {
+          stats.chunk = request.quantity / 2;
+        } else {
+          stats.deviceLost = true;
+        }
+      }
+      break;
+  }
+
+  if (stats.unsupported || stats.deviceLost || stats.next > stats.last) finishDump();
+}
+
+bool dumpStart(uint8_t slaveId, uint8_t table, uint16_t first, uint16_t last, uint8_t bus, uint16_t maxChunk) {
+  if (active) {
+    Serial.println("❌ A dump is already running");
+    return false;
+  }
+  if (slaveId < 1 || slaveId > 247 || table >= MAP_TABLE_COUNT || first > last || bus >= rtuBusCount()) {
+    Serial.println("❌ Invalid dump range");
+    return false;
+  }
+  if (snifferActive()) {
+    Serial.println("❌ The sniffer is listening, stop it first");
+    return false;
+  }
+  if (!busTaskRunning(*rtuBuses[bus])) {
+    Serial.printf("❌ Bus %d is not running\n", bus + 1);
+    return false;
+  }
+
+  uint16_t protocolMax = tableIsBits(table) ? RTU_MAX_READ_BITS : RTU_MAX_READ_WORDS;
+  memset(&stats, 0, sizeof(stats));
+  stats.bus = bus;
+  stats.slaveId = slaveId;
+  stats.table = table;
+  stats.first = first;
+  stats.last = last;
+  stats.next = first;
+  stats.maxChunk = maxChunk == 0 || maxChunk > protocolMax ? protocolMax : maxChunk;
+  stats.chunk = stats.maxChunk;
+  stats.startMs = millis();
+  generation++;
+  retries = 0;
+  missingFrom = -1;
+  inFlight = false;
+  active = true;
+
+  ledStatusMessage(LED_CONNECTING, "Bulk dump running...");
+  Serial.printf("📦 Dumping %s %u-%u of slave %d on bus %d, up to %u per read\n", mapTableName(table), first, last,
+                slaveId, bus + 1, stats.maxChunk);
+  printDumpControls();
+  return true;
+}
+
+// Keep one chunk in flight; called from loop() on every pass
+void dumpTick() {
+  if (!active || inFlight) return;
+
+  uint32_t remaining = (uint32_t)stats.last + 1 - stats.next;
+  BusRequest request = {};
+  request.bus = rtuBuses[stats.bus];
+  request.slaveId = stats.slaveId;
+  request.function = stats.table + 1;
+  request.address = stats.next;
+  request.quantity = min((uint32_t)stats.chunk, remaining);
+  // The device is known to be there: wait as long as the scan's retry pass
+  // on top of the reply, so a slow responder is not timed out and its late
+  // reply cannot answer the next chunk
+  request.timeoutMs = rtuReadTimeoutMs(*request.bus, request.function, request.quantity) + sweepSettings.slowTimeoutMs;
+  request.tag = generation;
+  request.callback = onChunkDone;
+  if (busSubmit(request)) inFlight = true;
+}
+
+void dumpCancel() {
+  if (!active) return;
+  stats.cancelled = true;
+  generation++;
+  inFlight = false;
+  finishDump();
+}
+
+bool dumpActive() {
+  return active;
+}
+
+const DumpStats& dumpStats() {
+  return stats;
+}
+
+float dumpValuesPerSecond(const DumpStats& dump) {
+  unsigned long elapsed = dump.elapsedMs ? dump.elapsedMs : millis() - dump.startMs;
+  return elapsed > 0 ? dump.values * 1000.0f / elapsed : 0.0f;
+}
+
+// A whole transaction (as the read planner counts it) for every address
+float dumpSingleReadEstimate(const RtuBus& bus) {
+  return 1000000.0f / (planTransactionOverheadUs(bus) + 2 * rtuCharTimeUs(bus));
+}
+
+void dumpSetFinishHandler(DumpFinishHandler handler) {
+  finishHandler = handler;
+}
+
+bool dumpHandleCommand(const String& input) {
+  if (!active) return false;
+
+  if (input == "c") {
+    dumpCancel();
+  } else if (input == "s") {
+    printProgress();
+  } else {
+    printDumpControls();
+  }
+  return true;
+}
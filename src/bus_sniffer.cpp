@@ -0,0 +1,369 @@
+#include "bus_sniffer.h"
+#include "scanner.h"
+#include "modbus_rtu.h"
+
+static bool active = false;
+static SnifferStats stats;
+static SnifferSlave slaves[SNIFFER_MAX_SLAVES];
+static uint8_t slaveCount = 0;
+
+static uint8_t buffer[SNIFFER_BUFFER_SIZE];
+static uint16_t bufferLength = 0;
+static uint32_t lastByteUs = 0;
+
+// Request waiting for its reply
+static struct {
+  bool valid;
+  uint8_t slaveId;
+  uint8_t function;
+  uint16_t address;
+  uint16_t quantity;
+} pending;
+
+// First request seen; when the master sends it again one poll cycle is done
+static struct {
+  bool valid;
+  uint8_t slaveId;
+  uint8_t function;
+  uint16_t address;
+  uint16_t quantity;
+  unsigned long seenMs;
+} cycleMarker;
+
+static const char* tableNames[SNIFF_TABLE_COUNT] = {"CO", "DI", "HR", "IR"};
+
+static SnifferSlave* findSlave(uint8_t slaveId) {
+  for (uint8_t i = 0; i < slaveCount; i++) {
+    if (slaves[i].slaveId == slaveId) return &slaves[i];
+  }
+  if (slaveCount >= SNIFFER_MAX_SLAVES) return nullptr;
+
+  SnifferSlave* slave = &slaves[slaveCount++];
+  memset(slave, 0, sizeof(*slave));
+  slave->slaveId = slaveId;
+  Serial.printf("👂 New slave on the bus: ID %d\n", slaveId);
+  return slave;
+}
+
+static int tableForFunction(uint8_t function) {
+  switch (function) {
+    case 0x01: case 0x05: case 0x0F: return SNIFF_COILS;
+    case 0x02: return SNIFF_DISCRETE_INPUTS;
+    case 0x03: case 0x06: case 0x10: return SNIFF_HOLDING_REGISTERS;
+    case 0x04: return SNIFF_INPUT_REGISTERS;
+    default: return -1;
+  }
+}
+
+// Insert [first, last] into a sorted range list, merging overlapping and
+// adjacent ranges. When the list is full the new range is folded into its
+// nearest neighbour so the map gets coarser rather than losing addresses.
+static void addRange(SnifferSlave* slave, int table, uint16_t first, uint16_t last) {
+  SnifferRange* ranges = slave->ranges[table];
+  uint8_t& count = slave->rangeCount[table];
+
+  uint8_t pos = 0;
+  while (pos < count && ranges[pos].last + 1 < first) pos++;
+
+  if (pos < count && ranges[pos].first <= (uint32_t)last + 1) {
+    // Overlaps or touches ranges[pos]: grow it and swallow followers
+    ranges[pos].first = min(ranges[pos].first, first);
+    ranges[pos].last = max(ranges[pos].last, last);
+    while (pos + 1 < count && ranges[pos + 1].first <= (uint32_t)ranges[pos].last + 1) {
+      ranges[pos].last = max(ranges[pos].last, ranges[pos + 1].last);
+      memmove(&ranges[pos + 1], &ranges[pos + 2], (count - pos - 2) * sizeof(SnifferRange));
+      count--;
+    }
+    return;
+  }
+
+  if (count < SNIFFER_MAX_RANGES) {
+    memmove(&ranges[pos + 1], &ranges[pos], (count - pos) * sizeof(SnifferRange));
+    ranges[pos].first = first;
+    ranges[pos].last = last;
+    count++;
+    return;
+  }
+
+  // List full: extend whichever neighbour is closest
+  if (pos == count || (pos > 0 && first - ranges[pos - 1].last < ranges[pos].first - last)) {
+    ranges[pos - 1].last = last;
+  } else {
+    ranges[pos].first = first;
+  }
+}
+
+static uint16_t requestLength(const uint8_t* frame, uint16_t available) {
+  switch (frame[1]) {
+    case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06:
+      return 8;
+    case 0x0F: case 0x10:
+      return available >= 7 ? 9 + frame[6] : 0;
+    default:
+      return 0;
+  }
+}
+
+static uint16_t responseLength(const uint8_t* frame, uint16_t available) {
+  if (frame[1] & 0x80) return 5;
+  switch (frame[1]) {
+    case 0x01: case 0x02: case 0x03: case 0x04:
+      return available >= 3 ? 5 + frame[2] : 0;
+    case 0x05: case 0x06: case 0x0F: case 0x10:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+static bool crcValid(const uint8_t* frame, uint16_t length, uint16_t available) {
+  if (length < 4 || length > available) return false;
+  uint16_t crc = frame[length - 2] | (frame[length - 1] << 8);
+  return rtuCrc16(frame, length - 2) == crc;
+}
+
+static void handleRequest(const uint8_t* frame) {
+  uint8_t slaveId = frame[0];
+  uint8_t function = frame[1];
+  uint16_t address = (frame[2] << 8) | frame[3];
+  uint16_t quantity = (function == 0x05 || function == 0x06) ? 1 : (frame[4] << 8) | frame[5];
+
+  // The previous request was never answered
+  if (pending.valid) {
+    SnifferSlave* previous = findSlave(pending.slaveId);
+    if (previous) previous->unanswered++;
+  }
+  pending.valid = false;
+
+  if (slaveId == 0) {
+    stats.broadcasts++;
+    return;
+  }
+
+  if (!cycleMarker.valid) {
+    cycleMarker.valid = true;
+    cycleMarker.slaveId = slaveId;
+    cycleMarker.function = function;
+    cycleMarker.address = address;
+    cycleMarker.quantity = quantity;
+    cycleMarker.seenMs = millis();
+  } else if (stats.cycleMs == 0 && cycleMarker.slaveId == slaveId &&
+             cycleMarker.function == function && cycleMarker.address == address &&
+             cycleMarker.quantity == quantity) {
+    stats.cycleMs = millis() - cycleMarker.seenMs;
+    Serial.printf("\n🔁 Master poll cycle detected (%lu ms) - bus map complete\n", stats.cycleMs);
+    snifferPrintMap();
+  }
+
+  SnifferSlave* slave = findSlave(slaveId);
+  if (!slave) return;
+  slave->requests++;
+  if (function < 32) slave->functionMask |= 1UL << function;
+
+  pending.valid = true;
+  pending.slaveId = slaveId;
+  pending.function = function;
+  pending.address = address;
+  pending.quantity = quantity;
+}
+
+static void handleResponse(const uint8_t* frame) {
+  uint8_t slaveId = frame[0];
+  uint8_t function = frame[1] & 0x7F;
+
+  if (!pending.valid || pending.slaveId != slaveId || pending.function != function) {
+    stats.unmatched++;
+    return;
+  }
+  pending.valid = false;
+
+  SnifferSlave* slave = findSlave(slaveId);
+  if (!slave) return;
+
+  if (frame[1] & 0x80) {
+    slave->exceptions++;
+    return;
+  }
+
+  slave->responses++;
+  int table = tableForFunction(function);
+  if (table >= 0 && pending.quantity > 0) {
+    uint32_t last = (uint32_t)pending.address + pending.quantity - 1;
+    addRange(slave, table, pending.address, last > 0xFFFF ? 0xFFFF : last);
+  }
+}
+
+// True when the frame is the expected reply to the pending request
+static bool expectingResponse(const uint8_t* frame, uint16_t length) {
+  if (!pending.valid || frame[0] != pending.slaveId) return false;
+  if ((frame[1] & 0x7F) != pending.function) return false;
+  if (frame[1] & 0x80) return length == 5;
+
+  switch (pending.function) {
+    case 0x01: case 0x02: return length == 5 + (pending.quantity + 7) / 8;
+    case 0x03: case 0x04: return length == 5 + pending.quantity * 2;
+    default: return length == 8;
+  }
+}
+
+// Split the buffered burst into frames. A burst can hold several frames when
+// the UART delivers them together, so frame boundaries come from the RTU
+// lengths and are confirmed by the CRC; unparseable bytes are skipped.
+static void processBuffer() {
+  uint16_t pos = 0;
+  while (bufferLength - pos >= 4) {
+    const uint8_t* frame = buffer + pos;
+    uint16_t available = bufferLength - pos;
+    uint16_t rqLength = requestLength(frame, available);
+    uint16_t rsLength = responseLength(frame, available);
+    bool rqValid = crcValid(frame, rqLength, available);
+    bool rsValid = crcValid(frame, rsLength, available);
+
+    if (rsValid && (!rqValid || expectingResponse(frame, rsLength))) {
+      handleResponse(frame);
+      pos += rsLength;
+      stats.frames++;
+    } else if (rqValid) {
+      handleRequest(frame);
+      pos += rqLength;
+      stats.frames++;
+    } else {
+      stats.crcErrors++;
+      pos++;
+    }
+  }
+  bufferLength = 0;
+}
+
+void snifferStart() {
+  memset(&stats, 0, sizeof(stats));
+  memset(&pending, 0, sizeof(pending));
+  memset(&cycleMarker, 0, sizeof(cycleMarker));
+  slaveCount = 0;
+  bufferLength = 0;
+
+  if (modbusBus.baud == 0) {
+    rtuBegin(modbusBus, MODBUS_BAUD, SERIAL_8N1);
+  }
+  // Keep the transceiver in receive mode for the whole session
+  if (modbusBus.dePin >= 0) {
+    digitalWrite(modbusBus.dePin, LOW);
+  }
+#if defined(ARDUINO_ARCH_ESP32)
+  // Hand bytes to the driver after ~1 character of silence so idle gaps are
+  // seen close to when they happen
+  modbusBus.port->setRxTimeout(1);
+#endif
+  while (modbusBus.port->available()) modbusBus.port->read();
+
+  stats.startMs = millis();
+  lastByteUs = micros();
+  active = true;
+
+  ledStatusMessage(LED_CONNECTING, "Passive bus sniffer started (listen-only)");
+  Serial.printf("👂 Listening at %lu baud %s - nothing will be transmitted\n",
+                (unsigned long)modbusBus.baud, rtuConfigName(modbusBus.config));
+  Serial.println("⌨️  Sniffer controls: t = show bus map, r = reset, q = stop");
+}
+
+void snifferStop() {
+  if (!active) return;
+  processBuffer();
+  active = false;
+
+  ledStatusMessage(LED_READY, "Passive bus sniffer stopped");
+  snifferPrintMap();
+  Serial.println("\n" + String('-', 40));
+  showMainMenu();
+}
+
+// Collect bytes and close the frame once the line has been idle for t3.5
+void snifferTick() {
+  if (!active) return;
+
+  Stream* port = modbusBus.port;
+  while (port->available()) {
+    if (bufferLength >= SNIFFER_BUFFER_SIZE) {
+      processBuffer(); // Overlong burst; parse what we have
+    }
+    buffer[bufferLength++] = port->read();
+    stats.bytes++;
+    lastByteUs = micros();
+  }
+
+  if (bufferLength > 0 && micros() - lastByteUs >= rtuFrameGapUs(modbusBus)) {
+    processBuffer();
+  }
+}
+
+bool snifferActive() {
+  return active;
+}
+
+const SnifferStats& snifferStats() {
+  return stats;
+}
+
+const SnifferSlave* snifferSlaves(uint8_t* count) {
+  *count = slaveCount;
+  return slaves;
+}
+
+void snifferPrintMap() {
+  unsigned long elapsed = millis() - stats.startMs;
+  Serial.println("\n📡 PASSIVE BUS MAP");
+  Serial.printf("   %lu frames, %lu bytes, %lu resync bytes, %lu broadcasts, %lu unmatched replies in %lu ms\n",
+                (unsigned long)stats.frames, (unsigned long)stats.bytes, (unsigned long)stats.crcErrors,
+                (unsigned long)stats.broadcasts, (unsigned long)stats.unmatched, elapsed);
+  if (stats.cycleMs > 0) {
+    Serial.printf("   Master poll cycle: %lu ms\n", stats.cycleMs);
+  }
+
+  if (slaveCount == 0) {
+    Serial.println("   No slaves seen yet");
+    if (stats.bytes > 0 && stats.frames == 0) {
+      Serial.println("   💡 Traffic but no valid frames - check baud rate and parity");
+    }
+    return;
+  }
+
+  Serial.println("    ID   Req  Resp   Exc  NoRep  FCs / Address ranges");
+  for (uint8_t i = 0; i < slaveCount; i++) {
+    const SnifferSlave& slave = slaves[i];
+    Serial.printf("   %3d %5d %5d %5d %6d  FC", slave.slaveId, slave.requests,
+                  slave.responses, slave.exceptions, slave.unanswered);
+    for (uint8_t fc = 1; fc < 32; fc++) {
+      if (slave.functionMask & (1UL << fc)) Serial.printf(" %02X", fc);
+    }
+    Serial.println();
+
+    for (uint8_t table = 0; table < SNIFF_TABLE_COUNT; table++) {
+      if (slave.rangeCount[table] == 0) continue;
+      Serial.printf("                                  %s", tableNames[table]);
+      for (uint8_t r = 0; r < slave.rangeCount[table]; r++) {
+        const SnifferRange& range = slave.ranges[table][r];
+        if (range.first == range.last) {
+          Serial.printf(" %u", range.first);
+        } else {
+          Serial.printf(" %u-%u", range.first, range.last);
+        }
+      }
+      Serial.println();
+    }
+  }
+}
+
+bool snifferHandleCommand(const String& input) {
+  if (!active) return false;
+
+  if (input == "t") {
+    snifferPrintMap();
+  } else if (input == "r") {
+    snifferStart();
+  } else if (input == "q") {
+    snifferStop();
+  } else {
+    Serial.println("⌨️  Sniffer controls: t = show bus map, r = reset, q = stop");
+  }
+  return true;
+}
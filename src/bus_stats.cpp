@@ -0,0 +1,213 @@
+#include "bus_stats.h"
+
+static BusStatsEntry totals[MODBUS_BUS_COUNT];
+static BusStatsEntry entries[MODBUS_BUS_COUNT][BUS_STATS_MAX_ENTRIES];
+
+// Single writer per bus: a plain load and store is enough, and is all the
+// C3 can do without a lock
+static inline void add(BusStatsCounter& counter, uint32_t amount) {
+  counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+static inline uint32_t get(const BusStatsCounter& counter) {
+  return counter.load(std::memory_order_relaxed);
+}
+
+static uint8_t bucketFor(uint32_t latencyUs) {
+  if (latencyUs < (1UL << BUS_STATS_MIN_SHIFT)) return 0;
+  uint8_t top = 31 - __builtin_clz(latencyUs);
+  uint8_t octave = top - BUS_STATS_MIN_SHIFT;
+  if (octave >= BUS_STATS_OCTAVES) return BUS_STATS_BUCKETS - 1;
+  uint8_t sub = (latencyUs >> (top - BUS_STATS_SUB_SHIFT)) & ((1 << BUS_STATS_SUB_SHIFT) - 1);
+  return 1 + (octave << BUS_STATS_SUB_SHIFT) + sub;
+}
+
+// Lower edge of a bucket; one past the last bucket is its upper edge
+static uint32_t bucketStartUs(uint8_t bucket) {
+  if (bucket == 0) return 0;
+  uint8_t octave = (bucket - 1) >> BUS_STATS_SUB_SHIFT;
+  uint8_t sub = (bucket - 1) & ((1 << BUS_STATS_SUB_SHIFT) - 1);
+  return (uint32_t)((1 << BUS_STATS_SUB_SHIFT) + sub) << (octave + BUS_STATS_MIN_SHIFT - BUS_STATS_SUB_SHIFT);
+}
+
+static bool isReply(uint8_t result) {
+  return result == ModbusMaster::ku8MBSuccess ||
+         (result >= ModbusMaster::ku8MBIllegalFunction && result < ModbusMaster::ku8MBInvalidSlaveID);
+}
+
+static BusStatsEntry* findEntry(uint8_t bus, uint8_t slaveId, uint8_t function, bool create) {
+  for (uint8_t i = 0; i < BUS_STATS_MAX_ENTRIES; i++) {
+    BusStatsEntry& entry = entries[bus][i];
+    if (!entry.used.load(std::memory_order_acquire)) {
+      if (!create) return nullptr;  // Entries fill from the front
+      entry.slaveId = slaveId;
+      entry.function = function;
+      entry.used.store(true, std::memory_order_release);
+      return &entry;
+    }
+    if (entry.slaveId == slaveId && entry.function == function) return &entry;
+  }
+  return nullptr;
+}
+
+static void record(BusStatsEntry& entry, uint8_t result, uint32_t latencyUs,
+                   uint16_t txBytes, uint16_t rxBytes, uint32_t turnaroundUs) {
+  add(entry.transactions, 1);
+  add(entry.txBytes, txBytes);
+  add(entry.rxBytes, rxBytes);
+
+  if (result == ModbusMaster::ku8MBResponseTimedOut) {
+    add(entry.timeouts, 1);
+    return;
+  }
+  if (result == ModbusMaster::ku8MBInvalidCRC) {
+    add(entry.crcErrors, 1);
+    return;
+  }
+  if (!isReply(result)) {
+    add(entry.other, 1);
+    return;
+  }
+
+  add(result == ModbusMaster::ku8MBSuccess ? entry.ok : entry.exceptions, 1);
+  if (latencyUs > get(entry.maxLatencyUs)) entry.maxLatencyUs.store(latencyUs, std::memory_order_relaxed);
+  add(entry.buckets[bucketFor(latencyUs)], 1);
+
+  // Running average over about 8 replies; 0 = not measured
+  if (turnaroundUs == 0) return;
+  uint32_t average = get(entry.turnaroundUs);
+  average = average == 0 ? turnaroundUs : average - average / 8 + turnaroundUs / 8;
+  entry.turnaroundUs.store(average, std::memory_order_relaxed);
+}
+
+void busStatsRecord(const RtuBus& bus, uint8_t slaveId, uint8_t function, uint8_t result,
+                    uint32_t latencyUs, uint16_t txBytes, uint16_t rxBytes, uint32_t turnaroundUs) {
+  uint8_t index = rtuBusNumber(bus) - 1;
+  record(totals[index], result, latencyUs, txBytes, rxBytes, turnaroundUs);
+
+  BusStatsEntry* entry = findEntry(index, slaveId, function, isReply(result));
+  if (entry) record(*entry, result, latencyUs, txBytes, rxBytes, turnaroundUs);
+}
+
+const BusStatsEntry* busStatsEntry(uint8_t bus, uint8_t index) {
+  if (bus >= rtuBusCount() || index >= BUS_STATS_MAX_ENTRIES) return nullptr;
+  return entries[bus][index].used.load(std::memory_order_acquire) ? &entries[bus][index] : nullptr;
+}
+
+const BusStatsEntry& busStatsTotal(uint8_t bus) {
+  return totals[bus];
+}
+
+uint32_t busStatsReplies(const BusStatsEntry& entry) {
+  return get(entry.ok) + get(entry.exceptions);
+}
+
+uint32_t busStatsQuantileUs(const BusStatsEntry& entry, float fraction) {
+  uint32_t counts[BUS_STATS_BUCKETS];
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < BUS_STATS_BUCKETS; i++) {
+    counts[i] = get(entry.buckets[i]);
+    total += counts[i];
+  }
+  if (total == 0) return 0;
+
+  // Interpolate inside the bucket the quantile falls in
+  float target = fraction * total;
+  uint32_t below = 0;
+  uint32_t maxUs = get(entry.maxLatencyUs);
+  for (uint8_t i = 0; i < BUS_STATS_BUCKETS; i++) {
+    if (counts[i] == 0 || below + counts[i] < target) {
+      below += counts[i];
+      continue;
+    }
+    uint32_t startUs = bucketStartUs(i);
+    uint32_t endUs = i + 1 < BUS_STATS_BUCKETS ? bucketStartUs(i + 1) : maxUs;
+    uint32_t us = startUs + (uint32_t)((endUs - startUs) * ((target - below) / counts[i]));
+    return min(us, maxUs);
+  }
+  return maxUs;
+}
+
+static void clearEntry(BusStatsEntry& entry) {
+  BusStatsCounter* counters[] = {&entry.transactions, &entry.ok, &entry.timeouts, &entry.crcErrors,
+                                 &entry.exceptions, &entry.other, &entry.txBytes, &entry.rxBytes,
+                                 &entry.maxLatencyUs, &entry.turnaroundUs};
+  for (BusStatsCounter* counter : counters) counter->store(0, std::memory_order_relaxed);
+  for (uint8_t i = 0; i < BUS_STATS_BUCKETS; i++) entry.buckets[i].store(0, std::memory_order_relaxed);
+}
+
+void busStatsReset() {
+  for (uint8_t bus = 0; bus < rtuBusCount(); bus++) {
+    // With the lock held nobody records on this bus
+    rtuLock(*rtuBuses[bus]);
+    clearEntry(totals[bus]);
+    for (uint8_t i = 0; i < BUS_STATS_MAX_ENTRIES; i++) {
+      entries[bus][i].used.store(false, std::memory_order_release);
+      clearEntry(entries[bus][i]);
+    }
+    rtuUnlock(*rtuBuses[bus]);
+  }
+}
+
+static void printLatency(uint32_t us) {
+  if (us < 10000) {
+    Serial.printf(" %6.2f", us / 1000.0f);
+  } else {
+    Serial.printf(" %6.1f", us / 1000.0f);
+  }
+}
+
+static void printEntry(const BusStatsEntry& entry, bool isTotal) {
+  uint32_t transactions = get(entry.transactions);
+  uint32_t replies = busStatsReplies(entry);
+  if (isTotal) {
+    Serial.printf("   all     ");
+  } else {
+    Serial.printf("   %3d 0x%02X", entry.slaveId, entry.function);
+  }
+  Serial.printf(" %7lu %5.1f%% %5lu %4lu %4lu %4lu", (unsigned long)transactions,
+                transactions ? get(entry.ok) * 100.0f / transactions : 0.0f,
+                (unsigned long)get(entry.timeouts), (unsigned long)get(entry.crcErrors),
+                (unsigned long)get(entry.exceptions), (unsigned long)get(entry.other));
+  if (replies == 0) {
+    Serial.println("      -      -      -      -      -");
+    return;
+  }
+  printLatency(busStatsQuantileUs(entry, 0.50f));
+  printLatency(busStatsQuantileUs(entry, 0.95f));
+  printLatency(busStatsQuantileUs(entry, 0.99f));
+  printLatency(get(entry.maxLatencyUs));
+  printLatency(get(entry.turnaroundUs));
+  Serial.println();
+}
+
+void busStatsPrint() {
+  bool any = false;
+  for (uint8_t bus = 0; bus < rtuBusCount(); bus++) {
+    const BusStatsEntry& total = totals[bus];
+    if (get(total.transactions) == 0) continue;
+    any = true;
+
+    Serial.printf("\n📊 Bus %d: %lu transaction(s), %lu bytes out, %lu bytes in\n", bus + 1,
+                  (unsigned long)get(total.transactions), (unsigned long)get(total.txBytes),
+                  (unsigned long)get(total.rxBytes));
+    Serial.println("   Slave FC    count    ok%   tmo  crc  exc  oth    p50    p95    p99    max   turn (ms)");
+    for (uint8_t i = 0; i < BUS_STATS_MAX_ENTRIES; i++) {
+      const BusStatsEntry& entry = entries[bus][i];
+      if (!entry.used.load(std::memory_order_acquire)) break;
+      printEntry(entry, false);
+    }
+    printEntry(total, true);
+
+    uint32_t tracked = 0;
+    for (uint8_t i = 0; i < BUS_STATS_MAX_ENTRIES && entries[bus][i].used.load(std::memory_order_acquire); i++) {
+      tracked += get(entries[bus][i].transactions);
+    }
+    uint32_t transactions = get(total.transactions);   // Read after the entries, so never behind them
+    if (transactions > tracked) {
+      Serial.printf("   %lu transaction(s) to silent IDs or beyond the %d tracked pairs are only in 'all'\n",
+                    (unsigned long)(transactions - tracked), BUS_STATS_MAX_ENTRIES);
+    }
+  }
+  if (!any) Serial.println("📊 No transactions recorded yet");
+}
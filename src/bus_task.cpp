@@ -0,0 +1,185 @@
+#include "bus_task.h"
+#include "scanner.h"
+#include "retry_policy.h"
+#include "read_cache.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+// One task and request queue per bus
+struct BusWorker {
+  RtuBus* bus;
+  QueueHandle_t requests;
+  volatile uint8_t pending;
+  BusTaskStats stats;
+};
+
+static BusWorker workers[MODBUS_BUS_COUNT];
+static uint8_t workerCount = 0;
+static QueueHandle_t results = nullptr;
+static BusTaskStats noStats;
+
+// While the task waits for a reply it sleeps a tick instead of spinning,
+// so loop() keeps running on the single core
+static void taskIdle() {
+  vTaskDelay(1);
+}
+
+static BusWorker* findWorker(const RtuBus& bus) {
+  for (uint8_t i = 0; i < workerCount; i++) {
+    if (workers[i].bus == &bus) return &workers[i];
+  }
+  return nullptr;
+}
+
+static void busTaskMain(void* parameter) {
+  BusWorker& worker = *(BusWorker*)parameter;
+  RtuBus* bus = worker.bus;
+  BusResult result;   // On this task's stack: a shared static would mix up the buses
+
+  for (;;) {
+    xQueueReceive(worker.requests, &result.request, portMAX_DELAY);
+    const BusRequest& request = result.request;
+    uint16_t timeoutMs = request.timeoutMs ? request.timeoutMs
+                                           : rtuReadTimeoutMs(*bus, request.function, request.quantity);
+
+    // The lock keeps direct callers out; their idle hook belongs to
+    // loop(). Event framing already sleeps until the reply is in.
+    rtuLock(*bus);
+    void (*idle)() = bus->idle;
+    bus->idle = bus->eventFraming ? nullptr : taskIdle;
+    bus->strayResponseSlave = 0;
+    result.cached = request.maxAgeMs &&
+        cacheLookup(*bus, request.slaveId, request.function, request.address, request.quantity,
+                    result.values, request.maxAgeMs);
+    if (result.cached) {
+      result.status = ModbusMaster::ku8MBSuccess;
+      result.durationUs = 0;
+      result.rxBytes = 0;
+      result.straySlave = 0;
+    } else {
+      uint32_t startUs = micros();
+      result.status = request.retry
+          ? retryRead(*bus, request.slaveId, request.function, request.address, request.quantity,
+                      result.values, timeoutMs)
+          : rtuReadRequest(*bus, request.slaveId, request.function, request.address,
+                           request.quantity, result.values, timeoutMs);
+      result.durationUs = micros() - startUs;
+      result.rxBytes = bus->lastRxBytes;
+      result.straySlave = bus->strayResponseSlave;
+      if (result.status == ModbusMaster::ku8MBSuccess && request.maxAgeMs) {
+        cacheStore(*bus, request.slaveId, request.function, request.address, request.quantity, result.values);
+      }
+      if (result.status == ModbusMaster::ku8MBResponseTimedOut && !request.keepLate) {
+        rtuDrain(*bus, timeoutMs); // A late reply must not answer the next request
+      }
+    }
+    bus->idle = idle;
+    rtuUnlock(*bus);
+
+    result.completedMs = millis();
+    worker.stats.completed++;
+    worker.stats.busyUs += result.durationUs;
+    xQueueSend(results, &result, portMAX_DELAY);
+  }
+}
+
+bool busTaskStart(RtuBus& rtuBus) {
+  if (findWorker(rtuBus)) return true;
+  if (workerCount >= MODBUS_BUS_COUNT) return false;
+
+  if (!results) results = xQueueCreate(BUS_QUEUE_LENGTH * MODBUS_BUS_COUNT, sizeof(BusResult));
+  BusWorker& worker = workers[workerCount];
+  rtuBus.lock = xSemaphoreCreateRecursiveMutex();
+  worker.requests = xQueueCreate(BUS_QUEUE_LENGTH, sizeof(BusRequest));
+  if (!rtuBus.lock || !worker.requests || !results) {
+    Serial.println("❌ Could not create the bus task queues");
+    return false;
+  }
+  worker.bus = &rtuBus;
+  worker.pending = 0;
+  memset(&worker.stats, 0, sizeof(worker.stats));
+
+  char name[12];
+  snprintf(name, sizeof(name), "modbus%d", workerCount + 1);
+  if (xTaskCreate(busTaskMain, name, BUS_TASK_STACK, &worker, BUS_TASK_PRIORITY, nullptr) != pdPASS) {
+    Serial.println("❌ Could not start the bus task");
+    return false;
+  }
+  workerCount++;
+  return true;
+}
+
+bool busTaskRunning() {
+  return workerCount > 0;
+}
+
+bool busTaskRunning(const RtuBus& bus) {
+  return findWorker(bus) != nullptr;
+}
+
+bool busSubmit(const BusRequest& request) {
+  BusWorker* worker = findWorker(request.bus ? *request.bus : modbusBus);
+  if (!worker) return false;
+  if (cacheJoin(request)) {
+    worker->pending++;          // Answered when the read it joined is dispatched
+    return true;
+  }
+  if (xQueueSend(worker->requests, &request, 0) != pdPASS) {
+    worker->stats.rejected++;
+    return false;
+  }
+  cacheLead(request);
+  worker->pending++;
+  worker->stats.submitted++;
+  uint8_t queued = uxQueueMessagesWaiting(worker->requests);
+  if (queued > worker->stats.maxQueued) worker->stats.maxQueued = queued;
+  return true;
+}
+
+uint8_t busPending() {
+  uint8_t total = 0;
+  for (uint8_t i = 0; i < workerCount; i++) total += workers[i].pending;
+  return total;
+}
+
+uint8_t busPending(const RtuBus& bus) {
+  BusWorker* worker = findWorker(bus);
+  return worker ? worker->pending : 0;
+}
+
+uint8_t busDispatch() {
+  if (!results) return 0;
+  static BusResult result;
+  uint8_t count = 0;
+  while (xQueueReceive(results, &result, 0) == pdTRUE) {
+    BusWorker* worker = findWorker(result.request.bus ? *result.request.bus : modbusBus);
+    if (worker) worker->pending--;
+    count++;
+    if (result.request.callback) result.request.callback(result);
+    uint8_t merged = cacheRelease(result);
+    if (worker) worker->pending -= merged;
+    count += merged;
+  }
+  return count;
+}
+
+const BusTaskStats& busTaskStats(const RtuBus& bus) {
+  BusWorker* worker = findWorker(bus);
+  return worker ? worker->stats : noStats;
+}
+
+void busTaskPrintStats() {
+  if (workerCount == 0) {
+    Serial.println("   Bus Task: not running");
+    return;
+  }
+  for (uint8_t i = 0; i < workerCount; i++) {
+    const BusWorker& worker = workers[i];
+    const BusTaskStats& stats = worker.stats;
+    Serial.printf("   Bus Task %d: %lu submitted, %lu completed, %lu rejected, %d pending, queue peak %d/%d, %lu ms on the wire\n",
+                  rtuBusNumber(*worker.bus), (unsigned long)stats.submitted, (unsigned long)stats.completed,
+                  (unsigned long)stats.rejected, worker.pending, stats.maxQueued, BUS_QUEUE_LENGTH,
+                  (unsigned long)(stats.busyUs / 1000));
+  }
+}
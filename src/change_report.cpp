@@ -0,0 +1,234 @@
+#include "change_report.h"
+#include "register_map.h"
+
+// Where a point's last reported values live in the store
+struct ChangeTrack {
+  uint16_t offset;
+  bool tracked;               // Fits the store; otherwise every read is reported whole
+  bool primed;                // The store holds a reported read
+  unsigned long snapshotDueMs;
+};
+
+static bool enabled = false;
+static uint32_t snapshotMs = CHANGE_SNAPSHOT_MS;
+static uint16_t store[CHANGE_MAX_VALUES];
+static ChangeTrack tracks[POLL_MAX_POINTS];
+static uint8_t trackCount = 0;
+static ChangeStats stats;
+
+// Text output is built in a line buffer and written a line at a time
+static char line[128];
+static size_t lineLength = 0;
+
+static bool tableIsBits(uint8_t table) {
+  return table == MAP_COILS || table == MAP_DISCRETE_INPUTS;
+}
+
+// millis() comparison that survives the 49 day wrap
+static bool reached(unsigned long now, unsigned long when) {
+  return (long)(now - when) >= 0;
+}
+
+static uint16_t storeWords(const PollPoint& point) {
+  return tableIsBits(point.table) ? (point.count + 15) / 16 : point.count;
+}
+
+static uint8_t bitAt(const uint16_t* words, uint16_t i) {
+  return (words[i / 16] >> (i % 16)) & 1;
+}
+
+static void lineStart(const PollPoint& point, const char* mark, bool listing) {
+  lineLength = snprintf(line, sizeof(line), "   %s [%d] %s%s", mark, point.slaveId, mapTableName(point.table),
+                        listing ? "" : ":");
+  if (listing) lineLength += snprintf(line + lineLength, sizeof(line) - lineLength, " %u:", point.address);
+}
+
+static void lineAdd(const char* text) {
+  size_t length = strlen(text);
+  if (lineLength + length >= sizeof(line)) {
+    line[lineLength] = '\0';
+    Serial.println(line);
+    lineLength = snprintf(line, sizeof(line), "       ");
+  }
+  memcpy(line + lineLength, text, length);
+  lineLength += length;
+}
+
+static void lineEnd() {
+  line[lineLength] = '\0';
+  Serial.println(line);
+}
+
+// The whole point: first read, snapshot, or a point the store has no room for
+static void reportWhole(const PollPoint& point, const uint16_t* values) {
+  stats.valuesReported += point.count;
+  if (streamBinary()) {
+    streamRecord(point.bus + 1, point.slaveId, point.table, point.address, point.count, values);
+    return;
+  }
+
+  bool bits = tableIsBits(point.table);
+  char item[8];
+  lineStart(point, "📸", true);
+  for (uint16_t i = 0; i < point.count; i++) {
+    snprintf(item, sizeof(item), " %u", bits ? bitAt(values, i) : values[i]);
+    lineAdd(item);
+  }
+  lineEnd();
+}
+
+// Absolute, or percent of the last reported value; deadband 0 reports any change
+static bool beyondDeadband(const PollPoint& point, uint16_t last, uint16_t value) {
+  uint16_t up = value - last;
+  uint16_t down = last - value;
+  uint16_t distance = min(up, down);     // Modular, so a signed value crossing zero moves a little
+  uint32_t threshold = point.deadbandPercent ? (uint32_t)last * point.deadband / 100 : point.deadband;
+  return distance > threshold;
+}
+
+static void reportBits(const PollPoint& point, const uint16_t* values, uint16_t* last) {
+  bool binary = streamBinary();
+  uint16_t changed = 0;
+  char item[16];
+  for (uint16_t i = 0; i < point.count; i++) {
+    if (bitAt(values, i) == bitAt(last, i)) continue;
+    if (!binary) {
+      if (changed == 0) lineStart(point, "🔄", false);
+      snprintf(item, sizeof(item), " %u=%u", point.address + i, bitAt(values, i));
+      lineAdd(item);
+    }
+    changed++;
+  }
+  if (changed == 0) return;
+
+  memcpy(last, values, storeWords(point) * sizeof(uint16_t));
+  if (binary) {
+    stats.valuesReported += point.count;
+    streamRecord(point.bus + 1, point.slaveId, point.table, point.address, point.count, values);
+  } else {
+    stats.valuesReported += changed;
+    lineEnd();
+  }
+}
+
+static void sendRun(const PollPoint& point, const uint16_t* values, int first, int last) {
+  uint16_t count = last - first + 1;
+  stats.valuesReported += count;
+  streamRecord(point.bus + 1, point.slaveId, point.table, point.address + first, count, values + first);
+}
+
+static void reportRegisters(const PollPoint& point, const uint16_t* values, uint16_t* last) {
+  bool binary = streamBinary();
+  int runFirst = -1;
+  int runLast = -1;
+  bool any = false;
+  char item[16];
+
+  for (uint16_t i = 0; i < point.count; i++) {
+    if (!beyondDeadband(point, last[i], values[i])) continue;
+    last[i] = values[i];
+    if (binary) {
+      // Extend the run over a short gap, else send it and start a new one
+      if (runFirst >= 0 && i - runLast - 1 <= CHANGE_MERGE_GAP) {
+        runLast = i;
+      } else {
+        if (runFirst >= 0) sendRun(point, values, runFirst, runLast);
+        runFirst = runLast = i;
+      }
+    } else {
+      if (!any) lineStart(point, "🔄", false);
+      snprintf(item, sizeof(item), " %u=%u", point.address + i, values[i]);
+      lineAdd(item);
+      stats.valuesReported++;
+    }
+    any = true;
+  }
+
+  if (runFirst >= 0) sendRun(point, values, runFirst, runLast);
+  if (any && !binary) lineEnd();
+}
+
+void changeSetEnabled(bool enable) {
+  enabled = enable;
+  // Start from a full report, the store may be stale
+  for (uint8_t i = 0; i < trackCount; i++) tracks[i].primed = false;
+}
+
+bool changeEnabled() {
+  return enabled;
+}
+
+void changeSetSnapshotMs(uint32_t intervalMs) {
+  snapshotMs = intervalMs;
+}
+
+uint32_t changeSnapshotMs() {
+  return snapshotMs;
+}
+
+bool changeParseDeadband(const char* text, uint16_t* deadband, bool* percent) {
+  char* end;
+  unsigned long value = strtoul(text, &end, 10);
+  if (end == text) return false;
+  *percent = *end == '%';
+  if (*percent) end++;
+  if (*end != '\0' || value > (*percent ? 100UL : 0xFFFFUL)) return false;
+  *deadband = value;
+  return true;
+}
+
+void changeBegin(const PollPoint* points, uint8_t count) {
+  uint16_t offset = 0;
+  trackCount = count;
+  for (uint8_t i = 0; i < count; i++) {
+    uint16_t words = storeWords(points[i]);
+    tracks[i].offset = offset;
+    tracks[i].tracked = offset + words <= CHANGE_MAX_VALUES;
+    tracks[i].primed = false;
+    if (tracks[i].tracked) offset += words;
+  }
+  memset(&stats, 0, sizeof(stats));
+}
+
+void changeReport(uint8_t index, const PollPoint& point, const uint16_t* values) {
+  stats.reads++;
+  stats.valuesRead += point.count;
+  if (index >= trackCount || !tracks[index].tracked) {
+    stats.untracked++;
+    reportWhole(point, values);
+    return;
+  }
+
+  ChangeTrack& track = tracks[index];
+  uint16_t* last = store + track.offset;
+  unsigned long now = millis();
+  if (!track.primed || (snapshotMs > 0 && reached(now, track.snapshotDueMs))) {
+    memcpy(last, values, storeWords(point) * sizeof(uint16_t));
+    track.primed = true;
+    track.snapshotDueMs = now + snapshotMs;
+    stats.snapshots++;
+    reportWhole(point, values);
+    return;
+  }
+
+  if (tableIsBits(point.table)) {
+    reportBits(point, values, last);
+  } else {
+    reportRegisters(point, values, last);
+  }
+}
+
+const ChangeStats& changeStats() {
+  return stats;
+}
+
+void changePrintStats() {
+  Serial.printf("📉 Changes only: %lu of %lu values reported (%.1f%%), %lu full report(s), snapshot every %lu s\n",
+                (unsigned long)stats.valuesReported, (unsigned long)stats.valuesRead,
+                stats.valuesRead ? stats.valuesReported * 100.0f / stats.valuesRead : 0.0f,
+                (unsigned long)stats.snapshots, (unsigned long)(snapshotMs / 1000));
+  if (stats.untracked > 0) {
+    Serial.printf("   ⚠️  %lu read(s) reported whole: the points hold more than %d values\n",
+                  (unsigned long)stats.untracked, CHANGE_MAX_VALUES);
+  }
+}
@@ -0,0 +1,669 @@
+#include "command_line.h"
+#include "scanner.h"
+#include "modbus_rtu.h"
+#include "bus_task.h"
+#include "scan_engine.h"
+#include "poll_scheduler.h"
+#include "register_map.h"
+#include "bus_sniffer.h"
+#include "stream_output.h"
+#include "bulk_dump.h"
+#include "change_report.h"
+#include "history.h"
+#include "bus_stats.h"
+#include "retry_policy.h"
+#include "tcp_gateway.h"
+#include "read_cache.h"
+#include <stdarg.h>
+
+#define COMMAND_MAX_ARGS 10
+#define COMMAND_MAX_READS (BUS_QUEUE_LENGTH * MODBUS_BUS_COUNT)
+
+enum CommandResult {
+  COMMAND_DONE,
+  COMMAND_DEFER         // Bus queue full: run the line again on the next pass
+};
+
+// Reads handed to the bus task, waiting for their result
+struct CommandRead {
+  bool used;
+  char id[COMMAND_MAX_ID + 1];
+};
+
+static char lineBuffer[COMMAND_MAX_LINE + 1];
+static uint8_t lineLength = 0;
+static bool lineOverflow = false;
+static String deferred;
+static CommandRead reads[COMMAND_MAX_READS];
+static char scanId[COMMAND_MAX_ID + 1];   // ID of the command that started the running scan
+static char dumpId[COMMAND_MAX_ID + 1];   // Same for the running dump
+
+static void reply(const char* kind, const char* id, const char* format, ...) {
+  char text[160];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  Serial.printf("> %s %s %s\n", kind, id, text);
+}
+
+static const char* resultName(uint8_t result) {
+  switch (result) {
+    case ModbusMaster::ku8MBSuccess: return "ok";
+    case ModbusMaster::ku8MBIllegalFunction: return "illegal-function";
+    case ModbusMaster::ku8MBIllegalDataAddress: return "illegal-address";
+    case ModbusMaster::ku8MBIllegalDataValue: return "illegal-value";
+    case ModbusMaster::ku8MBSlaveDeviceFailure: return "device-failure";
+    case ModbusMaster::ku8MBInvalidSlaveID: return "invalid-slave";
+    case ModbusMaster::ku8MBInvalidFunction: return "invalid-function";
+    case ModbusMaster::ku8MBResponseTimedOut: return "timeout";
+    case ModbusMaster::ku8MBInvalidCRC: return "crc";
+    case RETRY_CIRCUIT_OPEN: return "circuit-open";
+    default: return "error";
+  }
+}
+
+static int parseTable(const char* name) {
+  for (uint8_t t = 0; t < MAP_TABLE_COUNT; t++) {
+    if (strcasecmp(mapTableName(t), name) == 0) return t;
+  }
+  return -1;
+}
+
+// Whole-token integer in [low, high]
+static bool parseNumber(const char* text, long low, long high, long* value) {
+  char* end;
+  *value = strtol(text, &end, 10);
+  return end != text && *end == '\0' && *value >= low && *value <= high;
+}
+
+bool commandReadLine(String& line) {
+  if (deferred.length() > 0) {
+    line = deferred;
+    deferred = "";
+    return true;
+  }
+
+  while (Serial.available()) {
+    int c = Serial.read();
+    if (c < 0) break;
+    if (c == '\r') continue;
+    if (c != '\n') {
+      if (lineLength < COMMAND_MAX_LINE) {
+        lineBuffer[lineLength++] = c;
+      } else {
+        lineOverflow = true;
+      }
+      continue;
+    }
+
+    lineBuffer[lineLength] = '\0';
+    lineLength = 0;
+    if (lineOverflow) {
+      lineOverflow = false;
+      reply("err", "-", "line longer than %d characters", COMMAND_MAX_LINE);
+      continue;
+    }
+    line = lineBuffer;
+    line.trim();
+    return true;
+  }
+  return false;
+}
+
+static void onCommandRead(const BusResult& result) {
+  const BusRequest& request = result.request;
+  CommandRead& read = reads[request.tag];
+  read.used = false;
+  uint8_t table = request.function - 1;
+  uint8_t bus = rtuBusNumber(request.bus ? *request.bus : modbusBus);
+
+  if (result.status != ModbusMaster::ku8MBSuccess) {
+    reply("err", read.id, "read %s %d %u: %s", mapTableName(table), request.slaveId, request.address,
+          resultName(result.status));
+    return;
+  }
+
+  if (streamBinary()) {
+    streamRecord(bus, request.slaveId, table, request.address, request.quantity, result.values);
+  } else {
+    bool bits = table == MAP_COILS || table == MAP_DISCRETE_INPUTS;
+    Serial.printf("> data %s %s %d %u:", read.id, mapTableName(table), request.slaveId, request.address);
+    for (uint16_t i = 0; i < request.quantity; i++) {
+      if (bits) {
+        Serial.printf(" %d", (result.values[i / 16] >> (i % 16)) & 1);
+      } else {
+        Serial.printf(" %u", result.values[i]);
+      }
+    }
+    Serial.println();
+  }
+  reply("ok", read.id, "read %s %d %u %u %lu us%s", mapTableName(table), request.slaveId, request.address,
+        request.quantity, (unsigned long)result.durationUs, result.cached ? " cached" : "");
+}
+
+static CommandResult commandRead(const char* id, char** args, int argc) {
+  long slave, address, count, bus = 1;
+  int table = argc >= 4 ? parseTable(args[0]) : -1;
+  bool bits = table == MAP_COILS || table == MAP_DISCRETE_INPUTS;
+  if (table < 0 || !parseNumber(args[1], 1, 247, &slave) || !parseNumber(args[2], 0, 0xFFFF, &address) ||
+      !parseNumber(args[3], 1, bits ? RTU_MAX_READ_BITS : RTU_MAX_READ_WORDS, &count) ||
+      (argc >= 5 && !parseNumber(args[4], 1, rtuBusCount(), &bus))) {
+    reply("err", id, "usage: read <co|di|hr|ir> <slave> <address> <count> [bus]");
+    return COMMAND_DONE;
+  }
+  if (snifferActive()) {
+    reply("err", id, "sniffer is listening, stop it first");
+    return COMMAND_DONE;
+  }
+  RtuBus& rtuBus = *rtuBuses[bus - 1];
+  if (!busTaskRunning(rtuBus)) {
+    reply("err", id, "bus %ld not running", bus);
+    return COMMAND_DONE;
+  }
+
+  int slot = -1;
+  for (int i = 0; i < COMMAND_MAX_READS && slot < 0; i++) {
+    if (!reads[i].used) slot = i;
+  }
+  if (slot < 0) return COMMAND_DEFER;
+
+  BusRequest request = {};
+  request.bus = &rtuBus;
+  request.slaveId = slave;
+  request.function = table + 1;
+  request.address = address;
+  request.quantity = count;
+  request.retry = true;
+  request.maxAgeMs = CACHE_ANY_AGE;
+  request.tag = slot;
+  request.callback = onCommandRead;
+  if (!busSubmit(request)) return COMMAND_DEFER;
+  reads[slot].used = true;
+  strncpy(reads[slot].id, id, COMMAND_MAX_ID);
+  reads[slot].id[COMMAND_MAX_ID] = '\0';
+  return COMMAND_DONE;
+}
+
+static void onScanFinished(const ScanStats& stats, bool cancelled) {
+  if (!scanId[0]) return;
+  reply("done", scanId, "scan %d %d %lu%s", stats.devicesFound, stats.probes,
+        (unsigned long)(millis() - stats.startMs - stats.pausedMs), cancelled ? " cancelled" : "");
+  scanId[0] = '\0';
+}
+
+static void commandScan(const char* id, char** args, int argc) {
+  long first = 1, last = 247;
+  for (int i = 0; i < argc; i++) {
+    char* dash = strchr(args[i], '-');
+    if (dash) {
+      *dash = '\0';
+      if (!parseNumber(args[i], 1, 247, &first) || !parseNumber(dash + 1, first, 247, &last)) {
+        reply("err", id, "bad ID range, expected <first>-<last> within 1-247");
+        return;
+      }
+    } else if (strcasecmp(args[i], "fast") == 0) {
+      sweepSettings.fastSweep = true;
+    } else if (strcasecmp(args[i], "slow") == 0) {
+      sweepSettings.fastSweep = false;
+    } else if (strcasecmp(args[i], "retry") == 0) {
+      sweepSettings.retryPass = true;
+    } else if (strcasecmp(args[i], "noretry") == 0) {
+      sweepSettings.retryPass = false;
+    } else {
+      reply("err", id, "usage: scan [<first>-<last>] [fast|slow] [retry|noretry]");
+      return;
+    }
+  }
+  if (scanActive()) {
+    reply("err", id, "scan already running");
+    return;
+  }
+
+  scanSetFinishHandler(onScanFinished);
+  scanStart(first, last);
+  if (!scanActive()) {
+    reply("err", id, "no bus to scan");
+    return;
+  }
+  strncpy(scanId, id, COMMAND_MAX_ID);
+  scanId[COMMAND_MAX_ID] = '\0';
+  reply("ok", id, "scan %ld-%ld %s", first, last, sweepSettings.fastSweep ? "fast" : "slow");
+}
+
+static void onDumpFinished(const DumpStats& stats) {
+  if (!dumpId[0]) return;
+  reply("done", dumpId, "dump %lu %lu %lu %.0f%s", (unsigned long)stats.values, (unsigned long)stats.transactions,
+        stats.elapsedMs, dumpValuesPerSecond(stats),
+        stats.cancelled ? " cancelled" : stats.deviceLost ? " lost" : stats.unsupported ? " unsupported" : "");
+  dumpId[0] = '\0';
+}
+
+static void commandDump(const char* id, char** args, int argc) {
+  long slave, first = 0, last = 0xFFFF, bus = 1;
+  int table = argc >= 2 ? parseTable(args[0]) : -1;
+  char* dash = argc >= 3 ? strchr(args[2], '-') : nullptr;
+  if (dash) *dash = '\0';
+  if (table < 0 || !parseNumber(args[1], 1, 247, &slave) ||
+      (argc >= 3 && (!dash || !parseNumber(args[2], 0, 0xFFFF, &first) || !parseNumber(dash + 1, first, 0xFFFF, &last))) ||
+      (argc >= 4 && !parseNumber(args[3], 1, rtuBusCount(), &bus))) {
+    reply("err", id, "usage: dump <co|di|hr|ir> <slave> [<first>-<last>] [bus]");
+    return;
+  }
+  if (dumpActive()) {
+    reply("err", id, "dump already running");
+    return;
+  }
+
+  dumpSetFinishHandler(onDumpFinished);
+  if (!dumpStart(slave, table, first, last, bus - 1)) {
+    reply("err", id, "dump not started");
+    return;
+  }
+  strncpy(dumpId, id, COMMAND_MAX_ID);
+  dumpId[COMMAND_MAX_ID] = '\0';
+  reply("ok", id, "dump %s %ld %ld-%ld", mapTableName(table), slave, first, last);
+}
+
+static void commandPoll(const char* id, char** args, int argc) {
+  const char* action = argc > 0 ? args[0] : "";
+  if (strcasecmp(action, "add") == 0) {
+    long slave, address, count, periodMs, bus = 1;
+    int table = argc >= 6 ? parseTable(args[2]) : -1;
+    if (table < 0 || !parseNumber(args[1], 1, 247, &slave) || !parseNumber(args[3], 0, 0xFFFF, &address) ||
+        !parseNumber(args[4], 1, RTU_MAX_READ_BITS, &count) || !parseNumber(args[5], 1, 86400000L, &periodMs) ||
+        (argc >= 7 && !parseNumber(args[6], 1, rtuBusCount(), &bus))) {
+      reply("err", id, "usage: poll add <slave> <co|di|hr|ir> <address> <count> <period ms> [bus]");
+      return;
+    }
+    int index = pollAddPoint(slave, table, address, count, periodMs, bus - 1);
+    if (index < 0) {
+      reply("err", id, "invalid poll point or list full");
+    } else {
+      reply("ok", id, "poll add %d", index);
+    }
+  } else if (strcasecmp(action, "clear") == 0) {
+    pollClear();
+    reply("ok", id, "poll clear");
+  } else if (strcasecmp(action, "start") == 0) {
+    pollStart();
+    if (pollActive()) {
+      reply("ok", id, "poll start %d", pollPointCount());
+    } else {
+      reply("err", id, "no poll points");
+    }
+  } else if (strcasecmp(action, "stop") == 0) {
+    pollStop();
+    reply("ok", id, "poll stop");
+  } else if (strcasecmp(action, "stats") == 0) {
+    PollWindow totals = pollTotals();
+    if (changeEnabled()) {
+      const ChangeStats& changes = changeStats();
+      reply("ok", id, "poll stats %lu %lu %lu %lu %lu", (unsigned long)totals.reads, (unsigned long)totals.misses,
+            (unsigned long)totals.failures, (unsigned long)changes.valuesRead, (unsigned long)changes.valuesReported);
+      return;
+    }
+    reply("ok", id, "poll stats %lu %lu %lu", (unsigned long)totals.reads, (unsigned long)totals.misses,
+          (unsigned long)totals.failures);
+  } else if (strcasecmp(action, "deadband") == 0) {
+    long index;
+    uint16_t deadband;
+    bool percent;
+    if (argc < 3 || !parseNumber(args[1], 0, POLL_MAX_POINTS - 1, &index) ||
+        !changeParseDeadband(args[2], &deadband, &percent) || !pollSetDeadband(index, deadband, percent)) {
+      reply("err", id, "usage: poll deadband <point> <value>[%%]");
+      return;
+    }
+    reply("ok", id, "poll deadband %ld %u%s", index, deadband, percent ? "%" : "");
+  } else if (strcasecmp(action, "changes") == 0) {
+    long snapshotS = changeSnapshotMs() / 1000;
+    bool on = argc >= 2 && strcasecmp(args[1], "on") == 0;
+    if (argc < 2 || (!on && strcasecmp(args[1], "off") != 0) ||
+        (argc >= 3 && !parseNumber(args[2], 0, 86400, &snapshotS))) {
+      reply("err", id, "usage: poll changes on|off [snapshot s]");
+      return;
+    }
+    changeSetSnapshotMs(snapshotS * 1000);
+    changeSetEnabled(on);
+    reply("ok", id, "poll changes %s %ld", on ? "on" : "off", snapshotS);
+  } else {
+    reply("err", id, "usage: poll add|clear|start|stop|stats|deadband|changes");
+  }
+}
+
+static void commandHistory(const char* id, char** args, int argc) {
+  const char* action = argc > 0 ? args[0] : "list";
+  char prefix[48];
+  long index, windowS = 0;
+  bool raw = strcasecmp(action, "raw") == 0;
+  if (raw || strcasecmp(action, "rollup") == 0) {
+    if (argc < 2 || !parseNumber(args[1], 0, HISTORY_MAX_SERIES - 1, &index) || index >= historySeriesCount() ||
+        (argc >= 3 && !parseNumber(args[2], 1, 86400L * 7, &windowS))) {
+      reply("err", id, "usage: history raw|rollup <series> [seconds]");
+      return;
+    }
+    snprintf(prefix, sizeof(prefix), "> data %s hist %ld %s", id, index, raw ? "raw" : "rollup");
+    uint16_t written = raw ? historyStreamRaw(Serial, prefix, index, windowS)
+                           : historyStreamRollup(Serial, prefix, index, windowS);
+    reply("ok", id, "history %s %ld %u", action, index, written);
+  } else if (strcasecmp(action, "flash") == 0) {
+    HistoryFlashInfo info;
+    if (argc < 2 || !parseNumber(args[1], 0, HISTORY_SPILL_BLOCKS - 1, &index) || !historyFlashBlock(index, &info)) {
+      reply("err", id, "usage: history flash <block> (a stored block)");
+      return;
+    }
+    snprintf(prefix, sizeof(prefix), "> data %s hist flash %ld", id, index);
+    uint16_t written = historyStreamFlash(Serial, prefix, index);
+    reply("ok", id, "history flash %ld %s %d %u boot %u %u", index, mapTableName(info.table), info.slaveId,
+          info.address, info.boot, written);
+  } else if (strcasecmp(action, "spill") == 0 && argc >= 2 &&
+             (strcasecmp(args[1], "on") == 0 || strcasecmp(args[1], "off") == 0)) {
+    historySetSpill(strcasecmp(args[1], "on") == 0);
+    reply("ok", id, "history spill %s", historySpill() ? "on" : "off");
+  } else if (strcasecmp(action, "clear") == 0) {
+    historyClear();
+    reply("ok", id, "history clear");
+  } else if (strcasecmp(action, "list") == 0) {
+    // One line per series: index, bus, table, slave, address, samples
+    for (uint8_t i = 0; i < historySeriesCount(); i++) {
+      const HistorySeries& series = historySeries(i);
+      Serial.printf("> data %s hist %d: bus %d %s %d %u, %lu samples\n", id, i, series.bus + 1,
+                    mapTableName(series.table), series.slaveId, series.address, (unsigned long)series.samples);
+    }
+    reply("ok", id, "history list %d", historySeriesCount());
+  } else {
+    reply("err", id, "usage: history [list|raw|rollup|flash|spill on|off|clear]");
+  }
+}
+
+static void statsLine(const char* id, uint8_t bus, const BusStatsEntry& entry) {
+  char who[16];
+  if (entry.slaveId == 0) {
+    snprintf(who, sizeof(who), "all");
+  } else {
+    snprintf(who, sizeof(who), "%d %d", entry.slaveId, entry.function);
+  }
+  Serial.printf("> data %s stats %d %s: %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu\n", id, bus + 1, who,
+                (unsigned long)entry.transactions.load(), (unsigned long)entry.ok.load(),
+                (unsigned long)entry.timeouts.load(), (unsigned long)entry.crcErrors.load(),
+                (unsigned long)entry.exceptions.load(), (unsigned long)entry.other.load(),
+                (unsigned long)busStatsQuantileUs(entry, 0.50f), (unsigned long)busStatsQuantileUs(entry, 0.95f),
+                (unsigned long)busStatsQuantileUs(entry, 0.99f), (unsigned long)entry.maxLatencyUs.load());
+}
+
+static void commandStats(const char* id, char** args, int argc) {
+  if (argc >= 1 && strcasecmp(args[0], "reset") == 0) {
+    busStatsReset();
+    reply("ok", id, "stats reset");
+    return;
+  }
+  if (argc >= 1) {
+    reply("err", id, "usage: stats [reset]");
+    return;
+  }
+  // Per bus: its slave/function entries, then the totals
+  uint16_t lines = 0;
+  for (uint8_t bus = 0; bus < rtuBusCount(); bus++) {
+    for (uint8_t i = 0; busStatsEntry(bus, i); i++) {
+      statsLine(id, bus, *busStatsEntry(bus, i));
+      lines++;
+    }
+    statsLine(id, bus, busStatsTotal(bus));
+    lines++;
+  }
+  reply("ok", id, "stats %u", lines);
+}
+
+// Settings as keyword/value pairs; any of them changes the policy for every caller
+static void commandRetry(const char* id, char** args, int argc) {
+  if (argc >= 1 && strcasecmp(args[0], "reset") == 0) {
+    retryReset();
+    reply("ok", id, "retry reset");
+    return;
+  }
+  RetryPolicy policy = retryPolicy;
+  for (int i = 0; i < argc; i += 2) {
+    long value = 0;
+    bool off = i + 1 < argc && strcasecmp(args[i], "breaker") == 0 && strcasecmp(args[i + 1], "off") == 0;
+    if (i + 1 >= argc || (!off && !parseNumber(args[i + 1], 0, 60000, &value))) {
+      reply("err", id, "usage: retry [attempts <n>] [timeouts <n>] [backoff <ms>] [breaker <failures>|off] | retry reset");
+      return;
+    }
+    if (strcasecmp(args[i], "attempts") == 0 && value >= 1 && value <= 10) {
+      policy.maxAttempts = value;
+    } else if (strcasecmp(args[i], "timeouts") == 0 && value <= 10) {
+      policy.maxTimeoutRetries = value;
+    } else if (strcasecmp(args[i], "backoff") == 0) {
+      policy.backoffMs = value;
+      policy.maxBackoffMs = max((long)policy.maxBackoffMs, value);
+    } else if (strcasecmp(args[i], "breaker") == 0 && (off || value <= 255)) {
+      policy.breakerFailures = off ? 0 : value;
+    } else {
+      reply("err", id, "bad retry setting %s %s", args[i], args[i + 1]);
+      return;
+    }
+  }
+  retryPolicy = policy;
+
+  // Per bus: calls, retries, recovered, failed after retrying, no budget, refused, trips
+  for (uint8_t bus = 0; bus < rtuBusCount(); bus++) {
+    const RetryStats& stats = retryStats(*rtuBuses[bus]);
+    Serial.printf("> data %s retry %d: %lu %lu %lu %lu %lu %lu %lu\n", id, bus + 1, (unsigned long)stats.calls,
+                  (unsigned long)stats.retries, (unsigned long)stats.recovered, (unsigned long)stats.exhausted,
+                  (unsigned long)stats.budgetDenied, (unsigned long)stats.shortCircuited, (unsigned long)stats.trips);
+  }
+  reply("ok", id, "retry attempts %d timeouts %d backoff %u breaker %d", retryPolicy.maxAttempts,
+        retryPolicy.maxTimeoutRetries, retryPolicy.backoffMs, retryPolicy.breakerFailures);
+}
+
+// No arguments: the counters; start/stop/reset/wifi control the gateway
+static void commandGateway(const char* id, char** args, int argc) {
+  const char* usage = "usage: gateway [start [port] [bus]] | gateway stop | gateway reset | gateway wifi <ssid> [password]";
+  if (argc >= 1 && strcasecmp(args[0], "start") == 0) {
+    long port = GATEWAY_PORT, bus = 1;
+    if ((argc >= 2 && !parseNumber(args[1], 1, 65535, &port)) ||
+        (argc >= 3 && !parseNumber(args[2], 1, rtuBusCount(), &bus)) || argc > 3) {
+      reply("err", id, "%s", usage);
+      return;
+    }
+    if (gatewayStart(port, *rtuBuses[bus - 1])) {
+      reply("ok", id, "gateway start %u %ld", gatewayPort(), bus);
+    } else {
+      reply("err", id, "gateway could not start");
+    }
+    return;
+  }
+  if (argc == 1 && strcasecmp(args[0], "stop") == 0) {
+    gatewayStop();
+    reply("ok", id, "gateway stop");
+    return;
+  }
+  if (argc == 1 && strcasecmp(args[0], "reset") == 0) {
+    gatewayResetStats();
+    reply("ok", id, "gateway reset");
+    return;
+  }
+  if ((argc == 2 || argc == 3) && strcasecmp(args[0], "wifi") == 0) {
+    gatewaySetWifi(args[1], argc == 3 ? args[2] : "");
+    reply("ok", id, "gateway wifi %s", args[1]);
+    return;
+  }
+  if (argc > 0) {
+    reply("err", id, "%s", usage);
+    return;
+  }
+
+  // Clients, requests, replies, exceptions, busy, no reply, rejected, requests/s, avg and max queue wait
+  const GatewayStats& stats = gatewayStats();
+  Serial.printf("> data %s gateway: %d %lu %lu %lu %lu %lu %lu %.1f %lu %lu\n", id, gatewayClientCount(),
+                (unsigned long)stats.requests, (unsigned long)stats.replies, (unsigned long)stats.exceptions,
+                (unsigned long)stats.busy, (unsigned long)stats.failed, (unsigned long)stats.rejected,
+                gatewayRequestsPerSecond(), (unsigned long)(stats.forwarded ? stats.waitUs / stats.forwarded : 0),
+                (unsigned long)stats.maxWaitUs);
+  reply("ok", id, gatewayActive() ? "gateway on port %u" : "gateway off", gatewayPort());
+}
+
+// No arguments: the counters; the rest sets TTLs and switches the cache
+static void commandCache(const char* id, char** args, int argc) {
+  const char* usage = "usage: cache [on|off|clear|reset] | cache default <ms> | "
+                      "cache ttl <co|di|hr|ir> <slave> <first>[-<last>] <ms> [bus] | cache ttl clear";
+  long value;
+  if (argc == 1 && (strcasecmp(args[0], "on") == 0 || strcasecmp(args[0], "off") == 0)) {
+    cacheSettings.enabled = strcasecmp(args[0], "on") == 0;
+    cacheClear();
+  } else if (argc == 1 && strcasecmp(args[0], "clear") == 0) {
+    cacheClear();
+  } else if (argc == 1 && strcasecmp(args[0], "reset") == 0) {
+    cacheResetStats();
+  } else if (argc == 2 && strcasecmp(args[0], "default") == 0 && parseNumber(args[1], 0, 3600000L, &value)) {
+    cacheSettings.defaultTtlMs = value;
+    cacheClear();
+  } else if (argc == 2 && strcasecmp(args[0], "ttl") == 0 && strcasecmp(args[1], "clear") == 0) {
+    cacheClearRules();
+  } else if ((argc == 5 || argc == 6) && strcasecmp(args[0], "ttl") == 0) {
+    long slave, first, last, bus = 1;
+    int table = parseTable(args[1]);
+    char* dash = strchr(args[3], '-');
+    if (dash) *dash = '\0';
+    if (table < 0 || !parseNumber(args[2], 0, 247, &slave) || !parseNumber(args[3], 0, 0xFFFF, &first) ||
+        !parseNumber(dash ? dash + 1 : args[3], first, 0xFFFF, &last) ||
+        !parseNumber(args[4], 0, 3600000L, &value) || (argc == 6 && !parseNumber(args[5], 1, rtuBusCount(), &bus))) {
+      reply("err", id, "%s", usage);
+      return;
+    }
+    if (!cacheSetTtl(slave, table, first, last, value, *rtuBuses[bus - 1])) {
+      reply("err", id, "all %d TTL rules taken, cache ttl clear first", CACHE_MAX_RULES);
+      return;
+    }
+  } else if (argc > 0) {
+    reply("err", id, "%s", usage);
+    return;
+  }
+
+  // Per bus: hits, hits from a larger block, merged in flight, misses, stored, evicted, hit rate
+  for (uint8_t bus = 0; bus < rtuBusCount(); bus++) {
+    const CacheStats& stats = cacheStats(*rtuBuses[bus]);
+    Serial.printf("> data %s cache %d: %lu %lu %lu %lu %lu %lu %.1f\n", id, bus + 1, (unsigned long)stats.hits,
+                  (unsigned long)stats.coveredHits, (unsigned long)stats.joined, (unsigned long)stats.misses,
+                  (unsigned long)stats.stores, (unsigned long)stats.evictions, cacheHitRate(*rtuBuses[bus]));
+  }
+  uint8_t rules = 0;
+  while (cacheRule(rules)) rules++;
+  reply("ok", id, "cache %s default %lu rules %d", cacheSettings.enabled ? "on" : "off",
+        (unsigned long)cacheSettings.defaultTtlMs, rules);
+}
+
+static void commandBaud(const char* id, char** args, int argc) {
+  static const uint32_t configs[] = {SERIAL_8N1, SERIAL_8N2, SERIAL_8E1, SERIAL_8E2, SERIAL_8O1,
+                                     SERIAL_8O2, SERIAL_7E1, SERIAL_7O1, SERIAL_7N1};
+  long baud;
+  uint32_t config = modbusBus.config;
+  if (argc < 1 || !parseNumber(args[0], 300, 1000000L, &baud)) {
+    reply("err", id, "usage: baud <rate> [8N1|8E1|...]");
+    return;
+  }
+  if (argc >= 2) {
+    bool known = false;
+    for (uint32_t candidate : configs) {
+      if (strcasecmp(rtuConfigName(candidate), args[1]) == 0) {
+        config = candidate;
+        known = true;
+      }
+    }
+    if (!known) {
+      reply("err", id, "unknown frame format %s", args[1]);
+      return;
+    }
+  }
+  rtuBegin(modbusBus, baud, config);
+  reply("ok", id, "baud %lu %s", (unsigned long)modbusBus.baud, rtuConfigName(modbusBus.config));
+}
+
+static void commandHelp(const char* id) {
+  Serial.println("Commands (optional #<id> first, replies start with '> '):");
+  Serial.println("  read <co|di|hr|ir> <slave> <address> <count> [bus]");
+  Serial.println("  scan [<first>-<last>] [fast|slow] [retry|noretry]");
+  Serial.println("  dump <co|di|hr|ir> <slave> [<first>-<last>] [bus]");
+  Serial.println("  poll add <slave> <co|di|hr|ir> <address> <count> <period ms> [bus]");
+  Serial.println("  poll clear | poll start | poll stop | poll stats");
+  Serial.println("  poll deadband <point> <value>[%] | poll changes on|off [snapshot s]");
+  Serial.println("  history [list] | history raw|rollup <series> [seconds] | history flash <block>");
+  Serial.println("  history spill on|off | history clear");
+  Serial.println("  stats [reset]");
+  Serial.println("  retry [attempts <n>] [timeouts <n>] [backoff <ms>] [breaker <failures>|off] | retry reset");
+  Serial.println("  gateway [start [port] [bus]] | gateway stop | gateway reset | gateway wifi <ssid> [password]");
+  Serial.println("  cache [on|off|clear|reset] | cache default <ms> | cache ttl clear");
+  Serial.println("  cache ttl <co|di|hr|ir> <slave> <first>[-<last>] <ms> [bus]");
+  Serial.println("  baud <rate> [8N1|8E1|...]");
+  Serial.println("  output text|binary");
+  Serial.println("  status");
+  reply("ok", id, "help");
+}
+
+bool commandHandle(const String& line) {
+  char text[COMMAND_MAX_LINE + 1];
+  strncpy(text, line.c_str(), COMMAND_MAX_LINE);
+  text[COMMAND_MAX_LINE] = '\0';
+
+  char* tokens[COMMAND_MAX_ARGS + 2];
+  int count = 0;
+  char* save = nullptr;
+  for (char* token = strtok_r(text, " \t", &save); token && count < COMMAND_MAX_ARGS + 2;
+       token = strtok_r(nullptr, " \t", &save)) {
+    tokens[count++] = token;
+  }
+
+  const char* id = "-";
+  int first = 0;
+  if (count > 0 && tokens[0][0] == '#') {
+    if (strlen(tokens[0]) < 2 || strlen(tokens[0]) > COMMAND_MAX_ID + 1) return false;
+    id = tokens[0] + 1;
+    first = 1;
+  }
+  if (first >= count) return false;
+
+  const char* name = tokens[first];
+  char** args = tokens + first + 1;
+  int argc = count - first - 1;
+
+  if (strcasecmp(name, "read") == 0) {
+    if (commandRead(id, args, argc) == COMMAND_DEFER) deferred = line;
+  } else if (strcasecmp(name, "scan") == 0) {
+    commandScan(id, args, argc);
+  } else if (strcasecmp(name, "dump") == 0) {
+    commandDump(id, args, argc);
+  } else if (strcasecmp(name, "poll") == 0) {
+    commandPoll(id, args, argc);
+  } else if (strcasecmp(name, "history") == 0) {
+    commandHistory(id, args, argc);
+  } else if (strcasecmp(name, "stats") == 0) {
+    commandStats(id, args, argc);
+  } else if (strcasecmp(name, "retry") == 0) {
+    commandRetry(id, args, argc);
+  } else if (strcasecmp(name, "gateway") == 0) {
+    commandGateway(id, args, argc);
+  } else if (strcasecmp(name, "cache") == 0) {
+    commandCache(id, args, argc);
+  } else if (strcasecmp(name, "baud") == 0) {
+    commandBaud(id, args, argc);
+  } else if (strcasecmp(name, "output") == 0) {
+    if (argc >= 1 && (strcasecmp(args[0], "text") == 0 || strcasecmp(args[0], "binary") == 0)) {
+      streamSetMode(strcasecmp(args[0], "binary") == 0 ? STREAM_BINARY : STREAM_TEXT);
+      reply("ok", id, "output %s", args[0]);
+    } else {
+      reply("err", id, "usage: output text|binary");
+    }
+  } else if (strcasecmp(name, "status") == 0) {
+    reply("ok", id, "status scan=%s poll=%s dump=%s sniffer=%s gateway=%s pending=%d baud=%lu %s",
+          scanActive() ? "running" : "idle", pollActive() ? "running" : "idle", dumpActive() ? "running" : "idle",
+          snifferActive() ? "on" : "off", gatewayActive() ? "on" : "off", busPending(),
+          (unsigned long)modbusBus.baud, rtuConfigName(modbusBus.config));
+  } else if (strcasecmp(name, "help") == 0) {
+    commandHelp(id);
+  } else if (first == 1) {
+    reply("err", id, "unknown command %s", name);
+  } else {
+    return false; // Menu number or engine control
+  }
+  return true;
+}
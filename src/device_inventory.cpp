@@ -0,0 +1,187 @@
+#include "device_inventory.h"
+#include <Preferences.h>
+
+#define INVENTORY_NAMESPACE "modbus"
+#define INVENTORY_KEY "inventory"
+#define SERIAL_CONFIG_BASE 0x8000000UL   // Common high bits of the SERIAL_xxx values
+
+// Stored blob: header, records, CRC16 over both
+struct __attribute__((packed)) InventoryHeader {
+  uint8_t version;
+  uint8_t count;
+};
+
+static InventoryRecord records[INVENTORY_MAX_DEVICES];
+static uint8_t recordCount = 0;
+static unsigned long bootMs = 0;
+static unsigned long firstReadMs = 0;
+static Preferences nvs;
+
+static uint8_t blob[sizeof(InventoryHeader) + sizeof(records) + 2];
+
+uint32_t inventoryBaud(const InventoryRecord& record) {
+  return record.baud100 * 100UL;
+}
+
+uint32_t inventoryConfig(const InventoryRecord& record) {
+  return SERIAL_CONFIG_BASE | record.format;
+}
+
+static void noteRead() {
+  if (firstReadMs == 0) firstReadMs = max(millis() - bootMs, 1UL);
+}
+
+static void save() {
+  InventoryHeader header = {INVENTORY_VERSION, recordCount};
+  size_t length = sizeof(header) + recordCount * sizeof(InventoryRecord);
+  memcpy(blob, &header, sizeof(header));
+  memcpy(blob + sizeof(header), records, recordCount * sizeof(InventoryRecord));
+  uint16_t crc = rtuCrc16(blob, length);
+  blob[length++] = crc & 0xFF;
+  blob[length++] = crc >> 8;
+
+  nvs.begin(INVENTORY_NAMESPACE, false);
+  if (nvs.putBytes(INVENTORY_KEY, blob, length) != length) {
+    Serial.println("⚠️  Could not save the device inventory");
+  }
+  nvs.end();
+}
+
+static bool load() {
+  nvs.begin(INVENTORY_NAMESPACE, true);
+  size_t length = nvs.getBytes(INVENTORY_KEY, blob, sizeof(blob));
+  nvs.end();
+  if (length == 0) return false;
+
+  InventoryHeader header;
+  memcpy(&header, blob, min(length, sizeof(header)));
+  size_t expected = sizeof(header) + header.count * sizeof(InventoryRecord) + 2;
+  if (length < sizeof(header) + 2 || header.version != INVENTORY_VERSION ||
+      header.count > INVENTORY_MAX_DEVICES || length != expected ||
+      rtuCrc16(blob, length - 2) != (blob[length - 2] | (blob[length - 1] << 8))) {
+    Serial.println("⚠️  Stored device inventory is invalid - ignoring it");
+    return false;
+  }
+
+  recordCount = header.count;
+  memcpy(records, blob + sizeof(header), recordCount * sizeof(InventoryRecord));
+  return true;
+}
+
+void inventoryBegin() {
+  bootMs = millis();
+  firstReadMs = 0;
+  recordCount = 0;
+  load();
+}
+
+// Record a device that answered at the bus's current settings; NVS is only
+// written when something changed
+void inventoryRemember(uint8_t slaveId, const RtuBus& bus, uint8_t flags) {
+  noteRead();
+
+  InventoryRecord record;
+  record.slaveId = slaveId;
+  record.format = bus.config & 0xFF;
+  record.baud100 = bus.baud / 100;
+  record.turnaroundMs = min((bus.turnaroundUs + 999) / 1000, (uint32_t)255);
+  record.flags = flags;
+
+  uint8_t i = 0;
+  while (i < recordCount && records[i].slaveId != slaveId) i++;
+  if (i == recordCount) {
+    if (recordCount >= INVENTORY_MAX_DEVICES) return;
+    recordCount++;
+  } else {
+    // The turnaround is the bus-wide worst case, so keep the larger value
+    // and leave flags found earlier in place
+    record.turnaroundMs = max(record.turnaroundMs, records[i].turnaroundMs);
+    record.flags |= records[i].flags;
+    if (memcmp(&records[i], &record, sizeof(record)) == 0) return;
+  }
+  records[i] = record;
+  save();
+}
+
+void inventoryClear() {
+  recordCount = 0;
+  nvs.begin(INVENTORY_NAMESPACE, false);
+  nvs.remove(INVENTORY_KEY);
+  nvs.end();
+}
+
+uint8_t inventoryCount() {
+  return recordCount;
+}
+
+const InventoryRecord* inventoryRecords() {
+  return records;
+}
+
+unsigned long inventoryFirstReadMs() {
+  return firstReadMs;
+}
+
+static bool answered(uint8_t result) {
+  return result != ModbusMaster::ku8MBResponseTimedOut && result != ModbusMaster::ku8MBInvalidSlaveID &&
+         result != ModbusMaster::ku8MBInvalidCRC;
+}
+
+// One probe per known device at its stored settings (a second, patient one
+// only if the first goes unanswered). Devices that stay silent are dropped;
+// returns true when every device answered.
+bool inventoryWarmStart(RtuBus& bus) {
+  if (recordCount == 0) return false;
+
+  Serial.printf("\n♻️  Warm start: verifying %d known device(s)\n", recordCount);
+  unsigned long startMs = millis();
+  uint8_t known = recordCount;
+  uint8_t kept = 0;
+
+  for (uint8_t i = 0; i < known; i++) {
+    InventoryRecord record = records[i];
+    uint32_t baud = inventoryBaud(record);
+    uint32_t config = inventoryConfig(record);
+    if (bus.baud != baud || bus.config != config) rtuBegin(bus, baud, config);
+    bus.turnaroundUs = max(bus.turnaroundUs, (uint32_t)(record.turnaroundMs * 1000UL));
+
+    uint8_t result = rtuProbe(bus, record.slaveId, rtuProbeTimeoutMs(bus));
+    if (!answered(result)) {
+      rtuDrain(bus, rtuProbeTimeoutMs(bus));
+      result = rtuProbe(bus, record.slaveId, sweepSettings.slowTimeoutMs);
+    }
+
+    if (answered(result)) {
+      noteRead();
+      records[kept++] = record;
+      Serial.printf("   ✅ Slave ID %d at %lu baud %s\n", record.slaveId, (unsigned long)baud, rtuConfigName(config));
+    } else {
+      Serial.printf("   ❌ Slave ID %d at %lu baud %s no longer answers\n", record.slaveId,
+                    (unsigned long)baud, rtuConfigName(config));
+    }
+  }
+
+  recordCount = kept;
+  if (kept != known) save();
+
+  // Leave the bus on the first device's settings
+  if (kept > 0 && (bus.baud != inventoryBaud(records[0]) || bus.config != inventoryConfig(records[0]))) {
+    rtuBegin(bus, inventoryBaud(records[0]), inventoryConfig(records[0]));
+  }
+
+  Serial.printf("   %d/%d verified in %lu ms", kept, known, millis() - startMs);
+  if (firstReadMs) Serial.printf(", boot to first successful read %lu ms", firstReadMs);
+  Serial.println();
+  return kept == known;
+}
+
+void inventoryPrint() {
+  Serial.printf("\n📇 DEVICE INVENTORY: %d device(s) stored\n", recordCount);
+  for (uint8_t i = 0; i < recordCount; i++) {
+    const InventoryRecord& record = records[i];
+    Serial.printf("   Slave ID %3d: %6lu baud %s, turnaround %d ms%s\n", record.slaveId,
+                  (unsigned long)inventoryBaud(record), rtuConfigName(inventoryConfig(record)),
+                  record.turnaroundMs, record.flags & INVENTORY_FLAG_TEC ? ", TEC QRS11" : "");
+  }
+  if (firstReadMs) Serial.printf("   Boot to first successful read: %lu ms\n", firstReadMs);
+}
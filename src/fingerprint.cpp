@@ -0,0 +1,483 @@
+#include "fingerprint.h"
+#include "device_inventory.h"
+#include "scanner.h"
+
+// ---- Fingerprint database ------------------------------------------------
+
+// A profile names the tables its device does not implement (every read
+// there is refused) and lists what chosen addresses of the others return.
+// Only those two can rule a profile out, so each profile also states the
+// low addresses (IR 0, HR 0, CO 0) and the vendor markers of the others
+// (HR 0x0101, HR 0x4000) as far as its map documents them. Addresses
+// outside a device's published map are expected to be refused, as the
+// listed devices do.
+
+#define NO_CO (1 << MAP_COILS)
+#define NO_DI (1 << MAP_DISCRETE_INPUTS)
+#define NO_HR (1 << MAP_HOLDING_REGISTERS)
+#define NO_IR (1 << MAP_INPUT_REGISTERS)
+
+static const FingerprintCheck tecQrs11[] = {
+  {MAP_INPUT_REGISTERS, 0, FINGERPRINT_ABSENT},     // Map starts at IR 1
+  {MAP_HOLDING_REGISTERS, 0, FINGERPRINT_ABSENT},   // and HR 61
+  {MAP_HOLDING_REGISTERS, 0x0101, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 0x4000, FINGERPRINT_ABSENT},
+  {MAP_INPUT_REGISTERS, 20, 1, 9},                  // Unit state
+  {MAP_INPUT_REGISTERS, 2, 1, 999},                 // B2 outlet water, 0.1 °C
+  {MAP_HOLDING_REGISTERS, 79, 300, 700},            // ST09 hot water setpoint, 0.1 °C
+};
+
+static const FingerprintCheck eastronSdm120[] = {
+  {MAP_INPUT_REGISTERS, 0, 0x4300, 0x437F},         // Voltage, float high word: 128-256 V
+  {MAP_HOLDING_REGISTERS, 0, FINGERPRINT_ABSENT},   // Setup starts at HR 2
+  {MAP_HOLDING_REGISTERS, 0x0101, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 0x4000, FINGERPRINT_ABSENT},
+  {MAP_INPUT_REGISTERS, 70, 0x4240, 0x4250},        // Frequency, float high word: 48-52 Hz
+  {MAP_INPUT_REGISTERS, 200, FINGERPRINT_ABSENT},   // Single phase: no line-to-line voltages
+};
+
+static const FingerprintCheck eastronSdm630[] = {
+  {MAP_INPUT_REGISTERS, 0, 0x4300, 0x437F},         // Phase 1 voltage
+  {MAP_HOLDING_REGISTERS, 0, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 0x0101, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 0x4000, FINGERPRINT_ABSENT},
+  {MAP_INPUT_REGISTERS, 70, 0x4240, 0x4250},        // Frequency
+  {MAP_INPUT_REGISTERS, 200, 0x43A0, 0x43E0},       // L1-L2 voltage: 320-448 V
+};
+
+static const FingerprintCheck chintDdsu666[] = {
+  {MAP_HOLDING_REGISTERS, 0, 0, 0xFFFF},            // Firmware revision
+  {MAP_HOLDING_REGISTERS, 0x00FD, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 0x0101, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 0x4000, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 0x2000, 0x4300, 0x437F},  // Voltage, float high word
+  {MAP_HOLDING_REGISTERS, 0x2044, 0x4240, 0x4250},  // Frequency
+};
+
+static const FingerprintCheck peacefairPzem016[] = {
+  {MAP_INPUT_REGISTERS, 0, 800, 2800},              // Voltage, 0.1 V
+  {MAP_HOLDING_REGISTERS, 0, FINGERPRINT_ABSENT},   // Settings are HR 1-2
+  {MAP_HOLDING_REGISTERS, 0x0101, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 0x4000, FINGERPRINT_ABSENT},
+  {MAP_INPUT_REGISTERS, 7, 450, 650},               // Frequency, 0.1 Hz
+  {MAP_INPUT_REGISTERS, 8, 0, 100},                 // Power factor, 0.01
+  {MAP_HOLDING_REGISTERS, 2, 1, 247},               // Slave address
+  {MAP_HOLDING_REGISTERS, 3, FINGERPRINT_ABSENT},
+};
+
+static const FingerprintCheck peacefairPzem017[] = {
+  {MAP_INPUT_REGISTERS, 0, 0, 30000},               // DC voltage, 0.01 V
+  {MAP_HOLDING_REGISTERS, 0, 500, 35000},           // High voltage alarm, 0.01 V
+  {MAP_HOLDING_REGISTERS, 0x0101, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 0x4000, FINGERPRINT_ABSENT},
+  {MAP_INPUT_REGISTERS, 8, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 2, 1, 247},               // Slave address
+  {MAP_HOLDING_REGISTERS, 3, 0, 3},                 // Shunt range: 100/50/200/300 A
+};
+
+static const FingerprintCheck xyMd02[] = {
+  {MAP_INPUT_REGISTERS, 0, FINGERPRINT_ABSENT},     // Measurements are IR 1-2
+  {MAP_HOLDING_REGISTERS, 0, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 0x0101, 1, 247},          // Slave address
+  {MAP_HOLDING_REGISTERS, 0x4000, FINGERPRINT_ABSENT},
+  {MAP_INPUT_REGISTERS, 2, 0, 1000},                // Humidity, 0.1 %
+  {MAP_INPUT_REGISTERS, 3, FINGERPRINT_ABSENT},
+  {MAP_INPUT_REGISTERS, 20, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 0x0102, 0, 2},            // Baud rate code
+};
+
+static const FingerprintCheck r4dcb08[] = {
+  {MAP_HOLDING_REGISTERS, 0, 0, 0xFFFF},            // Channel 1 temperature, 0.1 °C signed
+  {MAP_HOLDING_REGISTERS, 0x00FD, 1, 247},          // Slave address
+  {MAP_HOLDING_REGISTERS, 0x00FE, 0, 4},            // Baud rate code
+  {MAP_HOLDING_REGISTERS, 0x0101, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 0x4000, FINGERPRINT_ABSENT},
+};
+
+static const FingerprintCheck waveshareRelay8[] = {
+  {MAP_HOLDING_REGISTERS, 0, FINGERPRINT_ABSENT},   // Settings are HR 0x4000 and 0x8000
+  {MAP_COILS, 0, 0, 1},                             // Relay 1
+  {MAP_HOLDING_REGISTERS, 0x0101, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 0x4000, 1, 247},          // Slave address
+  {MAP_HOLDING_REGISTERS, 0x8000, 0, 0xFFFF},       // Firmware version
+};
+
+static const FingerprintCheck waveshareAnalog8[] = {
+  {MAP_INPUT_REGISTERS, 0, 0, 20000},               // Channel 1, mV or µA
+  {MAP_HOLDING_REGISTERS, 0, FINGERPRINT_ABSENT},   // Channel modes are HR 0x1000-0x1007
+  {MAP_HOLDING_REGISTERS, 0x0101, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 0x4000, 1, 247},          // Slave address
+  {MAP_HOLDING_REGISTERS, 0x1000, 0, 6},            // Channel 1 mode
+};
+
+static const FingerprintCheck epeverTracer[] = {
+  {MAP_INPUT_REGISTERS, 0, FINGERPRINT_ABSENT},     // Real-time data starts at IR 0x3100
+  {MAP_HOLDING_REGISTERS, 0, FINGERPRINT_ABSENT},   // and settings at HR 0x9000
+  {MAP_COILS, 0, FINGERPRINT_ABSENT},               // Controls start at CO 2
+  {MAP_INPUT_REGISTERS, 2, FINGERPRINT_ABSENT},
+  {MAP_INPUT_REGISTERS, 20, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 0x0101, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 0x4000, FINGERPRINT_ABSENT},
+  {MAP_INPUT_REGISTERS, 0x3104, 800, 6400},         // Battery voltage, 0.01 V
+  {MAP_HOLDING_REGISTERS, 0x9000, 0, 3},            // Battery type
+};
+
+static const FingerprintCheck growattInverter[] = {
+  {MAP_INPUT_REGISTERS, 0, 0, 3},                   // Inverter status
+  {MAP_HOLDING_REGISTERS, 0, 0, 1},                 // Remote on/off
+  {MAP_HOLDING_REGISTERS, 0x0101, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 0x4000, FINGERPRINT_ABSENT},
+  {MAP_HOLDING_REGISTERS, 9, 0x2020, 0x7A7A},       // Firmware version, two ASCII characters
+};
+
+#define PROFILE(name, flags, absentTables, checks) \
+  {name, flags, absentTables, checks, sizeof(checks) / sizeof(checks[0])}
+
+static const FingerprintProfile profiles[] = {
+  PROFILE("TEC QRS11 heat pump", INVENTORY_FLAG_TEC, NO_CO, tecQrs11),
+  PROFILE("Eastron SDM120 energy meter", 0, NO_CO | NO_DI, eastronSdm120),
+  PROFILE("Eastron SDM630 energy meter", 0, NO_CO | NO_DI, eastronSdm630),
+  PROFILE("Chint DDSU666 energy meter", 0, NO_CO | NO_DI | NO_IR, chintDdsu666),
+  PROFILE("Peacefair PZEM-016 AC meter", 0, NO_CO | NO_DI, peacefairPzem016),
+  PROFILE("Peacefair PZEM-017 DC meter", 0, NO_CO | NO_DI, peacefairPzem017),
+  PROFILE("XY-MD02 temperature/humidity sensor", 0, NO_CO | NO_DI, xyMd02),
+  PROFILE("R4DCB08 temperature module", 0, NO_CO | NO_DI | NO_IR, r4dcb08),
+  PROFILE("Waveshare 8-channel relay", 0, NO_DI | NO_IR, waveshareRelay8),
+  PROFILE("Waveshare 8-channel analog input", 0, NO_CO | NO_DI, waveshareAnalog8),
+  PROFILE("Epever Tracer charge controller", 0, 0, epeverTracer),
+  PROFILE("Growatt inverter", 0, NO_CO | NO_DI, growattInverter),
+};
+
+static const uint8_t profileCount = sizeof(profiles) / sizeof(profiles[0]);
+static_assert(sizeof(profiles) / sizeof(profiles[0]) <= FINGERPRINT_MAX_PROFILES, "candidate mask too small");
+
+// ---- Decision tree ---------------------------------------------------------
+
+struct Probe {
+  uint8_t table;
+  uint16_t address;
+};
+
+// Inner node: read `probe` and follow the edge whose range holds the answer.
+// Leaf (probe -1): `candidates` is what is left.
+struct TreeNode {
+  int8_t probe;
+  uint32_t candidates;
+  uint8_t firstEdge;
+  uint8_t edgeCount;
+};
+
+struct TreeEdge {
+  bool absent;                // Taken on an exception
+  uint16_t min;
+  uint16_t max;
+  uint8_t child;
+};
+
+static Probe probes[FINGERPRINT_MAX_PROBES];
+static uint8_t probeCount = 0;
+static TreeNode nodes[FINGERPRINT_MAX_NODES];
+static uint8_t nodeCount = 0;
+static TreeEdge edges[FINGERPRINT_MAX_EDGES];
+static uint8_t edgeCount = 0;
+static uint8_t treeDepth = 0;
+static bool truncated = false;      // Ran out of nodes or edges; some leaves are ambiguous
+static bool compiled = false;
+
+// One way a probe can answer, and the candidates that allow it
+struct Outcome {
+  bool absent;
+  uint16_t min;
+  uint16_t max;
+  uint32_t candidates;
+};
+
+// What `profile` expects from `probe`; nullptr = any answer
+static const FingerprintCheck* findCheck(uint8_t profile, uint8_t probe) {
+  static const FingerprintCheck refused = {0, 0, FINGERPRINT_ABSENT};
+  const FingerprintProfile& p = profiles[profile];
+  if (p.absentTables & (1 << probes[probe].table)) return &refused;
+  for (uint8_t i = 0; i < p.checkCount; i++) {
+    if (p.checks[i].table == probes[probe].table && p.checks[i].address == probes[probe].address) return &p.checks[i];
+  }
+  return nullptr;
+}
+
+static bool allows(uint8_t profile, uint8_t probe, bool absent, uint16_t value) {
+  const FingerprintCheck* check = findCheck(profile, probe);
+  if (!check) return true;
+  if (check->min > check->max) return absent;
+  return !absent && value >= check->min && value <= check->max;
+}
+
+static uint32_t allowing(uint32_t candidates, uint8_t probe, bool absent, uint16_t value) {
+  uint32_t mask = 0;
+  for (uint8_t i = 0; i < profileCount; i++) {
+    if ((candidates & (1UL << i)) && allows(i, probe, absent, value)) mask |= 1UL << i;
+  }
+  return mask;
+}
+
+static uint8_t popcount(uint32_t mask) {
+  uint8_t count = 0;
+  for (; mask; mask &= mask - 1) count++;
+  return count;
+}
+
+// Split the answers to `probe` into the exception plus value ranges over
+// which the allowed candidates do not change. Ranges nobody allows are dropped.
+static uint8_t outcomesOf(uint32_t candidates, uint8_t probe, Outcome* out) {
+  uint32_t bounds[2 * FINGERPRINT_MAX_PROFILES + 2];
+  uint8_t boundCount = 0;
+  bounds[boundCount++] = 0;
+  bounds[boundCount++] = probes[probe].table == MAP_COILS || probes[probe].table == MAP_DISCRETE_INPUTS ? 2 : 0x10000;
+  for (uint8_t i = 0; i < profileCount; i++) {
+    if (!(candidates & (1UL << i))) continue;
+    const FingerprintCheck* check = findCheck(i, probe);
+    if (!check || check->min > check->max) continue;
+    bounds[boundCount++] = min((uint32_t)check->min, bounds[1]);
+    bounds[boundCount++] = min((uint32_t)check->max + 1, bounds[1]);
+  }
+  // Insertion sort; a few dozen entries at most
+  for (uint8_t i = 1; i < boundCount; i++) {
+    for (uint8_t j = i; j > 0 && bounds[j - 1] > bounds[j]; j--) {
+      uint32_t swap = bounds[j];
+      bounds[j] = bounds[j - 1];
+      bounds[j - 1] = swap;
+    }
+  }
+
+  uint8_t count = 0;
+  uint32_t absentMask = allowing(candidates, probe, true, 0);
+  if (absentMask) out[count++] = {true, 0, 0, absentMask};
+  for (uint8_t i = 0; i + 1 < boundCount; i++) {
+    if (bounds[i] == bounds[i + 1]) continue;
+    uint32_t mask = allowing(candidates, probe, false, bounds[i]);
+    if (!mask) continue;
+    Outcome* last = count > 0 ? &out[count - 1] : nullptr;
+    if (last && !last->absent && last->candidates == mask && last->max + 1UL == bounds[i]) {
+      last->max = bounds[i + 1] - 1;
+    } else {
+      out[count++] = {false, (uint16_t)bounds[i], (uint16_t)(bounds[i + 1] - 1), mask};
+    }
+  }
+  return count;
+}
+
+static int8_t chooseProbe(uint32_t candidates, uint64_t used) {
+  Outcome outcomes[2 * FINGERPRINT_MAX_PROFILES + 2];
+  uint8_t size = popcount(candidates);
+  int8_t best = -1;
+  uint16_t bestWorst = 0xFFFF;
+  uint32_t bestTotal = 0xFFFFFFFF;
+
+  for (uint8_t probe = 0; probe < probeCount; probe++) {
+    if (used & (1ULL << probe)) continue;
+    uint8_t count = outcomesOf(candidates, probe, outcomes);
+    uint16_t worst = 0;
+    uint32_t total = 0;
+    bool splits = false;
+    for (uint8_t i = 0; i < count; i++) {
+      uint8_t branch = popcount(outcomes[i].candidates);
+      worst = max(worst, (uint16_t)branch);
+      total += branch;
+      if (branch < size) splits = true;
+    }
+    // Some answer has to rule a candidate out. For a single candidate that
+    // is any answer outside its expectation, and the narrowest value range
+    // confirms it best; a refusal is weaker evidence, many devices refuse
+    // most addresses.
+    bool answersOutside = false;
+    if (size == 1) {
+      const FingerprintCheck* check = findCheck(__builtin_ctz(candidates), probe);
+      answersOutside = check != nullptr;
+      if (check) total = check->min > check->max ? 0x8000 : check->max - check->min;
+    }
+    if (!splits && !answersOutside) continue;
+    if (worst < bestWorst || (worst == bestWorst && total < bestTotal)) {
+      best = probe;
+      bestWorst = worst;
+      bestTotal = total;
+    }
+  }
+  return best;
+}
+
+// Reads in `used` that the profile has an expectation for
+static uint8_t checksRead(uint8_t profile, uint64_t used) {
+  uint8_t count = 0;
+  for (uint8_t probe = 0; probe < probeCount; probe++) {
+    if ((used & (1ULL << probe)) && findCheck(profile, probe)) count++;
+  }
+  return count;
+}
+
+static uint8_t addLeaf(uint32_t candidates) {
+  TreeNode& node = nodes[nodeCount];
+  node.probe = -1;
+  node.candidates = candidates;
+  node.firstEdge = 0;
+  node.edgeCount = 0;
+  return nodeCount++;
+}
+
+// `reserved` nodes are promised to siblings still to be built; a node only
+// grows children if they all fit as leaves on top of that
+static uint8_t build(uint32_t candidates, uint64_t used, uint8_t depth, uint8_t reserved) {
+  // A single candidate is named once its own checks have been read often enough
+  bool settled = false;
+  if (popcount(candidates) == 1) {
+    uint8_t profile = __builtin_ctz(candidates);
+    settled = checksRead(profile, used) >= min((uint8_t)FINGERPRINT_MIN_PROBES, profiles[profile].checkCount);
+  }
+  int8_t probe = settled || depth >= FINGERPRINT_MAX_DEPTH ? -1 : chooseProbe(candidates, used);
+  Outcome outcomes[2 * FINGERPRINT_MAX_PROFILES + 2];
+  uint8_t count = probe < 0 ? 0 : outcomesOf(candidates, probe, outcomes);
+  if (probe < 0 || nodeCount + 1 + count + reserved > FINGERPRINT_MAX_NODES ||
+      edgeCount + count > FINGERPRINT_MAX_EDGES) {
+    if (probe >= 0) truncated = true;
+    treeDepth = max(treeDepth, depth);
+    return addLeaf(candidates);
+  }
+
+  uint8_t index = addLeaf(candidates);
+  nodes[index].probe = probe;
+  nodes[index].firstEdge = edgeCount;
+  nodes[index].edgeCount = count;
+  edgeCount += count;
+  for (uint8_t i = 0; i < count; i++) {
+    TreeEdge& edge = edges[nodes[index].firstEdge + i];
+    edge.absent = outcomes[i].absent;
+    edge.min = outcomes[i].min;
+    edge.max = outcomes[i].max;
+    edge.child = build(outcomes[i].candidates, used | (1ULL << probe), depth + 1, reserved + count - 1 - i);
+  }
+  return index;
+}
+
+void fingerprintBegin() {
+  if (compiled) return;
+
+  probeCount = 0;
+  for (uint8_t i = 0; i < profileCount; i++) {
+    for (uint8_t j = 0; j < profiles[i].checkCount; j++) {
+      const FingerprintCheck& check = profiles[i].checks[j];
+      bool known = false;
+      for (uint8_t k = 0; k < probeCount && !known; k++) {
+        known = probes[k].table == check.table && probes[k].address == check.address;
+      }
+      if (!known && probeCount < FINGERPRINT_MAX_PROBES) probes[probeCount++] = {check.table, check.address};
+    }
+  }
+
+  nodeCount = 0;
+  edgeCount = 0;
+  treeDepth = 0;
+  truncated = false;
+  build((1UL << profileCount) - 1, 0, 0, 0);
+  if (truncated) Serial.println("⚠️  Fingerprint tree truncated, raise FINGERPRINT_MAX_NODES/EDGES");
+  compiled = true;
+}
+
+// ---- Identification --------------------------------------------------------
+
+// One single-address read: true with *absent set on a value or an exception,
+// false when the device gave no usable reply (after one retry)
+static bool probeRead(RtuBus& bus, uint8_t slaveId, const Probe& probe, FingerprintResult* result,
+                      bool* absent, uint16_t* value) {
+  uint8_t function = probe.table + 1;
+  uint16_t timeoutMs = rtuReadTimeoutMs(bus, function, 1);
+  uint16_t data = 0;
+
+  for (uint8_t attempt = 0; attempt < 2; attempt++) {
+    result->probes++;
+    uint8_t status = rtuReadRequest(bus, slaveId, function, probe.address, 1, &data, timeoutMs);
+    switch (status) {
+      case ModbusMaster::ku8MBSuccess:
+        *absent = false;
+        *value = probe.table == MAP_COILS || probe.table == MAP_DISCRETE_INPUTS ? data & 1 : data;
+        return true;
+      case ModbusMaster::ku8MBIllegalFunction:
+      case ModbusMaster::ku8MBIllegalDataAddress:
+      case ModbusMaster::ku8MBIllegalDataValue:
+      case ModbusMaster::ku8MBSlaveDeviceFailure:
+        *absent = true;
+        *value = 0;
+        return true;
+      default:
+        // Timeout or a garbled reply: let a late reply pass, then once more
+        // with the scan's retry timeout
+        rtuDrain(bus, timeoutMs);
+        timeoutMs = sweepSettings.slowTimeoutMs;
+        break;
+    }
+  }
+  return false;
+}
+
+bool fingerprintIdentify(RtuBus& bus, uint8_t slaveId, FingerprintResult* result) {
+  fingerprintBegin();
+  memset(result, 0, sizeof(*result));
+  result->profile = -1;
+  unsigned long startMs = millis();
+
+  uint8_t index = 0;
+  while (nodes[index].probe >= 0) {
+    const TreeNode& node = nodes[index];
+    bool absent;
+    uint16_t value;
+    if (!probeRead(bus, slaveId, probes[node.probe], result, &absent, &value)) {
+      result->noReply = true;
+      result->candidates = node.candidates;
+      result->elapsedMs = millis() - startMs;
+      return false;
+    }
+
+    int16_t next = -1;
+    for (uint8_t i = 0; i < node.edgeCount && next < 0; i++) {
+      const TreeEdge& edge = edges[node.firstEdge + i];
+      if (edge.absent ? absent : !absent && value >= edge.min && value <= edge.max) next = edge.child;
+    }
+    if (next < 0) {
+      // An answer none of the remaining profiles gives
+      result->candidates = 0;
+      result->elapsedMs = millis() - startMs;
+      return true;
+    }
+    index = next;
+  }
+
+  result->candidates = nodes[index].candidates;
+  if (popcount(result->candidates) == 1) result->profile = __builtin_ctz(result->candidates);
+  result->elapsedMs = millis() - startMs;
+  return true;
+}
+
+uint8_t fingerprintProfileCount() {
+  return profileCount;
+}
+
+const FingerprintProfile& fingerprintProfile(uint8_t index) {
+  return profiles[index < profileCount ? index : 0];
+}
+
+uint8_t fingerprintTreeDepth() {
+  fingerprintBegin();
+  return treeDepth;
+}
+
+void fingerprintPrintResult(const FingerprintResult& result) {
+  if (result.noReply) {
+    Serial.printf("❌ Identification stopped: no reply (%u reads, %lu ms)\n", result.probes, result.elapsedMs);
+  } else if (result.profile >= 0) {
+    Serial.printf("🔎 Identified: %s (%u reads, %lu ms)\n", profiles[result.profile].name, result.probes,
+                  result.elapsedMs);
+  } else if (result.candidates == 0) {
+    Serial.printf("❔ Not in the fingerprint database (%u reads, %lu ms)\n", result.probes, result.elapsedMs);
+  } else {
+    Serial.printf("❔ Could be any of (%u reads, %lu ms):\n", result.probes, result.elapsedMs);
+    for (uint8_t i = 0; i < profileCount; i++) {
+      if (result.candidates & (1UL << i)) Serial.printf("   %s\n", profiles[i].name);
+    }
+  }
+}
@@ -0,0 +1,355 @@
+#include "history.h"
+#include "modbus_rtu.h"
+#include "register_map.h"
+#include <Preferences.h>
+#include <stdarg.h>
+
+#define HISTORY_NAMESPACE "history"
+#define HISTORY_FLASH_VERSION 1
+
+// Stored block: header, buckets, CRC16 over both
+struct __attribute__((packed)) HistoryBlockHeader {
+  uint8_t version;
+  uint8_t slaveId;
+  uint8_t table;
+  uint16_t address;
+  uint16_t boot;
+  uint32_t firstStartMs;
+  uint8_t count;
+};
+
+static HistorySeries series[HISTORY_MAX_SERIES];
+static uint8_t seriesCount = 0;
+static uint32_t rawTimes[HISTORY_MAX_SERIES][HISTORY_RAW_SAMPLES];
+static uint16_t rawValues[HISTORY_MAX_SERIES][HISTORY_RAW_SAMPLES];
+static HistoryBucket buckets[HISTORY_MAX_SERIES][HISTORY_BUCKETS];
+
+static bool spill = false;
+static uint16_t boot = 0;            // This boot's number, read from NVS at the first spill
+static uint8_t nextBlock = 0;
+static Preferences nvs;
+static uint8_t blob[sizeof(HistoryBlockHeader) + HISTORY_SPILL_BUCKETS * sizeof(HistoryBucket) + 2];
+
+static bool tableIsBits(uint8_t table) {
+  return table == MAP_COILS || table == MAP_DISCRETE_INPUTS;
+}
+
+static void resetSeries(HistorySeries& s) {
+  s.samples = 0;
+  s.rawNext = s.rawCount = 0;
+  s.bucketNext = s.bucketCount = 0;
+  s.bucketOpen = false;
+}
+
+static void blockKey(uint8_t block, char* key) {
+  snprintf(key, 8, "b%u", block);
+}
+
+// Boot number and ring position, once per boot; the boot number goes up by one
+static void openFlash() {
+  if (boot != 0) return;
+  nvs.begin(HISTORY_NAMESPACE, false);
+  nvs.getBytes("boot", &boot, sizeof(boot));
+  nvs.getBytes("next", &nextBlock, sizeof(nextBlock));
+  if (++boot == 0) boot = 1;
+  nvs.putBytes("boot", &boot, sizeof(boot));
+  nvs.end();
+  if (nextBlock >= HISTORY_SPILL_BLOCKS) nextBlock = 0;
+}
+
+// Write the oldest HISTORY_SPILL_BUCKETS of a full rollup ring as one block
+// and drop them from RAM, written or not
+static void spillOldest(uint8_t index) {
+  HistorySeries& s = series[index];
+  openFlash();
+
+  HistoryBlockHeader header = {HISTORY_FLASH_VERSION, s.slaveId, s.table, s.address, boot,
+                               (uint32_t)(s.bucketStartMs - s.bucketCount * HISTORY_BUCKET_MS),
+                               HISTORY_SPILL_BUCKETS};
+  size_t length = sizeof(header);
+  memcpy(blob, &header, sizeof(header));
+  uint16_t oldest = (s.bucketNext + HISTORY_BUCKETS - s.bucketCount) % HISTORY_BUCKETS;
+  for (uint16_t k = 0; k < HISTORY_SPILL_BUCKETS; k++) {
+    memcpy(blob + length, &buckets[index][(oldest + k) % HISTORY_BUCKETS], sizeof(HistoryBucket));
+    length += sizeof(HistoryBucket);
+  }
+  uint16_t crc = rtuCrc16(blob, length);
+  blob[length++] = crc & 0xFF;
+  blob[length++] = crc >> 8;
+
+  char key[8];
+  blockKey(nextBlock, key);
+  nvs.begin(HISTORY_NAMESPACE, false);
+  bool written = nvs.putBytes(key, blob, length) == length;
+  nextBlock = (nextBlock + 1) % HISTORY_SPILL_BLOCKS;
+  nvs.putBytes("next", &nextBlock, sizeof(nextBlock));
+  nvs.end();
+  if (!written) Serial.println("⚠️  Could not write history to flash");
+
+  s.bucketCount -= HISTORY_SPILL_BUCKETS;
+}
+
+static void pushBucket(uint8_t index, const HistoryBucket& bucket) {
+  HistorySeries& s = series[index];
+  if (s.bucketCount == HISTORY_BUCKETS) {
+    if (spill) {
+      spillOldest(index);
+    } else {
+      s.bucketCount--;        // The oldest is overwritten
+    }
+  }
+  buckets[index][s.bucketNext] = bucket;
+  s.bucketNext = (s.bucketNext + 1) % HISTORY_BUCKETS;
+  s.bucketCount++;
+}
+
+// Close the open bucket once its interval is over, with an empty bucket for
+// every interval without reads since, then add the value to the open one
+static void rollup(uint8_t index, unsigned long now, uint16_t value) {
+  HistorySeries& s = series[index];
+  if (s.bucketOpen && now - s.bucketStartMs >= HISTORY_BUCKET_MS) {
+    HistoryBucket closed = s.open;
+    closed.avg = (s.openSum + s.open.count / 2) / s.open.count;
+    pushBucket(index, closed);
+
+    uint32_t skipped = (now - s.bucketStartMs) / HISTORY_BUCKET_MS - 1;
+    HistoryBucket empty = {};
+    for (uint32_t k = 0; k < min(skipped, (uint32_t)HISTORY_BUCKETS); k++) pushBucket(index, empty);
+    s.bucketStartMs += (skipped + 1) * HISTORY_BUCKET_MS;
+    s.bucketOpen = false;
+  }
+
+  if (!s.bucketOpen) {
+    if (s.samples == 1) s.bucketStartMs = now;
+    s.open = {value, value, value, 0};
+    s.openSum = 0;
+    s.bucketOpen = true;
+  }
+  s.open.min = min(s.open.min, value);
+  s.open.max = max(s.open.max, value);
+  s.open.count++;
+  s.openSum += value;
+}
+
+static void record(uint8_t index, unsigned long now, uint16_t value) {
+  HistorySeries& s = series[index];
+  s.samples++;
+  rawTimes[index][s.rawNext] = now;
+  rawValues[index][s.rawNext] = value;
+  s.rawNext = (s.rawNext + 1) % HISTORY_RAW_SAMPLES;
+  if (s.rawCount < HISTORY_RAW_SAMPLES) s.rawCount++;
+  rollup(index, now, value);
+}
+
+void historyBegin(const PollPoint* points, uint8_t count) {
+  // The series the points ask for, compared with the ones there are
+  uint8_t wanted = 0;
+  bool same = true;
+  for (uint8_t p = 0; p < count && wanted < HISTORY_MAX_SERIES; p++) {
+    for (uint16_t offset = 0; offset < points[p].count && wanted < HISTORY_MAX_SERIES; offset++, wanted++) {
+      const HistorySeries& s = series[wanted];
+      same = same && wanted < seriesCount && s.point == p && s.offset == offset && s.bus == points[p].bus &&
+             s.slaveId == points[p].slaveId && s.table == points[p].table &&
+             s.address == points[p].address + offset;
+    }
+  }
+  if (same && wanted == seriesCount) {
+    for (uint8_t i = 0; i < seriesCount; i++) series[i].periodMs = points[series[i].point].periodMs;
+    return;
+  }
+
+  seriesCount = 0;
+  for (uint8_t p = 0; p < count && seriesCount < HISTORY_MAX_SERIES; p++) {
+    for (uint16_t offset = 0; offset < points[p].count && seriesCount < HISTORY_MAX_SERIES; offset++) {
+      HistorySeries& s = series[seriesCount++];
+      s.point = p;
+      s.offset = offset;
+      s.bus = points[p].bus;
+      s.slaveId = points[p].slaveId;
+      s.table = points[p].table;
+      s.address = points[p].address + offset;
+      s.periodMs = points[p].periodMs;
+      resetSeries(s);
+    }
+  }
+}
+
+void historySample(const PollPoint& point, const uint16_t* values) {
+  uint8_t index = &point - pollPoints();
+  unsigned long now = millis();
+  bool bits = tableIsBits(point.table);
+  for (uint8_t i = 0; i < seriesCount; i++) {
+    const HistorySeries& s = series[i];
+    if (s.point != index) continue;
+    record(i, now, bits ? (values[s.offset / 16] >> (s.offset % 16)) & 1 : values[s.offset]);
+  }
+}
+
+uint8_t historySeriesCount() {
+  return seriesCount;
+}
+
+const HistorySeries& historySeries(uint8_t index) {
+  return series[index];
+}
+
+void historyClear() {
+  for (uint8_t i = 0; i < seriesCount; i++) resetSeries(series[i]);
+  char key[8];
+  nvs.begin(HISTORY_NAMESPACE, false);
+  for (uint8_t block = 0; block < HISTORY_SPILL_BLOCKS; block++) {
+    blockKey(block, key);
+    nvs.remove(key);
+  }
+  nvs.end();
+}
+
+void historySetSpill(bool enabled) {
+  spill = enabled;
+}
+
+bool historySpill() {
+  return spill;
+}
+
+// Loads a block into blob; false if it is missing or damaged
+static bool loadBlock(uint8_t block, HistoryBlockHeader* header) {
+  if (block >= HISTORY_SPILL_BLOCKS) return false;
+  char key[8];
+  blockKey(block, key);
+  nvs.begin(HISTORY_NAMESPACE, true);
+  size_t length = nvs.getBytes(key, blob, sizeof(blob));
+  nvs.end();
+  if (length < sizeof(*header) + 2) return false;
+
+  memcpy(header, blob, sizeof(*header));
+  return header->version == HISTORY_FLASH_VERSION && header->count <= HISTORY_SPILL_BUCKETS &&
+         length == sizeof(*header) + header->count * sizeof(HistoryBucket) + 2 &&
+         rtuCrc16(blob, length - 2) == (blob[length - 2] | (blob[length - 1] << 8));
+}
+
+bool historyFlashBlock(uint8_t block, HistoryFlashInfo* info) {
+  HistoryBlockHeader header;
+  if (!loadBlock(block, &header)) return false;
+  *info = {header.slaveId, header.table, header.address, header.boot, header.firstStartMs, header.count};
+  return true;
+}
+
+// Output lines are built in a buffer and written whole
+static char line[192];
+static size_t lineLength = 0;
+static uint8_t lineItems = 0;
+
+static void lineAdd(Print& out, const char* prefix, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+static void lineAdd(Print& out, const char* prefix, const char* format, ...) {
+  if (lineItems == 0) lineLength = snprintf(line, sizeof(line), "%s:", prefix);
+  va_list args;
+  va_start(args, format);
+  lineLength += vsnprintf(line + lineLength, sizeof(line) - lineLength, format, args);
+  va_end(args);
+  lineLength = min(lineLength, sizeof(line) - 1);
+  if (++lineItems == HISTORY_LINE_VALUES) {
+    out.println(line);
+    lineItems = 0;
+  }
+}
+
+static void lineFlush(Print& out) {
+  if (lineItems > 0) out.println(line);
+  lineItems = 0;
+}
+
+static void addBucket(Print& out, const char* prefix, const char* sign, uint32_t seconds, const HistoryBucket& b) {
+  if (b.count == 0) {
+    lineAdd(out, prefix, " %s%lu=-", sign, (unsigned long)seconds);
+  } else {
+    lineAdd(out, prefix, " %s%lu=%u/%u/%u", sign, (unsigned long)seconds, b.min, b.avg, b.max);
+  }
+}
+
+uint16_t historyStreamRaw(Print& out, const char* prefix, uint8_t index, uint32_t windowS) {
+  if (index >= seriesCount) return 0;
+  const HistorySeries& s = series[index];
+  unsigned long now = millis();
+  uint16_t written = 0;
+
+  for (uint16_t k = 0; k < s.rawCount; k++) {
+    uint16_t slot = (s.rawNext + HISTORY_RAW_SAMPLES - s.rawCount + k) % HISTORY_RAW_SAMPLES;
+    uint32_t ageMs = now - rawTimes[index][slot];
+    if (windowS > 0 && ageMs > windowS * 1000) continue;
+    lineAdd(out, prefix, " -%lu.%lu=%u", (unsigned long)(ageMs / 1000), (unsigned long)(ageMs % 1000 / 100),
+            rawValues[index][slot]);
+    written++;
+  }
+  lineFlush(out);
+  return written;
+}
+
+uint16_t historyStreamRollup(Print& out, const char* prefix, uint8_t index, uint32_t windowS) {
+  if (index >= seriesCount) return 0;
+  const HistorySeries& s = series[index];
+  if (!s.bucketOpen) return 0;
+  unsigned long now = millis();
+  uint16_t written = 0;
+
+  // Closed buckets are back to back before the open one
+  for (uint16_t k = 0; k <= s.bucketCount; k++) {
+    bool open = k == s.bucketCount;
+    uint32_t ageS = (now - (s.bucketStartMs - (s.bucketCount - k) * HISTORY_BUCKET_MS)) / 1000;
+    if (windowS > 0 && ageS > windowS) continue;
+    HistoryBucket bucket = s.open;
+    if (open) {
+      bucket.avg = (s.openSum + s.open.count / 2) / s.open.count;
+    } else {
+      bucket = buckets[index][(s.bucketNext + HISTORY_BUCKETS - s.bucketCount + k) % HISTORY_BUCKETS];
+    }
+    addBucket(out, prefix, "-", ageS, bucket);
+    written++;
+  }
+  lineFlush(out);
+  return written;
+}
+
+// Bucket starts in seconds since the boot the block was recorded in
+uint16_t historyStreamFlash(Print& out, const char* prefix, uint8_t block) {
+  HistoryBlockHeader header;
+  if (!loadBlock(block, &header)) return 0;
+  for (uint8_t k = 0; k < header.count; k++) {
+    HistoryBucket bucket;
+    memcpy(&bucket, blob + sizeof(header) + k * sizeof(HistoryBucket), sizeof(bucket));
+    addBucket(out, prefix, "+", (header.firstStartMs + k * HISTORY_BUCKET_MS) / 1000, bucket);
+  }
+  lineFlush(out);
+  return header.count;
+}
+
+void historyPrint() {
+  size_t ram = sizeof(series) + sizeof(rawTimes) + sizeof(rawValues) + sizeof(buckets);
+  Serial.printf("\n📈 History: %d series of %d, %u bytes RAM, %lu s buckets, flash spill %s\n", seriesCount,
+                HISTORY_MAX_SERIES, (unsigned)ram, HISTORY_BUCKET_MS / 1000, spill ? "on" : "off");
+  if (seriesCount == 0) {
+    Serial.println("   Nothing recorded yet - values are kept while polling (menu 12)");
+  } else {
+    // Raw costs a sample per read; a rollup bucket per interval whatever the period
+    uint32_t rollupPerHour = 3600000UL / HISTORY_BUCKET_MS * sizeof(HistoryBucket);
+    Serial.println("  #  point  bus  slave table  address  period  samples  raw span  raw B/h  rollup B/h  rollup span");
+    for (uint8_t i = 0; i < seriesCount; i++) {
+      const HistorySeries& s = series[i];
+      uint32_t rawPerHour = 3600000UL / s.periodMs * (sizeof(rawTimes[0][0]) + sizeof(rawValues[0][0]));
+      Serial.printf("%3d  %5d  %3d  %5d  %4s  %7u  %6lu  %7lu  %6.1f m  %7lu  %10lu  %8.1f h\n", i, s.point,
+                    s.bus + 1, s.slaveId, mapTableName(s.table), s.address, (unsigned long)s.periodMs,
+                    (unsigned long)s.samples, HISTORY_RAW_SAMPLES * s.periodMs / 60000.0f,
+                    (unsigned long)rawPerHour, (unsigned long)rollupPerHour,
+                    HISTORY_BUCKETS * HISTORY_BUCKET_MS / 3600000.0f);
+    }
+  }
+
+  for (uint8_t block = 0; block < HISTORY_SPILL_BLOCKS; block++) {
+    HistoryFlashInfo info;
+    if (!historyFlashBlock(block, &info)) continue;
+    Serial.printf("   Flash block %d: [%d] %s %u, boot %u, %d min from minute %lu\n", block, info.slaveId,
+                  mapTableName(info.table), info.address, info.boot, info.count,
+                  (unsigned long)(info.firstStartMs / 60000));
+  }
+}
@@ -0,0 +1,205 @@
+#include "led_renderer.h"
+#include <FastLED.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+CRGB leds[NUM_LEDS];
+
+// Everything the renderer needs to draw the LED at any moment
+struct LedState {
+  LEDStatus status;
+  bool animate;
+  unsigned long startMs;
+  LEDStatus flash;
+  unsigned long flashStartMs;
+  uint16_t flashMs;                 // 0 = no flash
+};
+
+static LedState posted = {LED_OFF, false, 0, LED_OFF, 0, 0};  // Poster side, loop() task
+static QueueHandle_t mailbox = nullptr;
+static LedStats stats;
+
+// (sin(2 pi i / 256) + 1) * 127.5, one breathing cycle
+static const uint8_t breathTable[256] = {
+  128, 131, 134, 137, 140, 143, 146, 149, 152, 155, 158, 162, 165, 167, 170, 173,
+  176, 179, 182, 185, 188, 190, 193, 196, 198, 201, 203, 206, 208, 211, 213, 215,
+  218, 220, 222, 224, 226, 228, 230, 232, 234, 235, 237, 238, 240, 241, 243, 244,
+  245, 246, 248, 249, 250, 250, 251, 252, 253, 253, 254, 254, 254, 255, 255, 255,
+  255, 255, 255, 255, 254, 254, 254, 253, 253, 252, 251, 250, 250, 249, 248, 246,
+  245, 244, 243, 241, 240, 238, 237, 235, 234, 232, 230, 228, 226, 224, 222, 220,
+  218, 215, 213, 211, 208, 206, 203, 201, 198, 196, 193, 190, 188, 185, 182, 179,
+  176, 173, 170, 167, 165, 162, 158, 155, 152, 149, 146, 143, 140, 137, 134, 131,
+  128, 124, 121, 118, 115, 112, 109, 106, 103, 100,  97,  93,  90,  88,  85,  82,
+   79,  76,  73,  70,  67,  65,  62,  59,  57,  54,  52,  49,  47,  44,  42,  40,
+   37,  35,  33,  31,  29,  27,  25,  23,  21,  20,  18,  17,  15,  14,  12,  11,
+   10,   9,   7,   6,   5,   5,   4,   3,   2,   2,   1,   1,   1,   0,   0,   0,
+    0,   0,   0,   0,   1,   1,   1,   2,   2,   3,   4,   5,   5,   6,   7,   9,
+   10,  11,  12,  14,  15,  17,  18,  20,  21,  23,  25,  27,  29,  31,  33,  35,
+   37,  40,  42,  44,  47,  49,  52,  54,  57,  59,  62,  65,  67,  70,  73,  76,
+   79,  82,  85,  88,  90,  93,  97, 100, 103, 106, 109, 112, 115, 118, 121, 124,
+};
+
+static CRGB staticColour(LEDStatus status) {
+  switch (status) {
+    case LED_READY: return CRGB::Blue;
+    case LED_SUCCESS: return CRGB::Green;
+    case LED_ERROR: return CRGB::Red;
+    case LED_WARNING: return CRGB::Orange;
+    case LED_WRITING: return CRGB::Yellow;
+    case LED_CONNECTING: return CRGB::Cyan;
+    case LED_SCANNING: return CRGB::Purple;
+    default: return CRGB::Black;
+  }
+}
+
+static CRGB breathe(uint8_t hue, unsigned long elapsed, uint16_t periodMs) {
+  uint8_t phase = (elapsed % periodMs) * 256 / periodMs;
+  return CHSV(hue, 255, breathTable[phase]);
+}
+
+// Colour of `state` at `now`. Timed animations that run out fall back to
+// ready in the renderer's copy; *animating tells whether later frames differ.
+static CRGB renderFrame(LedState& state, unsigned long now, bool* animating) {
+  if (state.flashMs) {
+    if (now - state.flashStartMs < state.flashMs) {
+      *animating = true;
+      return staticColour(state.flash);
+    }
+    state.flashMs = 0;
+  }
+
+  *animating = state.animate;
+  if (!state.animate) return staticColour(state.status);
+
+  unsigned long elapsed = now - state.startMs;
+  switch (state.status) {
+    case LED_SCANNING:
+      return breathe(192, elapsed, LED_SCANNING_PERIOD_MS);   // Purple
+    case LED_CONNECTING:
+      return breathe(128, elapsed, LED_CONNECTING_PERIOD_MS); // Cyan
+    case LED_WRITING:
+      return breathe(64, elapsed, LED_WRITING_PERIOD_MS);     // Yellow
+    case LED_ERROR:
+      // Red blink for 3 seconds
+      if (elapsed <= 3000) return (elapsed / 250) % 2 == 0 ? CRGB(CRGB::Red) : CRGB(CRGB::Black);
+      break;
+    case LED_SUCCESS:
+      // Green, then fade to the ready blue
+      if (elapsed < 500) return CRGB::Green;
+      if (elapsed < 1000) {
+        uint8_t fade = 255 - (elapsed - 500) * 255 / 500;
+        return CRGB(0, fade, 255 - fade);
+      }
+      break;
+    default:
+      // Static colours have nothing to animate
+      *animating = false;
+      return staticColour(state.status);
+  }
+
+  state.status = LED_READY;
+  state.animate = false;
+  *animating = false;
+  return staticColour(LED_READY);
+}
+
+static void ledTaskMain(void*) {
+  LedState state = {LED_OFF, false, 0, LED_OFF, 0, 0};
+  CRGB shown = leds[0];
+  bool animating = false;
+
+  for (;;) {
+    LedState next;
+    if (xQueueReceive(mailbox, &next, animating ? pdMS_TO_TICKS(LED_FRAME_MS) : portMAX_DELAY) == pdTRUE) {
+      state = next;
+    }
+    stats.frames++;
+    CRGB colour = renderFrame(state, millis(), &animating);
+    if (colour != shown) {
+      leds[0] = colour;
+      FastLED.show();
+      shown = colour;
+      stats.shows++;
+    }
+  }
+}
+
+// Hand the wanted state to the renderer; the newest post replaces one it
+// has not picked up yet. Without the task the LED is drawn right here.
+static void post() {
+  stats.posts++;
+  if (mailbox) {
+    xQueueOverwrite(mailbox, &posted);
+    return;
+  }
+  bool animating;
+  LedState state = posted;
+  leds[0] = renderFrame(state, millis(), &animating);
+  FastLED.show();
+  stats.shows++;
+}
+
+void initializeLED() {
+  FastLED.addLeds<LED_TYPE, LED_PIN, COLOR_ORDER>(leds, NUM_LEDS);
+  FastLED.setBrightness(100); // Set brightness (0-255)
+  leds[0] = CRGB::Black;
+  FastLED.show();
+
+  if (!mailbox) {
+    mailbox = xQueueCreate(1, sizeof(LedState));
+    if (!mailbox || xTaskCreate(ledTaskMain, "led", LED_TASK_STACK, nullptr, LED_TASK_PRIORITY, nullptr) != pdPASS) {
+      mailbox = nullptr;
+      Serial.println("⚠️  LED task not started; drawing static colours inline");
+    }
+  }
+
+  setLEDStatus(LED_READY);
+  Serial.println("🔵 WS2812 LED initialized on GPIO 10");
+}
+
+void setLEDStatus(LEDStatus status, bool animate) {
+  posted.status = status;
+  posted.animate = animate;
+  posted.startMs = millis();
+  posted.flashMs = 0;
+  post();
+}
+
+void ledFlash(LEDStatus flash, uint16_t durationMs) {
+  posted.flash = flash;
+  posted.flashStartMs = millis();
+  posted.flashMs = durationMs;
+  post();
+}
+
+bool ledRendererRunning() {
+  return mailbox != nullptr;
+}
+
+const LedStats& ledStats() {
+  return stats;
+}
+
+void ledResetStats() {
+  memset(&stats, 0, sizeof(stats));
+}
+
+void ledStatusMessage(LEDStatus status, const char* message) {
+  setLEDStatus(status);
+
+  // Add LED status emoji to message
+  String emoji;
+  switch (status) {
+    case LED_READY: emoji = "🔵"; break;
+    case LED_SUCCESS: emoji = "✅"; break;
+    case LED_ERROR: emoji = "🔴"; break;
+    case LED_WARNING: emoji = "🟠"; break;
+    case LED_WRITING: emoji = "🟡"; break;
+    case LED_CONNECTING: emoji = "🔄"; break;
+    case LED_SCANNING: emoji = "🟣"; break;
+    default: emoji = "⚫"; break;
+  }
+
+  Serial.println(emoji + " " + String(message));
+}
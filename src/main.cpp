@@ -1,71 +1,34 @@
 #include <Arduino.h>
 #include <ModbusMaster.h>
-#include <FastLED.h>
-
-// WS2812 LED configuration
-#define LED_PIN 10        // GPIO 10 for WS2812
-#define NUM_LEDS 1        // Single LED
-#define LED_TYPE WS2812B
-#define COLOR_ORDER GRB
-
-CRGB leds[NUM_LEDS];
-
-// Modbus RTU configuration
-#define MODBUS_RX_PIN 20  // GPIO 20 for RX (adjust for your wiring)
-#define MODBUS_TX_PIN 21  // GPIO 21 for TX (adjust for your wiring)
-#define MODBUS_DE_PIN -1   // GPIO 2 for DE/RE (Direction Enable - optional, set to -1 if not used)
-#define MODBUS_BAUD 9600  // Common Modbus RTU baud rate
-
-// Modbus slave configuration
-#define SLAVE_ID 1        // Default slave ID, change as needed
+#include "scanner.h"
+#include "scan_engine.h"
+#include "modbus_rtu.h"
+#include "bus_sniffer.h"
+#include "register_map.h"
+#include "read_planner.h"
+#include "poll_scheduler.h"
+#include "baud_detect.h"
+#include "device_inventory.h"
+#include "bus_task.h"
+#include "stream_output.h"
+#include "command_line.h"
+#include "led_renderer.h"
+#include "bulk_dump.h"
+#include "fingerprint.h"
+#include "tec_profile.h"
+#include "change_report.h"
+#include "history.h"
+#include "bus_stats.h"
+#include "retry_policy.h"
+#include "tcp_gateway.h"
+#include "read_cache.h"
+#include <esp_timer.h>
 
 // Create ModbusMaster object
 ModbusMaster modbus;
 
-// LED Status Colors and Functions
-enum LEDStatus {
-  LED_OFF,              // LED off
-  LED_READY,            // System ready (blue)
-  LED_SCANNING,         // Scanning for devices (purple pulse)
-  LED_SUCCESS,          // Communication success (green)
-  LED_ERROR,            // Communication error (red)
-  LED_WARNING,          // Warning/timeout (orange)
-  LED_WRITING,          // Writing data (yellow)
-  LED_CONNECTING        // Trying to connect (cyan)
-};
-
-// Forward declarations
-void printModbusError(uint8_t result);
-void changeModbusSettings(uint32_t newBaud, uint8_t newSlaveId);
-void readHoldingRegisters(uint8_t slaveId, uint16_t startAddress, uint16_t quantity);
-void readInputRegisters(uint8_t slaveId, uint16_t startAddress, uint16_t quantity);
-void readCoils(uint8_t slaveId, uint16_t startAddress, uint16_t quantity);
-void readDiscreteInputs(uint8_t slaveId, uint16_t startAddress, uint16_t quantity);
-void writeSingleRegister(uint8_t slaveId, uint16_t address, uint16_t value);
-void writeSingleCoil(uint8_t slaveId, uint16_t address, bool value);
-void scanModbusDevices();
-bool autoDetectBaudRate(uint8_t slaveId, uint32_t* detectedBaud);
-bool autoDetectSerialConfig(uint8_t slaveId, uint32_t baudRate);
-void detectModbusDevice();
-void testSpecificSlaveId();
-void testDifferentBaudRates();
-void readSpecificRegisters();
-void writeToRegister();
-void showCurrentConfiguration();
-void changeSettingsInteractive();
-void showHelp();
-void showMainMenu();
-void setLEDStatus(LEDStatus status, bool animate = true);
-void ledStatusMessage(LEDStatus status, const char* message);
-void analyzeTECHeatPump(uint8_t slaveId);
-
-// Variables for periodic reading
-unsigned long lastModbusRead = 0;
-const unsigned long modbusInterval = 1000; // Read every 1 second
-
-LEDStatus currentLEDStatus = LED_OFF;
-unsigned long ledAnimationStart = 0;
-bool ledAnimationActive = false;
+// Number of entries in the main menu
+#define MENU_OPTION_COUNT 17
 
 // Function to control DE/RE pin (if used)
 void preTransmission() {
@@ -80,138 +43,34 @@ void postTransmission() {
   }
 }
 
-// LED Control Functions
-void initializeLED() {
-  FastLED.addLeds<LED_TYPE, LED_PIN, COLOR_ORDER>(leds, NUM_LEDS);
-  FastLED.setBrightness(100); // Set brightness (0-255)
-  setLEDStatus(LED_READY);
-  Serial.println("🔵 WS2812 LED initialized on GPIO 10");
-}
+struct ModbusReadArgs {
+  uint8_t slaveId;
+  uint8_t function;
+  uint8_t (ModbusMaster::*read)(uint16_t, uint16_t);
+  uint16_t address;
+  uint16_t quantity;
+};
 
-void setLEDStatus(LEDStatus status, bool animate) {
-  currentLEDStatus = status;
-  ledAnimationActive = animate;
-  ledAnimationStart = millis();
-  
-  switch (status) {
-    case LED_OFF:
-      leds[0] = CRGB::Black;
-      break;
-    case LED_READY:
-      leds[0] = CRGB::Blue;
-      break;
-    case LED_SUCCESS:
-      leds[0] = CRGB::Green;
-      break;
-    case LED_ERROR:
-      leds[0] = CRGB::Red;
-      break;
-    case LED_WARNING:
-      leds[0] = CRGB::Orange;
-      break;
-    case LED_WRITING:
-      leds[0] = CRGB::Yellow;
-      break;
-    case LED_CONNECTING:
-      leds[0] = CRGB::Cyan;
-      break;
-    case LED_SCANNING:
-      leds[0] = CRGB::Purple;
-      break;
-  }
-  
-  FastLED.show();
-}
+// One ModbusMaster transaction, timed into the bus statistics like the rtu
+// layer's own; retryRun() holds the bus lock
+static uint8_t modbusReadAttempt(void* context) {
+  const ModbusReadArgs& args = *(const ModbusReadArgs*)context;
+  int64_t startUs = esp_timer_get_time();
+  uint8_t result = (modbus.*args.read)(args.address, args.quantity);
+  uint32_t elapsedUs = esp_timer_get_time() - startUs;
 
-void updateLEDAnimation() {
-  if (!ledAnimationActive) return;
-  
-  unsigned long elapsed = millis() - ledAnimationStart;
-  
-  switch (currentLEDStatus) {
-    case LED_SCANNING: {
-      // Purple breathing effect for scanning
-      int brightness = (sin(elapsed / 200.0) + 1) * 127;
-      leds[0] = CHSV(192, 255, brightness); // Purple hue
-      FastLED.show();
-      break;
-    }
-    
-    case LED_CONNECTING: {
-      // Cyan pulse for connecting
-      int brightness = (sin(elapsed / 300.0) + 1) * 127;
-      leds[0] = CHSV(128, 255, brightness); // Cyan hue
-      FastLED.show();
-      break;
-    }
-    
-    case LED_ERROR: {
-      // Red blink for errors
-      if ((elapsed / 250) % 2 == 0) {
-        leds[0] = CRGB::Red;
-      } else {
-        leds[0] = CRGB::Black;
-      }
-      FastLED.show();
-      
-      // Stop blinking after 3 seconds
-      if (elapsed > 3000) {
-        ledAnimationActive = false;
-        setLEDStatus(LED_READY, false);
-      }
-      break;
-    }
-    
-    case LED_SUCCESS: {
-      // Green flash and fade to ready
-      if (elapsed < 500) {
-        leds[0] = CRGB::Green;
-      } else if (elapsed < 1000) {
-        // Fade to blue
-        int fade = map(elapsed - 500, 0, 500, 255, 0);
-        leds[0] = CRGB(0, fade, 255 - fade);
-      } else {
-        ledAnimationActive = false;
-        setLEDStatus(LED_READY, false);
-      }
-      FastLED.show();
-      break;
-    }
-    
-    case LED_WRITING: {
-      // Yellow pulse for writing
-      int brightness = (sin(elapsed / 150.0) + 1) * 127;
-      leds[0] = CHSV(64, 255, brightness); // Yellow hue
-      FastLED.show();
-      break;
-    }
-    
-    default:
-      // For static colors, stop animation after a short time
-      if (elapsed > 2000) {
-        ledAnimationActive = false;
-      }
-      break;
-  }
+  bool bits = args.function == MB_FC_READ_COILS || args.function == MB_FC_READ_DISCRETE_INPUTS;
+  uint16_t rxBytes = result == ModbusMaster::ku8MBSuccess ? 5 + (bits ? (args.quantity + 7) / 8 : args.quantity * 2) : 0;
+  busStatsRecord(modbusBus, args.slaveId, args.function, result, elapsedUs, 8, rxBytes, 0);
+  return result;
 }
 
-void ledStatusMessage(LEDStatus status, const char* message) {
-  setLEDStatus(status);
-  
-  // Add LED status emoji to message
-  String emoji;
-  switch (status) {
-    case LED_READY: emoji = "🔵"; break;
-    case LED_SUCCESS: emoji = "✅"; break;
-    case LED_ERROR: emoji = "🔴"; break;
-    case LED_WARNING: emoji = "🟠"; break;
-    case LED_WRITING: emoji = "🟡"; break;
-    case LED_CONNECTING: emoji = "🔄"; break;
-    case LED_SCANNING: emoji = "🟣"; break;
-    default: emoji = "⚫"; break;
-  }
-  
-  Serial.println(emoji + " " + String(message));
+// A ModbusMaster read on bus 1 under the retry policy
+static uint8_t modbusRead(uint8_t slaveId, uint8_t function,
+                          uint8_t (ModbusMaster::*read)(uint16_t, uint16_t),
+                          uint16_t address, uint16_t quantity) {
+  ModbusReadArgs args = {slaveId, function, read, address, quantity};
+  return retryRun(modbusBus, slaveId, modbusReadAttempt, &args, sweepSettings.slowTimeoutMs);
 }
 
 void setup() {
@@ -219,6 +78,9 @@ void setup() {
   Serial.begin(115200);
   while (!Serial) delay(10); // Wait for Serial to initialize
   
+  // Start the boot clock and load the devices known from the last session
+  inventoryBegin();
+  
   // Initialize WS2812 LED
   initializeLED();
   
@@ -234,6 +96,28 @@ void setup() {
     digitalWrite(MODBUS_DE_PIN, LOW); // Start in receive mode
   }
   
+  // Start the bus with the default settings; replies end on UART RX events
+  rtuSetEventFraming(modbusBus, true);
+  rtuBegin(modbusBus, MODBUS_BAUD, SERIAL_8N1);
+  
+  // Let the LED task and others run while waiting for a response
+  modbus.idle(yield);
+  modbusBus.idle = yield;
+  
+  // Queued bus I/O runs in its own task
+  busTaskStart(modbusBus);
+  
+#if MODBUS_BUS_COUNT > 1
+  // Second segment: own UART, pins and line settings, own bus task
+  if (MODBUS2_DE_PIN >= 0) {
+    pinMode(MODBUS2_DE_PIN, OUTPUT);
+    digitalWrite(MODBUS2_DE_PIN, LOW);
+  }
+  rtuSetEventFraming(modbusBus2, true);
+  rtuBegin(modbusBus2, MODBUS2_BAUD, MODBUS2_CONFIG);
+  busTaskStart(modbusBus2);
+#endif
+  
   // Show initial configuration
   Serial.printf("📋 Current Configuration:\n");
   Serial.printf("   RX Pin: %d\n", MODBUS_RX_PIN);
@@ -246,9 +130,24 @@ void setup() {
   }
   Serial.printf("   Default Baud: %d\n", MODBUS_BAUD);
   Serial.printf("   Default Slave ID: %d\n", SLAVE_ID);
+#if MODBUS_BUS_COUNT > 1
+  Serial.printf("   Bus 2: RX %d, TX %d, DE/RE %d, %lu baud %s\n", MODBUS2_RX_PIN, MODBUS2_TX_PIN,
+                MODBUS2_DE_PIN, (unsigned long)modbusBus2.baud, rtuConfigName(modbusBus2.config));
+#endif
   
   ledStatusMessage(LED_READY, "System ready! LED status indicators active.");
   
+  // Known devices get one probe each; full detection only when one is gone
+  if (inventoryCount() > 0) {
+    if (inventoryWarmStart(modbusBus)) {
+      modbus.begin(inventoryRecords()[0].slaveId, Serial1);
+      ledStatusMessage(LED_SUCCESS, "Known devices verified");
+    } else {
+      Serial.println("🔄 A known device is missing - running full detection");
+      detectModbusDevice();
+    }
+  }
+  
   // Interactive menu
   showMainMenu();
 }
@@ -264,17 +163,34 @@ void showMainMenu() {
   Serial.println("7. Show current configuration");
   Serial.println("8. Change settings");
   Serial.println("9. Help/Troubleshooting");
+  Serial.println("10. Passive bus sniffer (listen-only)");
+  Serial.println("11. Discover register map");
+  Serial.println("12. Continuous polling (multi-rate)");
+  Serial.println("13. Device inventory (warm start)");
+  Serial.println("14. Bulk dump (address range)");
+  Serial.println("15. Value history (min/max/avg)");
+  Serial.println("16. Bus statistics (latency per slave)");
+  Serial.println("17. Modbus TCP gateway (WiFi)");
   Serial.println("\n⚠️  NOTE: Write operations disabled for safety");
-  Serial.println("Type a number (1-9) and press Enter:");
+  Serial.printf("Type a number (1-%d) and press Enter, or a command ('help'):\n", MENU_OPTION_COUNT);
 }
 
 void handleSerialInput() {
-  if (Serial.available()) {
-    String input = Serial.readStringUntil('\n');
-    input.trim();
+  String input;
+  if (commandReadLine(input)) {
+    // One-line commands work at any time; see command_line.h
+    if (commandHandle(input)) {
+      return;
+    }
+    
+    // While a scan, the sniffer, polling or a dump is running the console only accepts their controls
+    if (scanHandleCommand(input) || snifferHandleCommand(input) || pollHandleCommand(input) ||
+        dumpHandleCommand(input)) {
+      return;
+    }
     
-    if (input.length() == 1 && input.charAt(0) >= '1' && input.charAt(0) <= '9') {
-      int choice = input.toInt();
+    int choice = input.toInt();
+    if (input.length() > 0 && String(choice) == input && choice >= 1 && choice <= MENU_OPTION_COUNT) {
       
       switch (choice) {
         case 1:
@@ -305,7 +221,7 @@ void handleSerialInput() {
           while (!Serial.available()) delay(10);
           int slaveId = Serial.readStringUntil('\n').toInt();
           if (slaveId >= 1 && slaveId <= 247) {
-            Serial1.begin(9600, SERIAL_8E2, MODBUS_RX_PIN, MODBUS_TX_PIN); // TEC specific settings
+            rtuBegin(modbusBus, 9600, SERIAL_8E2); // TEC specific settings
             modbus.begin(slaveId, Serial1);
             analyzeTECHeatPump(slaveId);
           } else {
@@ -326,16 +242,114 @@ void handleSerialInput() {
           showHelp();
           break;
           
+        case 10:
+          Serial.println("\n👂 Starting passive bus sniffer...");
+          snifferStart();
+          break;
+          
+        case 11: {
+          Serial.println("\n🗺️  Register map discovery (uses the current bus settings)");
+          Serial.println("   Sweeps 0-65535 for blocks of 16+ addresses: about 4000 reads per table, minutes at 9600 baud");
+          Serial.println("Enter Slave ID to map (1-247):");
+          while (!Serial.available()) delay(10);
+          int slaveId = Serial.readStringUntil('\n').toInt();
+          if (slaveId >= 1 && slaveId <= 247) {
+            MapDiscoveryOptions options;
+            MapDiscoveryResult result;
+            mapDefaultOptions(&options);
+            discoverRegisterMap(modbusBus, slaveId, options, &result);
+            printRegisterMap(result);
+          } else {
+            Serial.println("❌ Invalid Slave ID");
+          }
+          break;
+        }
+          
+        case 12:
+          configurePolling();
+          break;
+          
+        case 13: {
+          inventoryPrint();
+          Serial.println("Enter 'v' to verify now, 'c' to clear, or press Enter to go back:");
+          while (!Serial.available()) delay(10);
+          String action = Serial.readStringUntil('\n');
+          action.trim();
+          if (action == "v") {
+            inventoryWarmStart(modbusBus);
+          } else if (action == "c") {
+            inventoryClear();
+            Serial.println("🗑️  Inventory cleared - the next boot starts cold");
+          }
+          break;
+        }
+          
+        case 14:
+          configureDump();
+          break;
+          
+        case 15:
+          showHistory();
+          break;
+          
+        case 16: {
+          busStatsPrint();
+          retryPrintStats();
+          cachePrintStats();
+          Serial.println("Enter 'r' to reset the statistics and close all circuits, or press Enter to go back:");
+          while (!Serial.available()) delay(10);
+          String action = Serial.readStringUntil('\n');
+          action.trim();
+          if (action == "r") {
+            busStatsReset();
+            retryReset();
+            cacheResetStats();
+            Serial.println("🗑️  Bus statistics cleared, circuits closed");
+          }
+          break;
+        }
+          
+        case 17: {
+          gatewayPrintStats();
+          Serial.printf("Enter 's' to start on port %d, 'q' to stop, 'w' to set the WiFi network, or press Enter to go back:\n",
+                        GATEWAY_PORT);
+          while (!Serial.available()) delay(10);
+          String action = Serial.readStringUntil('\n');
+          action.trim();
+          if (action == "s") {
+            gatewayStart();
+          } else if (action == "q") {
+            gatewayStop();
+          } else if (action == "w") {
+            Serial.println("Enter the network name (SSID):");
+            while (!Serial.available()) delay(10);
+            String ssid = Serial.readStringUntil('\n');
+            ssid.trim();
+            Serial.println("Enter the password (empty for an open network):");
+            while (!Serial.available()) delay(10);
+            String password = Serial.readStringUntil('\n');
+            password.trim();
+            if (ssid.length() > 0) {
+              gatewaySetWifi(ssid.c_str(), password.c_str());
+              Serial.printf("📶 WiFi network %s saved\n", ssid.c_str());
+            }
+          }
+          break;
+        }
+          
         default:
-          Serial.println("❌ Invalid option. Please choose 1-9.");
+          Serial.printf("❌ Invalid option. Please choose 1-%d.\n", MENU_OPTION_COUNT);
           break;
       }
     } else {
-      Serial.println("❌ Please enter a single digit (1-9).");
+      Serial.printf("❌ Please enter a number (1-%d) or a command ('help' lists them).\n", MENU_OPTION_COUNT);
     }
     
-    Serial.println("\n" + String('-', 40));
-    showMainMenu();
+    // A running scan, sniffer, poll or dump prints the menu again when it finishes
+    if (!scanActive() && !snifferActive() && !pollActive() && !dumpActive()) {
+      Serial.println("\n" + String('-', 40));
+      showMainMenu();
+    }
   }
 }
 
@@ -355,11 +369,11 @@ void testSpecificSlaveId() {
   Serial.printf("🔍 Testing Slave ID %d...\n", slaveId);
   
   // Initialize with current settings
-  Serial1.begin(MODBUS_BAUD, SERIAL_8N1, MODBUS_RX_PIN, MODBUS_TX_PIN);
+  rtuBegin(modbusBus, MODBUS_BAUD, SERIAL_8N1);
   modbus.begin(slaveId, Serial1);
   
   // Test basic communication
-  uint8_t result = modbus.readHoldingRegisters(0, 1);
+  uint8_t result = modbusRead(slaveId, MB_FC_READ_HOLDING_REGISTERS, &ModbusMaster::readHoldingRegisters, 0, 1);
   
   if (result == modbus.ku8MBSuccess) {
     Serial.printf("✅ SUCCESS! Device found at Slave ID %d\n", slaveId);
@@ -388,9 +402,14 @@ void testDifferentBaudRates() {
     return;
   }
   
-  uint32_t detectedBaud;
-  if (autoDetectBaudRate(slaveId, &detectedBaud)) {
+  uint32_t detectedBaud, lineBaud;
+  if (autoDetectBaudRate(slaveId, &detectedBaud, &lineBaud)) {
     Serial.printf("✅ Device communicates at %d baud\n", detectedBaud);
+  } else if (lineBaud && autoDetectSerialConfig(slaveId, lineBaud)) {
+    Serial.printf("✅ Device communicates at %lu baud %s\n", (unsigned long)lineBaud, rtuConfigName(modbusBus.config));
+  } else if (lineBaud) {
+    Serial.printf("❌ The bus runs at %lu baud, but Slave ID %d does not answer in any frame format.\n",
+                  (unsigned long)lineBaud, slaveId);
   } else {
     Serial.println("❌ Could not detect baud rate for this device.");
   }
@@ -415,7 +434,16 @@ void readSpecificRegisters() {
   while (!Serial.available()) delay(10);
   int quantity = Serial.readStringUntil('\n').toInt();
   
-  Serial1.begin(MODBUS_BAUD, SERIAL_8N1, MODBUS_RX_PIN, MODBUS_TX_PIN);
+  rtuBegin(modbusBus, MODBUS_BAUD, SERIAL_8N1);
+  
+  // More than ModbusMaster's buffer holds goes out as a bulk dump in protocol-size chunks
+  static const uint8_t dumpTables[] = {MAP_HOLDING_REGISTERS, MAP_INPUT_REGISTERS, MAP_COILS, MAP_DISCRETE_INPUTS};
+  bool bits = regType == 3 || regType == 4;
+  if (regType >= 1 && regType <= 4 && quantity > (bits ? DUMP_MODBUSMASTER_WORDS * 16 : DUMP_MODBUSMASTER_WORDS)) {
+    long last = min((long)startAddr + quantity - 1, 0xFFFFL);
+    dumpStart(slaveId, dumpTables[regType - 1], startAddr, last);
+    return;
+  }
   
   switch (regType) {
     case 1:
@@ -436,6 +464,98 @@ void readSpecificRegisters() {
   }
 }
 
+// Range to dump as one line: "<slave> <co|di|hr|ir> <first> <last> [bus]"
+void configureDump() {
+  Serial.println("\n📦 Bulk dump (uses the current bus settings, up to 125 registers / 2000 bits per read)");
+  Serial.println("Enter: <slave> <co|di|hr|ir> <first> <last> [bus]   e.g. 1 hr 0 65535");
+  while (!Serial.available()) delay(10);
+  String line = Serial.readStringUntil('\n');
+  line.trim();
+  line.toLowerCase();
+  
+  char tableName[4] = "";
+  int slaveId = 0, bus = 1;
+  long first = 0, last = 0;
+  int table = -1;
+  if (sscanf(line.c_str(), "%d %3s %ld %ld %d", &slaveId, tableName, &first, &last, &bus) >= 4) {
+    for (uint8_t t = 0; t < MAP_TABLE_COUNT; t++) {
+      if (String(mapTableName(t)).equalsIgnoreCase(tableName)) table = t;
+    }
+  }
+  if (table < 0 || first < 0 || last > 0xFFFF || first > last || bus < 1 || bus > rtuBusCount()) {
+    Serial.println("❌ Expected: <slave> <co|di|hr|ir> <first> <last> [bus]");
+    return;
+  }
+  dumpStart(slaveId, table, first, last, bus - 1);
+}
+
+// Poll points are entered one per line:
+// "<slave> <co|di|hr|ir> <address> <count> <period ms> [bus] [deadband[%]]"
+void configurePolling() {
+  Serial.println("\n⏱️  Continuous polling (uses the current bus settings)");
+  Serial.println("Enter poll points, one per line: <slave> <co|di|hr|ir> <address> <count> <period ms> [bus] [deadband[%]]");
+  Serial.println("Example: 1 ir 0 4 250 1 2% - empty line to start, 'x' to cancel");
+  Serial.println("The deadband applies in change reporting ('c' while polling)");
+  
+  pollClear();
+  while (true) {
+    while (!Serial.available()) delay(10);
+    String line = Serial.readStringUntil('\n');
+    line.trim();
+    line.toLowerCase();
+    if (line == "x") return;
+    if (line.length() == 0) break;
+    
+    char tableName[4] = "";
+    char deadbandText[8] = "0";
+    int slaveId = 0, address = 0, count = 0;
+    long periodMs = 0;
+    int bus = 1;
+    uint16_t deadband = 0;
+    bool percent = false;
+    if (sscanf(line.c_str(), "%d %3s %d %d %ld %d %7s", &slaveId, tableName, &address, &count, &periodMs, &bus,
+               deadbandText) < 5 || !changeParseDeadband(deadbandText, &deadband, &percent)) {
+      Serial.println("❌ Expected: <slave> <co|di|hr|ir> <address> <count> <period ms> [bus] [deadband[%]]");
+      continue;
+    }
+    int table = -1;
+    for (uint8_t t = 0; t < MAP_TABLE_COUNT; t++) {
+      if (String(mapTableName(t)).equalsIgnoreCase(tableName)) table = t;
+    }
+    if (slaveId < 1 || slaveId > 247 || table < 0 || address < 0 || address > 0xFFFF || periodMs <= 0 ||
+        bus < 1 || bus > rtuBusCount() || pollAddPoint(slaveId, table, address, count, periodMs, bus - 1) < 0) {
+      Serial.println("❌ Invalid poll point (or list full)");
+      continue;
+    }
+    pollSetDeadband(pollPointCount() - 1, deadband, percent);
+    Serial.printf("   ✅ Point %d added\n", pollPointCount() - 1);
+  }
+  pollStart();
+}
+
+// Series table, then one series or flash block at a time: "<series>" for
+// its minute buckets, "r <series>" for raw samples, "f <block>" for flash
+void showHistory() {
+  historyPrint();
+  while (true) {
+    Serial.println("Enter a series for its minutes, 'r <series>' for raw samples, 'f <block>' for a flash block, or Enter to go back:");
+    while (!Serial.available()) delay(10);
+    String line = Serial.readStringUntil('\n');
+    line.trim();
+    if (line.length() == 0) return;
+    
+    char kind = line[0] == 'r' || line[0] == 'f' ? line[0] : 'm';
+    int number = (kind == 'm' ? line : line.substring(1)).toInt();
+    uint16_t written = 0;
+    if (kind == 'f') {
+      written = historyStreamFlash(Serial, "  ", number);
+    } else if (number >= 0 && number < historySeriesCount()) {
+      written = kind == 'r' ? historyStreamRaw(Serial, "  ", number, 0) : historyStreamRollup(Serial, "  ", number, 0);
+    }
+    if (written == 0) Serial.println("❌ Nothing recorded there");
+  }
+}
+
 void writeToRegister() {
   Serial.println("\n⚠️  WRITE OPERATIONS DISABLED FOR SAFETY");
   Serial.println("This scanner is configured for READ-ONLY operations to prevent");
@@ -451,6 +571,37 @@ void showCurrentConfiguration() {
   Serial.printf("   Baud Rate: %d\n", MODBUS_BAUD);
   Serial.printf("   Default Slave ID: %d\n", SLAVE_ID);
   Serial.printf("   Data Format: 8N1 (8 data bits, No parity, 1 stop bit)\n");
+  Serial.printf("   Active Bus: %lu baud %s\n", (unsigned long)modbusBus.baud, rtuConfigName(modbusBus.config));
+#if MODBUS_BUS_COUNT > 1
+  Serial.printf("   Bus 2: RX %d, TX %d, DE/RE %s, %lu baud %s (scanned and polled in parallel)\n",
+                MODBUS2_RX_PIN, MODBUS2_TX_PIN, MODBUS2_DE_PIN >= 0 ? String(MODBUS2_DE_PIN).c_str() : "Not used",
+                (unsigned long)modbusBus2.baud, rtuConfigName(modbusBus2.config));
+#endif
+  Serial.printf("   Fast Sweep: %s (probe timeout %d ms, measured turnaround %lu us)\n",
+                sweepSettings.fastSweep ? "ON" : "OFF", rtuProbeTimeoutMs(modbusBus),
+                (unsigned long)modbusBus.turnaroundUs);
+  Serial.printf("   Retry Pass: %s (%d ms timeout)\n",
+                sweepSettings.retryPass ? "ON" : "OFF", sweepSettings.slowTimeoutMs);
+  Serial.printf("   Baud Detection: listen %d ms for traffic, then probe\n", sweepSettings.listenMs);
+  if (modbusBus.eventFraming) {
+    Serial.printf("   RX Framing: event-driven (RX timeout %d chars = t3.5)\n", rtuRxTimeoutSymbols(modbusBus));
+  } else {
+    Serial.println("   RX Framing: polled");
+  }
+  busTaskPrintStats();
+  if (streamBinary()) {
+    const StreamStats& stream = streamStats();
+    Serial.printf("   Output: binary records (%lu records, %lu values in %lu bytes)\n",
+                  (unsigned long)stream.records, (unsigned long)stream.values, (unsigned long)stream.bytes);
+  } else {
+    Serial.println("   Output: text");
+  }
+  
+  RtuCrcBenchmark crc;
+  rtuCrcBenchmark(&crc);
+  Serial.printf("   CRC16: table %.1f bytes/us, bitwise %.1f bytes/us (%s)\n",
+                crc.tableUs ? (float)crc.bytes / crc.tableUs : 0, crc.bitwiseUs ? (float)crc.bytes / crc.bitwiseUs : 0,
+                crc.mismatches ? "MISMATCH" : "bit-exact");
 }
 
 void changeSettingsInteractive() {
@@ -467,6 +618,49 @@ void changeSettingsInteractive() {
   String slaveInput = Serial.readStringUntil('\n');
   slaveInput.trim();
   
+  Serial.printf("Fast sweep mode (y/n, or press Enter to keep %s):\n", sweepSettings.fastSweep ? "ON" : "OFF");
+  while (!Serial.available()) delay(10);
+  String fastInput = Serial.readStringUntil('\n');
+  fastInput.trim();
+  if (fastInput.length() > 0) {
+    sweepSettings.fastSweep = fastInput.charAt(0) == 'y' || fastInput.charAt(0) == 'Y';
+  }
+  
+  Serial.printf("Retry pass for slow responders (y/n, or press Enter to keep %s):\n", sweepSettings.retryPass ? "ON" : "OFF");
+  while (!Serial.available()) delay(10);
+  String retryInput = Serial.readStringUntil('\n');
+  retryInput.trim();
+  if (retryInput.length() > 0) {
+    sweepSettings.retryPass = retryInput.charAt(0) == 'y' || retryInput.charAt(0) == 'Y';
+  }
+  
+  Serial.printf("Event-driven RX framing (y/n, or press Enter to keep %s):\n", modbusBus.eventFraming ? "ON" : "OFF");
+  while (!Serial.available()) delay(10);
+  String framingInput = Serial.readStringUntil('\n');
+  framingInput.trim();
+  if (framingInput.length() > 0) {
+    rtuSetEventFraming(modbusBus, framingInput.charAt(0) == 'y' || framingInput.charAt(0) == 'Y');
+  }
+  
+  Serial.printf("Register data output (t = text, b = binary records, or press Enter to keep %s):\n",
+                streamBinary() ? "binary" : "text");
+  while (!Serial.available()) delay(10);
+  String outputInput = Serial.readStringUntil('\n');
+  outputInput.trim();
+  if (outputInput.length() > 0) {
+    streamSetMode(outputInput.charAt(0) == 'b' || outputInput.charAt(0) == 'B' ? STREAM_BINARY : STREAM_TEXT);
+  }
+  
+#if MODBUS_BUS_COUNT > 1
+  Serial.printf("Bus 2 baud rate (or press Enter to keep %lu):\n", (unsigned long)modbusBus2.baud);
+  while (!Serial.available()) delay(10);
+  String bus2Input = Serial.readStringUntil('\n');
+  bus2Input.trim();
+  if (bus2Input.toInt() > 0) {
+    rtuBegin(modbusBus2, bus2Input.toInt(), modbusBus2.config);
+  }
+#endif
+  
   uint32_t newBaud = baudInput.length() > 0 ? baudInput.toInt() : MODBUS_BAUD;
   uint8_t newSlaveId = slaveInput.length() > 0 ? slaveInput.toInt() : SLAVE_ID;
   
@@ -509,13 +703,28 @@ void showHelp() {
 }
 
 void loop() {
-  // Update LED animations
-  updateLEDAnimation();
-  
   // Handle interactive serial commands
   handleSerialInput();
   
-  delay(50); // Small delay to prevent excessive CPU usage while allowing smooth LED animations
+  // Advance a running scan by one probe
+  scanTick();
+  
+  // Collect sniffed bytes
+  snifferTick();
+  
+  // Queue the next due poll read
+  pollTick();
+  
+  // Queue the next chunk of a bulk dump
+  dumpTick();
+  
+  // Accept Modbus TCP clients and queue their requests
+  gatewayTick();
+  
+  // Results of queued bus requests
+  busDispatch();
+  
+  delay(1); // Let the idle and bus tasks run; keeps console latency at a tick
 }
 
 // Function to read Modbus holding registers
@@ -524,11 +733,18 @@ void readHoldingRegisters(uint8_t slaveId, uint16_t startAddress, uint16_t quant
   Serial.printf("\n--- Reading %d holding registers from address %d (Slave ID: %d) ---\n", 
                 quantity, startAddress, slaveId);
   
-  uint8_t result = modbus.readHoldingRegisters(startAddress, quantity);
+  uint8_t result = modbusRead(slaveId, MB_FC_READ_HOLDING_REGISTERS, &ModbusMaster::readHoldingRegisters,
+                                startAddress, quantity);
   
   if (result == modbus.ku8MBSuccess) {
     ledStatusMessage(LED_SUCCESS, "Holding registers read successfully!");
     
+    if (streamBinary()) {
+      streamBegin(1, slaveId, MAP_HOLDING_REGISTERS, startAddress, quantity);
+      for (uint16_t i = 0; i < quantity; i++) streamWord(modbus.getResponseBuffer(i));
+      streamEnd();
+      return;
+    }
     for (uint16_t i = 0; i < quantity; i++) {
       uint16_t value = modbus.getResponseBuffer(i);
       Serial.printf("Register %d: 0x%04X (%d)\n", startAddress + i, value, value);
@@ -545,11 +761,18 @@ void readInputRegisters(uint8_t slaveId, uint16_t startAddress, uint16_t quantit
   Serial.printf("\n--- Reading %d input registers from address %d (Slave ID: %d) ---\n", 
                 quantity, startAddress, slaveId);
   
-  uint8_t result = modbus.readInputRegisters(startAddress, quantity);
+  uint8_t result = modbusRead(slaveId, MB_FC_READ_INPUT_REGISTERS, &ModbusMaster::readInputRegisters,
+                                startAddress, quantity);
   
   if (result == modbus.ku8MBSuccess) {
     ledStatusMessage(LED_SUCCESS, "Input registers read successfully!");
     
+    if (streamBinary()) {
+      streamBegin(1, slaveId, MAP_INPUT_REGISTERS, startAddress, quantity);
+      for (uint16_t i = 0; i < quantity; i++) streamWord(modbus.getResponseBuffer(i));
+      streamEnd();
+      return;
+    }
     for (uint16_t i = 0; i < quantity; i++) {
       uint16_t value = modbus.getResponseBuffer(i);
       Serial.printf("Register %d: 0x%04X (%d)\n", startAddress + i, value, value);
@@ -566,11 +789,17 @@ void readCoils(uint8_t slaveId, uint16_t startAddress, uint16_t quantity) {
   Serial.printf("\n--- Reading %d coils from address %d (Slave ID: %d) ---\n", 
                 quantity, startAddress, slaveId);
   
-  uint8_t result = modbus.readCoils(startAddress, quantity);
+  uint8_t result = modbusRead(slaveId, MB_FC_READ_COILS, &ModbusMaster::readCoils, startAddress, quantity);
   
   if (result == modbus.ku8MBSuccess) {
     ledStatusMessage(LED_SUCCESS, "Coils read successfully!");
     
+    if (streamBinary()) {
+      streamBegin(1, slaveId, MAP_COILS, startAddress, quantity);
+      for (uint16_t i = 0; i < (quantity + 15) / 16; i++) streamWord(modbus.getResponseBuffer(i));
+      streamEnd();
+      return;
+    }
     for (uint16_t i = 0; i < quantity; i++) {
       bool value = modbus.getResponseBuffer(i / 16) & (1 << (i % 16));
       Serial.printf("Coil %d: %s\n", startAddress + i, value ? "ON" : "OFF");
@@ -586,11 +815,18 @@ void readDiscreteInputs(uint8_t slaveId, uint16_t startAddress, uint16_t quantit
   Serial.printf("\n--- Reading %d discrete inputs from address %d (Slave ID: %d) ---\n", 
                 quantity, startAddress, slaveId);
   
-  uint8_t result = modbus.readDiscreteInputs(startAddress, quantity);
+  uint8_t result = modbusRead(slaveId, MB_FC_READ_DISCRETE_INPUTS, &ModbusMaster::readDiscreteInputs,
+                                startAddress, quantity);
   
   if (result == modbus.ku8MBSuccess) {
     Serial.println("✅ SUCCESS: Discrete inputs read successfully!");
     
+    if (streamBinary()) {
+      streamBegin(1, slaveId, MAP_DISCRETE_INPUTS, startAddress, quantity);
+      for (uint16_t i = 0; i < (quantity + 15) / 16; i++) streamWord(modbus.getResponseBuffer(i));
+      streamEnd();
+      return;
+    }
     for (uint16_t i = 0; i < quantity; i++) {
       bool value = modbus.getResponseBuffer(i / 16) & (1 << (i % 16));
       Serial.printf("Input %d: %s\n", startAddress + i, value ? "HIGH" : "LOW");
@@ -619,39 +855,6 @@ void writeSingleCoil(uint8_t slaveId, uint16_t address, bool value) {
                 slaveId, address, value ? "ON" : "OFF");
 }
 
-// Main function to demonstrate Modbus communication
-void readModbusData() {
-  // Change slave ID if needed
-  modbus.begin(SLAVE_ID, Serial1);
-  
-  // Example reads - customize these for your specific device
-  // Uncomment the functions you want to test:
-  
-  // Read 4 holding registers starting from address 0
-  readHoldingRegisters(SLAVE_ID, 0, 4);
-  
-  delay(100); // Small delay between requests
-  
-  // Read 2 input registers starting from address 0
-  // readInputRegisters(SLAVE_ID, 0, 2);
-  
-  // delay(100);
-  
-  // Read 8 coils starting from address 0
-  // readCoils(SLAVE_ID, 0, 8);
-  
-  // delay(100);
-  
-  // Read 8 discrete inputs starting from address 0
-  // readDiscreteInputs(SLAVE_ID, 0, 8);
-  
-  // delay(100);
-  
-  // Example write operations (uncomment to test):
-  // writeSingleRegister(SLAVE_ID, 0, 12345);
-  // writeSingleCoil(SLAVE_ID, 0, true);
-}
-
 // Function to print detailed Modbus error information
 void printModbusError(uint8_t result) {
   switch (result) {
@@ -682,6 +885,9 @@ void printModbusError(uint8_t result) {
     case modbus.ku8MBInvalidCRC:
       Serial.println("❌ ERROR: Invalid CRC - Data corruption detected");
       break;
+    case RETRY_CIRCUIT_OPEN:
+      Serial.println("⛔ ERROR: Circuit open - The slave kept failing, calls are paused (see option 16)");
+      break;
     default:
       Serial.printf("❌ ERROR: Unknown error code: 0x%02X\n", result);
       break;
@@ -689,56 +895,9 @@ void printModbusError(uint8_t result) {
 }
 
 // Function to scan for Modbus devices (useful for debugging)
+// Starts a non-blocking scan of every bus; loop() keeps the bus tasks fed
 void scanModbusDevices() {
-  ledStatusMessage(LED_SCANNING, "Scanning for Modbus devices...");
-  Serial.println("\n🔍 Scanning for Modbus devices (IDs 1-247)...");
-  Serial.println("This may take a while...\n");
-  
-  int devicesFound = 0;
-  
-  for (uint8_t id = 1; id <= 247; id++) {
-    modbus.begin(id, Serial1);
-    
-    // Try to read one holding register
-    uint8_t result = modbus.readHoldingRegisters(0, 1);
-    
-    if (result == modbus.ku8MBSuccess) {
-      setLEDStatus(LED_SUCCESS, false); // Brief green flash
-      Serial.printf("✅ Device found at ID: %d\n", id);
-      devicesFound++;
-      delay(100); // Show success briefly
-      setLEDStatus(LED_SCANNING); // Back to scanning
-    }
-    else if (result != modbus.ku8MBResponseTimedOut && result != modbus.ku8MBInvalidSlaveID) {
-      setLEDStatus(LED_WARNING, false); // Brief orange flash
-      Serial.printf("⚠️  Device at ID %d responded with error: ", id);
-      printModbusError(result);
-      delay(100);
-      setLEDStatus(LED_SCANNING); // Back to scanning
-    }
-    
-    delay(50); // Small delay between attempts
-    
-    // Print progress every 50 devices
-    if (id % 50 == 0) {
-      Serial.printf("Progress: %d/247 devices checked\n", id);
-    }
-  }
-  
-  if (devicesFound > 0) {
-    ledStatusMessage(LED_SUCCESS, "Scan complete - devices found!");
-  } else {
-    ledStatusMessage(LED_WARNING, "Scan complete - no devices found");
-  }
-  
-  Serial.printf("\n🎯 Scan complete! Found %d device(s)\n", devicesFound);
-  if (devicesFound == 0) {
-    Serial.println("💡 Tips:");
-    Serial.println("   - Check wiring connections (RX, TX, GND)");
-    Serial.println("   - Verify baud rate matches your device");
-    Serial.println("   - Check if DE/RE pin is needed and properly connected");
-    Serial.println("   - Ensure correct voltage levels (3.3V vs 5V)");
-  }
+  scanStart(1, 247);
 }
 
 // Function to change Modbus settings at runtime
@@ -748,7 +907,7 @@ void changeModbusSettings(uint32_t newBaud, uint8_t newSlaveId) {
   // Reinitialize serial with new baud rate
   Serial1.end();
   delay(100);
-  Serial1.begin(newBaud, SERIAL_8N1, MODBUS_RX_PIN, MODBUS_TX_PIN);
+  rtuBegin(modbusBus, newBaud, SERIAL_8N1);
   
   // Update ModbusMaster with new slave ID
   modbus.begin(newSlaveId, Serial1);
@@ -757,7 +916,7 @@ void changeModbusSettings(uint32_t newBaud, uint8_t newSlaveId) {
 }
 
 // Auto-detect baud rate function
-bool autoDetectBaudRate(uint8_t slaveId, uint32_t* detectedBaud) {
+bool autoDetectBaudRate(uint8_t slaveId, uint32_t* detectedBaud, uint32_t* lineBaud) {
   // Common Modbus RTU baud rates to test
   uint32_t baudRates[] = {
     9600,   // Most common
@@ -774,6 +933,39 @@ bool autoDetectBaudRate(uint8_t slaveId, uint32_t* detectedBaud) {
   
   ledStatusMessage(LED_SCANNING, "Auto-detecting baud rate...");
   Serial.println("\n🔍 AUTO-DETECTING BAUD RATE...");
+  
+  if (lineBaud) *lineBaud = 0;
+
+  // Traffic from another master gives the bus baud rate without a single probe
+  if (sweepSettings.listenMs > 0) {
+    BaudMeasurement measurement;
+    Serial.printf("Listening up to %d ms for bus traffic... ", sweepSettings.listenMs);
+    if (baudMeasureFromTraffic(sweepSettings.listenMs, &measurement)) {
+      Serial.printf("✅ %lu baud (bit time %.2f us, %lu edges, %lu ms)\n", (unsigned long)measurement.baud,
+                    measurement.bitTimeNs / 1000.0f, (unsigned long)measurement.edges, measurement.elapsedMs);
+      rtuBegin(modbusBus, measurement.baud, SERIAL_8N1);
+      modbus.begin(slaveId, Serial1);
+      if (lineBaud) *lineBaud = measurement.baud;
+      uint8_t result = rtuProbe(modbusBus, slaveId, rtuProbeTimeoutMs(modbusBus));
+      if (result == modbus.ku8MBSuccess || result == modbus.ku8MBIllegalDataAddress) {
+        Serial.printf("✅ Slave ID %d answers at %lu baud\n", slaveId, (unsigned long)measurement.baud);
+        ledStatusMessage(LED_SUCCESS, "Baud rate detected!");
+        *detectedBaud = measurement.baud;
+        return true;
+      }
+      // The line runs at this rate whatever the slave does: sweeping others is pointless
+      Serial.printf("⚠️  Slave ID %d did not answer at 8N1 - check the ID and frame format\n", slaveId);
+      ledStatusMessage(LED_WARNING, "Bus baud measured, slave silent");
+      return false;
+    }
+    if (measurement.edges >= BAUD_MIN_EDGES) {
+      Serial.printf("❓ %lu edges but no standard rate (about %lu baud)\n",
+                    (unsigned long)measurement.edges, (unsigned long)measurement.measuredBaud);
+    } else {
+      Serial.println("line is silent");
+    }
+  }
+  
   Serial.printf("Testing %d different baud rates with Slave ID %d\n\n", numBaudRates, slaveId);
   
   for (int i = 0; i < numBaudRates; i++) {
@@ -783,11 +975,11 @@ bool autoDetectBaudRate(uint8_t slaveId, uint32_t* detectedBaud) {
     // Reinitialize serial with test baud rate
     Serial1.end();
     delay(100);
-    Serial1.begin(testBaud, SERIAL_8N1, MODBUS_RX_PIN, MODBUS_TX_PIN);
+    rtuBegin(modbusBus, testBaud, SERIAL_8N1);
     modbus.begin(slaveId, Serial1);
     
     // Try to read a holding register (most devices support this)
-    uint8_t result = modbus.readHoldingRegisters(0, 1);
+    uint8_t result = rtuProbe(modbusBus, slaveId, rtuProbeTimeoutMs(modbusBus));
     
     if (result == modbus.ku8MBSuccess) {
       Serial.println("✅ FOUND!");
@@ -839,11 +1031,11 @@ bool autoDetectSerialConfig(uint8_t slaveId, uint32_t baudRate) {
     // Reinitialize serial with test configuration
     Serial1.end();
     delay(100);
-    Serial1.begin(baudRate, configs[i].config, MODBUS_RX_PIN, MODBUS_TX_PIN);
+    rtuBegin(modbusBus, baudRate, configs[i].config);
     modbus.begin(slaveId, Serial1);
     
     // Try to read a holding register
-    uint8_t result = modbus.readHoldingRegisters(0, 1);
+    uint8_t result = rtuProbe(modbusBus, slaveId, rtuProbeTimeoutMs(modbusBus));
     
     if (result == modbus.ku8MBSuccess || result == modbus.ku8MBIllegalDataAddress) {
       Serial.println("✅ WORKS!");
@@ -860,7 +1052,7 @@ bool autoDetectSerialConfig(uint8_t slaveId, uint32_t baudRate) {
   // Reset to default
   Serial1.end();
   delay(100);
-  Serial1.begin(baudRate, SERIAL_8N1, MODBUS_RX_PIN, MODBUS_TX_PIN);
+  rtuBegin(modbusBus, baudRate, SERIAL_8N1);
   modbus.begin(slaveId, Serial1);
   return false;
 }
@@ -874,132 +1066,52 @@ void analyzeTECHeatPump(uint8_t slaveId) {
   // Test key registers to identify TEC heat pump
   Serial.println("🔍 Testing TEC-specific registers...");
   
-  // Test Input Registers (key temperature sensors)
-  struct {
-    uint16_t address;
-    const char* name;
-    const char* unit;
-    float scale;
-  } tecInputRegisters[] = {
-    {1, "B1 - Inlet Temperature", "°C", 0.1},
-    {2, "B2 - Outlet Temperature", "°C", 0.1},
-    {3, "T2 - Ambient Temperature", "°C", 0.1},
-    {4, "T4 - Suction", "°C", 0.1},
-    {5, "T3 - Discharge", "°C", 0.1},
-    {6, "B6 - Low Pressure Side", "bar", 0.1},
-    {7, "B7 - High Pressure Side", "bar", 0.1},
-    {8, "Flow", "m3/h", 0.1},
-    {9, "Room Temperature", "°C", 0.1},
-    {13, "Compressor", "Hz", 1.0},
-    {14, "Y3 - Indoor pump PWM", "%", 0.1},
-    {17, "B4 - Hot Water", "°C", 0.1},
-    {18, "Operating Hours", "Hours", 1.0},
-    {20, "Unit State", "", 1.0}
+  // One coalesced poll of the profile instead of a read per register
+  ReadPlan plan;
+  planInit(&plan);
+  registerProfilePlan(&plan, tecRegisters, tecRegisterCount);
+  planBuild(&plan, modbusBus);
+  planExecute(&plan, modbusBus, slaveId);
+  planPrint(&plan);
+  Serial.printf("   %d transaction(s) in %lu ms\n", plan.transactions, plan.elapsedMs);
+  
+  // Registers count towards detection; the alarms are reported only
+  static const char* sectionTitles[MAP_TABLE_COUNT] = {
+    nullptr, "\n🚨 ALARM STATUS (Discrete Inputs):", "\n🎛️  HOLDING REGISTERS (Configuration):", "\n📊 INPUT REGISTERS:"
   };
-  
+  static const uint8_t sectionOrder[] = {MAP_INPUT_REGISTERS, MAP_HOLDING_REGISTERS, MAP_DISCRETE_INPUTS};
   int validReadings = 0;
-  int totalTests = sizeof(tecInputRegisters) / sizeof(tecInputRegisters[0]);
-  
-  Serial.println("\n📊 INPUT REGISTERS:");
-  for (int i = 0; i < totalTests; i++) {
-    uint8_t result = modbus.readInputRegisters(tecInputRegisters[i].address, 1);
-    if (result == modbus.ku8MBSuccess) {
-      validReadings++;
-      uint16_t rawValue = modbus.getResponseBuffer(0);
-      float scaledValue = rawValue * tecInputRegisters[i].scale;
+  int totalTests = 0;
+  char text[REGISTER_TEXT_MAX];
+  
+  for (uint8_t table : sectionOrder) {
+    Serial.println(sectionTitles[table]);
+    for (uint8_t i = 0; i < tecRegisterCount; i++) {
+      const RegisterDescriptor& reg = tecRegisters[i];
+      if (reg.table != table) continue;
+      bool isRegister = table == MAP_INPUT_REGISTERS || table == MAP_HOLDING_REGISTERS;
+      if (isRegister) totalTests++;
       
-      Serial.printf("  ✅ Reg %d: %s = %.1f %s\n", 
-                    tecInputRegisters[i].address, 
-                    tecInputRegisters[i].name, 
-                    scaledValue, 
-                    tecInputRegisters[i].unit);
-                    
-      // Special handling for Unit State
-      if (tecInputRegisters[i].address == 20) {
-        const char* stateText = "Unknown";
-        switch (rawValue) {
-          case 1: stateText = "Heating"; break;
-          case 2: stateText = "Cooling"; break;
-          case 3: stateText = "Antifreeze"; break;
-          case 4: stateText = "Defrost"; break;
-          case 5: stateText = "Standby"; break;
-          case 6: stateText = "Off"; break;
-          case 7: stateText = "Starting"; break;
-          case 8: stateText = "On"; break;
-          case 9: stateText = "DHW"; break;
-        }
-        Serial.printf("       State: %s (%d)\n", stateText, rawValue);
+      int32_t value;
+      if (!registerPlanValue(&plan, reg, &value)) {
+        if (table == MAP_INPUT_REGISTERS) Serial.printf("  ❌ Reg %d: %s - No response\n", reg.address, reg.name);
+        continue;
       }
-    } else {
-      Serial.printf("  ❌ Reg %d: %s - No response\n", 
-                    tecInputRegisters[i].address, 
-                    tecInputRegisters[i].name);
-    }
-    delay(100); // Small delay between readings
-  }
-  
-  // Test some Holding Registers (read-only for safety)
-  Serial.println("\n🎛️  HOLDING REGISTERS (Configuration):");
-  struct {
-    uint16_t address;
-    const char* name;
-    const char* unit;
-    float scale;
-  } tecHoldingRegisters[] = {
-    {61, "ST01 - Cooling mode temperature", "°C", 0.1},
-    {62, "ST02 - Heating mode temperature", "°C", 0.1},
-    {79, "ST09 - DHW temperature setup", "°C", 0.1},
-    {80, "ST10 - DHW temperature difference", "°C", 0.1}
-  };
-  
-  for (int i = 0; i < 4; i++) {
-    uint8_t result = modbus.readHoldingRegisters(tecHoldingRegisters[i].address, 1);
-    if (result == modbus.ku8MBSuccess) {
-      validReadings++;
-      uint16_t rawValue = modbus.getResponseBuffer(0);
-      float scaledValue = rawValue * tecHoldingRegisters[i].scale;
-      
-      Serial.printf("  ✅ Reg %d: %s = %.1f %s\n", 
-                    tecHoldingRegisters[i].address, 
-                    tecHoldingRegisters[i].name, 
-                    scaledValue, 
-                    tecHoldingRegisters[i].unit);
-    }
-    delay(100);
-  }
-  
-  // Test Discrete Inputs (Alarms)
-  Serial.println("\n🚨 ALARM STATUS (Discrete Inputs):");
-  const char* alarmNames[] = {
-    "AL01 - Low pressure",
-    "AL02 - High pressure", 
-    "AL03 - Low outlet water temp",
-    "", // Address 4 not used
-    "AL05 - High outlet water temp",
-    "AL17 - Water flow short",
-    "AL18 - Low pressure alarm limit",
-    "AL19 - High pressure alarm limit"
-  };
-  
-  uint8_t result = modbus.readDiscreteInputs(1, 8);
-  if (result == modbus.ku8MBSuccess) {
-    for (int i = 0; i < 8; i++) {
-      if (strlen(alarmNames[i]) > 0) {
-        bool alarmActive = modbus.getResponseBuffer(i / 16) & (1 << (i % 16));
-        Serial.printf("  %s Alarm %d: %s - %s\n", 
-                      alarmActive ? "🔴" : "✅", 
-                      i + 1,
-                      alarmNames[i],
-                      alarmActive ? "ACTIVE" : "OK");
+      if (!isRegister) {
+        Serial.printf("  %s Alarm %d: %s - %s\n", value ? "🔴" : "✅", reg.address, reg.name, value ? "ACTIVE" : "OK");
+        continue;
       }
+      validReadings++;
+      registerFormat(reg, value, text, sizeof(text));
+      Serial.printf("  ✅ Reg %d: %s = %s\n", reg.address, reg.name, text);
     }
   }
   
   // Conclusion
-  float detectionRate = (float)validReadings / (totalTests + 4) * 100;
+  float detectionRate = (float)validReadings / totalTests * 100;
   Serial.println(String('=', 50));
   Serial.printf("📈 Detection Rate: %.1f%% (%d/%d registers responded)\n", 
-                detectionRate, validReadings, totalTests + 4);
+                detectionRate, validReadings, totalTests);
                 
   if (detectionRate > 70) {
     ledStatusMessage(LED_SUCCESS, "TEC QRS11 Heat Pump detected!");
@@ -1024,21 +1136,19 @@ void detectModbusDevice() {
   // First, try to find devices at different slave IDs with default settings
   Serial.println("\n📡 Phase 1: Scanning for device IDs (using default 9600 baud, 8N1)...");
   
-  Serial1.begin(9600, SERIAL_8N1, MODBUS_RX_PIN, MODBUS_TX_PIN);
+  rtuBegin(modbusBus, 9600, SERIAL_8N1);
   
   uint8_t foundSlaveIds[10]; // Store up to 10 found slave IDs
   int foundCount = 0;
   
   for (uint8_t id = 1; id <= 10 && foundCount < 10; id++) { // Quick scan first 10 IDs
-    modbus.begin(id, Serial1);
-    uint8_t result = modbus.readHoldingRegisters(0, 1);
+    uint8_t result = rtuProbe(modbusBus, id, rtuProbeTimeoutMs(modbusBus));
     
     if (result == modbus.ku8MBSuccess || result == modbus.ku8MBIllegalDataAddress) {
       Serial.printf("✅ Device found at Slave ID: %d\n", id);
-      setLEDStatus(LED_SUCCESS, false); // Brief success flash
+      ledFlash(LED_SUCCESS, 100); // Brief success flash; the renderer returns to scanning
       foundSlaveIds[foundCount++] = id;
-      delay(100);
-      setLEDStatus(LED_SCANNING); // Back to scanning
+      inventoryRemember(id, modbusBus);
     }
     delay(50);
   }
@@ -1052,19 +1162,31 @@ void detectModbusDevice() {
     uint8_t commonIds[] = {1, 2, 3, 247}; // Common slave IDs to test
     bool detected = false;
     uint32_t detectedBaud;
-    uint8_t detectedId;
+    uint32_t lineBaud = 0;      // Measured from another master's traffic, 0 = silent line
     
     for (int i = 0; i < 4 && !detected; i++) {
-      Serial.printf("\n--- Trying Slave ID %d ---\n", commonIds[i]);
-      if (autoDetectBaudRate(commonIds[i], &detectedBaud)) {
+      uint8_t id = commonIds[i];
+      Serial.printf("\n--- Trying Slave ID %d ---\n", id);
+      if (lineBaud == 0 && autoDetectBaudRate(id, &detectedBaud, &lineBaud)) {
         detected = true;
-        detectedId = commonIds[i];
-        foundSlaveIds[0] = detectedId;
-        foundCount = 1;
         
         // Phase 3: Auto-detect serial configuration
         Serial.println("\n📡 Phase 3: Auto-detecting serial configuration...");
-        autoDetectSerialConfig(detectedId, detectedBaud);
+        if (autoDetectSerialConfig(id, detectedBaud)) {
+          inventoryRemember(id, modbusBus);
+        }
+      } else if (lineBaud) {
+        // The bus rate is known from traffic, only the frame format can be off
+        Serial.printf("\n📡 Phase 3: Frame formats for Slave ID %d at %lu baud...\n", id, (unsigned long)lineBaud);
+        if (autoDetectSerialConfig(id, lineBaud)) {
+          detected = true;
+          detectedBaud = lineBaud;
+          inventoryRemember(id, modbusBus);
+        }
+      }
+      if (detected) {
+        foundSlaveIds[0] = id;
+        foundCount = 1;
       }
     }
     
@@ -1090,56 +1212,29 @@ void detectModbusDevice() {
     Serial.printf("\n--- Device Information (Slave ID: %d) ---\n", slaveId);
     modbus.begin(slaveId, Serial1);
     
-    // Check if this might be a TEC QRS11 Heat Pump
-    Serial.println("🔍 Checking for TEC QRS11 Heat Pump...");
-    
-    // Test a few key TEC registers to see if this is a heat pump
-    bool possibleTEC = false;
-    uint8_t tecTestResult = modbus.readInputRegisters(20, 1); // Unit State register
-    if (tecTestResult == modbus.ku8MBSuccess) {
-      uint16_t unitState = modbus.getResponseBuffer(0);
-      if (unitState >= 1 && unitState <= 9) {
-        possibleTEC = true;
-      }
-    }
-    
-    // Also test temperature register
-    if (!possibleTEC) {
-      tecTestResult = modbus.readInputRegisters(2, 1); // Outlet temperature
-      if (tecTestResult == modbus.ku8MBSuccess) {
-        uint16_t temp = modbus.getResponseBuffer(0);
-        if (temp > 0 && temp < 1000) { // Reasonable temperature range in 0.1°C
-          possibleTEC = true;
-        }
-      }
-    }
+    // Walk the fingerprint tree: a few single-address reads name a known device
+    Serial.println("🔍 Identifying device...");
+    FingerprintResult identity;
+    fingerprintIdentify(modbusBus, slaveId, &identity);
+    fingerprintPrintResult(identity);
+    const FingerprintProfile* profile = identity.profile >= 0 ? &fingerprintProfile(identity.profile) : nullptr;
     
-    if (possibleTEC) {
-      Serial.println("🎯 Possible TEC heat pump detected! Running detailed analysis...");
+    if (profile && (profile->inventoryFlags & INVENTORY_FLAG_TEC)) {
+      inventoryRemember(slaveId, modbusBus, INVENTORY_FLAG_TEC);
+      Serial.println("🎯 TEC heat pump detected! Running detailed analysis...");
       analyzeTECHeatPump(slaveId);
     } else {
-      Serial.println("📋 Standard Modbus device - reading common registers:");
-      
-      // Try holding registers 0-9
-      for (int reg = 0; reg < 10; reg++) {
-        uint8_t result = modbus.readHoldingRegisters(reg, 1);
-        if (result == modbus.ku8MBSuccess) {
-          uint16_t value = modbus.getResponseBuffer(0);
-          Serial.printf("  Holding Register %d: %d (0x%04X)\n", reg, value, value);
-        }
-        delay(50);
-      }
+      if (profile) inventoryRemember(slaveId, modbusBus, profile->inventoryFlags);
+      Serial.println("📋 Mapping the low address range:");
       
-      // Try input registers 0-4
-      Serial.println("📈 Input Registers:");
-      for (int reg = 0; reg < 5; reg++) {
-        uint8_t result = modbus.readInputRegisters(reg, 1);
-        if (result == modbus.ku8MBSuccess) {
-          uint16_t value = modbus.getResponseBuffer(0);
-          Serial.printf("  Input Register %d: %d (0x%04X)\n", reg, value, value);
-        }
-        delay(50);
-      }
+      // Quick map of the dense span only; option 11 searches all 65536 addresses
+      MapDiscoveryOptions options;
+      MapDiscoveryResult result;
+      mapDefaultOptions(&options);
+      options.lastAddress = options.firstAddress + options.denseSpan - 1;
+      discoverRegisterMap(modbusBus, slaveId, options, &result);
+      printRegisterMap(result);
+      Serial.println("💡 Use option 11 to map the full address space");
     }
   }
   
@@ -1147,5 +1242,8 @@ void detectModbusDevice() {
   Serial.println("\n" + String('=', 60));
   Serial.println("✅ DETECTION COMPLETE!");
   Serial.printf("Found %d device(s). Check output above for details.\n", foundCount);
+  if (inventoryFirstReadMs()) {
+    Serial.printf("⏱️  Boot to first successful read: %lu ms\n", inventoryFirstReadMs());
+  }
   Serial.println(String('=', 60));
 }
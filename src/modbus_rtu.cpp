@@ -0,0 +1,426 @@
+#include "modbus_rtu.h"
+#include "scanner.h"
+#include "bus_stats.h"
+#include <esp_timer.h>
+
+RtuBus modbusBus = {
+  &Serial1, MODBUS_RX_PIN, MODBUS_TX_PIN, MODBUS_DE_PIN,
+  0, SERIAL_8N1, 0, 0, 0, 0, nullptr, nullptr, nullptr, false, 0
+};
+
+#if MODBUS_BUS_COUNT > 1
+RtuBus modbusBus2 = {
+  &MODBUS2_PORT, MODBUS2_RX_PIN, MODBUS2_TX_PIN, MODBUS2_DE_PIN,
+  0, SERIAL_8N1, 0, 0, 0, 0, nullptr, nullptr, nullptr, false, 0
+};
+
+RtuBus* const rtuBuses[MODBUS_BUS_COUNT] = {&modbusBus, &modbusBus2};
+#else
+RtuBus* const rtuBuses[MODBUS_BUS_COUNT] = {&modbusBus};
+#endif
+
+SweepSettings sweepSettings = {
+  true,   // fastSweep
+  false,  // retryPass
+  20,     // minTurnaroundMs
+  300,    // slowTimeoutMs
+  500     // listenMs
+};
+
+uint8_t rtuBusCount() {
+  return MODBUS_BUS_COUNT;
+}
+
+uint8_t rtuBusNumber(const RtuBus& bus) {
+  for (uint8_t i = 0; i < MODBUS_BUS_COUNT; i++) {
+    if (rtuBuses[i] == &bus) return i + 1;
+  }
+  return 0;
+}
+
+void rtuLock(RtuBus& bus) {
+  if (bus.lock) xSemaphoreTakeRecursive(bus.lock, portMAX_DELAY);
+}
+
+void rtuUnlock(RtuBus& bus) {
+  if (bus.lock) xSemaphoreGiveRecursive(bus.lock);
+}
+
+// (Re)start the bus UART and remember the active line settings
+void rtuBegin(RtuBus& bus, uint32_t baud, uint32_t config) {
+  rtuLock(bus);
+  bus.port->begin(baud, config, bus.rxPin, bus.txPin);
+  bus.baud = baud;
+  bus.config = config;
+  if (bus.eventFraming) bus.port->setRxTimeout(rtuRxTimeoutSymbols(bus));
+  rtuUnlock(bus);
+}
+
+// Bits on the wire per character: start + data + parity + stop
+uint8_t rtuCharBits(uint32_t config) {
+  uint8_t dataBits = ((config >> 2) & 0x03) + 5;
+  uint8_t parityBits = (config & 0x03) ? 1 : 0;
+  uint8_t stopBits = ((config >> 4) & 0x03) == 0x03 ? 2 : 1;
+  return 1 + dataBits + parityBits + stopBits;
+}
+
+uint32_t rtuCharTimeUs(const RtuBus& bus) {
+  uint32_t baud = bus.baud > 0 ? bus.baud : MODBUS_BAUD;
+  return (rtuCharBits(bus.config) * 1000000UL + baud - 1) / baud;
+}
+
+// Silent interval t3.5 that separates RTU frames (fixed 1750 us above 19200 baud)
+uint32_t rtuFrameGapUs(const RtuBus& bus) {
+  if (bus.baud > 19200) return 1750;
+  return rtuCharTimeUs(bus) * 7 / 2;
+}
+
+// Response timeout for a reply of responseBytes: time on the wire, one frame
+// gap and a turnaround budget of twice the slowest device seen (or the
+// configured minimum until a device has answered).
+uint16_t rtuResponseTimeoutMs(const RtuBus& bus, uint16_t responseBytes) {
+  uint32_t turnaroundBudgetUs = max((uint32_t)(sweepSettings.minTurnaroundMs * 1000UL),
+                                    bus.turnaroundUs * 2);
+  uint32_t timeoutUs = responseBytes * rtuCharTimeUs(bus) + rtuFrameGapUs(bus) +
+                       turnaroundBudgetUs;
+  uint32_t timeoutMs = (timeoutUs + 999) / 1000 + 1; // +1 for millis() granularity
+  return timeoutMs < RTU_DEFAULT_TIMEOUT_MS ? timeoutMs : RTU_DEFAULT_TIMEOUT_MS;
+}
+
+// Timeout for a probe: derived in fast-sweep mode, ModbusMaster's 2 s otherwise
+uint16_t rtuProbeTimeoutMs(const RtuBus& bus) {
+  if (!sweepSettings.fastSweep) return RTU_DEFAULT_TIMEOUT_MS;
+  return rtuResponseTimeoutMs(bus, 7); // Slave, FC, count, 1 register, CRC
+}
+
+// Timeout for a read of `quantity` registers or bits, same rules as a probe
+uint16_t rtuReadTimeoutMs(const RtuBus& bus, uint8_t function, uint16_t quantity) {
+  if (!sweepSettings.fastSweep) return RTU_DEFAULT_TIMEOUT_MS;
+  bool bits = function == MB_FC_READ_COILS || function == MB_FC_READ_DISCRETE_INPUTS;
+  return rtuResponseTimeoutMs(bus, 5 + (bits ? (quantity + 7) / 8 : quantity * 2));
+}
+
+const char* rtuConfigName(uint32_t config) {
+  switch (config) {
+    case SERIAL_8N1: return "8N1";
+    case SERIAL_8N2: return "8N2";
+    case SERIAL_8E1: return "8E1";
+    case SERIAL_8E2: return "8E2";
+    case SERIAL_8O1: return "8O1";
+    case SERIAL_7E1: return "7E1";
+    case SERIAL_7O1: return "7O1";
+    default: return "custom";
+  }
+}
+
+// CRC of every byte value, reflected polynomial 0xA001. Kept in DRAM so a
+// lookup never waits on the flash cache.
+static DRAM_ATTR const uint16_t crcTable[256] = {
+  0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+  0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+  0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+  0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+  0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+  0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+  0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+  0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+  0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+  0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+  0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+  0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+  0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+  0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+  0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+  0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+  0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+  0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+  0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+  0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+  0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+  0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+  0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+  0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+  0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+  0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+  0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+  0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+  0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+  0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+  0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+  0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
+};
+
+// One table lookup per byte instead of eight shift/XOR steps
+uint16_t IRAM_ATTR rtuCrc16(const uint8_t* data, uint16_t length) {
+  uint16_t crc = 0xFFFF;
+  while (length--) {
+    crc = (crc >> 8) ^ crcTable[(crc ^ *data++) & 0xFF];
+  }
+  return crc;
+}
+
+// Bit by bit, as ModbusMaster's crc16_update(); the reference for the table
+uint16_t rtuCrc16Bitwise(const uint8_t* data, uint16_t length) {
+  uint16_t crc = 0xFFFF;
+  for (uint16_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+  }
+  return crc;
+}
+
+// Both CRCs over every length of a pseudo-random 256 byte buffer (bit-exact
+// check), then over repeated full frames of a 125 register reply for speed
+void rtuCrcBenchmark(RtuCrcBenchmark* result) {
+  static uint8_t buffer[256];
+  uint32_t seed = 0x12345678;
+  for (uint16_t i = 0; i < sizeof(buffer); i++) {
+    seed = seed * 1103515245 + 12345;
+    buffer[i] = seed >> 16;
+  }
+
+  result->mismatches = 0;
+  for (uint16_t length = 0; length <= sizeof(buffer); length++) {
+    if (rtuCrc16(buffer, length) != rtuCrc16Bitwise(buffer, length)) result->mismatches++;
+  }
+
+  const uint16_t frameBytes = 3 + RTU_MAX_READ_WORDS * 2;  // CRC'd part of the largest read reply
+  volatile uint16_t sink = 0;
+  uint32_t startUs = micros();
+  for (uint16_t i = 0; i < RTU_CRC_BENCH_FRAMES; i++) sink ^= rtuCrc16Bitwise(buffer, frameBytes);
+  result->bitwiseUs = micros() - startUs;
+  startUs = micros();
+  for (uint16_t i = 0; i < RTU_CRC_BENCH_FRAMES; i++) sink ^= rtuCrc16(buffer, frameBytes);
+  result->tableUs = micros() - startUs;
+  result->bytes = (uint32_t)RTU_CRC_BENCH_FRAMES * frameBytes;
+  (void)sink;
+}
+
+// t3.5 in whole characters, the unit of the UART's RX timeout
+uint8_t rtuRxTimeoutSymbols(const RtuBus& bus) {
+  uint32_t charUs = rtuCharTimeUs(bus);
+  return (rtuFrameGapUs(bus) + charUs - 1) / charUs;
+}
+
+bool rtuSetEventFraming(RtuBus& bus, bool enabled) {
+  rtuLock(bus);
+  if (enabled && !bus.rxEvent) bus.rxEvent = xSemaphoreCreateBinary();
+  bus.eventFraming = enabled && bus.rxEvent;
+  if (bus.eventFraming) {
+    SemaphoreHandle_t rxEvent = bus.rxEvent;
+    bus.port->onReceive([rxEvent]() { xSemaphoreGive(rxEvent); }, false);
+    bus.port->setRxTimeout(rtuRxTimeoutSymbols(bus));
+  } else {
+    bus.port->onReceive(nullptr);
+  }
+  rtuUnlock(bus);
+  return bus.eventFraming == enabled;
+}
+
+// Reply length once the header is in: an exception is 5 bytes, data replies
+// carry their byte count
+static uint16_t replyLength(const uint8_t* response, uint16_t length) {
+  if (length < 3 || (response[1] & 0x80)) return 5;
+  return 3 + response[2] + 2;
+}
+
+static uint8_t receivePolled(RtuBus& bus, uint8_t* response, uint16_t size, uint16_t* length,
+                             uint32_t* firstByteUs, uint16_t timeoutMs) {
+  Stream* port = bus.port;
+  unsigned long startMs = millis();
+  uint16_t expected = 5;
+
+  while (*length < expected) {
+    if (port->available()) {
+      if (*length == 0) *firstByteUs = micros();
+      response[(*length)++] = port->read();
+      if (*length == 3) {
+        expected = replyLength(response, *length);
+        if (expected > size) return ModbusMaster::ku8MBInvalidCRC; // Garbage byte count
+      }
+    } else {
+      if (millis() - startMs > timeoutMs) return ModbusMaster::ku8MBResponseTimedOut;
+      bus.lastWakeups++;
+      if (bus.idle) bus.idle();
+    }
+  }
+  return ModbusMaster::ku8MBSuccess;
+}
+
+// Sleep on RX events. A complete reply of the expected length fires the FIFO
+// threshold on its last byte; anything else (an exception, garbage, a reply
+// of another length) ends when the RX timeout sees t3.5 of silence. An event
+// that brought fewer bytes than the threshold can only be that timeout.
+// The first byte's arrival is not observed, so it is worked back from the
+// end of the frame for the turnaround measurement.
+static uint8_t receiveEvents(RtuBus& bus, uint8_t* response, uint16_t size, uint16_t* length,
+                             uint32_t* firstByteUs, uint16_t timeoutMs, uint8_t threshold) {
+  Stream* port = bus.port;
+  unsigned long startMs = millis();
+  uint32_t charUs = rtuCharTimeUs(bus);
+
+  for (;;) {
+    // Wake at least every 10 ms so the idle hook keeps running
+    unsigned long waitedMs = millis() - startMs;
+    if (waitedMs > timeoutMs) return ModbusMaster::ku8MBResponseTimedOut;
+    uint32_t sliceMs = min((uint32_t)(timeoutMs - waitedMs + 1), (uint32_t)10);
+    if (xSemaphoreTake(bus.rxEvent, pdMS_TO_TICKS(sliceMs)) != pdTRUE) {
+      if (bus.idle) bus.idle();
+      continue;
+    }
+    bus.lastWakeups++;
+
+    uint32_t eventUs = micros();
+    uint16_t before = *length;
+    while (port->available() && *length < size) response[(*length)++] = port->read();
+    uint16_t arrived = *length - before;
+    uint16_t expected = replyLength(response, *length);
+
+    bool idle = arrived < threshold;
+    if (*length >= expected) {
+      uint32_t lastByteUs = idle ? eventUs - rtuRxTimeoutSymbols(bus) * charUs : eventUs;
+      *firstByteUs = lastByteUs - (*length - 1) * charUs;
+      return *length == expected ? ModbusMaster::ku8MBSuccess : ModbusMaster::ku8MBInvalidCRC;
+    }
+    if (*length > 0 && idle) {
+      return ModbusMaster::ku8MBInvalidCRC; // The line went idle inside the frame
+    }
+    if (*length >= size) return ModbusMaster::ku8MBInvalidCRC;
+  }
+}
+
+static uint8_t readRequest(RtuBus& bus, uint8_t slaveId, uint8_t function,
+                           uint16_t address, uint16_t quantity, uint16_t* dst,
+                           uint16_t timeoutMs) {
+  if (bus.baud == 0) {
+    rtuBegin(bus, MODBUS_BAUD, SERIAL_8N1);
+  }
+
+  HardwareSerial* port = bus.port;
+  uint8_t frame[8];
+  frame[0] = slaveId;
+  frame[1] = function;
+  frame[2] = highByte(address);
+  frame[3] = lowByte(address);
+  frame[4] = highByte(quantity);
+  frame[5] = lowByte(quantity);
+  uint16_t crc = rtuCrc16(frame, 6);
+  frame[6] = lowByte(crc);
+  frame[7] = highByte(crc);
+
+  bool bits = function == MB_FC_READ_COILS || function == MB_FC_READ_DISCRETE_INPUTS;
+  uint16_t byteCount = bits ? (quantity + 7) / 8 : quantity * 2;
+  uint8_t threshold = min((uint32_t)(3 + byteCount + 2), (uint32_t)RTU_EVENT_FIFO_MAX);
+
+  // Drop anything left over from a previous (late) response
+  while (port->available()) port->read();
+  if (bus.eventFraming) {
+    port->setRxFIFOFull(threshold - 1); // The interrupt fires on more than this many bytes
+    xSemaphoreTake(bus.rxEvent, 0); // Stale event from that response
+  }
+
+  if (bus.dePin >= 0) digitalWrite(bus.dePin, HIGH);
+  port->write(frame, sizeof(frame));
+  port->flush();
+  if (bus.dePin >= 0) digitalWrite(bus.dePin, LOW);
+
+  uint32_t txDoneUs = micros();
+  uint32_t firstByteUs = 0;
+
+  // Largest reply: slave, FC, byte count, 250 data bytes, CRC
+  uint8_t response[3 + RTU_MAX_READ_WORDS * 2 + 2];
+  uint16_t length = 0;
+  bus.lastWakeups = 0;
+  bus.lastTurnaroundUs = 0;
+  uint8_t status = bus.eventFraming
+      ? receiveEvents(bus, response, sizeof(response), &length, &firstByteUs, timeoutMs, threshold)
+      : receivePolled(bus, response, sizeof(response), &length, &firstByteUs, timeoutMs);
+  bus.lastRxBytes = length;
+  if (status != ModbusMaster::ku8MBSuccess) return status;
+
+  uint16_t receivedCrc = response[length - 2] | (response[length - 1] << 8);
+  if (rtuCrc16(response, length - 2) != receivedCrc) {
+    return ModbusMaster::ku8MBInvalidCRC;
+  }
+  if (response[0] != slaveId) {
+    // A valid frame from another slave: usually a late reply to an earlier probe
+    bus.strayResponseSlave = response[0];
+    return ModbusMaster::ku8MBInvalidSlaveID;
+  }
+  if ((response[1] & 0x7F) != function) {
+    return ModbusMaster::ku8MBInvalidFunction;
+  }
+
+  // Turnaround: time between our last stop bit and the slave's first character
+  uint32_t turnaroundUs = firstByteUs - txDoneUs;
+  uint32_t charUs = rtuCharTimeUs(bus);
+  turnaroundUs = turnaroundUs > charUs ? turnaroundUs - charUs : 0;
+  bus.lastTurnaroundUs = turnaroundUs;
+  if (turnaroundUs > bus.turnaroundUs) {
+    bus.turnaroundUs = turnaroundUs;
+  }
+
+  if (response[1] & 0x80) {
+    return response[2]; // Modbus exception code
+  }
+
+  // A byte count that does not fit the request means this is a late reply
+  // to an earlier request that had already timed out
+  if (response[2] != byteCount) {
+    return ModbusMaster::ku8MBInvalidCRC;
+  }
+
+  if (dst) {
+    const uint8_t* data = response + 3;
+    if (bits) {
+      for (uint16_t i = 0; i < byteCount; i += 2) {
+        uint16_t word = data[i];
+        if (i + 1 < byteCount) word |= data[i + 1] << 8;
+        dst[i / 2] = word;
+      }
+    } else {
+      for (uint16_t i = 0; i < byteCount / 2; i++) {
+        dst[i] = (data[i * 2] << 8) | data[i * 2 + 1];
+      }
+    }
+  }
+
+  return ModbusMaster::ku8MBSuccess;
+}
+
+// Send a read request (FC 0x01-0x04) and wait up to timeoutMs for the reply.
+// Register values land in dst as words; coil/input bits are packed 16 per
+// word, LSB first, the same layout as ModbusMaster's response buffer.
+uint8_t rtuReadRequest(RtuBus& bus, uint8_t slaveId, uint8_t function,
+                       uint16_t address, uint16_t quantity, uint16_t* dst,
+                       uint16_t timeoutMs) {
+  rtuLock(bus);
+  int64_t startUs = esp_timer_get_time();
+  uint8_t result = readRequest(bus, slaveId, function, address, quantity, dst, timeoutMs);
+  // Every read request is 8 bytes on the wire
+  busStatsRecord(bus, slaveId, function, result, (uint32_t)(esp_timer_get_time() - startUs),
+                 8, bus.lastRxBytes, bus.lastTurnaroundUs);
+  rtuUnlock(bus);
+  return result;
+}
+
+uint8_t rtuProbe(RtuBus& bus, uint8_t slaveId, uint16_t timeoutMs) {
+  uint16_t value;
+  return rtuReadRequest(bus, slaveId, MB_FC_READ_HOLDING_REGISTERS, 0, 1, &value, timeoutMs);
+}
+
+void rtuDrain(RtuBus& bus, uint16_t quietMs) {
+  rtuLock(bus);
+  unsigned long quietSince = millis();
+  while (millis() - quietSince < quietMs) {
+    if (bus.port->available()) {
+      bus.port->read();
+      quietSince = millis();
+    } else if (bus.idle) {
+      bus.idle();
+    }
+  }
+  rtuUnlock(bus);
+}
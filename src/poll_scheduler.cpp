@@ -0,0 +1,318 @@
+#include "poll_scheduler.h"
+#include "bus_task.h"
+#include "read_cache.h"
+#include "read_planner.h"
+#include "scanner.h"
+#include "stream_output.h"
+#include "change_report.h"
+#include "history.h"
+
+static PollPoint points[POLL_MAX_POINTS];
+static uint8_t pointCount = 0;
+static bool active = false;
+static bool inFlight[MODBUS_BUS_COUNT];   // One read per bus, so every pick sees the latest deadlines
+static uint8_t busesInUse = 0;
+static bool showValues = false;
+static PollSampleHandler sampleHandler = nullptr;
+
+static PollWindow window;
+static PollWindow totals;
+
+// millis() comparison that survives the 49 day wrap
+static bool reached(unsigned long now, unsigned long when) {
+  return (long)(now - when) >= 0;
+}
+
+void pollClear() {
+  pollStop();
+  pointCount = 0;
+}
+
+int pollAddPoint(uint8_t slaveId, uint8_t table, uint16_t address, uint16_t count, uint32_t periodMs,
+                 uint8_t bus) {
+  bool bits = table == MAP_COILS || table == MAP_DISCRETE_INPUTS;
+  if (pointCount >= POLL_MAX_POINTS || table >= MAP_TABLE_COUNT || periodMs == 0) return -1;
+  if (bus >= rtuBusCount()) return -1;
+  if (count == 0 || count > (bits ? RTU_MAX_READ_BITS : RTU_MAX_READ_WORDS)) return -1;
+
+  PollPoint& point = points[pointCount];
+  memset(&point, 0, sizeof(point));
+  point.bus = bus;
+  point.slaveId = slaveId;
+  point.table = table;
+  point.address = address;
+  point.count = count;
+  point.periodMs = periodMs;
+  return pointCount++;
+}
+
+bool pollSetDeadband(uint8_t index, uint16_t deadband, bool percent) {
+  if (index >= pointCount || (percent && deadband > 100)) return false;
+  points[index].deadband = deadband;
+  points[index].deadbandPercent = percent;
+  return true;
+}
+
+uint8_t pollPointCount() {
+  return pointCount;
+}
+
+const PollPoint* pollPoints() {
+  return points;
+}
+
+void pollSetSampleHandler(PollSampleHandler handler) {
+  sampleHandler = handler;
+}
+
+// Expected bus time of one read of this point at the current line settings
+uint32_t pollEstimateUs(const RtuBus& bus, const PollPoint& point) {
+  bool bits = point.table == MAP_COILS || point.table == MAP_DISCRETE_INPUTS;
+  uint16_t dataBytes = bits ? (point.count + 7) / 8 : point.count * 2;
+  return planTransactionOverheadUs(bus) + dataBytes * rtuCharTimeUs(bus);
+}
+
+// Sum of read time over period for all points; above 1.0 the bus cannot keep up
+float pollPredictedUtilisation(const RtuBus& bus) {
+  float utilisation = 0;
+  for (uint8_t i = 0; i < pointCount; i++) {
+    if (rtuBuses[points[i].bus] != &bus) continue;
+    utilisation += pollEstimateUs(bus, points[i]) / (points[i].periodMs * 1000.0f);
+  }
+  return utilisation;
+}
+
+static void resetWindow(PollWindow& w, unsigned long now) {
+  memset(&w, 0, sizeof(w));
+  w.startMs = now;
+}
+
+static void printWindow(const char* label, const PollWindow& w, unsigned long now) {
+  unsigned long spanMs = now - w.startMs;
+  uint8_t buses = busesInUse > 0 ? busesInUse : 1;
+  float busy = spanMs > 0 ? w.busyUs / (spanMs * 10.0f * buses) : 0; // percent, average per bus
+  Serial.printf("📊 %s %.1f s: %lu reads, %s %.1f%% busy, %lu deadline misses, %lu failures\n",
+                label, spanMs / 1000.0f, (unsigned long)w.reads, buses > 1 ? "buses" : "bus", busy,
+                (unsigned long)w.misses, (unsigned long)w.failures);
+}
+
+static void printPollControls() {
+  Serial.println("⌨️  Poll controls: s = statistics, v = show values, c = changes only, h = history, q = stop");
+}
+
+void pollStart() {
+  if (pointCount == 0) {
+    Serial.println("❌ No poll points configured");
+    return;
+  }
+
+  unsigned long now = millis();
+  bool used[MODBUS_BUS_COUNT] = {};
+  for (uint8_t i = 0; i < pointCount; i++) {
+    PollPoint& point = points[i];
+    used[point.bus] = true;
+    point.pending = false;
+    point.nextReleaseMs = now;
+    point.reads = point.failures = point.misses = point.maxLatenessMs = 0;
+  }
+  resetWindow(window, now);
+  resetWindow(totals, now);
+  changeBegin(points, pointCount);
+  historyBegin(points, pointCount);
+  memset(inFlight, 0, sizeof(inFlight));
+  active = true;
+
+  busesInUse = 0;
+  Serial.printf("\n⏱️  Polling %d point(s)\n", pointCount);
+  for (uint8_t b = 0; b < MODBUS_BUS_COUNT; b++) {
+    if (!used[b]) continue;
+    busesInUse++;
+    const RtuBus& bus = *rtuBuses[b];
+    float utilisation = pollPredictedUtilisation(bus);
+    Serial.printf("   Bus %d at %lu baud %s: predicted utilisation %.1f%%", b + 1,
+                  (unsigned long)bus.baud, rtuConfigName(bus.config), utilisation * 100);
+    if (utilisation > 0) Serial.printf(" (room for about %.1fx this load)", 1.0f / utilisation);
+    Serial.println();
+    if (utilisation > 1.0f) {
+      Serial.println("   ⚠️  More work than the bus can carry - expect deadline misses");
+    }
+  }
+  printPollControls();
+  ledStatusMessage(LED_CONNECTING, "Polling...");
+}
+
+void pollStop() {
+  if (!active) return;
+  active = false;
+  unsigned long now = millis();
+  Serial.println("\n⏹️  Polling stopped");
+  printWindow("Total", totals, now);
+  pollPrintStats();
+  ledStatusMessage(LED_READY, "Polling stopped");
+  Serial.println("\n" + String('-', 40));
+  showMainMenu();
+}
+
+bool pollActive() {
+  return active;
+}
+
+// Release due points; a point still pending when its next release comes
+// has missed a whole period and is moved on to the new one
+static void releasePoints(unsigned long now) {
+  for (uint8_t i = 0; i < pointCount; i++) {
+    PollPoint& point = points[i];
+    while (reached(now, point.nextReleaseMs)) {
+      if (point.pending) {
+        point.misses++;
+        window.misses++;
+        totals.misses++;
+      }
+      point.pending = true;
+      point.releaseMs = point.nextReleaseMs;
+      point.nextReleaseMs += point.periodMs;
+    }
+  }
+}
+
+static int earliestDeadline(uint8_t bus) {
+  int best = -1;
+  for (uint8_t i = 0; i < pointCount; i++) {
+    if (!points[i].pending || points[i].bus != bus) continue;
+    if (best < 0 || (long)((points[i].releaseMs + points[i].periodMs) -
+                           (points[best].releaseMs + points[best].periodMs)) < 0) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+static void printValues(const PollPoint& point, const uint16_t* values) {
+  bool bits = point.table == MAP_COILS || point.table == MAP_DISCRETE_INPUTS;
+  Serial.printf("   [%d] %s %u:", point.slaveId, mapTableName(point.table), point.address);
+  uint16_t shown = min(point.count, (uint16_t)8);
+  for (uint16_t i = 0; i < shown; i++) {
+    if (bits) {
+      Serial.printf(" %d", (values[i / 16] >> (i % 16)) & 1);
+    } else {
+      Serial.printf(" %u", values[i]);
+    }
+  }
+  Serial.println(point.count > shown ? " ..." : "");
+}
+
+static void onReadDone(const BusResult& result) {
+  uint8_t bus = rtuBusNumber(result.request.bus ? *result.request.bus : modbusBus);
+  if (bus > 0) inFlight[bus - 1] = false;
+  if (!active || result.request.tag >= pointCount) return;
+  PollPoint& point = points[result.request.tag];
+
+  point.lastDurationUs = result.durationUs;
+  point.lastStatus = result.status;
+  point.reads++;
+  window.reads++;
+  totals.reads++;
+  window.busyUs += result.durationUs;
+  totals.busyUs += result.durationUs;
+
+  unsigned long deadlineMs = point.releaseMs + point.periodMs;
+  if (!reached(deadlineMs, result.completedMs)) {
+    point.misses++;
+    window.misses++;
+    totals.misses++;
+    point.maxLatenessMs = max(point.maxLatenessMs, (uint32_t)(result.completedMs - deadlineMs));
+  }
+
+  if (result.status == ModbusMaster::ku8MBSuccess) {
+    historySample(point, result.values);
+    if (sampleHandler) sampleHandler(point, result.values);
+    if (changeEnabled()) {
+      changeReport(result.request.tag, point, result.values);
+    } else if (streamBinary()) {
+      streamRecord(point.bus + 1, point.slaveId, point.table, point.address, point.count, result.values);
+    } else if (showValues) {
+      printValues(point, result.values);
+    }
+  } else {
+    point.failures++;
+    window.failures++;
+    totals.failures++;
+  }
+}
+
+// Hand each idle bus task the most urgent released point on its bus;
+// called from loop() on every pass while polling
+void pollTick() {
+  if (!active) return;
+
+  unsigned long now = millis();
+  releasePoints(now);
+
+  if (reached(now, window.startMs + POLL_REPORT_MS)) {
+    printWindow("Window", window, now);
+    resetWindow(window, now);
+  }
+
+  for (uint8_t bus = 0; bus < MODBUS_BUS_COUNT; bus++) {
+    if (inFlight[bus]) continue;
+    int index = earliestDeadline(bus);
+    if (index < 0) continue;
+    PollPoint& point = points[index];
+
+    BusRequest request = {};
+    request.bus = rtuBuses[bus];
+    request.slaveId = point.slaveId;
+    request.function = point.table + 1;
+    request.address = point.address;
+    request.quantity = point.count;
+    request.retry = true;
+    request.maxAgeMs = point.periodMs / 2;   // A cached value this young still counts for this period
+    request.tag = index;
+    request.callback = onReadDone;
+    if (busSubmit(request)) {
+      point.pending = false;
+      inFlight[bus] = true;
+    }
+  }
+}
+
+void pollPrintStats() {
+  Serial.println("\n  #  bus  slave table  address  count  period   est ms  reads  fail  miss  late ms  dband");
+  for (uint8_t i = 0; i < pointCount; i++) {
+    const PollPoint& point = points[i];
+    char deadband[8];
+    snprintf(deadband, sizeof(deadband), "%u%s", point.deadband, point.deadbandPercent ? "%" : "");
+    Serial.printf("%3d  %3d  %5d  %4s  %7u  %5u  %6lu  %7.1f  %5lu  %4lu  %4lu  %7lu  %5s\n", i, point.bus + 1,
+                  point.slaveId, mapTableName(point.table), point.address, point.count,
+                  (unsigned long)point.periodMs, pollEstimateUs(*rtuBuses[point.bus], point) / 1000.0f,
+                  (unsigned long)point.reads, (unsigned long)point.failures,
+                  (unsigned long)point.misses, (unsigned long)point.maxLatenessMs, deadband);
+  }
+  if (active) printWindow("Total", totals, millis());
+  if (changeEnabled()) changePrintStats();
+}
+
+PollWindow pollTotals() {
+  return totals;
+}
+
+bool pollHandleCommand(const String& input) {
+  if (!active) return false;
+
+  if (input == "q") {
+    pollStop();
+  } else if (input == "s") {
+    pollPrintStats();
+  } else if (input == "v") {
+    showValues = !showValues;
+    Serial.printf("Values %s\n", showValues ? "shown" : "hidden");
+  } else if (input == "h") {
+    historyPrint();
+  } else if (input == "c") {
+    changeSetEnabled(!changeEnabled());
+    Serial.printf("Change reporting %s\n", changeEnabled() ? "on: only values beyond the deadband" : "off");
+  } else {
+    printPollControls();
+  }
+  return true;
+}
@@ -0,0 +1,386 @@
+#include "read_cache.h"
+#include "register_map.h"
+
+CacheSettings cacheSettings = {
+  true,    // enabled
+  1000     // defaultTtlMs
+};
+
+struct CacheBlock {
+  bool used;
+  uint8_t slaveId;
+  uint8_t table;
+  uint16_t first;
+  uint16_t count;
+  uint32_t ttlMs;             // Shortest TTL of its points
+  unsigned long storedMs;
+  unsigned long usedMs;       // Last stored or hit; the least recent is evicted
+  uint16_t values[RTU_MAX_READ_WORDS];
+};
+
+struct CacheBus {
+  CacheBlock blocks[CACHE_BLOCKS_PER_BUS];
+  CacheStats stats;
+};
+
+// A queued request others can merge into, and one that did
+struct CacheLeader {
+  bool used;
+  BusRequest request;
+};
+
+struct CacheFollower {
+  bool used;
+  uint8_t leader;
+  BusRequest request;
+};
+
+static CacheBus buses[MODBUS_BUS_COUNT];
+static CacheTtlRule rules[CACHE_MAX_RULES];
+static CacheLeader leaders[CACHE_MAX_LEADERS];
+static CacheFollower followers[CACHE_MAX_FOLLOWERS];
+
+static bool bitTable(uint8_t table) {
+  return table == MAP_COILS || table == MAP_DISCRETE_INPUTS;
+}
+
+static bool readFunction(uint8_t function) {
+  return function >= MB_FC_READ_COILS && function <= MB_FC_READ_INPUT_REGISTERS;
+}
+
+static uint16_t wordCount(uint8_t table, uint16_t quantity) {
+  return bitTable(table) ? (quantity + 15) / 16 : quantity;
+}
+
+static CacheBus& stateFor(const RtuBus& bus) {
+  return buses[rtuBusNumber(bus) - 1];
+}
+
+// quantity values from address out of a reply that started at first
+static void extract(const uint16_t* values, uint16_t first, uint8_t table, uint16_t address, uint16_t quantity,
+                    uint16_t* dst) {
+  uint16_t offset = address - first;
+  if (!bitTable(table)) {
+    memcpy(dst, values + offset, quantity * sizeof(uint16_t));
+    return;
+  }
+  memset(dst, 0, wordCount(table, quantity) * sizeof(uint16_t));
+  for (uint16_t i = 0; i < quantity; i++) {
+    uint16_t bit = offset + i;
+    if ((values[bit / 16] >> (bit % 16)) & 1) dst[i / 16] |= 1 << (i % 16);
+  }
+}
+
+// ---- TTL rules ---------------------------------------------------------------
+
+static bool ruleApplies(const CacheTtlRule& rule, uint8_t bus, uint8_t slaveId, uint8_t table) {
+  return rule.bus == bus && (rule.slaveId == 0 || rule.slaveId == slaveId) && rule.table == table;
+}
+
+// Shortest TTL of the points first..last: the rules that overlap them, and
+// the default when some point has no rule
+static uint32_t ttlFor(uint8_t bus, uint8_t slaveId, uint8_t table, uint16_t first, uint16_t last) {
+  uint32_t ttlMs = CACHE_ANY_AGE;
+  for (const CacheTtlRule& rule : rules) {
+    if (ruleApplies(rule, bus, slaveId, table) && rule.first <= last && rule.last >= first) {
+      ttlMs = min(ttlMs, rule.ttlMs);
+    }
+  }
+
+  // Walk the range along the rules; a gap leaves points on the default
+  uint32_t next = first;
+  while (next <= last) {
+    uint32_t reach = 0;
+    for (const CacheTtlRule& rule : rules) {
+      if (ruleApplies(rule, bus, slaveId, table) && rule.first <= next && rule.last >= next) {
+        reach = max(reach, (uint32_t)rule.last + 1);
+      }
+    }
+    if (reach == 0) return min(ttlMs, cacheSettings.defaultTtlMs);
+    next = reach;
+  }
+  return ttlMs;
+}
+
+bool cacheSetTtl(uint8_t slaveId, uint8_t table, uint16_t first, uint16_t last, uint32_t ttlMs, RtuBus& bus) {
+  uint8_t busNumber = rtuBusNumber(bus);
+  if (busNumber == 0 || table >= MAP_TABLE_COUNT || last < first) return false;
+  CacheTtlRule* slot = nullptr;
+  for (CacheTtlRule& rule : rules) {
+    if (rule.bus == busNumber && rule.slaveId == slaveId && rule.table == table && rule.first == first &&
+        rule.last == last) {
+      slot = &rule;
+      break;
+    }
+    if (rule.bus == 0 && !slot) slot = &rule;
+  }
+  if (!slot) return false;
+  *slot = {busNumber, slaveId, table, first, last, ttlMs};
+
+  // Blocks were stored with the old TTLs
+  cacheClear();
+  return true;
+}
+
+void cacheClearRules() {
+  memset(rules, 0, sizeof(rules));
+  cacheClear();
+}
+
+const CacheTtlRule* cacheRule(uint8_t index) {
+  for (const CacheTtlRule& rule : rules) {
+    if (rule.bus != 0 && index-- == 0) return &rule;
+  }
+  return nullptr;
+}
+
+// ---- Blocks ------------------------------------------------------------------
+
+static bool fresh(const CacheBlock& block, unsigned long now, uint32_t maxAgeMs) {
+  uint32_t ageMs = now - block.storedMs;
+  return block.used && ageMs < block.ttlMs && ageMs <= maxAgeMs;
+}
+
+bool cacheLookup(RtuBus& bus, uint8_t slaveId, uint8_t function, uint16_t address, uint16_t quantity,
+                 uint16_t* dst, uint32_t maxAgeMs) {
+  if (!cacheSettings.enabled || !readFunction(function) || quantity == 0) return false;
+  CacheBus& state = stateFor(bus);
+  uint8_t table = function - 1;
+  uint32_t end = (uint32_t)address + quantity;
+  unsigned long now = millis();
+
+  // The exact range if it is there, else any block around it
+  CacheBlock* found = nullptr;
+  for (CacheBlock& block : state.blocks) {
+    if (!fresh(block, now, maxAgeMs) || block.slaveId != slaveId || block.table != table ||
+        block.first > address || (uint32_t)block.first + block.count < end) {
+      continue;
+    }
+    found = &block;
+    if (block.first == address && block.count == quantity) break;
+  }
+  if (!found) {
+    state.stats.misses++;
+    return false;
+  }
+
+  extract(found->values, found->first, table, address, quantity, dst);
+  found->usedMs = now;
+  if (found->first == address && found->count == quantity) {
+    state.stats.hits++;
+  } else {
+    state.stats.coveredHits++;
+  }
+  return true;
+}
+
+void cacheStore(RtuBus& bus, uint8_t slaveId, uint8_t function, uint16_t address, uint16_t quantity,
+                const uint16_t* values) {
+  if (!cacheSettings.enabled || !readFunction(function) || quantity == 0) return;
+  uint8_t table = function - 1;
+  uint32_t end = (uint32_t)address + quantity;
+  uint32_t ttlMs = ttlFor(rtuBusNumber(bus), slaveId, table, address, end - 1);
+  if (ttlMs == 0) return;
+
+  // Expired blocks and older copies inside the new one make room first
+  CacheBus& state = stateFor(bus);
+  unsigned long now = millis();
+  CacheBlock* slot = nullptr;
+  for (CacheBlock& block : state.blocks) {
+    if (block.used && (!fresh(block, now, CACHE_ANY_AGE) ||
+                       (block.slaveId == slaveId && block.table == table && block.first >= address &&
+                        (uint32_t)block.first + block.count <= end))) {
+      block.used = false;
+    }
+    if (!block.used && !slot) slot = &block;
+  }
+  if (!slot) {
+    for (CacheBlock& block : state.blocks) {
+      if (!slot || (long)(block.usedMs - slot->usedMs) < 0) slot = &block;
+    }
+    state.stats.evictions++;
+  }
+
+  slot->used = true;
+  slot->slaveId = slaveId;
+  slot->table = table;
+  slot->first = address;
+  slot->count = quantity;
+  slot->ttlMs = ttlMs;
+  slot->storedMs = now;
+  slot->usedMs = now;
+  memcpy(slot->values, values, wordCount(table, quantity) * sizeof(uint16_t));
+  state.stats.stores++;
+}
+
+uint8_t cacheRead(RtuBus& bus, uint8_t slaveId, uint8_t function, uint16_t address, uint16_t quantity,
+                  uint16_t* dst, uint16_t timeoutMs, uint32_t maxAgeMs, RetryOutcome* outcome) {
+  RetryOutcome local;
+  if (!outcome) outcome = &local;
+
+  // Looking only once the lock is ours lets a read of the same registers
+  // that held it answer this one
+  rtuLock(bus);
+  uint8_t result = ModbusMaster::ku8MBSuccess;
+  if (cacheLookup(bus, slaveId, function, address, quantity, dst, maxAgeMs)) {
+    outcome->attempts = 0;
+    outcome->timeouts = 0;
+  } else {
+    result = retryRead(bus, slaveId, function, address, quantity, dst, timeoutMs, outcome);
+    if (result == ModbusMaster::ku8MBSuccess) cacheStore(bus, slaveId, function, address, quantity, dst);
+  }
+  rtuUnlock(bus);
+  return result;
+}
+
+void cacheClear() {
+  for (uint8_t i = 0; i < rtuBusCount(); i++) {
+    rtuLock(*rtuBuses[i]);
+    for (CacheBlock& block : buses[i].blocks) block.used = false;
+    rtuUnlock(*rtuBuses[i]);
+  }
+}
+
+// ---- In-flight merging ---------------------------------------------------------
+
+static RtuBus* busOf(const BusRequest& request) {
+  return request.bus ? request.bus : &modbusBus;
+}
+
+static bool sameRead(const BusRequest& a, const BusRequest& b) {
+  return busOf(a) == busOf(b) && a.slaveId == b.slaveId && a.function == b.function && a.address == b.address &&
+         a.quantity == b.quantity && a.maxAgeMs == b.maxAgeMs && a.retry == b.retry;
+}
+
+// The leader's reply answers the follower: its range covers the follower's,
+// its values are at least as young and it retries if the follower would
+static bool answers(const BusRequest& leader, const BusRequest& follower) {
+  return busOf(leader) == busOf(follower) && leader.slaveId == follower.slaveId &&
+         leader.function == follower.function && leader.address <= follower.address &&
+         (uint32_t)leader.address + leader.quantity >= (uint32_t)follower.address + follower.quantity &&
+         leader.maxAgeMs <= follower.maxAgeMs && (leader.retry || !follower.retry);
+}
+
+bool cacheJoin(const BusRequest& request) {
+  if (!cacheSettings.enabled || request.maxAgeMs == 0 || !readFunction(request.function)) return false;
+  int leader = -1;
+  for (uint8_t i = 0; i < CACHE_MAX_LEADERS && leader < 0; i++) {
+    if (leaders[i].used && answers(leaders[i].request, request)) leader = i;
+  }
+  if (leader < 0) return false;
+
+  for (CacheFollower& follower : followers) {
+    if (follower.used) continue;
+    follower.used = true;
+    follower.leader = leader;
+    follower.request = request;
+    stateFor(*busOf(request)).stats.joined++;
+    return true;
+  }
+  return false;
+}
+
+void cacheLead(const BusRequest& request) {
+  if (!cacheSettings.enabled || request.maxAgeMs == 0 || !readFunction(request.function)) return;
+  // One leader per read: a twin queued while the followers were full
+  // releases them when its reply comes first, which is just as young
+  for (const CacheLeader& leader : leaders) {
+    if (leader.used && sameRead(leader.request, request)) return;
+  }
+  for (CacheLeader& leader : leaders) {
+    if (leader.used) continue;
+    leader.used = true;
+    leader.request = request;
+    return;
+  }
+}
+
+uint8_t cacheRelease(const BusResult& result) {
+  if (result.request.maxAgeMs == 0) return 0;
+  int leader = -1;
+  for (uint8_t i = 0; i < CACHE_MAX_LEADERS && leader < 0; i++) {
+    if (leaders[i].used && sameRead(leaders[i].request, result.request)) leader = i;
+  }
+  if (leader < 0) return 0;
+  leaders[leader].used = false;
+
+  // Collected first: callbacks submit again and may reuse the slots
+  uint8_t waiting[CACHE_MAX_FOLLOWERS];
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < CACHE_MAX_FOLLOWERS; i++) {
+    if (followers[i].used && followers[i].leader == leader) waiting[count++] = i;
+  }
+
+  static BusResult copy;
+  for (uint8_t i = 0; i < count; i++) {
+    CacheFollower& follower = followers[waiting[i]];
+    copy.request = follower.request;
+    follower.used = false;
+    copy.status = result.status;
+    copy.durationUs = 0;
+    copy.completedMs = result.completedMs;
+    copy.rxBytes = 0;
+    copy.straySlave = 0;
+    copy.cached = true;
+    if (result.status == ModbusMaster::ku8MBSuccess) {
+      extract(result.values, result.request.address, copy.request.function - 1, copy.request.address,
+              copy.request.quantity, copy.values);
+    }
+    if (copy.request.callback) copy.request.callback(copy);
+  }
+  return count;
+}
+
+// ---- Statistics ----------------------------------------------------------------
+
+const CacheStats& cacheStats(const RtuBus& bus) {
+  return stateFor(bus).stats;
+}
+
+float cacheHitRate(const RtuBus& bus) {
+  const CacheStats& stats = cacheStats(bus);
+  uint32_t answered = stats.hits + stats.coveredHits + stats.joined;
+  uint32_t requests = answered + stats.misses;
+  return requests ? 100.0f * answered / requests : 0;
+}
+
+void cacheResetStats() {
+  for (uint8_t i = 0; i < rtuBusCount(); i++) {
+    rtuLock(*rtuBuses[i]);
+    memset(&buses[i].stats, 0, sizeof(buses[i].stats));
+    rtuUnlock(*rtuBuses[i]);
+  }
+}
+
+void cachePrintStats() {
+  Serial.printf("🗃️  Read cache: %s, default TTL %lu ms\n", cacheSettings.enabled ? "on" : "off",
+                (unsigned long)cacheSettings.defaultTtlMs);
+  for (const CacheTtlRule& rule : rules) {
+    if (rule.bus == 0) continue;
+    char slave[8];
+    snprintf(slave, sizeof(slave), rule.slaveId ? "%d" : "all", rule.slaveId);
+    Serial.printf("   Bus %d slave %s %s %u-%u: ", rule.bus, slave, mapTableName(rule.table), rule.first, rule.last);
+    if (rule.ttlMs) {
+      Serial.printf("%lu ms\n", (unsigned long)rule.ttlMs);
+    } else {
+      Serial.println("not cached");
+    }
+  }
+
+  unsigned long now = millis();
+  for (uint8_t i = 0; i < rtuBusCount(); i++) {
+    const CacheBus& state = buses[i];
+    const CacheStats& stats = state.stats;
+    uint32_t requests = stats.hits + stats.coveredHits + stats.joined + stats.misses;
+    if (requests == 0) continue;
+    uint8_t freshBlocks = 0;
+    for (const CacheBlock& block : state.blocks) {
+      if (fresh(block, now, CACHE_ANY_AGE)) freshBlocks++;
+    }
+    Serial.printf("   Bus %d: %lu read(s), %.1f%% without a transaction: %lu hit(s), %lu from a larger block, "
+                  "%lu merged in flight, %lu to the bus; %lu stored, %lu evicted, %d/%d block(s) fresh\n",
+                  i + 1, (unsigned long)requests, cacheHitRate(*rtuBuses[i]), (unsigned long)stats.hits,
+                  (unsigned long)stats.coveredHits, (unsigned long)stats.joined, (unsigned long)stats.misses,
+                  (unsigned long)stats.stores, (unsigned long)stats.evictions, freshBlocks, CACHE_BLOCKS_PER_BUS);
+  }
+}
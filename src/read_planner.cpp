@@ -0,0 +1,211 @@
+#include "read_planner.h"
+#include "read_cache.h"
+
+static uint16_t scratch[RTU_MAX_READ_WORDS];
+
+static bool isBitTable(uint8_t table) {
+  return table == MAP_COILS || table == MAP_DISCRETE_INPUTS;
+}
+
+static uint16_t maxQuantity(uint8_t table) {
+  return isBitTable(table) ? RTU_MAX_READ_BITS : RTU_MAX_READ_WORDS;
+}
+
+// Data bytes a read of `count` addresses puts on the wire
+static uint16_t dataBytes(uint8_t table, uint16_t count) {
+  return isBitTable(table) ? (count + 7) / 8 : count * 2;
+}
+
+void planInit(ReadPlan* plan) {
+  memset(plan, 0, sizeof(*plan));
+}
+
+bool planAdd(ReadPlan* plan, uint8_t table, uint16_t address) {
+  if (plan->pointCount >= PLAN_MAX_POINTS || table >= MAP_TABLE_COUNT) return false;
+  PlanPoint& point = plan->points[plan->pointCount++];
+  point.table = table;
+  point.address = address;
+  point.value = 0;
+  point.valid = false;
+  return true;
+}
+
+// Fixed cost of one read transaction: request frame, reply header and CRC,
+// two frame gaps and the slave's turnaround (the probe minimum until one
+// has been measured)
+uint32_t planTransactionOverheadUs(const RtuBus& bus) {
+  uint32_t turnaroundUs = bus.turnaroundUs ? bus.turnaroundUs : sweepSettings.minTurnaroundMs * 1000UL;
+  return (8 + 5) * rtuCharTimeUs(bus) + 2 * rtuFrameGapUs(bus) + turnaroundUs;
+}
+
+static bool pointBefore(const PlanPoint& a, const PlanPoint& b) {
+  return a.table != b.table ? a.table < b.table : a.address < b.address;
+}
+
+// Sort and de-duplicate the points, then choose block boundaries with a
+// shortest-path pass over the sorted points: best[i] is the cheapest way to
+// read the first i points, trying every block that ends at point i.
+void planBuild(ReadPlan* plan, const RtuBus& bus) {
+  PlanPoint* points = plan->points;
+
+  for (uint8_t i = 1; i < plan->pointCount; i++) {
+    PlanPoint point = points[i];
+    int j = i - 1;
+    while (j >= 0 && pointBefore(point, points[j])) {
+      points[j + 1] = points[j];
+      j--;
+    }
+    points[j + 1] = point;
+  }
+  uint8_t unique = 0;
+  for (uint8_t i = 0; i < plan->pointCount; i++) {
+    if (unique > 0 && points[unique - 1].table == points[i].table &&
+        points[unique - 1].address == points[i].address) continue;
+    points[unique++] = points[i];
+  }
+  plan->pointCount = unique;
+
+  uint32_t overheadUs = planTransactionOverheadUs(bus);
+  uint32_t charUs = rtuCharTimeUs(bus);
+  uint32_t best[PLAN_MAX_POINTS + 1];
+  uint8_t blockStart[PLAN_MAX_POINTS + 1];
+  best[0] = 0;
+
+  for (uint8_t i = 1; i <= unique; i++) {
+    const PlanPoint& last = points[i - 1];
+    best[i] = UINT32_MAX;
+    for (int j = i; j >= 1; j--) {
+      const PlanPoint& first = points[j - 1];
+      if (first.table != last.table) break;
+      uint32_t span = (uint32_t)last.address - first.address + 1;
+      if (span > maxQuantity(last.table)) break;
+      uint32_t cost = best[j - 1] + overheadUs + dataBytes(last.table, span) * charUs;
+      if (cost < best[i]) {
+        best[i] = cost;
+        blockStart[i] = j - 1;
+      }
+    }
+  }
+
+  // Walk back from the end to recover the blocks, then put them in order
+  plan->blockCount = 0;
+  for (uint8_t end = unique; end > 0; end = blockStart[end]) {
+    PlanBlock& block = plan->blocks[plan->blockCount++];
+    uint8_t start = blockStart[end];
+    block.table = points[start].table;
+    block.first = points[start].address;
+    block.count = points[end - 1].address - points[start].address + 1;
+    block.firstPoint = start;
+    block.pointCount = end - start;
+    block.dead = false;
+  }
+  for (uint8_t i = 0; i < plan->blockCount / 2; i++) {
+    PlanBlock swap = plan->blocks[i];
+    plan->blocks[i] = plan->blocks[plan->blockCount - 1 - i];
+    plan->blocks[plan->blockCount - 1 - i] = swap;
+  }
+  plan->splits = 0;
+}
+
+// Split blocks[index] at its widest gap between wanted points (or in the
+// middle of a contiguous run); the first half stays at index
+static void splitBlock(ReadPlan* plan, uint8_t index) {
+  PlanBlock& block = plan->blocks[index];
+  const PlanPoint* points = plan->points + block.firstPoint;
+
+  uint8_t at = block.pointCount / 2;
+  uint16_t widestGap = 1;
+  for (uint8_t k = 1; k < block.pointCount; k++) {
+    uint16_t gap = points[k].address - points[k - 1].address;
+    if (gap > widestGap) {
+      widestGap = gap;
+      at = k;
+    }
+  }
+
+  memmove(&plan->blocks[index + 2], &plan->blocks[index + 1],
+          (plan->blockCount - index - 1) * sizeof(PlanBlock));
+  plan->blockCount++;
+
+  PlanBlock& second = plan->blocks[index + 1];
+  second.table = block.table;
+  second.firstPoint = block.firstPoint + at;
+  second.pointCount = block.pointCount - at;
+  second.first = points[at].address;
+  second.count = points[block.pointCount - 1].address - second.first + 1;
+  second.dead = false;
+
+  block.pointCount = at;
+  block.count = points[at - 1].address - block.first + 1;
+  plan->splits++;
+}
+
+// Poll every block once. Returns the number of read transactions issued.
+uint16_t planExecute(ReadPlan* plan, RtuBus& bus, uint8_t slaveId) {
+  unsigned long startMs = millis();
+  plan->transactions = 0;
+  plan->failures = 0;
+  for (uint8_t i = 0; i < plan->pointCount; i++) {
+    plan->points[i].valid = false;
+  }
+
+  for (uint8_t i = 0; i < plan->blockCount; i++) {
+    PlanBlock& block = plan->blocks[i];
+    if (block.dead) continue;
+
+    // Timeouts and garbled replies are retried under the retry policy; a
+    // block read moments ago by someone else comes from the read cache
+    uint8_t function = block.table + 1;
+    uint16_t timeoutMs = rtuReadTimeoutMs(bus, function, block.count);
+    RetryOutcome outcome;
+    uint8_t result = cacheRead(bus, slaveId, function, block.first, block.count, scratch, timeoutMs,
+                               CACHE_ANY_AGE, &outcome);
+    plan->transactions += outcome.attempts;
+
+    if (result == ModbusMaster::ku8MBSuccess) {
+      for (uint8_t k = 0; k < block.pointCount; k++) {
+        PlanPoint& point = plan->points[block.firstPoint + k];
+        uint16_t offset = point.address - block.first;
+        point.value = isBitTable(block.table) ? (scratch[offset / 16] >> (offset % 16)) & 1
+                                              : scratch[offset];
+        point.valid = true;
+      }
+    } else if (result == ModbusMaster::ku8MBIllegalDataAddress ||
+               result == ModbusMaster::ku8MBIllegalDataValue) {
+      if (block.pointCount > 1) {
+        splitBlock(plan, i);
+        i--; // Retry the first half now, the second half follows
+      } else {
+        block.dead = true;
+      }
+    } else {
+      plan->failures++;
+      if (result == ModbusMaster::ku8MBResponseTimedOut) rtuDrain(bus, timeoutMs);
+    }
+  }
+
+  plan->elapsedMs = millis() - startMs;
+  return plan->transactions;
+}
+
+bool planValue(const ReadPlan* plan, uint8_t table, uint16_t address, uint16_t* value) {
+  for (uint8_t i = 0; i < plan->pointCount; i++) {
+    const PlanPoint& point = plan->points[i];
+    if (point.table == table && point.address == address) {
+      if (point.valid) *value = point.value;
+      return point.valid;
+    }
+  }
+  return false;
+}
+
+void planPrint(const ReadPlan* plan) {
+  Serial.printf("📦 Read plan: %d register(s) in %d block read(s)", plan->pointCount, plan->blockCount);
+  if (plan->splits > 0) Serial.printf(", %d split after address exceptions", plan->splits);
+  Serial.println();
+  for (uint8_t i = 0; i < plan->blockCount; i++) {
+    const PlanBlock& block = plan->blocks[i];
+    Serial.printf("   %s %u-%u (%d wanted)%s\n", mapTableName(block.table), block.first,
+                  block.first + block.count - 1, block.pointCount, block.dead ? " - not available" : "");
+  }
+}
@@ -0,0 +1,368 @@
+#include "register_map.h"
+#include "scanner.h"
+#include "retry_policy.h"
+
+enum ReadOutcome {
+  READ_OK,
+  READ_INVALID,       // Illegal Data Address: at least one address does not exist
+  READ_TOO_LARGE,     // Quantity rejected (Illegal Data Value / device failure)
+  READ_UNSUPPORTED,   // Illegal Function: the table is not implemented
+  READ_FAILED         // No usable reply, or cancelled
+};
+
+#define MAP_MAX_CONSECUTIVE_TIMEOUTS 3
+#define MAP_SWEEP_FIRST_STRIDE 4096
+
+static const char* tableNames[MAP_TABLE_COUNT] = {"CO", "DI", "HR", "IR"};
+
+// Discovery in progress
+static struct {
+  RtuBus* bus;
+  uint8_t slaveId;
+  const MapDiscoveryOptions* options;
+  MapDiscoveryResult* result;
+  uint8_t consecutiveTimeouts;
+} ctx;
+
+static uint16_t scratch[RTU_MAX_READ_WORDS];
+
+const char* mapTableName(uint8_t table) {
+  return table < MAP_TABLE_COUNT ? tableNames[table] : "??";
+}
+
+void mapDefaultOptions(MapDiscoveryOptions* options) {
+  options->firstAddress = 0;
+  options->lastAddress = 0xFFFF;
+  options->denseSpan = 256;
+  options->seedStride = 8;
+  options->gapProbe = 4;
+  options->minBlock = 16;
+  options->maxRangeLength = 2000;
+  options->tableMask = (1 << MAP_TABLE_COUNT) - 1;
+}
+
+static bool stopRequested() {
+  MapDiscoveryResult* result = ctx.result;
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c == 'c' || c == 'C') result->cancelled = true;
+  }
+  return result->cancelled || result->deviceLost;
+}
+
+// One read; timeouts and garbled replies are retried under the retry
+// policy before the read counts as lost
+static ReadOutcome mapRead(uint8_t table, uint16_t address, uint16_t quantity) {
+  MapDiscoveryResult* result = ctx.result;
+  if (stopRequested()) return READ_FAILED;
+
+  uint16_t timeoutMs = rtuReadTimeoutMs(*ctx.bus, table + 1, quantity);
+  RetryOutcome outcome;
+  uint8_t status = retryRead(*ctx.bus, ctx.slaveId, table + 1, address, quantity, scratch, timeoutMs, &outcome);
+  result->transactions += outcome.attempts;
+  result->timeouts += outcome.timeouts;
+
+  if (status == ModbusMaster::ku8MBResponseTimedOut || status == RETRY_CIRCUIT_OPEN) {
+    if (++ctx.consecutiveTimeouts >= MAP_MAX_CONSECUTIVE_TIMEOUTS) result->deviceLost = true;
+    return READ_FAILED;
+  }
+  ctx.consecutiveTimeouts = 0;
+
+  switch (status) {
+    case ModbusMaster::ku8MBSuccess:
+      return READ_OK;
+    case ModbusMaster::ku8MBIllegalDataAddress:
+      return READ_INVALID;
+    case ModbusMaster::ku8MBIllegalFunction:
+      return READ_UNSUPPORTED;
+    case ModbusMaster::ku8MBIllegalDataValue:
+    case ModbusMaster::ku8MBSlaveDeviceFailure:
+      // Some devices reject a single unmapped address this way as well
+      return quantity > 1 ? READ_TOO_LARGE : READ_INVALID;
+    default:
+      return READ_FAILED;
+  }
+}
+
+// Read `count` addresses adjacent to cursor in direction dir: [cursor, cursor + count)
+// going up, (cursor - count, cursor] going down
+static ReadOutcome readBeside(uint8_t table, int32_t cursor, int8_t dir, uint16_t count) {
+  uint16_t address = dir > 0 ? cursor : cursor - count + 1;
+  return mapRead(table, address, count);
+}
+
+// Extend a run of valid addresses from cursor towards bound (inclusive).
+// Reads gallop (2, 4, 8, ... up to the block limit) while they succeed;
+// the first Illegal Data Address is bisected down to the exact boundary.
+// Returns the first address that is not part of the run.
+static int32_t extendRun(uint8_t table, int32_t cursor, int32_t bound, int8_t dir) {
+  MapDiscoveryResult* result = ctx.result;
+  uint16_t step = 2;
+
+  while (true) {
+    int32_t remaining = dir > 0 ? bound - cursor + 1 : cursor - bound + 1;
+    if (remaining <= 0) return cursor;
+    uint16_t count = min((int32_t)min(step, result->maxBlock[table]), remaining);
+
+    ReadOutcome outcome = readBeside(table, cursor, dir, count);
+    if (outcome == READ_OK) {
+      cursor += dir * count;
+      if (step < result->maxBlock[table]) step *= 2;
+      continue;
+    }
+    if (outcome == READ_TOO_LARGE) {
+      result->maxBlock[table] = count / 2;
+      continue;
+    }
+    if (outcome != READ_INVALID || count == 1) return cursor;
+
+    // Somewhere in these `count` addresses the run ends: find the longest valid prefix
+    uint16_t good = 0;
+    uint16_t bad = count;
+    while (bad - good > 1) {
+      uint16_t mid = (good + bad) / 2;
+      ReadOutcome probe = readBeside(table, cursor, dir, mid);
+      if (probe == READ_OK) {
+        good = mid;
+      } else if (probe == READ_INVALID) {
+        bad = mid;
+      } else {
+        break;
+      }
+    }
+    return cursor + dir * good;
+  }
+}
+
+static void addRange(uint8_t table, uint16_t first, uint16_t last) {
+  MapDiscoveryResult* result = ctx.result;
+  if (result->rangeCount >= MAP_MAX_RANGES) {
+    result->truncated = true;
+    return;
+  }
+  MapRange& range = result->ranges[result->rangeCount++];
+  range.table = table;
+  range.first = first;
+  range.last = last;
+  Serial.printf("   %s %u-%u (%u)\n", tableNames[table], first, last, last - first + 1);
+}
+
+// `address` is known valid and everything up to `knownInvalid` has been
+// ruled out below it; returns the last address of the block
+static int32_t growRange(uint8_t table, int32_t address, int32_t knownInvalid) {
+  const MapDiscoveryOptions& options = *ctx.options;
+  int32_t first = extendRun(table, address - 1, knownInvalid + 1, -1) + 1;
+  int32_t limit = min((int32_t)options.lastAddress, first + options.maxRangeLength - 1);
+  int32_t last = extendRun(table, address + 1, limit, 1) - 1;
+
+  if (last - first + 1 >= options.maxRangeLength) {
+    ctx.result->unbounded[table] = true;
+  }
+  addRange(table, first, last);
+  return last;
+}
+
+// Seeds: every seedStride addresses in the dense span, then multiples of 100
+// below 10000 and of 1000 above, where vendors tend to start their blocks.
+// Blocks between them are left to sweepGaps().
+static int32_t nextSeed(int32_t address) {
+  const MapDiscoveryOptions& options = *ctx.options;
+  int32_t denseEnd = (int32_t)options.firstAddress + options.denseSpan;
+  if (address + options.seedStride < denseEnd) return address + options.seedStride;
+
+  int32_t from = max(address + 1, denseEnd);
+  int32_t step = from < 10000 ? 100 : 1000;
+  return (from + step - 1) / step * step;
+}
+
+static bool onSeedGrid(int32_t address) {
+  const MapDiscoveryOptions& options = *ctx.options;
+  int32_t denseEnd = (int32_t)options.firstAddress + options.denseSpan;
+  if (address < denseEnd) return (address - options.firstAddress) % options.seedStride == 0;
+  return address % (address < 10000 ? 100 : 1000) == 0;
+}
+
+// Last address of the ranges below `address` in table, or before the search
+static int32_t rangeEndBelow(uint8_t table, int32_t address) {
+  const MapDiscoveryResult* result = ctx.result;
+  int32_t end = (int32_t)ctx.options->firstAddress - 1;
+  for (uint8_t i = 0; i < result->rangeCount; i++) {
+    const MapRange& range = result->ranges[i];
+    if (range.table == table && range.last < address) end = max(end, (int32_t)range.last);
+  }
+  return end;
+}
+
+static bool inRange(uint8_t table, int32_t address) {
+  const MapDiscoveryResult* result = ctx.result;
+  for (uint8_t i = 0; i < result->rangeCount; i++) {
+    const MapRange& range = result->ranges[i];
+    if (range.table == table && range.first <= address && range.last >= address) return true;
+  }
+  return false;
+}
+
+// Probe the gaps every stride addresses, halving the stride down to
+// minBlock; an address probed at a coarser stride is not asked again
+static void sweepGaps(uint8_t table) {
+  const MapDiscoveryOptions& options = *ctx.options;
+  MapDiscoveryResult* result = ctx.result;
+  if (options.minBlock == 0) return;
+
+  for (int32_t stride = MAP_SWEEP_FIRST_STRIDE; stride >= options.minBlock; stride /= 2) {
+    int32_t start = ((int32_t)options.firstAddress + stride - 1) / stride * stride;
+    for (int32_t address = start; address <= options.lastAddress; address += stride) {
+      if (stopRequested() || result->truncated || result->unbounded[table]) return;
+      if ((stride < MAP_SWEEP_FIRST_STRIDE && address % (stride * 2) == 0) || onSeedGrid(address) ||
+          inRange(table, address)) {
+        continue;
+      }
+      ReadOutcome outcome = mapRead(table, address, 1);
+      if (outcome == READ_OK) growRange(table, address, rangeEndBelow(table, address));
+    }
+  }
+}
+
+// Ranges of the sweep come in address order per stride, not overall
+static void sortRanges() {
+  MapDiscoveryResult* result = ctx.result;
+  for (uint8_t i = 1; i < result->rangeCount; i++) {
+    MapRange range = result->ranges[i];
+    uint8_t j = i;
+    for (; j > 0 && (result->ranges[j - 1].table > range.table ||
+                     (result->ranges[j - 1].table == range.table && result->ranges[j - 1].first > range.first));
+         j--) {
+      result->ranges[j] = result->ranges[j - 1];
+    }
+    result->ranges[j] = range;
+  }
+}
+
+// Seeded pass; false when the table is not implemented
+static bool seedTable(uint8_t table) {
+  const MapDiscoveryOptions& options = *ctx.options;
+  MapDiscoveryResult* result = ctx.result;
+  int32_t knownInvalid = (int32_t)options.firstAddress - 1;
+  int32_t seed = options.firstAddress;
+
+  Serial.printf("🔎 %s: searching %u-%u\n", tableNames[table], options.firstAddress, options.lastAddress);
+
+  while (seed <= options.lastAddress && !stopRequested()) {
+    if (seed <= knownInvalid) {
+      seed = nextSeed(seed);
+      continue;
+    }
+
+    ReadOutcome outcome = mapRead(table, seed, 1);
+    if (outcome == READ_UNSUPPORTED) {
+      result->supported[table] = false;
+      Serial.printf("   %s not supported (Illegal Function)\n", tableNames[table]);
+      return false;
+    }
+    if (outcome != READ_OK) {
+      if (outcome != READ_FAILED) knownInvalid = seed;
+      seed = nextSeed(seed);
+      continue;
+    }
+
+    // Found a block; afterwards look just past its end for short neighbours
+    int32_t address = seed;
+    while (address >= 0) {
+      int32_t last = growRange(table, address, knownInvalid);
+      if (stopRequested() || last >= options.lastAddress || result->unbounded[table]) return true;
+      knownInvalid = last + 1;
+      address = -1;
+
+      for (uint8_t gap = 1; gap <= options.gapProbe && knownInvalid < options.lastAddress; gap++) {
+        outcome = mapRead(table, knownInvalid + 1, 1);
+        if (outcome == READ_OK) {
+          address = knownInvalid + 1;
+          break;
+        }
+        if (outcome == READ_FAILED) break;
+        knownInvalid++;
+      }
+    }
+    seed = nextSeed(max(seed, knownInvalid));
+  }
+  return true;
+}
+
+static void discoverTable(uint8_t table) {
+  if (seedTable(table)) sweepGaps(table);
+}
+
+bool discoverRegisterMap(RtuBus& bus, uint8_t slaveId, const MapDiscoveryOptions& options,
+                         MapDiscoveryResult* result) {
+  memset(result, 0, sizeof(*result));
+  for (uint8_t table = 0; table < MAP_TABLE_COUNT; table++) {
+    result->supported[table] = true;
+    bool bits = table == MAP_COILS || table == MAP_DISCRETE_INPUTS;
+    result->maxBlock[table] = bits ? RTU_MAX_READ_BITS : RTU_MAX_READ_WORDS;
+  }
+
+  ctx.bus = &bus;
+  ctx.slaveId = slaveId;
+  ctx.options = &options;
+  ctx.result = result;
+  ctx.consecutiveTimeouts = 0;
+
+  ledStatusMessage(LED_SCANNING, "Discovering register map...");
+  Serial.printf("\n🗺️  Register map discovery for Slave ID %d (%lu baud %s)\n", slaveId,
+                (unsigned long)bus.baud, rtuConfigName(bus.config));
+  if (options.minBlock) {
+    Serial.printf("   Finds every block of %u+ addresses; shorter ones only at seed addresses "
+                  "(every %u below %u, multiples of 100 and 1000 above)\n", options.minBlock, options.seedStride,
+                  options.firstAddress + options.denseSpan);
+  } else {
+    Serial.printf("   Seed grid only: blocks are found if they contain an address every %u below %u "
+                  "or a multiple of 100 or 1000 above\n", options.seedStride, options.firstAddress + options.denseSpan);
+  }
+  Serial.println("⌨️  c = cancel");
+
+  unsigned long startMs = millis();
+  for (uint8_t table = 0; table < MAP_TABLE_COUNT && !stopRequested(); table++) {
+    if (options.tableMask & (1 << table)) discoverTable(table);
+  }
+  result->elapsedMs = millis() - startMs;
+  sortRanges();
+
+  if (result->deviceLost) {
+    ledStatusMessage(LED_ERROR, "Device stopped responding");
+  } else if (result->cancelled) {
+    ledStatusMessage(LED_WARNING, "Discovery cancelled");
+  } else {
+    ledStatusMessage(LED_SUCCESS, "Register map complete");
+  }
+  return !result->deviceLost && !result->cancelled;
+}
+
+void printRegisterMap(const MapDiscoveryResult& result) {
+  Serial.printf("\n🗺️  REGISTER MAP: %d range(s)%s\n", result.rangeCount,
+                result.truncated ? " (list full, more exist)" : "");
+
+  uint32_t addresses = 0;
+  for (uint8_t table = 0; table < MAP_TABLE_COUNT; table++) {
+    bool any = false;
+    for (uint8_t i = 0; i < result.rangeCount; i++) {
+      const MapRange& range = result.ranges[i];
+      if (range.table != table) continue;
+      if (!any) Serial.printf("   %s:", tableNames[table]);
+      Serial.printf(" %u-%u", range.first, range.last);
+      addresses += range.last - range.first + 1;
+      any = true;
+    }
+    if (any) Serial.println();
+    if (!result.supported[table]) Serial.printf("   %s: not supported\n", tableNames[table]);
+    if (result.unbounded[table]) {
+      Serial.printf("   ⚠️  %s answers every address tried - the device probably does not check its map\n",
+                    tableNames[table]);
+    }
+  }
+
+  Serial.printf("   %lu transactions in %lu ms (%lu timeouts) covering %lu addresses\n",
+                (unsigned long)result.transactions, result.elapsedMs,
+                (unsigned long)result.timeouts, (unsigned long)addresses);
+  if (result.deviceLost) Serial.println("   ❌ Stopped: device stopped responding");
+  if (result.cancelled) Serial.println("   ⏹️  Cancelled - map is incomplete");
+}
@@ -0,0 +1,84 @@
+#include "register_profile.h"
+
+static const int32_t powersOfTen[REGISTER_MAX_DECIMALS + 1] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+static bool tableIsBits(uint8_t table) {
+  return table == MAP_COILS || table == MAP_DISCRETE_INPUTS;
+}
+
+static size_t formatNumber(const RegisterDescriptor& reg, int32_t value, char* out, size_t size) {
+  const char* space = reg.unit[0] ? " " : "";
+  if (reg.decimals == 0) return snprintf(out, size, "%ld%s%s", (long)value, space, reg.unit);
+
+  // Integer and fraction parts of the magnitude; the sign is printed
+  // separately so -0.5 keeps its minus
+  uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+  uint32_t scale = powersOfTen[reg.decimals];
+  return snprintf(out, size, "%s%lu.%0*lu%s%s", value < 0 ? "-" : "", (unsigned long)(magnitude / scale),
+                  reg.decimals, (unsigned long)(magnitude % scale), space, reg.unit);
+}
+
+static size_t formatBits(const RegisterDescriptor& reg, int32_t value, char* out, size_t size) {
+  size_t length = 0;
+  out[0] = '\0';
+  for (uint8_t bit = 0; bit < reg.labelCount && length < size; bit++) {
+    if (!(value & (1L << bit))) continue;
+    length += snprintf(out + length, size - length, "%s%s", length ? ", " : "", reg.labels[bit]);
+  }
+  if (length == 0) length = snprintf(out, size, "none");
+  return min(length, size - 1);
+}
+
+size_t registerFormat(const RegisterDescriptor& reg, int32_t value, char* out, size_t size) {
+  if (size == 0) return 0;
+  switch (reg.kind) {
+    case REG_ENUM: {
+      int32_t index = value - reg.labelBase;
+      const char* label = index >= 0 && index < reg.labelCount ? reg.labels[index] : "Unknown";
+      return snprintf(out, size, "%s (%ld)", label, (long)value);
+    }
+    case REG_BITS:
+      return formatBits(reg, value, out, size);
+    default:
+      return formatNumber(reg, value, out, size);
+  }
+}
+
+void registerProfilePlan(ReadPlan* plan, const RegisterDescriptor* profile, uint8_t count) {
+  for (uint8_t i = 0; i < count; i++) {
+    for (uint8_t word = 0; word < profile[i].words; word++) {
+      planAdd(plan, profile[i].table, profile[i].address + word);
+    }
+  }
+}
+
+bool registerPlanValue(const ReadPlan* plan, const RegisterDescriptor& reg, int32_t* value) {
+  uint16_t words[2];
+  for (uint8_t word = 0; word < reg.words; word++) {
+    if (!planValue(plan, reg.table, reg.address + word, &words[word])) return false;
+  }
+  *value = reg.decode(words);
+  return true;
+}
+
+uint8_t registerDecodeBlock(const RegisterDescriptor* profile, uint8_t count, uint8_t table, uint16_t first,
+                            uint16_t quantity, const uint16_t* words, int32_t* values, bool* valid) {
+  uint8_t decoded = 0;
+  bool bits = tableIsBits(table);
+  for (uint8_t i = 0; i < count; i++) {
+    const RegisterDescriptor& reg = profile[i];
+    if (reg.table != table || reg.address < first || (uint32_t)reg.address + reg.words > (uint32_t)first + quantity) {
+      continue;
+    }
+    uint16_t offset = reg.address - first;
+    if (bits) {
+      uint16_t bit = (words[offset / 16] >> (offset % 16)) & 1;
+      values[i] = reg.decode(&bit);
+    } else {
+      values[i] = reg.decode(words + offset);
+    }
+    valid[i] = true;
+    decoded++;
+  }
+  return decoded;
+}
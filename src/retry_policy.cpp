@@ -0,0 +1,257 @@
+#include "retry_policy.h"
+
+RetryPolicy retryPolicy = {
+  3,       // maxAttempts
+  1,       // maxTimeoutRetries
+  20,      // backoffMs
+  250,     // maxBackoffMs
+  5,       // breakerFailures
+  5000,    // breakerOpenMs
+  120000   // breakerMaxOpenMs
+};
+
+// A slave that has failed since its last reply
+struct Breaker {
+  uint8_t slaveId;            // 0 = free slot
+  uint8_t failures;           // Failed calls in a row
+  bool open;
+  unsigned long openUntilMs;
+  uint32_t openMs;            // Length of the current open period
+};
+
+struct RetryBusState {
+  uint32_t baud;              // Line settings the breakers were tripped at
+  uint32_t config;
+  uint16_t spent;             // Retry budget used, in tenths of a retry
+  Breaker breakers[RETRY_BREAKER_SLOTS];
+  RetryStats stats;
+};
+
+static RetryBusState states[MODBUS_BUS_COUNT];
+
+// millis() comparison that survives the 49 day wrap
+static bool reached(unsigned long now, unsigned long when) {
+  return (long)(now - when) >= 0;
+}
+
+// Failures at other line settings say nothing about the slaves now:
+// every circuit closes when the baud rate or frame format changes
+static RetryBusState& stateFor(const RtuBus& bus) {
+  RetryBusState& state = states[rtuBusNumber(bus) - 1];
+  if (state.baud != bus.baud || state.config != bus.config) {
+    memset(state.breakers, 0, sizeof(state.breakers));
+    state.spent = 0;
+    state.baud = bus.baud;
+    state.config = bus.config;
+  }
+  return state;
+}
+
+bool retryTransient(uint8_t result) {
+  switch (result) {
+    case ModbusMaster::ku8MBResponseTimedOut:
+    case ModbusMaster::ku8MBInvalidCRC:
+    case ModbusMaster::ku8MBInvalidSlaveID:   // Someone else's (late) reply was in the way
+    case 0x05:                                // Acknowledge: still working on it
+    case 0x06:                                // Slave Device Busy
+    case 0x0B:                                // Gateway target failed to respond
+      return true;
+    default:
+      return false;
+  }
+}
+
+static Breaker* findBreaker(RetryBusState& state, uint8_t slaveId) {
+  for (Breaker& breaker : state.breakers) {
+    if (breaker.slaveId == slaveId) return &breaker;
+  }
+  return nullptr;
+}
+
+// A free slot, else the closed breaker with the fewest failures
+static Breaker* newBreaker(RetryBusState& state, uint8_t slaveId) {
+  Breaker* slot = nullptr;
+  for (Breaker& breaker : state.breakers) {
+    if (breaker.slaveId == 0) {
+      slot = &breaker;
+      break;
+    }
+    if (!breaker.open && (!slot || breaker.failures < slot->failures)) slot = &breaker;
+  }
+  if (!slot) return nullptr;   // Every slot holds an open circuit
+  memset(slot, 0, sizeof(*slot));
+  slot->slaveId = slaveId;
+  return slot;
+}
+
+// The call failed after its retries
+static void callFailed(RetryBusState& state, uint8_t slaveId, bool probing) {
+  if (retryPolicy.breakerFailures == 0) return;
+  Breaker* breaker = findBreaker(state, slaveId);
+  if (!breaker) breaker = newBreaker(state, slaveId);
+  if (!breaker) return;
+  if (breaker->failures < 0xFF) breaker->failures++;
+
+  if (probing) {
+    breaker->openMs = min(breaker->openMs * 2, retryPolicy.breakerMaxOpenMs);
+  } else if (breaker->failures >= retryPolicy.breakerFailures) {
+    breaker->openMs = retryPolicy.breakerOpenMs;
+    state.stats.trips++;
+  } else {
+    return;
+  }
+  breaker->open = true;
+  breaker->openUntilMs = millis() + breaker->openMs;
+}
+
+// Exponential with equal jitter: half the step fixed, half random
+static uint16_t backoffMs(uint8_t retry) {
+  uint32_t step = min((uint32_t)retryPolicy.backoffMs << min(retry, (uint8_t)8),
+                      (uint32_t)retryPolicy.maxBackoffMs);
+  return step / 2 + random(step / 2 + 1);
+}
+
+// Sleep off the backoff, then drop what a late reply left on the line.
+// After a timeout that reply may still be coming: the line has to stay
+// quiet for quietMs first, or it would answer the retry.
+static void backoff(RtuBus& bus, uint8_t retry, bool afterTimeout, uint16_t quietMs) {
+  delay(backoffMs(retry));
+  rtuDrain(bus, afterTimeout ? quietMs : rtuFrameGapUs(bus) / 1000 + 1);
+}
+
+uint8_t retryRun(RtuBus& bus, uint8_t slaveId, RetryAttempt attempt, void* context, uint16_t quietMs,
+                 RetryOutcome* outcome) {
+  RetryOutcome local;
+  if (!outcome) outcome = &local;
+  outcome->attempts = 0;
+  outcome->timeouts = 0;
+
+  rtuLock(bus);
+  RetryBusState& state = stateFor(bus);
+  RetryStats& stats = state.stats;
+  stats.calls++;
+
+  // An open circuit refuses the call; once its time is up one attempt goes through
+  Breaker* breaker = findBreaker(state, slaveId);
+  bool probing = false;
+  if (breaker && breaker->open) {
+    if (!reached(millis(), breaker->openUntilMs)) {
+      stats.shortCircuited++;
+      rtuUnlock(bus);
+      return RETRY_CIRCUIT_OPEN;
+    }
+    probing = true;
+  }
+  uint8_t maxAttempts = probing ? 1 : max(retryPolicy.maxAttempts, (uint8_t)1);
+
+  uint8_t result = ModbusMaster::ku8MBResponseTimedOut;
+  while (outcome->attempts < maxAttempts) {
+    if (outcome->attempts > 0) {
+      if (state.spent + 10 > RETRY_BUDGET_TOKENS * 10) {
+        stats.budgetDenied++;
+        break;
+      }
+      state.spent += 10;
+      stats.retries++;
+      backoff(bus, outcome->attempts - 1, result == ModbusMaster::ku8MBResponseTimedOut, quietMs);
+    }
+
+    result = attempt(context);
+    outcome->attempts++;
+    if (!retryTransient(result)) break;
+
+    if (result == ModbusMaster::ku8MBResponseTimedOut &&
+        ++outcome->timeouts > retryPolicy.maxTimeoutRetries) {
+      break;
+    }
+  }
+
+  if (retryTransient(result)) {
+    if (outcome->attempts > 1) stats.exhausted++;
+    callFailed(state, slaveId, probing);
+  } else {
+    // Any reply, an exception too, shows the slave is there
+    if (breaker) breaker->slaveId = 0;
+    if (outcome->attempts > 1) {
+      if (result == ModbusMaster::ku8MBSuccess) stats.recovered++;
+    } else if (state.spent > 0) {
+      state.spent--;
+    }
+  }
+  rtuUnlock(bus);
+  return result;
+}
+
+struct ReadArgs {
+  RtuBus* bus;
+  uint8_t slaveId;
+  uint8_t function;
+  uint16_t address;
+  uint16_t quantity;
+  uint16_t* dst;
+  uint16_t timeoutMs;
+};
+
+static uint8_t readAttempt(void* context) {
+  const ReadArgs& args = *(const ReadArgs*)context;
+  return rtuReadRequest(*args.bus, args.slaveId, args.function, args.address, args.quantity, args.dst,
+                        args.timeoutMs);
+}
+
+uint8_t retryRead(RtuBus& bus, uint8_t slaveId, uint8_t function, uint16_t address, uint16_t quantity,
+                  uint16_t* dst, uint16_t timeoutMs, RetryOutcome* outcome) {
+  ReadArgs args = {&bus, slaveId, function, address, quantity, dst, timeoutMs};
+  return retryRun(bus, slaveId, readAttempt, &args, timeoutMs, outcome);
+}
+
+bool retryCircuitOpen(const RtuBus& bus, uint8_t slaveId) {
+  Breaker* breaker = findBreaker(stateFor(bus), slaveId);
+  return breaker && breaker->open && !reached(millis(), breaker->openUntilMs);
+}
+
+const RetryStats& retryStats(const RtuBus& bus) {
+  return stateFor(bus).stats;
+}
+
+void retryReset() {
+  for (uint8_t i = 0; i < rtuBusCount(); i++) {
+    rtuLock(*rtuBuses[i]);
+    memset(&states[i], 0, sizeof(states[i]));
+    rtuUnlock(*rtuBuses[i]);
+  }
+}
+
+void retryPrintStats() {
+  Serial.printf("🔁 Retry policy: %d attempt(s), %d after a timeout, backoff %u-%u ms; breaker ",
+                retryPolicy.maxAttempts, retryPolicy.maxTimeoutRetries, retryPolicy.backoffMs,
+                retryPolicy.maxBackoffMs);
+  if (retryPolicy.breakerFailures == 0) {
+    Serial.println("off");
+  } else {
+    Serial.printf("after %d failed calls, open %lu-%lu s\n", retryPolicy.breakerFailures,
+                  (unsigned long)(retryPolicy.breakerOpenMs / 1000), (unsigned long)(retryPolicy.breakerMaxOpenMs / 1000));
+  }
+
+  unsigned long now = millis();
+  for (uint8_t i = 0; i < rtuBusCount(); i++) {
+    const RetryBusState& state = stateFor(*rtuBuses[i]);
+    const RetryStats& stats = state.stats;
+    if (stats.calls == 0) continue;
+    Serial.printf("   Bus %d: %lu call(s), %lu retries, %lu recovered, %lu failed after retrying, "
+                  "%lu without budget, %lu refused by an open circuit, %lu trip(s)\n",
+                  i + 1, (unsigned long)stats.calls, (unsigned long)stats.retries, (unsigned long)stats.recovered,
+                  (unsigned long)stats.exhausted, (unsigned long)stats.budgetDenied,
+                  (unsigned long)stats.shortCircuited, (unsigned long)stats.trips);
+    for (const Breaker& breaker : state.breakers) {
+      if (breaker.slaveId == 0) continue;
+      if (breaker.open) {
+        long leftMs = (long)(breaker.openUntilMs - now);
+        Serial.printf("   ⛔ Slave %d: circuit open, %d failed calls, %s %ld s\n", breaker.slaveId,
+                      breaker.failures, leftMs > 0 ? "retried in" : "next call probes, open for",
+                      (leftMs > 0 ? leftMs : (long)breaker.openMs) / 1000);
+      } else {
+        Serial.printf("   ⚠️  Slave %d: %d failed call(s) in a row\n", breaker.slaveId, breaker.failures);
+      }
+    }
+  }
+}
@@ -0,0 +1,319 @@
+#include "scan_engine.h"
+#include "scanner.h"
+#include "modbus_rtu.h"
+#include "device_inventory.h"
+#include "bus_task.h"
+#include "led_renderer.h"
+
+// How long a found/error flash stays visible before the scanning pulse resumes
+#define SCAN_FLASH_MS 100
+
+// Sweep state of one bus; every bus runs its own passes over the ID range
+struct ScanLane {
+  RtuBus* bus;
+  uint8_t nextId;           // Next ID to submit in this pass, 0 = all submitted
+  uint8_t pass;
+  uint8_t inFlight;         // Probes submitted and not back yet
+  bool done;
+  uint16_t timeoutMs;       // Probe timeout of the first pass
+  uint16_t retryIds;
+  uint8_t retryBitmap[32];  // IDs for the retry pass, one bit per slave ID
+  uint8_t foundBitmap[32];  // IDs that already answered
+};
+
+static ScanState state = SCAN_IDLE;
+static ScanStats stats;
+static ScanLane lanes[MODBUS_BUS_COUNT];
+static uint8_t laneCount = 0;
+static uint8_t generation = 0;   // In every probe's tag; results of an earlier scan are dropped
+static ScanFinishHandler finishHandler = nullptr;
+
+static bool testId(const uint8_t* bitmap, uint8_t id) {
+  return bitmap[id >> 3] & (1 << (id & 7));
+}
+
+static void markId(uint8_t* bitmap, uint8_t id) {
+  bitmap[id >> 3] |= 1 << (id & 7);
+}
+
+static void queueRetry(ScanLane& lane, uint8_t id) {
+  if (id < stats.firstId || id > stats.lastId) return;
+  if (testId(lane.retryBitmap, id) || testId(lane.foundBitmap, id)) return;
+  markId(lane.retryBitmap, id);
+  lane.retryIds++;
+  stats.retryIds++;
+}
+
+// Next ID to probe after `id` in the lane's current pass, 0 when the pass is done
+static uint8_t nextScanId(const ScanLane& lane, uint8_t id) {
+  for (uint16_t next = id + 1; next <= stats.lastId; next++) {
+    if (lane.pass == 1) return next;
+    if (testId(lane.retryBitmap, next) && !testId(lane.foundBitmap, next)) return next;
+  }
+  return 0;
+}
+
+// " on bus N" when more than one bus is being swept
+static const char* busLabel(const ScanLane& lane) {
+  static char label[16];
+  if (laneCount < 2) return "";
+  snprintf(label, sizeof(label), " on bus %d", rtuBusNumber(*lane.bus));
+  return label;
+}
+
+static unsigned long scanElapsedMs() {
+  unsigned long now = state == SCAN_PAUSED ? stats.pauseStartMs : millis();
+  return now - stats.startMs - stats.pausedMs;
+}
+
+static void printScanControls() {
+  Serial.println("⌨️  Scan controls: p = pause/resume, c = cancel, s = status");
+}
+
+static void printScanSummary(const char* title) {
+  unsigned long elapsed = scanElapsedMs();
+  float probesPerSec = elapsed > 0 ? stats.probes * 1000.0f / elapsed : 0;
+
+  Serial.printf("\n🎯 %s Found %d device(s)\n", title, stats.devicesFound);
+  Serial.printf("   %d probes in %lu ms (%.1f probes/sec, %d ms probe timeout)\n",
+                stats.probes, elapsed, probesPerSec, stats.timeoutMs);
+  if (stats.buses > 1) {
+    Serial.printf("   %d buses swept in parallel\n", stats.buses);
+  }
+  if (stats.retryIds > 0) {
+    Serial.printf("   Retry pass: %d ID(s) re-probed, %d found only on retry\n",
+                  stats.retryIds, stats.foundOnRetry);
+  }
+  if (stats.devicesWithErrors > 0) {
+    Serial.printf("   %d device(s) responded with an exception\n", stats.devicesWithErrors);
+  }
+}
+
+static void finishScan() {
+  state = SCAN_IDLE;
+
+  if (stats.devicesFound > 0) {
+    ledStatusMessage(LED_SUCCESS, "Scan complete - devices found!");
+  } else {
+    ledStatusMessage(LED_WARNING, "Scan complete - no devices found");
+  }
+
+  printScanSummary("Scan complete!");
+  if (stats.devicesFound == 0) {
+    Serial.println("💡 Tips:");
+    Serial.println("   - Check wiring connections (RX, TX, GND)");
+    Serial.println("   - Verify baud rate matches your device");
+    Serial.println("   - Check if DE/RE pin is needed and properly connected");
+    Serial.println("   - Ensure correct voltage levels (3.3V vs 5V)");
+  }
+  if (finishHandler) finishHandler(stats, false);
+
+  Serial.println("\n" + String('-', 40));
+  showMainMenu();
+}
+
+void scanStart(uint8_t firstId, uint8_t lastId, uint8_t busMask) {
+  memset(&stats, 0, sizeof(stats));
+  stats.firstId = firstId;
+  stats.lastId = lastId;
+  stats.nextId = firstId;
+  stats.pass = 1;
+  stats.startMs = millis();
+  generation++;
+
+  laneCount = 0;
+  for (uint8_t i = 0; i < MODBUS_BUS_COUNT; i++) {
+    RtuBus& bus = *rtuBuses[i];
+    if (!(busMask & (1 << i)) || bus.baud == 0 || !busTaskRunning(bus)) continue;
+    ScanLane& lane = lanes[laneCount++];
+    memset(&lane, 0, sizeof(lane));
+    lane.bus = &bus;
+    lane.nextId = firstId;
+    lane.pass = 1;
+    lane.timeoutMs = rtuProbeTimeoutMs(bus);
+  }
+  if (laneCount == 0) {
+    Serial.println("❌ No started bus to scan");
+    return;
+  }
+  stats.buses = laneCount;
+  stats.timeoutMs = lanes[0].timeoutMs;
+  state = SCAN_RUNNING;
+
+  ledStatusMessage(LED_SCANNING, "Scanning for Modbus devices...");
+  Serial.printf("\n🔍 Scanning for Modbus devices (IDs %d-%d)...\n", firstId, lastId);
+  for (uint8_t i = 0; i < laneCount; i++) {
+    const RtuBus& bus = *lanes[i].bus;
+    Serial.printf("   %s%s: %d ms probe timeout at %lu baud %s\n",
+                  sweepSettings.fastSweep ? "Fast sweep" : "Standard sweep", busLabel(lanes[i]),
+                  lanes[i].timeoutMs, (unsigned long)bus.baud, rtuConfigName(bus.config));
+  }
+  printScanControls();
+  Serial.println();
+}
+
+// Runs in loop() from busDispatch() for every probe that comes back
+static void onProbeDone(const BusResult& result) {
+  uint32_t tag = result.request.tag;
+  if (state == SCAN_IDLE || (uint8_t)(tag >> 16) != generation) return;
+  ScanLane& lane = lanes[(tag >> 8) & 0xFF];
+  uint8_t id = tag & 0xFF;
+  lane.inFlight--;
+  stats.probes++;
+
+  if (result.status == ModbusMaster::ku8MBSuccess) {
+    ledFlash(LED_SUCCESS, SCAN_FLASH_MS); // Brief green flash
+    Serial.printf("✅ Device found at ID: %d%s%s\n", id, busLabel(lane), lane.pass == 2 ? " (slow responder)" : "");
+    markId(lane.foundBitmap, id);
+    // The inventory and warm start cover the first bus
+    if (lane.bus == &modbusBus) inventoryRemember(id, modbusBus);
+    stats.devicesFound++;
+    if (lane.pass == 2) stats.foundOnRetry++;
+  }
+  else if (result.status == ModbusMaster::ku8MBInvalidCRC && lane.pass == 1) {
+    // Something answered but garbled; ask again in the retry pass before calling it
+    queueRetry(lane, id);
+  }
+  else if (result.status != ModbusMaster::ku8MBResponseTimedOut && result.status != ModbusMaster::ku8MBInvalidSlaveID) {
+    ledFlash(LED_WARNING, SCAN_FLASH_MS); // Brief orange flash
+    Serial.printf("⚠️  Device at ID %d%s responded with error: ", id, busLabel(lane));
+    printModbusError(result.status);
+    markId(lane.foundBitmap, id);
+    if (lane.bus == &modbusBus) inventoryRemember(id, modbusBus);
+    stats.devicesWithErrors++;
+  }
+  else if (lane.pass == 1 && sweepSettings.fastSweep &&
+           (sweepSettings.retryPass || result.rxBytes > 0)) {
+    // Partial reply or retry pass requested: try again with the slow timeout
+    queueRetry(lane, id);
+  }
+
+  // A late reply from an earlier ID proves that slave exists
+  if (result.straySlave != 0 && lane.pass == 1) {
+    queueRetry(lane, result.straySlave);
+  }
+
+  // Print progress every 50 devices
+  if (lane.pass == 1 && id % 50 == 0) {
+    Serial.printf("Progress%s: %d/%d devices checked\n", busLabel(lane), id - stats.firstId + 1,
+                  stats.lastId - stats.firstId + 1);
+  }
+}
+
+// Keep the lane's bus task supplied with probes; a pass ends once its last
+// probe is back, as the retry pass needs every answer of the sweep
+static void advanceLane(ScanLane& lane, uint8_t index) {
+  while (lane.nextId != 0 && lane.inFlight < SCAN_PIPELINE_DEPTH) {
+    BusRequest request = {};
+    request.bus = lane.bus;
+    request.slaveId = lane.nextId;
+    request.function = MB_FC_READ_HOLDING_REGISTERS;   // Holding register 0, as rtuProbe()
+    request.quantity = 1;
+    request.timeoutMs = lane.pass == 1 ? lane.timeoutMs : sweepSettings.slowTimeoutMs;
+    request.keepLate = true;   // Empty IDs are the common case; the stray check catches late replies
+    request.tag = ((uint32_t)generation << 16) | (index << 8) | lane.nextId;
+    request.callback = onProbeDone;
+    if (!busSubmit(request)) return;
+    lane.inFlight++;
+    lane.nextId = nextScanId(lane, lane.nextId);
+  }
+  if (lane.nextId != 0 || lane.inFlight > 0) return;
+
+  if (lane.pass == 1 && lane.retryIds > 0) {
+    lane.pass = 2;
+    lane.nextId = nextScanId(lane, stats.firstId - 1);
+    Serial.printf("🔁 Retry pass%s: %d ID(s) with %d ms timeout\n",
+                  busLabel(lane), lane.retryIds, sweepSettings.slowTimeoutMs);
+  }
+  lane.done = lane.nextId == 0;
+}
+
+// Top up every bus's probe queue; called from loop() on every pass while scanning
+void scanTick() {
+  if (state != SCAN_RUNNING) return;
+
+  bool running = false;
+  uint8_t nextId = 0;
+  for (uint8_t i = 0; i < laneCount; i++) {
+    ScanLane& lane = lanes[i];
+    if (!lane.done) advanceLane(lane, i);
+    if (lane.done) continue;
+    running = true;
+    if (lane.nextId != 0 && (nextId == 0 || lane.nextId < nextId)) nextId = lane.nextId;
+    if (lane.pass > stats.pass) stats.pass = lane.pass;
+  }
+
+  if (!running) {
+    finishScan();
+  } else if (nextId != 0) {
+    stats.nextId = nextId;
+  }
+}
+
+void scanPause() {
+  if (state != SCAN_RUNNING) return;
+  state = SCAN_PAUSED;
+  stats.pauseStartMs = millis();
+  setLEDStatus(LED_WARNING, false);
+  Serial.printf("⏸️  Scan paused at ID %d (p = resume, c = cancel)\n", stats.nextId);
+}
+
+void scanResume() {
+  if (state != SCAN_PAUSED) return;
+  stats.pausedMs += millis() - stats.pauseStartMs;
+  state = SCAN_RUNNING;
+  setLEDStatus(LED_SCANNING);
+  Serial.printf("▶️  Scan resumed at ID %d\n", stats.nextId);
+}
+
+void scanCancel() {
+  if (state == SCAN_IDLE) return;
+  if (state == SCAN_PAUSED) {
+    stats.pausedMs += millis() - stats.pauseStartMs;
+  }
+  state = SCAN_IDLE;
+
+  ledStatusMessage(LED_WARNING, "Scan cancelled");
+  printScanSummary("Scan cancelled!");
+  if (finishHandler) finishHandler(stats, true);
+  Serial.println("\n" + String('-', 40));
+  showMainMenu();
+}
+
+bool scanActive() {
+  return state != SCAN_IDLE;
+}
+
+ScanState scanState() {
+  return state;
+}
+
+const ScanStats& scanStats() {
+  return stats;
+}
+
+void scanSetFinishHandler(ScanFinishHandler handler) {
+  finishHandler = handler;
+}
+
+bool scanHandleCommand(const String& input) {
+  if (state == SCAN_IDLE) return false;
+
+  if (input == "p") {
+    if (state == SCAN_RUNNING) {
+      scanPause();
+    } else {
+      scanResume();
+    }
+  } else if (input == "c") {
+    scanCancel();
+  } else if (input == "s") {
+    unsigned long elapsed = scanElapsedMs();
+    Serial.printf("📊 %s (pass %d): next ID %d, %d probes, %d found, %lu ms\n",
+                  state == SCAN_PAUSED ? "Paused" : "Scanning", stats.pass,
+                  stats.nextId, stats.probes, stats.devicesFound, elapsed);
+  } else {
+    printScanControls();
+  }
+  return true;
+}
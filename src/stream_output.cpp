@@ -0,0 +1,87 @@
+#include "stream_output.h"
+#include "modbus_rtu.h"
+#include "register_map.h"
+
+static StreamMode mode = STREAM_TEXT;
+static StreamStats stats;
+static uint8_t record[STREAM_MAX_RECORD];
+static uint16_t length = 0;       // Bytes in record so far, 0 = no record open
+static uint16_t wordsLeft = 0;
+
+static void put16(uint8_t* p, uint16_t value) {
+  p[0] = value & 0xFF;
+  p[1] = value >> 8;
+}
+
+void streamSetMode(StreamMode newMode) {
+  mode = newMode;
+}
+
+StreamMode streamMode() {
+  return mode;
+}
+
+bool streamBinary() {
+  return mode == STREAM_BINARY;
+}
+
+const StreamStats& streamStats() {
+  return stats;
+}
+
+void streamResetStats() {
+  memset(&stats, 0, sizeof(stats));
+}
+
+void streamBegin(uint8_t bus, uint8_t slaveId, uint8_t table, uint16_t address, uint16_t count) {
+  bool bits = table == MAP_COILS || table == MAP_DISCRETE_INPUTS;
+  uint16_t words = bits ? (count + 15) / 16 : count;
+  if (words > STREAM_MAX_WORDS) {
+    words = STREAM_MAX_WORDS;
+    count = bits ? words * 16 : words;
+  }
+
+  unsigned long now = millis();
+  record[0] = STREAM_SYNC_0;
+  record[1] = STREAM_SYNC_1;
+  put16(record + 2, STREAM_HEADER_BYTES - 4 + words * 2);
+  record[4] = STREAM_RECORD_VERSION;
+  put16(record + 5, now & 0xFFFF);
+  put16(record + 7, now >> 16);
+  record[9] = bus;
+  record[10] = slaveId;
+  record[11] = table;
+  put16(record + 12, address);
+  put16(record + 14, count);
+  length = STREAM_HEADER_BYTES;
+  wordsLeft = words;
+  stats.values += count;
+}
+
+void streamWord(uint16_t value) {
+  if (wordsLeft == 0) return;
+  put16(record + length, value);
+  length += 2;
+  wordsLeft--;
+}
+
+void streamEnd() {
+  if (length == 0) return;
+  while (wordsLeft > 0) streamWord(0); // Short read: pad to the announced length
+  uint16_t crc = rtuCrc16(record + 4, length - 4);
+  put16(record + length, crc);
+  length += 2;
+
+  Serial.write(record, length);
+  stats.records++;
+  stats.bytes += length;
+  length = 0;
+}
+
+void streamRecord(uint8_t bus, uint8_t slaveId, uint8_t table, uint16_t address, uint16_t count,
+                  const uint16_t* values) {
+  streamBegin(bus, slaveId, table, address, count);
+  uint16_t words = wordsLeft;
+  for (uint16_t i = 0; i < words; i++) streamWord(values[i]);
+  streamEnd();
+}
@@ -0,0 +1,530 @@
+#include "tcp_gateway.h"
+#include "bus_task.h"
+#include "read_cache.h"
+#include <Preferences.h>
+#include <WiFi.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0                // lwIP has no SIGPIPE to suppress
+#endif
+
+#define GATEWAY_NAMESPACE "gateway"
+#define GATEWAY_WIFI_KEY "wifi"
+#define GATEWAY_MBAP_BYTES 7          // Transaction, protocol, length, unit
+#define GATEWAY_FRAME_MAX 260         // MBAP header and the largest PDU
+
+// Exception codes the gateway answers with itself
+#define EX_ILLEGAL_FUNCTION 0x01
+#define EX_ILLEGAL_DATA_VALUE 0x03
+#define EX_DEVICE_BUSY 0x06
+#define EX_PATH_UNAVAILABLE 0x0A
+#define EX_TARGET_NO_RESPONSE 0x0B
+
+struct GatewayRequest {
+  uint16_t transactionId;
+  uint8_t unitId;
+  uint8_t function;
+  uint16_t address;
+  uint16_t quantity;
+  uint32_t arrivedUs;
+  uint32_t costUs;            // Estimated bus time
+};
+
+struct GatewayClient {
+  int fd;                     // -1 = free slot
+  uint16_t generation;        // Changes with every connection in this slot
+  uint32_t remoteAddress;     // IPv4, host order
+  uint8_t rx[GATEWAY_FRAME_MAX];
+  uint16_t rxLength;
+  GatewayRequest queue[GATEWAY_CLIENT_QUEUE];
+  uint8_t head;
+  uint8_t queued;
+  uint32_t deficitUs;         // Bus time the client may still use before the others get a turn
+  unsigned long lastSeenMs;
+  uint32_t requests;
+  uint32_t busy;
+};
+
+// Handed to the bus task, waiting for the result
+struct GatewayInFlight {
+  bool used;
+  uint8_t client;
+  uint16_t generation;        // Reply dropped if the client has gone since
+  uint16_t transactionId;
+  uint32_t arrivedUs;
+};
+
+struct WifiCredentials {
+  char ssid[33];
+  char password[65];
+};
+
+static bool active = false;
+static bool announced = false;
+static int listenFd = -1;
+static uint16_t listenPort = 0;
+static RtuBus* targetBus = nullptr;
+static GatewayClient clients[GATEWAY_MAX_CLIENTS];
+static GatewayInFlight inFlight[GATEWAY_IN_FLIGHT];
+static uint8_t lastServed = 0;
+static GatewayStats stats;
+static Preferences nvs;
+
+static bool setNonBlocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) >= 0;
+}
+
+static int openListener(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+  int yes = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  socklen_t length = sizeof(address);
+  if (bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(fd, GATEWAY_MAX_CLIENTS) < 0 ||
+      !setNonBlocking(fd) || getsockname(fd, (struct sockaddr*)&address, &length) < 0) {
+    close(fd);
+    return -1;
+  }
+  listenPort = ntohs(address.sin_port);
+  return fd;
+}
+
+static bool loadWifi(WifiCredentials* credentials) {
+  nvs.begin(GATEWAY_NAMESPACE, true);
+  size_t length = nvs.getBytes(GATEWAY_WIFI_KEY, credentials, sizeof(*credentials));
+  nvs.end();
+  return length == sizeof(*credentials) && credentials->ssid[0] != '\0';
+}
+
+void gatewaySetWifi(const char* ssid, const char* password) {
+  WifiCredentials credentials;
+  memset(&credentials, 0, sizeof(credentials));
+  strncpy(credentials.ssid, ssid, sizeof(credentials.ssid) - 1);
+  strncpy(credentials.password, password, sizeof(credentials.password) - 1);
+  nvs.begin(GATEWAY_NAMESPACE, false);
+  if (nvs.putBytes(GATEWAY_WIFI_KEY, &credentials, sizeof(credentials)) != sizeof(credentials)) {
+    Serial.println("⚠️  Could not save the WiFi credentials");
+  }
+  nvs.end();
+  if (active) {
+    WiFi.begin(credentials.ssid, credentials.password);
+    announced = false;
+  }
+}
+
+static uint8_t queuedTotal() {
+  uint8_t total = 0;
+  for (const GatewayClient& client : clients) total += client.queued;
+  return total;
+}
+
+static void closeClient(GatewayClient& client) {
+  if (client.fd < 0) return;
+  close(client.fd);
+  client.fd = -1;
+  client.generation++;
+  client.queued = 0;
+}
+
+// One MBAP frame; a client that does not take it whole is not reading its
+// replies and is disconnected
+static void sendFrame(GatewayClient& client, uint16_t transactionId, uint8_t unitId, const uint8_t* pdu,
+                      uint16_t pduLength) {
+  uint8_t frame[GATEWAY_FRAME_MAX];
+  uint16_t length = pduLength + 1;
+  frame[0] = highByte(transactionId);
+  frame[1] = lowByte(transactionId);
+  frame[2] = 0;
+  frame[3] = 0;
+  frame[4] = highByte(length);
+  frame[5] = lowByte(length);
+  frame[6] = unitId;
+  memcpy(frame + GATEWAY_MBAP_BYTES, pdu, pduLength);
+  ssize_t sent = send(client.fd, frame, GATEWAY_MBAP_BYTES + pduLength, MSG_NOSIGNAL);
+  if (sent != GATEWAY_MBAP_BYTES + pduLength) closeClient(client);
+}
+
+static void sendException(GatewayClient& client, uint16_t transactionId, uint8_t unitId, uint8_t function,
+                          uint8_t code) {
+  uint8_t pdu[2] = {(uint8_t)(function | 0x80), code};
+  sendFrame(client, transactionId, unitId, pdu, sizeof(pdu));
+}
+
+static void popRequest(GatewayClient& client) {
+  client.head = (client.head + 1) % GATEWAY_CLIENT_QUEUE;
+  client.queued--;
+  if (client.queued == 0) client.deficitUs = 0;   // No credit saved up while idle
+}
+
+// Bus time of a read: request and reply on the wire, two frame gaps and
+// the slowest turnaround seen on the bus
+static uint32_t estimateUs(uint8_t function, uint16_t quantity) {
+  bool bits = function == MB_FC_READ_COILS || function == MB_FC_READ_DISCRETE_INPUTS;
+  uint16_t replyBytes = 5 + (bits ? (quantity + 7) / 8 : quantity * 2);
+  return (8 + replyBytes) * rtuCharTimeUs(*targetBus) + 2 * rtuFrameGapUs(*targetBus) + targetBus->turnaroundUs;
+}
+
+static void handleFrame(GatewayClient& client, const uint8_t* frame, uint16_t frameLength) {
+  stats.requests++;
+  client.requests++;
+  uint16_t transactionId = (frame[0] << 8) | frame[1];
+  uint8_t unitId = frame[6];
+  uint8_t function = frame[7];
+  uint16_t pduLength = frameLength - GATEWAY_MBAP_BYTES;
+
+  if (function < MB_FC_READ_COILS || function > MB_FC_READ_INPUT_REGISTERS) {
+    stats.rejected++;
+    sendException(client, transactionId, unitId, function, EX_ILLEGAL_FUNCTION);
+    return;
+  }
+  bool bits = function == MB_FC_READ_COILS || function == MB_FC_READ_DISCRETE_INPUTS;
+  uint16_t address = pduLength == 5 ? (frame[8] << 8) | frame[9] : 0;
+  uint16_t quantity = pduLength == 5 ? (frame[10] << 8) | frame[11] : 0;
+  if (quantity == 0 || quantity > (bits ? RTU_MAX_READ_BITS : RTU_MAX_READ_WORDS)) {
+    stats.rejected++;
+    sendException(client, transactionId, unitId, function, EX_ILLEGAL_DATA_VALUE);
+    return;
+  }
+  if (unitId == 0 || unitId > 247) {
+    // Broadcast or the gateway itself: no slave to ask
+    stats.rejected++;
+    sendException(client, transactionId, unitId, function, EX_PATH_UNAVAILABLE);
+    return;
+  }
+  if (client.queued >= GATEWAY_CLIENT_QUEUE) {
+    stats.busy++;
+    client.busy++;
+    sendException(client, transactionId, unitId, function, EX_DEVICE_BUSY);
+    return;
+  }
+
+  GatewayRequest& request = client.queue[(client.head + client.queued) % GATEWAY_CLIENT_QUEUE];
+  request.transactionId = transactionId;
+  request.unitId = unitId;
+  request.function = function;
+  request.address = address;
+  request.quantity = quantity;
+  request.arrivedUs = micros();
+  request.costUs = estimateUs(function, quantity);
+  client.queued++;
+  stats.maxQueued = max(stats.maxQueued, queuedTotal());
+}
+
+// Read what has arrived and cut the complete frames out of it
+static void receive(GatewayClient& client) {
+  for (;;) {
+    ssize_t got = recv(client.fd, client.rx + client.rxLength, sizeof(client.rx) - client.rxLength, 0);
+    if (got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+      closeClient(client);
+      return;
+    }
+    if (got < 0) return;
+    client.rxLength += got;
+    client.lastSeenMs = millis();
+
+    while (client.rxLength >= GATEWAY_MBAP_BYTES) {
+      uint16_t length = (client.rx[4] << 8) | client.rx[5];   // Unit ID and PDU
+      if (client.rx[2] != 0 || client.rx[3] != 0 || length < 2 || length > GATEWAY_FRAME_MAX - 6) {
+        closeClient(client);   // Not Modbus TCP; there is no frame boundary to resync on
+        return;
+      }
+      uint16_t frameLength = 6 + length;
+      if (client.rxLength < frameLength) break;
+      handleFrame(client, client.rx, frameLength);
+      if (client.fd < 0) return;
+      client.rxLength -= frameLength;
+      memmove(client.rx, client.rx + frameLength, client.rxLength);
+    }
+  }
+}
+
+static void acceptClients() {
+  for (;;) {
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    int fd = accept(listenFd, (struct sockaddr*)&address, &length);
+    if (fd < 0) return;
+
+    GatewayClient* slot = nullptr;
+    for (GatewayClient& client : clients) {
+      if (client.fd < 0) {
+        slot = &client;
+        break;
+      }
+    }
+    if (!slot || !setNonBlocking(fd)) {
+      close(fd);
+      stats.refused++;
+      continue;
+    }
+    int yes = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));   // Replies are whole frames
+    slot->fd = fd;
+    slot->remoteAddress = ntohl(address.sin_addr.s_addr);
+    slot->rxLength = 0;
+    slot->head = 0;
+    slot->queued = 0;
+    slot->deficitUs = 0;
+    slot->lastSeenMs = millis();
+    slot->requests = 0;
+    slot->busy = 0;
+    stats.connections++;
+  }
+}
+
+// Requests that waited too long for the bus: their clients have most likely
+// given up on them, so they are answered busy instead of using the line
+static void shedStale() {
+  uint32_t now = micros();
+  for (GatewayClient& client : clients) {
+    while (client.fd >= 0 && client.queued > 0) {
+      const GatewayRequest& request = client.queue[client.head];
+      if (now - request.arrivedUs <= GATEWAY_MAX_WAIT_MS * 1000UL) break;
+      stats.busy++;
+      client.busy++;
+      uint16_t transactionId = request.transactionId;
+      uint8_t unitId = request.unitId;
+      uint8_t function = request.function;
+      popRequest(client);
+      sendException(client, transactionId, unitId, function, EX_DEVICE_BUSY);
+    }
+  }
+}
+
+// Deficit round robin: the first client after the last one served whose
+// credit covers its next request. When nobody's does, every waiting client
+// gets the same credit, just enough for the closest one to go.
+static int8_t nextClient() {
+  for (uint8_t round = 0; round < 2; round++) {
+    uint32_t shortfallUs = UINT32_MAX;
+    for (uint8_t step = 1; step <= GATEWAY_MAX_CLIENTS; step++) {
+      uint8_t index = (lastServed + step) % GATEWAY_MAX_CLIENTS;
+      const GatewayClient& client = clients[index];
+      if (client.fd < 0 || client.queued == 0) continue;
+      uint32_t costUs = client.queue[client.head].costUs;
+      if (client.deficitUs >= costUs) return index;
+      shortfallUs = min(shortfallUs, costUs - client.deficitUs);
+    }
+    if (shortfallUs == UINT32_MAX) return -1;
+    for (GatewayClient& client : clients) {
+      if (client.fd >= 0 && client.queued > 0) client.deficitUs += shortfallUs;
+    }
+  }
+  return -1;
+}
+
+static void onBusResult(const BusResult& result) {
+  const BusRequest& request = result.request;
+  GatewayInFlight& slot = inFlight[request.tag];
+  slot.used = false;
+  GatewayClient& client = clients[slot.client];
+  if (client.fd < 0 || client.generation != slot.generation) return;   // Client left meanwhile
+
+  if (result.status == ModbusMaster::ku8MBSuccess) {
+    bool bits = request.function == MB_FC_READ_COILS || request.function == MB_FC_READ_DISCRETE_INPUTS;
+    uint8_t pdu[2 + RTU_MAX_READ_WORDS * 2];
+    uint8_t byteCount = bits ? (request.quantity + 7) / 8 : request.quantity * 2;
+    pdu[0] = request.function;
+    pdu[1] = byteCount;
+    for (uint8_t i = 0; i < byteCount; i++) {
+      // Bits come packed 16 per word, LSB first; registers go out big-endian
+      uint16_t word = result.values[i / 2];
+      pdu[2 + i] = bits ? ((i & 1) ? highByte(word) : lowByte(word)) : ((i & 1) ? lowByte(word) : highByte(word));
+    }
+    stats.replies++;
+    sendFrame(client, slot.transactionId, request.slaveId, pdu, 2 + byteCount);
+  } else if (result.status >= ModbusMaster::ku8MBIllegalFunction &&
+             result.status < ModbusMaster::ku8MBInvalidSlaveID) {
+    stats.exceptions++;
+    sendException(client, slot.transactionId, request.slaveId, request.function, result.status);
+  } else {
+    stats.failed++;
+    sendException(client, slot.transactionId, request.slaveId, request.function, EX_TARGET_NO_RESPONSE);
+  }
+
+  uint32_t responseUs = micros() - slot.arrivedUs;
+  stats.responseUs += responseUs;
+  stats.maxResponseUs = max(stats.maxResponseUs, responseUs);
+}
+
+// Hand queued requests to the bus task while fewer than GATEWAY_IN_FLIGHT
+// of ours are there; the rest wait here, where the order can still change
+static void dispatch() {
+  for (;;) {
+    int8_t slot = -1;
+    for (uint8_t i = 0; i < GATEWAY_IN_FLIGHT; i++) {
+      if (!inFlight[i].used) {
+        slot = i;
+        break;
+      }
+    }
+    if (slot < 0) return;
+    int8_t index = nextClient();
+    if (index < 0) return;
+
+    GatewayClient& client = clients[index];
+    const GatewayRequest& request = client.queue[client.head];
+    BusRequest busRequest;
+    memset(&busRequest, 0, sizeof(busRequest));
+    busRequest.bus = targetBus;
+    busRequest.slaveId = request.unitId;
+    busRequest.function = request.function;
+    busRequest.address = request.address;
+    busRequest.quantity = request.quantity;
+    busRequest.maxAgeMs = CACHE_ANY_AGE;
+    busRequest.tag = slot;
+    busRequest.callback = onBusResult;
+    if (!busSubmit(busRequest)) return;   // Bus queue full of other work: next tick
+
+    uint32_t waitUs = micros() - request.arrivedUs;
+    stats.forwarded++;
+    stats.waitUs += waitUs;
+    stats.maxWaitUs = max(stats.maxWaitUs, waitUs);
+    inFlight[slot] = {true, (uint8_t)index, client.generation, request.transactionId, request.arrivedUs};
+    client.deficitUs -= request.costUs;
+    lastServed = index;
+    popRequest(client);
+  }
+}
+
+bool gatewayStart(uint16_t port, RtuBus& bus) {
+  if (active) gatewayStop();
+  if (!busTaskRunning(bus)) {
+    Serial.printf("❌ Bus %d has no bus task to forward to\n", rtuBusNumber(bus));
+    return false;
+  }
+
+  if (WiFi.status() != WL_CONNECTED) {
+    WifiCredentials credentials;
+    if (!loadWifi(&credentials)) {
+      Serial.println("❌ No WiFi network stored - use 'gateway wifi <ssid> <password>' first");
+      return false;
+    }
+    Serial.printf("📶 Joining WiFi network %s...\n", credentials.ssid);
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(credentials.ssid, credentials.password);
+  }
+
+  listenFd = openListener(port);
+  if (listenFd < 0) {
+    Serial.printf("❌ Could not listen on TCP port %u: %s\n", port, strerror(errno));
+    return false;
+  }
+
+  for (GatewayClient& client : clients) {
+    client.fd = -1;
+    client.queued = 0;
+  }
+  memset(inFlight, 0, sizeof(inFlight));
+  targetBus = &bus;
+  gatewayResetStats();
+  active = true;
+  announced = false;
+  Serial.printf("🌐 Modbus TCP gateway on port %u to bus %d: %d clients, %d queued each, reads only\n",
+                listenPort, rtuBusNumber(bus), GATEWAY_MAX_CLIENTS, GATEWAY_CLIENT_QUEUE);
+  return true;
+}
+
+void gatewayStop() {
+  if (!active) return;
+  for (GatewayClient& client : clients) closeClient(client);
+  close(listenFd);
+  listenFd = -1;
+  active = false;
+  Serial.println("🌐 Modbus TCP gateway stopped");
+}
+
+void gatewayTick() {
+  if (!active) return;
+  if (!announced && WiFi.status() == WL_CONNECTED) {
+    Serial.printf("🌐 Gateway reachable at %s:%u\n", WiFi.localIP().toString().c_str(), listenPort);
+    announced = true;
+  }
+
+  acceptClients();
+  unsigned long now = millis();
+  for (GatewayClient& client : clients) {
+    if (client.fd < 0) continue;
+    receive(client);
+    if (client.fd >= 0 && client.queued == 0 && now - client.lastSeenMs > GATEWAY_IDLE_MS) closeClient(client);
+  }
+  shedStale();
+  dispatch();
+}
+
+bool gatewayActive() {
+  return active;
+}
+
+uint16_t gatewayPort() {
+  return active ? listenPort : 0;
+}
+
+uint8_t gatewayClientCount() {
+  uint8_t count = 0;
+  for (const GatewayClient& client : clients) {
+    if (active && client.fd >= 0) count++;
+  }
+  return count;
+}
+
+const GatewayStats& gatewayStats() {
+  return stats;
+}
+
+float gatewayRequestsPerSecond() {
+  unsigned long elapsedMs = millis() - stats.startMs;
+  return elapsedMs > 0 ? stats.requests * 1000.0f / elapsedMs : 0.0f;
+}
+
+void gatewayResetStats() {
+  memset(&stats, 0, sizeof(stats));
+  stats.startMs = millis();
+  for (GatewayClient& client : clients) {
+    client.requests = 0;
+    client.busy = 0;
+  }
+}
+
+void gatewayPrintStats() {
+  if (!active) {
+    Serial.println("🌐 Modbus TCP gateway: off");
+    return;
+  }
+  uint32_t answered = stats.replies + stats.exceptions + stats.failed;
+  Serial.printf("🌐 Gateway on port %u to bus %d: %d client(s), %lu connection(s), %lu refused, up %lu s\n",
+                listenPort, rtuBusNumber(*targetBus), gatewayClientCount(), (unsigned long)stats.connections,
+                (unsigned long)stats.refused, (millis() - stats.startMs) / 1000);
+  Serial.printf("   %lu request(s), %.1f/s: %lu replies, %lu exceptions, %lu busy (0x06), %lu without reply, "
+                "%lu rejected\n",
+                (unsigned long)stats.requests, gatewayRequestsPerSecond(), (unsigned long)stats.replies,
+                (unsigned long)stats.exceptions, (unsigned long)stats.busy, (unsigned long)stats.failed,
+                (unsigned long)stats.rejected);
+  if (answered > 0) {
+    Serial.printf("   Queue wait avg %.1f ms, max %.1f ms; request to reply avg %.1f ms, max %.1f ms; "
+                  "%d queued at most\n",
+                  stats.waitUs / 1000.0f / stats.forwarded, stats.maxWaitUs / 1000.0f,
+                  stats.responseUs / 1000.0f / answered, stats.maxResponseUs / 1000.0f, stats.maxQueued);
+  }
+  for (uint8_t i = 0; i < GATEWAY_MAX_CLIENTS; i++) {
+    const GatewayClient& client = clients[i];
+    if (client.fd < 0) continue;
+    Serial.printf("   Client %d: %lu.%lu.%lu.%lu, %lu request(s), %lu busy, %d queued\n", i + 1,
+                  (unsigned long)(client.remoteAddress >> 24), (unsigned long)((client.remoteAddress >> 16) & 0xFF),
+                  (unsigned long)((client.remoteAddress >> 8) & 0xFF), (unsigned long)(client.remoteAddress & 0xFF),
+                  (unsigned long)client.requests, (unsigned long)client.busy, client.queued);
+  }
+}
@@ -0,0 +1,42 @@
+#include "tec_profile.h"
+
+static constexpr const char* unitStates[] = {
+  "Heating", "Cooling", "Antifreeze", "Defrost", "Standby", "Off", "Starting", "On", "DHW"
+};
+
+static constexpr const char* alarmStates[] = {"OK", "ACTIVE"};
+
+// Temperatures are signed tenths of a degree
+constexpr RegisterDescriptor tecRegisters[] = {
+  regNumber(MAP_INPUT_REGISTERS, 1, "B1 - Inlet Temperature", "°C", 1, true),
+  regNumber(MAP_INPUT_REGISTERS, 2, "B2 - Outlet Temperature", "°C", 1, true),
+  regNumber(MAP_INPUT_REGISTERS, 3, "T2 - Ambient Temperature", "°C", 1, true),
+  regNumber(MAP_INPUT_REGISTERS, 4, "T4 - Suction", "°C", 1, true),
+  regNumber(MAP_INPUT_REGISTERS, 5, "T3 - Discharge", "°C", 1, true),
+  regNumber(MAP_INPUT_REGISTERS, 6, "B6 - Low Pressure Side", "bar", 1),
+  regNumber(MAP_INPUT_REGISTERS, 7, "B7 - High Pressure Side", "bar", 1),
+  regNumber(MAP_INPUT_REGISTERS, 8, "Flow", "m3/h", 1),
+  regNumber(MAP_INPUT_REGISTERS, 9, "Room Temperature", "°C", 1, true),
+  regNumber(MAP_INPUT_REGISTERS, 13, "Compressor", "Hz"),
+  regNumber(MAP_INPUT_REGISTERS, 14, "Y3 - Indoor pump PWM", "%", 1),
+  regNumber(MAP_INPUT_REGISTERS, 17, "B4 - Hot Water", "°C", 1, true),
+  regNumber(MAP_INPUT_REGISTERS, 18, "Operating Hours", "Hours"),
+  regEnum(MAP_INPUT_REGISTERS, 20, "Unit State", unitStates, 1),
+
+  regNumber(MAP_HOLDING_REGISTERS, 61, "ST01 - Cooling mode temperature", "°C", 1, true),
+  regNumber(MAP_HOLDING_REGISTERS, 62, "ST02 - Heating mode temperature", "°C", 1, true),
+  regNumber(MAP_HOLDING_REGISTERS, 79, "ST09 - DHW temperature setup", "°C", 1, true),
+  regNumber(MAP_HOLDING_REGISTERS, 80, "ST10 - DHW temperature difference", "°C", 1, true),
+
+  regEnum(MAP_DISCRETE_INPUTS, 1, "AL01 - Low pressure", alarmStates),
+  regEnum(MAP_DISCRETE_INPUTS, 2, "AL02 - High pressure", alarmStates),
+  regEnum(MAP_DISCRETE_INPUTS, 3, "AL03 - Low outlet water temp", alarmStates),
+  regEnum(MAP_DISCRETE_INPUTS, 5, "AL05 - High outlet water temp", alarmStates),
+  regEnum(MAP_DISCRETE_INPUTS, 6, "AL17 - Water flow short", alarmStates),
+  regEnum(MAP_DISCRETE_INPUTS, 7, "AL18 - Low pressure alarm limit", alarmStates),
+  regEnum(MAP_DISCRETE_INPUTS, 8, "AL19 - High pressure alarm limit", alarmStates),
+};
+
+const uint8_t tecRegisterCount = sizeof(tecRegisters) / sizeof(tecRegisters[0]);
+
+static_assert(registerProfileValid(tecRegisters), "TEC register profile");
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""Decode the scanner's binary register records (include/stream_output.h).
+
+Reads the console stream from a file, stdin or a serial port, finds the
+records between the menu text and prints one line per record:
+
+    python3 tools/decode_stream.py capture.bin
+    python3 tools/decode_stream.py --port /dev/ttyACM0 --json
+    .pio/build/native/program | python3 tools/decode_stream.py - --text
+
+CSV columns: timestamp_ms, bus, slave, table, address, count, values...
+(bits expanded to 0/1). --text copies everything that is not a record to
+stderr, so the menu stays readable. Serial ports need pyserial.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+SYNC = b"\xa5\x5a"
+VERSION = 1
+HEADER = struct.Struct("<BIBBBHH")   # version, timestamp, bus, slave, table, address, count
+MAX_BODY = HEADER.size + 125 * 2
+TABLES = ("co", "di", "hr", "ir")
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+class Decoder:
+    """Incremental parser: feed() bytes as they arrive, get whole records back."""
+
+    def __init__(self, text_sink=None):
+        self.buffer = bytearray()
+        self.text_sink = text_sink
+        self.records = 0
+        self.crc_errors = 0
+
+    def _text(self, data):
+        if self.text_sink and data:
+            self.text_sink.write(data.decode("utf-8", "replace"))
+
+    def feed(self, data):
+        self.buffer += data
+        records = []
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                # Keep a trailing first sync byte, it may be completed next time
+                keep = 1 if self.buffer.endswith(SYNC[:1]) else 0
+                self._text(bytes(self.buffer[:len(self.buffer) - keep]))
+                del self.buffer[:len(self.buffer) - keep]
+                return records
+            self._text(bytes(self.buffer[:start]))
+            del self.buffer[:start]
+            if len(self.buffer) < 5:
+                return records
+
+            (length,) = struct.unpack_from("<H", self.buffer, 2)
+            if length < HEADER.size or length > MAX_BODY or self.buffer[4] != VERSION:
+                self._text(bytes(self.buffer[:1]))   # Not a record after all
+                del self.buffer[:1]
+                continue
+            if len(self.buffer) < 4 + length + 2:
+                return records
+
+            body = bytes(self.buffer[4:4 + length])
+            (crc,) = struct.unpack_from("<H", self.buffer, 4 + length)
+            if crc16(body) != crc:
+                self.crc_errors += 1
+                self._text(bytes(self.buffer[:1]))
+                del self.buffer[:1]
+                continue
+            del self.buffer[:4 + length + 2]
+            records.append(self._parse(body))
+            self.records += 1
+
+    @staticmethod
+    def _parse(body):
+        _, timestamp, bus, slave, table, address, count = HEADER.unpack_from(body)
+        words = struct.unpack_from("<%dH" % ((len(body) - HEADER.size) // 2), body, HEADER.size)
+        if table in (0, 1):
+            values = [(words[i // 16] >> (i % 16)) & 1 for i in range(count)]
+        else:
+            values = list(words[:count])
+        return {
+            "timestamp_ms": timestamp,
+            "bus": bus,
+            "slave": slave,
+            "table": TABLES[table] if table < len(TABLES) else str(table),
+            "address": address,
+            "count": count,
+            "values": values,
+        }
+
+
+def open_input(args):
+    if args.port:
+        import serial  # pyserial
+        port = serial.Serial(args.port, args.baud, timeout=0.1)
+        return lambda: port.read(4096)
+    stream = sys.stdin.buffer if args.input in (None, "-") else open(args.input, "rb")
+    return lambda: stream.read1(4096) if hasattr(stream, "read1") else stream.read(4096)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", nargs="?", help="capture file, '-' for stdin (default)")
+    parser.add_argument("--port", help="read from this serial port instead")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--json", action="store_true", help="JSON lines instead of CSV")
+    parser.add_argument("--text", action="store_true", help="copy non-record bytes to stderr")
+    args = parser.parse_args()
+
+    read = open_input(args)
+    decoder = Decoder(sys.stderr if args.text else None)
+    try:
+        while True:
+            data = read()
+            if not data:
+                if args.port:
+                    continue
+                break
+            for record in decoder.feed(data):
+                if args.json:
+                    print(json.dumps(record))
+                else:
+                    print(",".join(str(field) for field in
+                                   [record["timestamp_ms"], record["bus"], record["slave"], record["table"],
+                                    record["address"], record["count"]] + record["values"]))
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+    print("%d record(s), %d CRC error(s)" % (decoder.records, decoder.crc_errors), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()